@@ -15,19 +15,20 @@ static uint8_t calc_checksum(uint8_t* buf)
     return (~sum) + 1;
 }
 
-int8_t oxygen_read(float* concentration) 
+int8_t oxygen_request(void) 
 {
     uint8_t tx_buf[9] = {0xFF, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
     tx_buf[8] = calc_checksum(tx_buf);
 
     int ret = i2c_write_blocking(O2_I2C_PORT, O2_ADDR, tx_buf, 9, false);
-    if (ret == PICO_ERROR_GENERIC) return O2_ERR;
-
-    sleep_ms(100);
+    return (ret < 0) ? O2_ERR : O2_OK;
+}
 
+int8_t oxygen_collect(float* concentration) 
+{
     uint8_t rx_buf[9];
-    ret = i2c_read_blocking(O2_I2C_PORT, O2_ADDR, rx_buf, 9, false);
-    if (ret == PICO_ERROR_GENERIC) return O2_ERR;
+    int ret = i2c_read_blocking(O2_I2C_PORT, O2_ADDR, rx_buf, 9, false);
+    if (ret < 0) return O2_ERR;
 
     if (rx_buf[0] == 0xFF && rx_buf[8] == calc_checksum(rx_buf)) 
     {
@@ -38,6 +39,15 @@ int8_t oxygen_read(float* concentration)
     else return O2_ERR;
 }
 
+int8_t oxygen_read(float* concentration) 
+{
+    if (oxygen_request() != O2_OK) return O2_ERR;
+
+    sleep_ms(O2_RESPONSE_MS);
+
+    return oxygen_collect(concentration);
+}
+
 int8_t oxygen_init(void) 
 {
     // "Pinging" the sensor by trying to read a value
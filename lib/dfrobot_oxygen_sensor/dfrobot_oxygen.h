@@ -10,8 +10,17 @@
 #define O2_OK   0
 #define O2_ERR -1
 
+// Time the sensor needs between a read command and its answer [ms]
+#define O2_RESPONSE_MS 100
+
 extern int8_t oxygen_init(void);
 
 extern int8_t oxygen_read(float* concentration);
 
+// The two halves of oxygen_read(), for callers that have other work to do
+// during the O2_RESPONSE_MS wait: send the read command, then fetch the answer.
+extern int8_t oxygen_request(void);
+
+extern int8_t oxygen_collect(float* concentration);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,428 @@
+/*
+ * Throughput comparison of the specialized RMC/GGA parsers against the
+ * generic minmea_scan() format-string path they replaced (a verbatim copy of
+ * the pre-change code, below).
+ *
+ * Build and run on the host:
+ *   cc -O2 -o minmea_bench bench.c minmea.c && ./minmea_bench
+ *
+ * Before timing, every sentence is parsed both ways and the resulting frames
+ * are compared byte for byte; the benchmark aborts on any difference.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "minmea.h"
+
+#define REPEATS 9
+#define ITERATIONS 200000
+
+static const char *rmc_sentences[] = {
+    "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62",
+    "$GPRMC,123205.00,A,5106.94085,N,01701.51689,E,0.016,,280214,,,A*7B",
+    "$GNRMC,092751.000,A,5321.6802,N,00630.3371,W,0.06,31.66,280511,,,A*45",
+    "$GPRMC,,V,,,,,,,,,,N*53",
+};
+
+static const char *gga_sentences[] = {
+    "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+    "$GPGGA,123204.00,5106.94086,N,01701.51680,E,1,06,3.86,127.9,M,40.5,M,,*51",
+    "$GNGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.2,M,,*76",
+    "$GPGGA,,,,,,0,00,99.99,,,,,,*48",
+};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+/*
+ * Reference: minmea_scan(), minmea_parse_rmc() and minmea_parse_gga() as they
+ * were before the specialized parsers, copied verbatim (only renamed, with
+ * minmea_isfield() as it was then), so the baseline keeps its format-string
+ * interpreter, varargs, ctype calls and strtol().
+ */
+
+static inline bool reference_isfield(char c) {
+    return isprint((unsigned char) c) && c != ',' && c != '*';
+}
+
+static bool reference_scan(const char *sentence, const char *format, ...)
+{
+    bool result = false;
+    bool optional = false;
+
+    if (sentence == NULL)
+        return false;
+
+    va_list ap;
+    va_start(ap, format);
+
+    const char *field = sentence;
+#define next_field() \
+    do { \
+        /* Progress to the next field. */ \
+        while (reference_isfield(*sentence)) \
+            sentence++; \
+        /* Make sure there is a field there. */ \
+        if (*sentence == ',') { \
+            sentence++; \
+            field = sentence; \
+        } else { \
+            field = NULL; \
+        } \
+    } while (0)
+
+    while (*format) {
+        char type = *format++;
+
+        if (type == ';') {
+            // All further fields are optional.
+            optional = true;
+            continue;
+        }
+
+        if (!field && !optional) {
+            // Field requested but we ran out if input. Bail out.
+            goto parse_error;
+        }
+
+        switch (type) {
+            case 'c': { // Single character field (char).
+                char value = '\0';
+
+                if (field && reference_isfield(*field))
+                    value = *field;
+
+                *va_arg(ap, char *) = value;
+            } break;
+
+            case 'd': { // Single character direction field (int).
+                int value = 0;
+
+                if (field && reference_isfield(*field)) {
+                    switch (*field) {
+                        case 'N':
+                        case 'E':
+                            value = 1;
+                            break;
+                        case 'S':
+                        case 'W':
+                            value = -1;
+                            break;
+                        default:
+                            goto parse_error;
+                    }
+                }
+
+                *va_arg(ap, int *) = value;
+            } break;
+
+            case 'f': { // Fractional value with scale (struct minmea_float).
+                int sign = 0;
+                int_least32_t value = -1;
+                int_least32_t scale = 0;
+
+                if (field) {
+                    while (reference_isfield(*field)) {
+                        if (*field == '+' && !sign && value == -1) {
+                            sign = 1;
+                        } else if (*field == '-' && !sign && value == -1) {
+                            sign = -1;
+                        } else if (isdigit((unsigned char) *field)) {
+                            int digit = *field - '0';
+                            if (value == -1)
+                                value = 0;
+                            if (value > (INT_LEAST32_MAX-digit) / 10) {
+                                /* we ran out of bits, what do we do? */
+                                if (scale) {
+                                    /* truncate extra precision */
+                                    break;
+                                } else {
+                                    /* integer overflow. bail out. */
+                                    goto parse_error;
+                                }
+                            }
+                            value = (10 * value) + digit;
+                            if (scale)
+                                scale *= 10;
+                        } else if (*field == '.' && scale == 0) {
+                            scale = 1;
+                        } else if (*field == ' ') {
+                            /* Allow spaces at the start of the field. Not NMEA
+                             * conformant, but some modules do this. */
+                            if (sign != 0 || value != -1 || scale != 0)
+                                goto parse_error;
+                        } else {
+                            goto parse_error;
+                        }
+                        field++;
+                    }
+                }
+
+                if ((sign || scale) && value == -1)
+                    goto parse_error;
+
+                if (value == -1) {
+                    /* No digits were scanned. */
+                    value = 0;
+                    scale = 0;
+                } else if (scale == 0) {
+                    /* No decimal point. */
+                    scale = 1;
+                }
+                if (sign)
+                    value *= sign;
+
+                *va_arg(ap, struct minmea_float *) = (struct minmea_float) {value, scale};
+            } break;
+
+            case 'i': { // Integer value, default 0 (int).
+                int value = 0;
+
+                if (field) {
+                    char *endptr;
+                    value = strtol(field, &endptr, 10);
+                    if (reference_isfield(*endptr))
+                        goto parse_error;
+                }
+
+                *va_arg(ap, int *) = value;
+            } break;
+
+            case 's': { // String value (char *).
+                char *buf = va_arg(ap, char *);
+
+                if (field) {
+                    while (reference_isfield(*field))
+                        *buf++ = *field++;
+                }
+
+                *buf = '\0';
+            } break;
+
+            case 't': { // NMEA talker identifier and type (union minmea_type *).
+                // This field is always mandatory.
+                if (!field)
+                    goto parse_error;
+
+                if (field[0] != '$')
+                    goto parse_error;
+                for (int f=0; f<5; f++)
+                    if (!reference_isfield(field[1+f]))
+                        goto parse_error;
+
+                union minmea_type *buf = va_arg(ap, union minmea_type *);
+                memcpy(buf, field+1, (sizeof(*buf) - sizeof(buf->null_terminator)));
+                buf->null_terminator = '\0';
+            } break;
+
+            case 'D': { // Date (int, int, int), -1 if empty.
+                struct minmea_date *date = va_arg(ap, struct minmea_date *);
+
+                int d = -1, m = -1, y = -1;
+
+                if (field && reference_isfield(*field)) {
+                    // Always six digits.
+                    for (int f=0; f<6; f++)
+                        if (!isdigit((unsigned char) field[f]))
+                            goto parse_error;
+
+                    char dArr[] = {field[0], field[1], '\0'};
+                    char mArr[] = {field[2], field[3], '\0'};
+                    char yArr[] = {field[4], field[5], '\0'};
+                    d = strtol(dArr, NULL, 10);
+                    m = strtol(mArr, NULL, 10);
+                    y = strtol(yArr, NULL, 10);
+                }
+
+                date->day = d;
+                date->month = m;
+                date->year = y;
+            } break;
+
+            case 'T': { // Time (int, int, int, int), -1 if empty.
+                struct minmea_time *time_ = va_arg(ap, struct minmea_time *);
+
+                int h = -1, i = -1, s = -1, u = -1;
+
+                if (field && reference_isfield(*field)) {
+                    // Minimum required: integer time.
+                    for (int f=0; f<6; f++)
+                        if (!isdigit((unsigned char) field[f]))
+                            goto parse_error;
+
+                    char hArr[] = {field[0], field[1], '\0'};
+                    char iArr[] = {field[2], field[3], '\0'};
+                    char sArr[] = {field[4], field[5], '\0'};
+                    h = strtol(hArr, NULL, 10);
+                    i = strtol(iArr, NULL, 10);
+                    s = strtol(sArr, NULL, 10);
+                    field += 6;
+
+                    // Extra: fractional time. Saved as microseconds.
+                    if (*field++ == '.') {
+                        uint32_t value = 0;
+                        uint32_t scale = 1000000LU;
+                        while (isdigit((unsigned char) *field) && scale > 1) {
+                            value = (value * 10) + (*field++ - '0');
+                            scale /= 10;
+                        }
+                        u = value * scale;
+                    } else {
+                        u = 0;
+                    }
+                }
+
+                time_->hours = h;
+                time_->minutes = i;
+                time_->seconds = s;
+                time_->microseconds = u;
+            } break;
+
+            case '_': { // Ignore the field.
+            } break;
+
+            default: { // Unknown.
+                goto parse_error;
+            }
+        }
+
+        next_field();
+    }
+
+    result = true;
+
+parse_error:
+    va_end(ap);
+    return result;
+}
+
+static bool reference_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence)
+{
+    // $GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62
+    char validity;
+    int latitude_direction;
+    int longitude_direction;
+    int variation_direction;
+    if (!reference_scan(sentence, "tTcfdfdffDfd",
+            &frame->type,
+            &frame->time,
+            &validity,
+            &frame->latitude, &latitude_direction,
+            &frame->longitude, &longitude_direction,
+            &frame->speed,
+            &frame->course,
+            &frame->date,
+            &frame->variation, &variation_direction))
+        return false;
+    if (memcmp(frame->type.sentence_id, "RMC", sizeof(frame->type.sentence_id)))
+        return false;
+
+    frame->valid = (validity == 'A');
+    frame->latitude.value *= latitude_direction;
+    frame->longitude.value *= longitude_direction;
+    frame->variation.value *= variation_direction;
+
+    return true;
+}
+
+static bool reference_parse_gga(struct minmea_sentence_gga *frame, const char *sentence)
+{
+    // $GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47
+    int latitude_direction;
+    int longitude_direction;
+
+    if (!reference_scan(sentence, "tTfdfdiiffcfcf_",
+            &frame->type,
+            &frame->time,
+            &frame->latitude, &latitude_direction,
+            &frame->longitude, &longitude_direction,
+            &frame->fix_quality,
+            &frame->satellites_tracked,
+            &frame->hdop,
+            &frame->altitude, &frame->altitude_units,
+            &frame->height, &frame->height_units,
+            &frame->dgps_age))
+        return false;
+    if (memcmp(frame->type.sentence_id, "GGA", sizeof(frame->type.sentence_id)))
+        return false;
+
+    frame->latitude.value *= latitude_direction;
+    frame->longitude.value *= longitude_direction;
+
+    return true;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static volatile int sink;
+
+#define TIME_PARSER(result, frame_type, parse, sentences) \
+    do { \
+        double samples[REPEATS]; \
+        for (int r = 0; r < REPEATS; r++) { \
+            struct frame_type frame; \
+            double start = now_ns(); \
+            for (int i = 0; i < ITERATIONS; i++) \
+                sink += parse(&frame, sentences[i % COUNT(sentences)]); \
+            samples[r] = (now_ns() - start) / ITERATIONS; \
+        } \
+        qsort(samples, REPEATS, sizeof(double), compare_double); \
+        result = samples[REPEATS / 2]; \
+    } while (0)
+
+int main(void)
+{
+    for (size_t i = 0; i < COUNT(rmc_sentences); i++) {
+        struct minmea_sentence_rmc a, b;
+        memset(&a, 0, sizeof(a));
+        memset(&b, 0, sizeof(b));
+        bool ra = minmea_parse_rmc(&a, rmc_sentences[i]);
+        bool rb = reference_parse_rmc(&b, rmc_sentences[i]);
+        if (ra != rb || memcmp(&a, &b, sizeof(a))) {
+            fprintf(stderr, "RMC mismatch: %s\n", rmc_sentences[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    for (size_t i = 0; i < COUNT(gga_sentences); i++) {
+        struct minmea_sentence_gga a, b;
+        memset(&a, 0, sizeof(a));
+        memset(&b, 0, sizeof(b));
+        bool ra = minmea_parse_gga(&a, gga_sentences[i]);
+        bool rb = reference_parse_gga(&b, gga_sentences[i]);
+        if (ra != rb || memcmp(&a, &b, sizeof(a))) {
+            fprintf(stderr, "GGA mismatch: %s\n", gga_sentences[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    double rmc_generic, rmc_fast, gga_generic, gga_fast;
+    TIME_PARSER(rmc_generic, minmea_sentence_rmc, reference_parse_rmc, rmc_sentences);
+    TIME_PARSER(rmc_fast, minmea_sentence_rmc, minmea_parse_rmc, rmc_sentences);
+    TIME_PARSER(gga_generic, minmea_sentence_gga, reference_parse_gga, gga_sentences);
+    TIME_PARSER(gga_fast, minmea_sentence_gga, minmea_parse_gga, gga_sentences);
+
+    printf("parser  generic [ns/sentence]  specialized [ns/sentence]  speedup\n");
+    printf("RMC     %22.1f  %25.1f  %6.2fx\n", rmc_generic, rmc_fast, rmc_generic / rmc_fast);
+    printf("GGA     %22.1f  %25.1f  %6.2fx\n", gga_generic, gga_fast, gga_generic / gga_fast);
+
+    return EXIT_SUCCESS;
+}
+
+/* vim: set ts=4 sw=4 et: */
@@ -8,6 +8,7 @@
 
 #include "minmea.h"
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
@@ -87,6 +88,264 @@ bool minmea_check(const char *sentence, bool strict)
     return true;
 }
 
+/*
+ * Field scanners shared by minmea_scan() and the specialized sentence parsers.
+ * Each one reads a single field starting at `field` (NULL when the sentence
+ * has run out of fields) and returns false on a malformed field.
+ */
+
+static inline bool minmea_isdigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline const char *minmea_next_field(const char *field)
+{
+    if (!field)
+        return NULL;
+    /* Progress to the next field. */
+    while (minmea_isfield(*field))
+        field++;
+    /* Make sure there is a field there. */
+    return (*field == ',') ? field + 1 : NULL;
+}
+
+static inline bool minmea_scan_char(const char *field, char *out)
+{
+    char value = '\0';
+
+    if (field && minmea_isfield(*field))
+        value = *field;
+
+    *out = value;
+    return true;
+}
+
+static inline bool minmea_scan_direction(const char *field, int *out)
+{
+    int value = 0;
+
+    if (field && minmea_isfield(*field)) {
+        switch (*field) {
+            case 'N':
+            case 'E':
+                value = 1;
+                break;
+            case 'S':
+            case 'W':
+                value = -1;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    *out = value;
+    return true;
+}
+
+static inline bool minmea_scan_float(const char *field, struct minmea_float *out)
+{
+    int sign = 0;
+    int_least32_t value = -1;
+    int_least32_t scale = 0;
+
+    if (field) {
+        while (minmea_isfield(*field)) {
+            if (*field == '+' && !sign && value == -1) {
+                sign = 1;
+            } else if (*field == '-' && !sign && value == -1) {
+                sign = -1;
+            } else if (minmea_isdigit(*field)) {
+                int digit = *field - '0';
+                if (value == -1)
+                    value = 0;
+                if (value > (INT_LEAST32_MAX-digit) / 10) {
+                    /* we ran out of bits, what do we do? */
+                    if (scale) {
+                        /* truncate extra precision */
+                        break;
+                    } else {
+                        /* integer overflow. bail out. */
+                        return false;
+                    }
+                }
+                value = (10 * value) + digit;
+                if (scale)
+                    scale *= 10;
+            } else if (*field == '.' && scale == 0) {
+                scale = 1;
+            } else if (*field == ' ') {
+                /* Allow spaces at the start of the field. Not NMEA
+                 * conformant, but some modules do this. */
+                if (sign != 0 || value != -1 || scale != 0)
+                    return false;
+            } else {
+                return false;
+            }
+            field++;
+        }
+    }
+
+    if ((sign || scale) && value == -1)
+        return false;
+
+    if (value == -1) {
+        /* No digits were scanned. */
+        value = 0;
+        scale = 0;
+    } else if (scale == 0) {
+        /* No decimal point. */
+        scale = 1;
+    }
+    if (sign)
+        value *= sign;
+
+    *out = (struct minmea_float) {value, scale};
+    return true;
+}
+
+/* Equivalent to strtol(field, &endptr, 10) in the "C" locale, followed by a
+ * check that the number fills the whole field. */
+static inline bool minmea_scan_int(const char *field, int *out)
+{
+    int value = 0;
+
+    if (field) {
+        const char *p = field;
+        bool negative = false;
+
+        while (*p == ' ' || (*p >= '\t' && *p <= '\r'))
+            p++;
+        if (*p == '+' || *p == '-')
+            negative = (*p++ == '-');
+
+        const char *digits = p;
+        unsigned long limit = negative ? (unsigned long) LONG_MAX + 1 : (unsigned long) LONG_MAX;
+        unsigned long magnitude = 0;
+        bool overflow = false;
+
+        while (minmea_isdigit(*p)) {
+            unsigned long digit = *p++ - '0';
+            if (overflow || magnitude > (limit - digit) / 10)
+                overflow = true;
+            else
+                magnitude = magnitude * 10 + digit;
+        }
+
+        if (p == digits) {
+            /* No conversion performed. */
+            p = field;
+        }
+
+        long result;
+        if (overflow)
+            result = negative ? LONG_MIN : LONG_MAX;
+        else if (negative)
+            result = (magnitude == limit) ? LONG_MIN : -(long) magnitude;
+        else
+            result = (long) magnitude;
+
+        value = (int) result;
+        if (minmea_isfield(*p))
+            return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+static inline bool minmea_scan_string(const char *field, char *buf)
+{
+    if (field) {
+        while (minmea_isfield(*field))
+            *buf++ = *field++;
+    }
+
+    *buf = '\0';
+    return true;
+}
+
+static inline bool minmea_scan_type(const char *field, union minmea_type *buf)
+{
+    // This field is always mandatory.
+    if (!field)
+        return false;
+
+    if (field[0] != '$')
+        return false;
+    for (int f=0; f<5; f++)
+        if (!minmea_isfield(field[1+f]))
+            return false;
+
+    memcpy(buf, field+1, (sizeof(*buf) - sizeof(buf->null_terminator)));
+    buf->null_terminator = '\0';
+    return true;
+}
+
+/* Two characters already known to be decimal digits. */
+static inline int minmea_2digits(const char *s)
+{
+    return (s[0] - '0') * 10 + (s[1] - '0');
+}
+
+static inline bool minmea_scan_date(const char *field, struct minmea_date *date)
+{
+    int d = -1, m = -1, y = -1;
+
+    if (field && minmea_isfield(*field)) {
+        // Always six digits.
+        for (int f=0; f<6; f++)
+            if (!minmea_isdigit(field[f]))
+                return false;
+
+        d = minmea_2digits(&field[0]);
+        m = minmea_2digits(&field[2]);
+        y = minmea_2digits(&field[4]);
+    }
+
+    date->day = d;
+    date->month = m;
+    date->year = y;
+    return true;
+}
+
+static inline bool minmea_scan_time(const char *field, struct minmea_time *time_)
+{
+    int h = -1, i = -1, s = -1, u = -1;
+
+    if (field && minmea_isfield(*field)) {
+        // Minimum required: integer time.
+        for (int f=0; f<6; f++)
+            if (!minmea_isdigit(field[f]))
+                return false;
+
+        h = minmea_2digits(&field[0]);
+        i = minmea_2digits(&field[2]);
+        s = minmea_2digits(&field[4]);
+        field += 6;
+
+        // Extra: fractional time. Saved as microseconds.
+        if (*field++ == '.') {
+            uint32_t value = 0;
+            uint32_t scale = 1000000LU;
+            while (minmea_isdigit(*field) && scale > 1) {
+                value = (value * 10) + (*field++ - '0');
+                scale /= 10;
+            }
+            u = value * scale;
+        } else {
+            u = 0;
+        }
+    }
+
+    time_->hours = h;
+    time_->minutes = i;
+    time_->seconds = s;
+    time_->microseconds = u;
+    return true;
+}
+
 bool minmea_scan(const char *sentence, const char *format, ...)
 {
     bool result = false;
@@ -99,19 +358,6 @@ bool minmea_scan(const char *sentence, const char *format, ...)
     va_start(ap, format);
 
     const char *field = sentence;
-#define next_field() \
-    do { \
-        /* Progress to the next field. */ \
-        while (minmea_isfield(*sentence)) \
-            sentence++; \
-        /* Make sure there is a field there. */ \
-        if (*sentence == ',') { \
-            sentence++; \
-            field = sentence; \
-        } else { \
-            field = NULL; \
-        } \
-    } while (0)
 
     while (*format) {
         char type = *format++;
@@ -127,208 +373,54 @@ bool minmea_scan(const char *sentence, const char *format, ...)
             goto parse_error;
         }
 
-        switch (type) {
-            case 'c': { // Single character field (char).
-                char value = '\0';
-
-                if (field && minmea_isfield(*field))
-                    value = *field;
-
-                *va_arg(ap, char *) = value;
-            } break;
-
-            case 'd': { // Single character direction field (int).
-                int value = 0;
-
-                if (field && minmea_isfield(*field)) {
-                    switch (*field) {
-                        case 'N':
-                        case 'E':
-                            value = 1;
-                            break;
-                        case 'S':
-                        case 'W':
-                            value = -1;
-                            break;
-                        default:
-                            goto parse_error;
-                    }
-                }
-
-                *va_arg(ap, int *) = value;
-            } break;
-
-            case 'f': { // Fractional value with scale (struct minmea_float).
-                int sign = 0;
-                int_least32_t value = -1;
-                int_least32_t scale = 0;
-
-                if (field) {
-                    while (minmea_isfield(*field)) {
-                        if (*field == '+' && !sign && value == -1) {
-                            sign = 1;
-                        } else if (*field == '-' && !sign && value == -1) {
-                            sign = -1;
-                        } else if (isdigit((unsigned char) *field)) {
-                            int digit = *field - '0';
-                            if (value == -1)
-                                value = 0;
-                            if (value > (INT_LEAST32_MAX-digit) / 10) {
-                                /* we ran out of bits, what do we do? */
-                                if (scale) {
-                                    /* truncate extra precision */
-                                    break;
-                                } else {
-                                    /* integer overflow. bail out. */
-                                    goto parse_error;
-                                }
-                            }
-                            value = (10 * value) + digit;
-                            if (scale)
-                                scale *= 10;
-                        } else if (*field == '.' && scale == 0) {
-                            scale = 1;
-                        } else if (*field == ' ') {
-                            /* Allow spaces at the start of the field. Not NMEA
-                             * conformant, but some modules do this. */
-                            if (sign != 0 || value != -1 || scale != 0)
-                                goto parse_error;
-                        } else {
-                            goto parse_error;
-                        }
-                        field++;
-                    }
-                }
+        bool ok;
 
-                if ((sign || scale) && value == -1)
-                    goto parse_error;
+        switch (type) {
+            case 'c': // Single character field (char).
+                ok = minmea_scan_char(field, va_arg(ap, char *));
+                break;
 
-                if (value == -1) {
-                    /* No digits were scanned. */
-                    value = 0;
-                    scale = 0;
-                } else if (scale == 0) {
-                    /* No decimal point. */
-                    scale = 1;
-                }
-                if (sign)
-                    value *= sign;
+            case 'd': // Single character direction field (int).
+                ok = minmea_scan_direction(field, va_arg(ap, int *));
+                break;
 
-                *va_arg(ap, struct minmea_float *) = (struct minmea_float) {value, scale};
-            } break;
+            case 'f': // Fractional value with scale (struct minmea_float).
+                ok = minmea_scan_float(field, va_arg(ap, struct minmea_float *));
+                break;
 
-            case 'i': { // Integer value, default 0 (int).
-                int value = 0;
+            case 'i': // Integer value, default 0 (int).
+                ok = minmea_scan_int(field, va_arg(ap, int *));
+                break;
 
-                if (field) {
-                    char *endptr;
-                    value = strtol(field, &endptr, 10);
-                    if (minmea_isfield(*endptr))
-                        goto parse_error;
-                }
+            case 's': // String value (char *).
+                ok = minmea_scan_string(field, va_arg(ap, char *));
+                break;
 
-                *va_arg(ap, int *) = value;
-            } break;
+            case 't': // NMEA talker identifier and type (union minmea_type *).
+                ok = minmea_scan_type(field, va_arg(ap, union minmea_type *));
+                break;
 
-            case 's': { // String value (char *).
-                char *buf = va_arg(ap, char *);
+            case 'D': // Date (int, int, int), -1 if empty.
+                ok = minmea_scan_date(field, va_arg(ap, struct minmea_date *));
+                break;
 
-                if (field) {
-                    while (minmea_isfield(*field))
-                        *buf++ = *field++;
-                }
+            case 'T': // Time (int, int, int, int), -1 if empty.
+                ok = minmea_scan_time(field, va_arg(ap, struct minmea_time *));
+                break;
 
-                *buf = '\0';
-            } break;
-
-            case 't': { // NMEA talker identifier and type (union minmea_type *).
-                // This field is always mandatory.
-                if (!field)
-                    goto parse_error;
-
-                if (field[0] != '$')
-                    goto parse_error;
-                for (int f=0; f<5; f++)
-                    if (!minmea_isfield(field[1+f]))
-                        goto parse_error;
-
-                union minmea_type *buf = va_arg(ap, union minmea_type *);
-                memcpy(buf, field+1, (sizeof(*buf) - sizeof(buf->null_terminator)));
-                buf->null_terminator = '\0';
-            } break;
-
-            case 'D': { // Date (int, int, int), -1 if empty.
-                struct minmea_date *date = va_arg(ap, struct minmea_date *);
-
-                int d = -1, m = -1, y = -1;
-
-                if (field && minmea_isfield(*field)) {
-                    // Always six digits.
-                    for (int f=0; f<6; f++)
-                        if (!isdigit((unsigned char) field[f]))
-                            goto parse_error;
-
-                    char dArr[] = {field[0], field[1], '\0'};
-                    char mArr[] = {field[2], field[3], '\0'};
-                    char yArr[] = {field[4], field[5], '\0'};
-                    d = strtol(dArr, NULL, 10);
-                    m = strtol(mArr, NULL, 10);
-                    y = strtol(yArr, NULL, 10);
-                }
+            case '_': // Ignore the field.
+                ok = true;
+                break;
 
-                date->day = d;
-                date->month = m;
-                date->year = y;
-            } break;
-
-            case 'T': { // Time (int, int, int, int), -1 if empty.
-                struct minmea_time *time_ = va_arg(ap, struct minmea_time *);
-
-                int h = -1, i = -1, s = -1, u = -1;
-
-                if (field && minmea_isfield(*field)) {
-                    // Minimum required: integer time.
-                    for (int f=0; f<6; f++)
-                        if (!isdigit((unsigned char) field[f]))
-                            goto parse_error;
-
-                    char hArr[] = {field[0], field[1], '\0'};
-                    char iArr[] = {field[2], field[3], '\0'};
-                    char sArr[] = {field[4], field[5], '\0'};
-                    h = strtol(hArr, NULL, 10);
-                    i = strtol(iArr, NULL, 10);
-                    s = strtol(sArr, NULL, 10);
-                    field += 6;
-
-                    // Extra: fractional time. Saved as microseconds.
-                    if (*field++ == '.') {
-                        uint32_t value = 0;
-                        uint32_t scale = 1000000LU;
-                        while (isdigit((unsigned char) *field) && scale > 1) {
-                            value = (value * 10) + (*field++ - '0');
-                            scale /= 10;
-                        }
-                        u = value * scale;
-                    } else {
-                        u = 0;
-                    }
-                }
-
-                time_->hours = h;
-                time_->minutes = i;
-                time_->seconds = s;
-                time_->microseconds = u;
-            } break;
-
-            case '_': { // Ignore the field.
-            } break;
-
-            default: { // Unknown.
-                goto parse_error;
-            }
+            default: // Unknown.
+                ok = false;
+                break;
         }
 
-        next_field();
+        if (!ok)
+            goto parse_error;
+
+        field = minmea_next_field(field);
     }
 
     result = true;
@@ -415,6 +507,20 @@ bool minmea_parse_gbs(struct minmea_sentence_gbs *frame, const char *sentence)
     return true;
 }
 
+/*
+ * RMC and GGA are parsed on every navigation epoch, so they use straight-line
+ * parsers with the field layout fixed at compile time instead of interpreting
+ * a minmea_scan() format string. They accept exactly the same input and
+ * produce exactly the same frames as the "tTcfdfdffDfd" and "tTfdfdiiffcfcf_"
+ * formats would.
+ */
+#define MINMEA_FIELD(scan) \
+    do { \
+        if (!field || !(scan)) \
+            return false; \
+        field = minmea_next_field(field); \
+    } while (0)
+
 bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence)
 {
     // $GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62
@@ -422,19 +528,25 @@ bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence)
     int latitude_direction;
     int longitude_direction;
     int variation_direction;
-    if (!minmea_scan(sentence, "tTcfdfdffDfd",
-            &frame->type,
-            &frame->time,
-            &validity,
-            &frame->latitude, &latitude_direction,
-            &frame->longitude, &longitude_direction,
-            &frame->speed,
-            &frame->course,
-            &frame->date,
-            &frame->variation, &variation_direction))
+    const char *field = sentence;
+
+    if (sentence == NULL)
         return false;
+
+    MINMEA_FIELD(minmea_scan_type(field, &frame->type));
     if (memcmp(frame->type.sentence_id, "RMC", sizeof(frame->type.sentence_id)))
         return false;
+    MINMEA_FIELD(minmea_scan_time(field, &frame->time));
+    MINMEA_FIELD(minmea_scan_char(field, &validity));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->latitude));
+    MINMEA_FIELD(minmea_scan_direction(field, &latitude_direction));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->longitude));
+    MINMEA_FIELD(minmea_scan_direction(field, &longitude_direction));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->speed));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->course));
+    MINMEA_FIELD(minmea_scan_date(field, &frame->date));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->variation));
+    MINMEA_FIELD(minmea_scan_direction(field, &variation_direction));
 
     frame->valid = (validity == 'A');
     frame->latitude.value *= latitude_direction;
@@ -449,21 +561,30 @@ bool minmea_parse_gga(struct minmea_sentence_gga *frame, const char *sentence)
     // $GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47
     int latitude_direction;
     int longitude_direction;
+    const char *field = sentence;
 
-    if (!minmea_scan(sentence, "tTfdfdiiffcfcf_",
-            &frame->type,
-            &frame->time,
-            &frame->latitude, &latitude_direction,
-            &frame->longitude, &longitude_direction,
-            &frame->fix_quality,
-            &frame->satellites_tracked,
-            &frame->hdop,
-            &frame->altitude, &frame->altitude_units,
-            &frame->height, &frame->height_units,
-            &frame->dgps_age))
+    if (sentence == NULL)
         return false;
+
+    MINMEA_FIELD(minmea_scan_type(field, &frame->type));
     if (memcmp(frame->type.sentence_id, "GGA", sizeof(frame->type.sentence_id)))
         return false;
+    MINMEA_FIELD(minmea_scan_time(field, &frame->time));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->latitude));
+    MINMEA_FIELD(minmea_scan_direction(field, &latitude_direction));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->longitude));
+    MINMEA_FIELD(minmea_scan_direction(field, &longitude_direction));
+    MINMEA_FIELD(minmea_scan_int(field, &frame->fix_quality));
+    MINMEA_FIELD(minmea_scan_int(field, &frame->satellites_tracked));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->hdop));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->altitude));
+    MINMEA_FIELD(minmea_scan_char(field, &frame->altitude_units));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->height));
+    MINMEA_FIELD(minmea_scan_char(field, &frame->height_units));
+    MINMEA_FIELD(minmea_scan_float(field, &frame->dgps_age));
+    // Last field (DGPS station ID) is required but ignored.
+    if (!field)
+        return false;
 
     frame->latitude.value *= latitude_direction;
     frame->longitude.value *= longitude_direction;
@@ -471,6 +592,8 @@ bool minmea_parse_gga(struct minmea_sentence_gga *frame, const char *sentence)
     return true;
 }
 
+#undef MINMEA_FIELD
+
 bool minmea_parse_gsa(struct minmea_sentence_gsa *frame, const char *sentence)
 {
     // $GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39
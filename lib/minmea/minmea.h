@@ -303,12 +303,35 @@ static inline float minmea_tocoord(const struct minmea_float *f)
     return (float) degrees + (float) minutes / (60 * f->scale);
 }
 
+/**
+ * Convert a raw coordinate to integer degrees scaled by 1e7 (DD.DDDDDDD * 10^7),
+ * using integer arithmetic only. Rounds to nearest, so NMEA coordinates with up to
+ * five decimal places of minutes are represented without loss.
+ * Returns 0 for "unknown" values and for more than 180 degrees.
+ */
+static inline int_least32_t minmea_tocoord_e7(const struct minmea_float *f)
+{
+    if (f->scale <= 0)
+        return 0;
+    if (f->scale > (INT_LEAST32_MAX / 100))
+        return 0;
+    int_least32_t degrees = f->value / (f->scale * 100);
+    int_least32_t minutes = f->value % (f->scale * 100);
+    if (degrees > 180 || degrees < -180)
+        return 0;
+    int_least64_t numerator = (int_least64_t) minutes * 10000000;
+    int_least64_t denominator = (int_least64_t) f->scale * 60;
+    numerator += (minutes < 0) ? -denominator / 2 : denominator / 2;
+    return (int_least32_t) ((int_least64_t) degrees * 10000000 + numerator / denominator);
+}
+
 /**
  * Check whether a character belongs to the set of characters allowed in a
  * sentence data field.
  */
 static inline bool minmea_isfield(char c) {
-    return isprint((unsigned char) c) && c != ',' && c != '*';
+    /* Same set as isprint() in the "C" locale, without the library call. */
+    return c >= ' ' && c <= '~' && c != ',' && c != '*';
 }
 
 #ifdef __cplusplus
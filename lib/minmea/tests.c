@@ -1162,6 +1162,52 @@ START_TEST(test_minmea_coord)
 }
 END_TEST
 
+START_TEST(test_minmea_coord_e7)
+{
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { 42, 0 }), 0);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { 4200, 1 }), 420000000);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { 420000, 100 }), 420000000);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { 423000, 100 }), 425000000);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { -423000, 100 }), -425000000);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { 1795999999, 100000 }), 1799999998);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { 18000, 1 }), 1800000000);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { 21500, 1 }), 0);
+    ck_assert_int_eq(minmea_tocoord_e7(&(struct minmea_float) { -2147480000, 1000 }), 0);
+}
+END_TEST
+
+START_TEST(test_minmea_coord_e7_precision)
+{
+    /* Every representable 5-decimal minute value must land within half a unit
+     * (0.5e-7 degree) of the exact decimal value of the NMEA string. */
+    for (int_least32_t minutes = 0; minutes < 6000000; minutes += 997) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            struct minmea_float f = { sign * (510000000 + minutes), 100000 };
+            long double exact = sign * (51.0L + minutes / 100000.0L / 60.0L) * 1e7L;
+            long double error = fabsl(minmea_tocoord_e7(&f) - exact);
+            ck_assert(error <= 0.5L);
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_minmea_coord_e7_sentence)
+{
+    /* Full NMEA round trip: no precision is lost between the raw text and the
+     * integer result. Exact values: 37 + 51.65/60, 145 + 7.36/60,
+     * 51 + 6.94085/60 and 17 + 1.51689/60 degrees. */
+    struct minmea_sentence_rmc frame;
+
+    ck_assert(minmea_parse_rmc(&frame, "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62") == true);
+    ck_assert_int_eq(minmea_tocoord_e7(&frame.latitude), -378608333);
+    ck_assert_int_eq(minmea_tocoord_e7(&frame.longitude), 1451226667);
+
+    ck_assert(minmea_parse_rmc(&frame, "$GPRMC,123205.00,A,5106.94085,N,01701.51689,E,0.016,,280214,,,A*7B") == true);
+    ck_assert_int_eq(minmea_tocoord_e7(&frame.latitude), 511156808);
+    ck_assert_int_eq(minmea_tocoord_e7(&frame.longitude), 170252815);
+}
+END_TEST
+
 static Suite *minmea_suite(void)
 {
     Suite *s = suite_create ("minmea");
@@ -1219,6 +1265,9 @@ static Suite *minmea_suite(void)
     tcase_add_test(tc_utils, test_minmea_rescale);
     tcase_add_test(tc_utils, test_minmea_float);
     tcase_add_test(tc_utils, test_minmea_coord);
+    tcase_add_test(tc_utils, test_minmea_coord_e7);
+    tcase_add_test(tc_utils, test_minmea_coord_e7_precision);
+    tcase_add_test(tc_utils, test_minmea_coord_e7_sentence);
     suite_add_tcase(s, tc_utils);
 
     return s;
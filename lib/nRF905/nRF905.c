@@ -66,10 +66,12 @@ void nrf905_init(void) {
     nrf_set_tx_addr();
 
     // 5. Default to RX Mode
-    nrf905_wakeup();
+    // Powered up since step 3: no second oscillator wait as in nrf905_wakeup()
+    gpio_put(PIN_TX_EN, 0);
+    gpio_put(PIN_TRX_CE, 1);
 }
 
-void nrf905_tx(uint8_t *data, uint8_t len) {
+bool nrf905_tx(uint8_t *data, uint8_t len) {
     // 1. Standby
     gpio_put(PIN_TRX_CE, 0);
     
@@ -97,6 +99,8 @@ void nrf905_tx(uint8_t *data, uint8_t len) {
     // 5. Return to RX Mode
     gpio_put(PIN_TX_EN, 0);
     gpio_put(PIN_TRX_CE, 1);
+
+    return timeout >= 0;
 }
 
 bool nrf905_data_ready(void) {
@@ -115,6 +119,16 @@ void nrf905_rx(uint8_t *buffer) {
     // Reset DR is handled automatically by chip upon reading
 }
 
+void nrf905_set_channel(uint16_t channel) {
+    // CH_NO is 9 bits: byte 0, and bit 0 of byte 1 next to the band and power settings.
+    uint8_t ch[2] = {channel & 0xFF, (config_registers[1] & 0xFE) | ((channel >> 8) & 0x01)};
+
+    gpio_put(PIN_TRX_CE, 0); // Standby while the configuration changes
+    nrf_write_config(CMD_W_CONFIG, ch, sizeof(ch));
+    gpio_put(PIN_TX_EN, 0);
+    gpio_put(PIN_TRX_CE, 1); // Back to RX Mode
+}
+
 void nrf905_sleep(void) {
     gpio_put(PIN_PWR, 0);
 }
@@ -29,7 +29,11 @@
 
 extern void nrf905_init(void);
 
-extern void nrf905_tx(uint8_t *data, uint8_t len);
+// Sets the 9-bit channel number (CH_NO) in the same band; the default is 0x6C (433.2 MHz).
+extern void nrf905_set_channel(uint16_t channel);
+
+// Returns false if the radio did not signal the end of transmission (DR) in time.
+extern bool nrf905_tx(uint8_t *data, uint8_t len);
 
 extern bool nrf905_data_ready(void);
 
@@ -1,11 +1,14 @@
-#include <math.h>
 #include "hardware/i2c.h"
 #include "hardware/adc.h"
 #include "atm_sen_module.h"
+#include "sensor_conversion.h"
 #include "debug_mode.h"
+#include "profiler.h"
+#include "i2c_trace.h"
 #include "lib/bmp280/bmp280_i2c.h"
 #include "lib/bmp280/bmp280_i2c_hal.h"
 #include "dfrobot_oxygen.h"
+#include "flash_config.h"
 
 #define I2C_PORT i2c0
 #define SHTC3_ADDR 0x70
@@ -13,11 +16,64 @@
 #define PIN_SCL 13
 #define O2_ADDR  0x74
 
-#define PIN_METHANE 26
-#define PIN_AMMONIA 28
+// Half period of the clock pulses that free a stuck bus (about 100 kHz) [us]
+#define I2C_RECOVERY_HALF_PERIOD_US 5
 
 static float startup_pressure_pa = 0.0f;
 
+// Whether the O2 read command of the reading in progress was acknowledged (read_all_start()).
+static bool o2_requested = false;
+
+i2c_device_stats_t i2c_device_stats[I2C_DEV_COUNT];
+
+const char *const i2c_device_names[I2C_DEV_COUNT] = {
+    [I2C_DEV_SHTC3] = "SHTC3",
+    [I2C_DEV_BMP280] = "BMP280",
+    [I2C_DEV_O2] = "O2",
+    [I2C_DEV_OTHER] = "other",
+};
+
+static i2c_device_t i2c_device_of(uint8_t addr)
+{
+    switch (addr)
+    {
+        case SHTC3_ADDR: return I2C_DEV_SHTC3;
+        case I2C_ADDRESS_BMP280: return I2C_DEV_BMP280;
+        case O2_ADDR: return I2C_DEV_O2;
+        default: return I2C_DEV_OTHER;
+    }
+}
+
+static int i2c_count(uint8_t addr, bool write, size_t len, bool nostop, uint32_t start_us, int ret)
+{
+    i2c_device_stats_t *s = &i2c_device_stats[i2c_device_of(addr)];
+
+    I2C_TRACE_RECORD(addr, write, len, nostop, start_us, ret);
+
+    s->transfers++;
+    if (ret == PICO_ERROR_TIMEOUT) s->timeouts++;
+    else if (ret < 0) s->errors++;
+    return ret;
+}
+
+// Every blocking I2C transfer in the firmware, drivers included, goes through these
+// (linked with --wrap=i2c_write_blocking and --wrap=i2c_read_blocking).
+int __wrap_i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    uint32_t start_us = time_us_32();
+    int ret = i2c_write_timeout_us(i2c, addr, src, len, nostop, I2C_TRANSFER_TIMEOUT_US);
+
+    return i2c_count(addr, true, len, nostop, start_us, ret);
+}
+
+int __wrap_i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    uint32_t start_us = time_us_32();
+    int ret = i2c_read_timeout_us(i2c, addr, dst, len, nostop, I2C_TRANSFER_TIMEOUT_US);
+
+    return i2c_count(addr, false, len, nostop, start_us, ret);
+}
+
 static void bmp280_init()
 {
     int err = BMP280_OK;
@@ -64,9 +120,9 @@ static void bmp280_init()
     else LOG("[BMP280] ERROR: Initialization FAILED.\n");
 }
 
-void init_all_sensors()
+static void init_peripherals(void)
 {
-    i2c_init(I2C_PORT, 100 * 1000);
+    i2c_init(I2C_PORT, flash_config()->i2c_baud_hz);
     gpio_set_function(PIN_SDA, GPIO_FUNC_I2C);
     gpio_set_function(PIN_SCL, GPIO_FUNC_I2C);
     gpio_pull_up(PIN_SDA);
@@ -75,56 +131,120 @@ void init_all_sensors()
     adc_init();
     adc_gpio_init(PIN_METHANE);
     adc_gpio_init(PIN_AMMONIA);
+}
+
+/** @brief Frees the bus from a device left in the middle of a read by a reset of the Pico:
+ * up to 9 clocks until it releases SDA, then a STOP condition.
+ */
+static void i2c_bus_recover(void)
+{
+    gpio_init(PIN_SDA);
+    gpio_set_dir(PIN_SDA, GPIO_IN);
+    gpio_pull_up(PIN_SDA);
+    gpio_init(PIN_SCL);
+    gpio_set_dir(PIN_SCL, GPIO_OUT);
+    gpio_put(PIN_SCL, 1);
+
+    for (int i = 0; i < 9 && !gpio_get(PIN_SDA); i++)
+    {
+        gpio_put(PIN_SCL, 0);
+        sleep_us(I2C_RECOVERY_HALF_PERIOD_US);
+        gpio_put(PIN_SCL, 1);
+        sleep_us(I2C_RECOVERY_HALF_PERIOD_US);
+    }
+
+    // STOP: SDA rises while SCL is high.
+    gpio_set_dir(PIN_SDA, GPIO_OUT);
+    gpio_put(PIN_SCL, 0);
+    gpio_put(PIN_SDA, 0);
+    sleep_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpio_put(PIN_SCL, 1);
+    sleep_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpio_put(PIN_SDA, 1);
+    sleep_us(I2C_RECOVERY_HALF_PERIOD_US);
+}
+
+void resume_all_sensors(void)
+{
+    i2c_bus_recover();
+    init_peripherals();
+}
+
+void init_all_sensors()
+{
+    init_peripherals();
+
+    // The O2 sensor is pinged with a read whose answer takes O2_RESPONSE_MS; the BMP280 is
+    // brought up in the meantime, its driver waiting as long again for the first measurement.
+    uint64_t o2_request_us = time_us_64();
+    bool o2_ok = oxygen_request() == O2_OK;
 
     bmp280_init();
-    oxygen_init();
 
-    if (oxygen_init() == O2_OK) {
+    uint64_t o2_elapsed_us = time_us_64() - o2_request_us;
+    if (o2_elapsed_us < O2_RESPONSE_MS * 1000ULL) sleep_us(O2_RESPONSE_MS * 1000ULL - o2_elapsed_us);
+
+    float o2_pct;
+    if (o2_ok && oxygen_collect(&o2_pct) == O2_OK) {
         LOG("[O2] Initialization SUCCESS.\n");
     } else {
         LOG("[O2] ERROR: Initialization FAILED.\n");
     }
 }
 
-static void bmp280_read(double *pressure, double *altitude)
+void bmp280_read(double *pressure, double *altitude, uint64_t *timestamp_us)
 {
+    PROF_ENTER(PROF_BMP280_READ);
     bmp280_data_t bmp280_dt;
 
-    if (bmp280_i2c_read_data(&bmp280_dt) == BMP280_OK)
+    int16_t err = bmp280_i2c_read_data(&bmp280_dt);
+    *timestamp_us = time_us_64();
+
+    if (err == BMP280_OK)
     {
         *pressure = (double)bmp280_dt.pressure / 256.0f;
-        *altitude = 44330.0f * (1.0f - powf(*pressure / 101325.0f, 0.1903f));
+        *altitude = pressure_to_altitude(*pressure);
     }
     else
     {
         *pressure = -1.0f; // Error flag
         *altitude = -1.0f; // Error flag
     }
+    PROF_EXIT(PROF_BMP280_READ);
 }
 
-static void shtc3_read(float *temp, float *hum)
-{
-    uint8_t cmd_wake[2]  = {0x35, 0x17};
-    uint8_t cmd_meas[2]  = {0x78, 0x66};
-    uint8_t cmd_sleep[2] = {0xB0, 0x98};
-    uint8_t buffer[6];
+static const uint8_t shtc3_cmd_wake[2]  = {0x35, 0x17};
+static const uint8_t shtc3_cmd_meas[2]  = {0x78, 0x66};
+static const uint8_t shtc3_cmd_sleep[2] = {0xB0, 0x98};
 
-    i2c_write_blocking(I2C_PORT, SHTC3_ADDR, cmd_wake, 2, false);
+void shtc3_request(void)
+{
+    PROF_ENTER(PROF_SHTC3_READ);
+    i2c_write_blocking(I2C_PORT, SHTC3_ADDR, shtc3_cmd_wake, 2, false);
     sleep_us(250); // Small delay for wakeup
 
-    i2c_write_blocking(I2C_PORT, SHTC3_ADDR, cmd_meas, 2, false);
-    sleep_ms(20);  // Waiting for measurement to complete
+    // No clock stretching: the bus stays free for the other devices during the conversion.
+    i2c_write_blocking(I2C_PORT, SHTC3_ADDR, shtc3_cmd_meas, 2, false);
+    PROF_EXIT(PROF_SHTC3_READ);
+}
+
+void shtc3_collect(float *temp, float *hum, uint64_t *timestamp_us)
+{
+    PROF_ENTER(PROF_SHTC3_READ);
+    uint8_t buffer[6];
 
     // Data - 6 bytes: Temp MSB, Temp LSB, CRC, Hum MSB, Hum LSB, CRC
     int ret = i2c_read_blocking(I2C_PORT, SHTC3_ADDR, buffer, 6, false);
+    *timestamp_us = time_us_64();
 
-    i2c_write_blocking(I2C_PORT, SHTC3_ADDR, cmd_sleep, 2, false);
+    i2c_write_blocking(I2C_PORT, SHTC3_ADDR, shtc3_cmd_sleep, 2, false);
 
-    if (ret == PICO_ERROR_GENERIC) 
+    if (ret < 0) 
     {
         LOG("[SHTC3] ERROR: Read failed.\n");
         *temp = 0.0f;
         *hum = 0.0f;
+        PROF_EXIT(PROF_SHTC3_READ);
         return;
     }
 
@@ -133,35 +253,75 @@ static void shtc3_read(float *temp, float *hum)
     uint16_t raw_temp = (buffer[0] << 8) | buffer[1];
     uint16_t raw_hum  = (buffer[3] << 8) | buffer[4];
 
-    *temp = -45.0f + 175 * ((float)raw_temp / 65535.0f);
-    *hum = 100.0f * ((float)raw_hum / 65535.0f);
+    *temp = shtc3_raw_to_celsius(raw_temp);
+    *hum = shtc3_raw_to_humidity(raw_hum);
+    PROF_EXIT(PROF_SHTC3_READ);
+}
+
+void shtc3_read(float *temp, float *hum, uint64_t *timestamp_us)
+{
+    shtc3_request();
+    sleep_ms(SHTC3_MEASURE_MS);  // Waiting for measurement to complete
+    shtc3_collect(temp, hum, timestamp_us);
 }
 
-static float mems_sensor_read(uint gpio_pin, float sensitivity_factor) 
+float mems_sensor_read(uint gpio_pin, float sensitivity_factor, uint64_t *timestamp_us) 
 {
+    PROF_ENTER(PROF_MEMS_READ);
     adc_select_input(gpio_pin - 26);
 
     sleep_us(20);
 
     uint16_t raw = adc_read();
+    *timestamp_us = time_us_64();
+    PROF_EXIT(PROF_MEMS_READ);
 
     if (raw < 50) return -1.0f; // Error flag
 
-    float voltage = (float)raw * 3.3f / 4095;
+    return adc_raw_to_ppm(raw, sensitivity_factor);
+}
+
+uint64_t read_all_start(sensor_readings_t* gathered_data) 
+{
+    PROF_ENTER(PROF_READ_ALL);
+
+    // The SHTC3 and O2 conversions run while the ADC and the BMP280 are read.
+    shtc3_request();
+
+    PROF_ENTER(PROF_OXYGEN_READ);
+    o2_requested = oxygen_request() == O2_OK;
+    PROF_EXIT(PROF_OXYGEN_READ);
+    uint32_t wait_ms = (O2_RESPONSE_MS > SHTC3_MEASURE_MS) ? O2_RESPONSE_MS : SHTC3_MEASURE_MS;
+    uint64_t ready_us = time_us_64() + wait_ms * 1000ULL;
+
+    gathered_data->methane_ppm = mems_sensor_read(PIN_METHANE, flash_config()->methane_sensitivity, &gathered_data->methane_us);
+    gathered_data->ammonia_ppm = mems_sensor_read(PIN_AMMONIA, flash_config()->ammonia_sensitivity, &gathered_data->ammonia_us);
+    
+    bmp280_read(&gathered_data->pressure_pa, &gathered_data->altitude_m, &gathered_data->pressure_us);
+
+    PROF_EXIT(PROF_READ_ALL);
+    return ready_us;
+}
+
+void read_all_finish(sensor_readings_t* gathered_data) 
+{
+    PROF_ENTER(PROF_READ_ALL);
+
+    shtc3_collect(&gathered_data->temperature_c, &gathered_data->humidity_pct, &gathered_data->temperature_us);
 
-    float ppm = voltage * sensitivity_factor; 
+    PROF_ENTER(PROF_OXYGEN_READ);
+    if (o2_requested) oxygen_collect(&gathered_data->oxygen_pct);
+    gathered_data->oxygen_us = time_us_64();
+    PROF_EXIT(PROF_OXYGEN_READ);
 
-    return ppm;
+    PROF_EXIT(PROF_READ_ALL);
 }
 
 void read_all(sensor_readings_t* gathered_data) 
 {
-    shtc3_read(&gathered_data->temperature_c, &gathered_data->humidity_pct);
+    uint64_t ready_us = read_all_start(gathered_data);
+    uint64_t now = time_us_64();
 
-    gathered_data->methane_ppm = mems_sensor_read(PIN_METHANE, 100.0f);
-    gathered_data->ammonia_ppm = mems_sensor_read(PIN_AMMONIA, 50.0f);
-    
-    bmp280_read(&gathered_data->pressure_pa,&gathered_data->altitude_m);
-    
-    oxygen_read(&gathered_data->oxygen_pct);
+    if (ready_us > now) sleep_us(ready_us - now);
+    read_all_finish(gathered_data);
 }
@@ -13,9 +13,35 @@
 #include <pico/stdlib.h>
 #include <stdint.h>
 
+// CONFIGURATION MACROS
+
+/** @brief ADC input pins of the MEMS gas sensors (GPIO 26-29 map to ADC inputs 0-3). */
+#define PIN_METHANE 26
+#define PIN_AMMONIA 28
+
+/** @brief Default sensitivity factors of the MEMS gas sensors [ppm/V] (see flash_config.h). */
+#define METHANE_SENSITIVITY 100.0f
+#define AMMONIA_SENSITIVITY 50.0f
+
+/** @brief Default clock of the sensor I2C bus (i2c0) [Hz] (see flash_config.h). */
+#define I2C_BAUD_RATE (100 * 1000)
+
+/** @brief Upper bound on a single I2C transfer [us].
+ * @details Every `i2c_write_blocking`/`i2c_read_blocking` call in the firmware (including
+ * the ones inside the sensor drivers) is redirected at link time (`--wrap`) to its
+ * timeout variant, so a sensor holding the bus cannot stall the main loop.
+ */
+#define I2C_TRANSFER_TIMEOUT_US 10000
+
+/** @brief Duration of one SHTC3 measurement in normal mode [ms]. */
+#define SHTC3_MEASURE_MS 20
+
 // DATA STRUCTURES
 
 /** @brief Structure for keeping all data read from the atmospheric sensors.
+ * @details Every channel carries the `time_us_64()` instant (microseconds since boot)
+ * at which its conversion was completed and read back, so readings taken within the
+ * same second can still be told apart.
 */
 
 typedef struct 
@@ -27,10 +53,39 @@ typedef struct
     float methane_ppm; /// Methane in particles per million
     float ammonia_ppm; /// Ammonia in particles per million
     float oxygen_pct; /// Oxygen percentage
+    uint64_t pressure_us; /// Timestamp of the BMP280 reading (pressure and altitude)
+    uint64_t temperature_us; /// Timestamp of the SHTC3 reading (temperature and humidity)
+    uint64_t methane_us; /// Timestamp of the methane ADC conversion
+    uint64_t ammonia_us; /// Timestamp of the ammonia ADC conversion
+    uint64_t oxygen_us; /// Timestamp of the oxygen reading
 } sensor_readings_t;
 
+/** @brief Devices on the sensor I2C bus, identified by their address. */
+typedef enum
+{
+    I2C_DEV_SHTC3 = 0,
+    I2C_DEV_BMP280,
+    I2C_DEV_O2,
+    I2C_DEV_OTHER, /// Any other address.
+    I2C_DEV_COUNT
+} i2c_device_t;
+
+/** @brief Transfer counters of one I2C device, cumulative since boot. */
+typedef struct
+{
+    uint32_t transfers; /// Reads and writes addressed to the device.
+    uint32_t errors; /// Transfers that failed (address or data not acknowledged).
+    uint32_t timeouts; /// Transfers aborted after `I2C_TRANSFER_TIMEOUT_US`.
+} i2c_device_stats_t;
+
 // FUNCTIONS
 
+/** @brief Per-device transfer counters, indexed by `i2c_device_t`. */
+extern i2c_device_stats_t i2c_device_stats[I2C_DEV_COUNT];
+
+/** @brief Display names of the devices, indexed by `i2c_device_t`. */
+extern const char *const i2c_device_names[I2C_DEV_COUNT];
+
 /** @brief Initializes all sensors with their I2C, SPI or UART connection 
  * (depending on which is necessary).
  * @details Within the function, for every sensor that needs initialization a dedicated function is called.
@@ -40,12 +95,62 @@ typedef struct
 
 extern void init_all_sensors(void);
 
+/** @brief Sets up the I2C and ADC connections again after a warm restart (warm_restart.h).
+ * @details The sensors stayed powered through the reset of the Pico and keep their
+ * configuration, so they are not brought up again; a device the reset caught in the middle
+ * of a transfer is released by clocking the bus first.
+ */
+extern void resume_all_sensors(void);
+
 /** @brief Begins readings from all the atmospheric sensors.
  * @details Within the function, for every sensor a dedicated _read function is called.
- * The data read is then immediately saved in a dedicated structure.
+ * The data read is then immediately saved in a dedicated structure, together with
+ * the moment each reading was completed.
  ** @param[out] gathered_data Pointer to the an object of a 'sensor_readings_t' structure,
  * to which data read from sensors is immediatly saved to.
  */
 extern void read_all(sensor_readings_t *gathered_data);
 
+/** @brief First half of `read_all()`, for callers that have other work to do during the conversions.
+ * @details Starts the SHTC3 and O2 conversions, then reads the MEMS sensors and the BMP280.
+ * The bus is free again on return; `read_all_finish()` completes the reading.
+ ** @param[out] gathered_data Structure that receives the pressure and gas readings.
+ ** @return `time_us_64()` instant from which `read_all_finish()` can fetch the conversions.
+ */
+extern uint64_t read_all_start(sensor_readings_t *gathered_data);
+
+/** @brief Second half of `read_all()`: fetches the SHTC3 and O2 readings started by `read_all_start()`.
+ ** @param[out] gathered_data The structure passed to `read_all_start()`.
+ */
+extern void read_all_finish(sensor_readings_t *gathered_data);
+
+/** @brief Reads pressure from the BMP280 and converts it into altitude.
+ ** @param[out] pressure Pressure in Pascals, -1 on a bus error.
+ ** @param[out] altitude Altitude in meters, -1 on a bus error.
+ ** @param[out] timestamp_us Time at which the reading was completed.
+ */
+extern void bmp280_read(double *pressure, double *altitude, uint64_t *timestamp_us);
+
+/** @brief Wakes the SHTC3, runs one measurement (`SHTC3_MEASURE_MS`) and puts it back to sleep.
+ ** @param[out] temp Temperature in Celsius degrees, 0 on a bus error.
+ ** @param[out] hum Relative humidity percentage, 0 on a bus error.
+ ** @param[out] timestamp_us Time at which the reading was completed.
+ */
+extern void shtc3_read(float *temp, float *hum, uint64_t *timestamp_us);
+
+/** @brief The two halves of `shtc3_read()`: wake the SHTC3 and start a measurement, then,
+ * `SHTC3_MEASURE_MS` later, fetch it and put the sensor back to sleep.
+ */
+extern void shtc3_request(void);
+
+extern void shtc3_collect(float *temp, float *hum, uint64_t *timestamp_us);
+
+/** @brief Samples one MEMS gas sensor on the ADC.
+ ** @param[in] gpio_pin ADC-capable GPIO the sensor is wired to (`PIN_METHANE`, `PIN_AMMONIA`).
+ ** @param[in] sensitivity_factor Sensor sensitivity [ppm/V].
+ ** @param[out] timestamp_us Time at which the conversion was completed.
+ ** @return Gas concentration in ppm, or -1 if the reading is implausibly low.
+ */
+extern float mems_sensor_read(uint gpio_pin, float sensitivity_factor, uint64_t *timestamp_us);
+
 #endif // ATM_SEN_MODULE_H
\ No newline at end of file
@@ -0,0 +1,179 @@
+/** @file bench_main.c
+ ** @brief Entry point of the CS_Bench firmware: on-target cycle counts of drivers and kernels.
+ * @details Runs every sensor driver, the SD append path and the per-sample compute kernels
+ * in a loop, times each call with the DWT cycle counter and prints min/median/max cycles
+ * over USB CDC as CSV:
+ *
+ *     # CS_Bench clk_sys=150000000 overhead=<cycles>
+ *     kernel,samples,min_cycles,median_cycles,max_cycles
+ *     bmp280_read,51,...
+ *     # end
+ *
+ * The timing overhead (two counter reads) is measured once and subtracted. `min` is the
+ * warm-cache cost; `max` includes XIP flash cache misses and interrupts (USB).
+ * The suite starts once a terminal is connected and runs again on any received character.
+ ** @note The SD kernels append to the flight log files; use a scratch card.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "cycle_counter.h"
+#include "atm_sen_module.h"
+#include "sensor_conversion.h"
+#include "microsd_module.h"
+#include "time_manager.h"
+#include "gps_module.h"
+#include "ubx_protocol.h"
+#include "minmea.h"
+#include "lib/bmp280/bmp280_i2c.h"
+#include "dfrobot_oxygen.h"
+
+/** @brief Samples per kernel for calls that wait on a bus or a sensor conversion. */
+#define BUS_SAMPLES 51
+
+/** @brief Samples per kernel for pure computation. */
+#define COMPUTE_SAMPLES 501
+
+static uint32_t samples[COMPUTE_SAMPLES];
+static uint32_t overhead;
+
+static volatile double sink_d;
+static volatile int sink_i;
+static volatile uint32_t input_index;
+
+static const char *rmc_sentence = "$GNRMC,092751.000,A,5321.6802,N,00630.3371,W,0.06,31.66,280511,,,A*45";
+static const char *gga_sentence = "$GNGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.2,M,,*76";
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, int n)
+{
+    for (int k = 0; k < n; k++) samples[k] = (samples[k] > overhead) ? samples[k] - overhead : 0;
+    qsort(samples, n, sizeof(samples[0]), compare_u32);
+    printf("%s,%d,%lu,%lu,%lu\n", name, n,
+           (unsigned long)samples[0], (unsigned long)samples[n / 2], (unsigned long)samples[n - 1]);
+}
+
+/** @brief Times `n` calls of `body` one by one and prints the CSV row. */
+#define BENCH(name, n, body) \
+    do \
+    { \
+        for (int k = 0; k < (n); k++) \
+        { \
+            uint32_t c0 = cycle_counter_read(); \
+            body; \
+            samples[k] = cycle_counter_read() - c0; \
+        } \
+        report(name, n); \
+    } while (0)
+
+static void measure_overhead(void)
+{
+    overhead = UINT32_MAX;
+    for (int k = 0; k < COMPUTE_SAMPLES; k++)
+    {
+        uint32_t c0 = cycle_counter_read();
+        uint32_t c1 = cycle_counter_read();
+        if (c1 - c0 < overhead) overhead = c1 - c0;
+    }
+}
+
+static void run_suite(void)
+{
+    sensor_readings_t readings = {0};
+    current_time_t now;
+    gps_data_t fix = {0};
+    uint64_t ts;
+
+    read_all(&readings);
+    time_manager_get(&now);
+
+    uint8_t pvt_frame[UBX_NAV_PVT_LEN + UBX_FRAME_OVERHEAD];
+    uint8_t pvt_payload[UBX_NAV_PVT_LEN] = {0};
+    uint16_t pvt_len = ubx_build_frame(pvt_frame, UBX_CLASS_NAV, UBX_ID_NAV_PVT, pvt_payload, UBX_NAV_PVT_LEN);
+    ubx_parser_t ubx;
+    ubx_parser_init(&ubx);
+
+    struct minmea_sentence_rmc rmc;
+    minmea_parse_rmc(&rmc, rmc_sentence);
+
+    char line[160];
+
+    measure_overhead();
+    printf("# CS_Bench clk_sys=%lu overhead=%lu\n", (unsigned long)clock_get_hz(clk_sys), (unsigned long)overhead);
+    printf("kernel,samples,min_cycles,median_cycles,max_cycles\n");
+
+    // Drivers (real bus transactions)
+    BENCH("bmp280_read", BUS_SAMPLES, bmp280_read(&readings.pressure_pa, &readings.altitude_m, &ts));
+    BENCH("bmp280_i2c_read_data", BUS_SAMPLES, {
+        bmp280_data_t dt;
+        sink_i += bmp280_i2c_read_data(&dt);
+    });
+    BENCH("bmp280_raw_registers", BUS_SAMPLES, {
+        int32_t press_raw;
+        int32_t temp_raw;
+        sink_i += bmp280_i2c_read_pressure_r(&press_raw) + bmp280_i2c_read_temperature_r(&temp_raw);
+    });
+    BENCH("shtc3_read", BUS_SAMPLES, shtc3_read(&readings.temperature_c, &readings.humidity_pct, &ts));
+    BENCH("mems_sensor_read", BUS_SAMPLES, sink_d += mems_sensor_read(PIN_METHANE, METHANE_SENSITIVITY, &ts));
+    BENCH("oxygen_read", BUS_SAMPLES, oxygen_read(&readings.oxygen_pct));
+    BENCH("save_system_data", BUS_SAMPLES, save_system_data(&readings, &now));
+    BENCH("save_gps_log", BUS_SAMPLES, save_gps_log(&fix));
+
+    // Pure computation
+    BENCH("pressure_to_altitude", COMPUTE_SAMPLES, sink_d += pressure_to_altitude(90000.0 + input_index));
+    BENCH("shtc3_conversion", COMPUTE_SAMPLES, {
+        uint16_t raw = (uint16_t)(25000 + input_index);
+        sink_d += shtc3_raw_to_celsius(raw) + shtc3_raw_to_humidity(raw);
+    });
+    BENCH("minmea_check", COMPUTE_SAMPLES, sink_i += minmea_check(rmc_sentence, true));
+    BENCH("minmea_parse_rmc", COMPUTE_SAMPLES, sink_i += minmea_parse_rmc(&rmc, rmc_sentence));
+    BENCH("minmea_parse_gga", COMPUTE_SAMPLES, {
+        struct minmea_sentence_gga gga;
+        sink_i += minmea_parse_gga(&gga, gga_sentence);
+    });
+    BENCH("minmea_tocoord", COMPUTE_SAMPLES, sink_d += minmea_tocoord(&rmc.latitude));
+    BENCH("minmea_tocoord_e7", COMPUTE_SAMPLES, sink_i += minmea_tocoord_e7(&rmc.latitude));
+    BENCH("ubx_nav_pvt_frame", COMPUTE_SAMPLES, {
+        for (uint16_t b = 0; b < pvt_len; b++) sink_i += ubx_parser_feed(&ubx, pvt_frame[b]);
+    });
+    BENCH("time_manager_get", COMPUTE_SAMPLES, {
+        time_manager_get(&now);
+        sink_i += now.sec;
+    });
+    BENCH("snprintf_data_log_line", COMPUTE_SAMPLES, {
+        sink_i += snprintf(line, sizeof(line), "[%02d:%02d:%02d] [BMP280] t=" TIME_US_FMT " s | Pressure: %.2f Pa | Altitude: %.2f m\n",
+                           now.hour, now.min, now.sec, TIME_US_ARGS(readings.pressure_us),
+                           readings.pressure_pa, readings.altitude_m);
+    });
+
+    printf("# end\n");
+}
+
+int main(void)
+{
+    stdio_init_all();
+    cycle_counter_init();
+
+    time_manager_init();
+    init_all_sensors();
+    sd_init();
+
+    while (1)
+    {
+        while (!stdio_usb_connected()) sleep_ms(100);
+
+        run_suite();
+
+        // Run again on any received character.
+        while (getchar_timeout_us(1000000) == PICO_ERROR_TIMEOUT) tight_loop_contents();
+    }
+}
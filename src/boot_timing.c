@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "boot_timing.h"
+#include "debug_mode.h"
+#include "time_manager.h"
+
+boot_timing_t boot_timing;
+
+const char *const boot_step_names[BOOT_STEP_COUNT] = {
+    [BOOT_USB_WAIT] = "usb_wait",
+    [BOOT_SENSORS] = "sensors",
+    [BOOT_RADIO] = "radio",
+    [BOOT_GPS] = "gps",
+};
+
+static uint64_t step_start_us = 0;
+
+void boot_timing_begin(boot_step_t step)
+{
+    (void)step;
+    step_start_us = time_us_64();
+}
+
+void boot_timing_end(boot_step_t step)
+{
+    uint64_t duration = time_us_64() - step_start_us;
+
+    boot_timing.step_us[step] = (duration > UINT32_MAX) ? UINT32_MAX : (uint32_t)duration;
+}
+
+void boot_timing_first_sample(void)
+{
+    if (boot_timing.first_sample_us == 0) boot_timing.first_sample_us = time_us_64();
+}
+
+void boot_timing_log(void)
+{
+    LOG("[Boot] Warm restarts %lu; first sample at " TIME_US_FMT " s;",
+        (unsigned long)boot_timing.warm_restarts, TIME_US_ARGS(boot_timing.first_sample_us));
+    for (int step = 0; step < BOOT_STEP_COUNT; step++)
+    {
+        LOG(" %s %lu us", boot_step_names[step], (unsigned long)boot_timing.step_us[step]);
+    }
+    LOG("\n");
+}
@@ -0,0 +1,66 @@
+/** @file boot_timing.h
+ ** @brief Boot time per subsystem and time to the first sample.
+ * @details After a reset in flight every second of boot is a second without data, so
+ * `main()` times each start-up step with `boot_timing_begin()` / `boot_timing_end()` and
+ * marks the first sensor reading with `boot_timing_first_sample()`. All times count from
+ * reset (`time_us_64()` starts at 0).
+ *
+ * The boot order is chosen for an early first sample: the sensors and the radio come up
+ * first and the main loop samples right away; the card is mounted by the first save and
+ * the GNSS receiver, whose configuration takes longest, is set up after the first record,
+ * one step per loop iteration.
+ * Once that is done the figures are logged and appended to 'boot_log.csv' by
+ * `save_boot_log()`, one row per boot. A warm restart (warm_restart.h) skips most of this.
+ */
+
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include <stdint.h>
+
+// CONFIGURATION MACROS
+
+/** @brief Longest wait for a USB host to open the console at boot, when VBUS is present [ms]. */
+#define BOOT_USB_WAIT_MS 5000
+
+// DATA STRUCTURES
+
+/** @brief Timed start-up steps, in boot order. */
+typedef enum
+{
+    BOOT_USB_WAIT = 0, /// Waiting for the USB console (only with VBUS present, cold boot only)
+    BOOT_SENSORS, /// init_all_sensors(), or resume_all_sensors() on a warm restart
+    BOOT_RADIO, /// radio_module_init()
+    BOOT_GPS, /// gps_init() after the first record until gps_configure_step() is done, or gps_resume() on a warm restart
+    BOOT_STEP_COUNT
+} boot_step_t;
+
+/** @brief Boot figures of the current run. */
+typedef struct
+{
+    uint32_t step_us[BOOT_STEP_COUNT]; /// Duration of each step.
+    uint64_t first_sample_us; /// Time from reset to the first sensor reading (0: none yet).
+    uint32_t warm_restarts; /// Warm restarts since the last cold boot (0: this is a cold boot).
+} boot_timing_t;
+
+// FUNCTIONS
+
+/** @brief Boot figures, filled as the steps complete. */
+extern boot_timing_t boot_timing;
+
+/** @brief Display names of the steps, indexed by `boot_step_t`. */
+extern const char *const boot_step_names[BOOT_STEP_COUNT];
+
+/** @brief Starts timing a step. */
+extern void boot_timing_begin(boot_step_t step);
+
+/** @brief Stops timing the step started last and stores its duration. */
+extern void boot_timing_end(boot_step_t step);
+
+/** @brief Records the time of the first sensor reading; later calls are ignored. */
+extern void boot_timing_first_sample(void);
+
+/** @brief Logs the boot figures (`LOG`). */
+extern void boot_timing_log(void);
+
+#endif // BOOT_TIMING_H
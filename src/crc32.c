@@ -0,0 +1,19 @@
+#include "crc32.h"
+
+#define CRC32_POLY_REFLECTED 0xEDB88320u
+
+uint32_t crc32_compute(const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (CRC32_POLY_REFLECTED & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
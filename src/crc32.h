@@ -0,0 +1,21 @@
+/** @file crc32.h
+ ** @brief CRC-32 (IEEE 802.3, the zlib one) of records kept across resets.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FUNCTIONS
+
+/** @brief Computes the CRC-32 of a buffer.
+ * @details Bitwise, without a table: the records it protects are a few dozen bytes.
+ ** @param[in] data Bytes to check.
+ ** @param[in] len Number of bytes.
+ ** @return CRC-32 of `data` (0 for an empty buffer).
+ */
+extern uint32_t crc32_compute(const void *data, size_t len);
+
+#endif // CRC32_H
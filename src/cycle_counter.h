@@ -0,0 +1,47 @@
+/** @file cycle_counter.h
+ ** @brief Cortex-M33 DWT cycle counter access.
+ * @details The Data Watchpoint and Trace unit has a free-running 32-bit counter of core
+ * clock cycles (`DWT_CYCCNT`). Reading it is a single load, so it can time anything from
+ * a few instructions up to ~28 s at 150 MHz before the counter wraps. Differences of two
+ * readings taken with unsigned 32-bit arithmetic are correct across one wrap.
+ * Each core has its own DWT, so a counter must be read on the core that enabled it.
+ ** @see Armv8-M Architecture Reference Manual, "DWT" and "DEMCR".
+ */
+
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+// CONFIGURATION MACROS
+
+/** @brief Debug Exception and Monitor Control Register; TRCENA powers the DWT. */
+#define CYCLE_DEMCR (*(volatile uint32_t *)0xE000EDFCu)
+#define CYCLE_DEMCR_TRCENA (1u << 24)
+
+/** @brief DWT control register; CYCCNTENA starts the cycle counter. */
+#define CYCLE_DWT_CTRL (*(volatile uint32_t *)0xE0001000u)
+#define CYCLE_DWT_CTRL_CYCCNTENA (1u << 0)
+
+/** @brief DWT cycle count register. */
+#define CYCLE_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+
+// FUNCTIONS
+
+/** @brief Enables and resets the cycle counter of the calling core.
+ * @note Safe to call more than once; a debugger attached over SWD may also have enabled it.
+ */
+static inline void cycle_counter_init(void)
+{
+    CYCLE_DEMCR |= CYCLE_DEMCR_TRCENA;
+    CYCLE_DWT_CYCCNT = 0;
+    CYCLE_DWT_CTRL |= CYCLE_DWT_CTRL_CYCCNTENA;
+}
+
+/** @brief Returns the current core cycle count. */
+static inline uint32_t cycle_counter_read(void)
+{
+    return CYCLE_DWT_CYCCNT;
+}
+
+#endif // CYCLE_COUNTER_H
@@ -11,7 +11,10 @@
 
 #include <stdio.h>
 
+// Host tools that run the firmware's modules define CS_QUIET to keep the log out of their reports.
+#ifndef CS_QUIET
 #define DEBUG_MODE
+#endif
 
 #ifdef DEBUG_MODE
     #define LOG(...) printf(__VA_ARGS__)
@@ -0,0 +1,63 @@
+#include "e2e_latency.h"
+
+typedef struct
+{
+    uint32_t window[E2E_WINDOW];
+    uint32_t count;
+    uint32_t max_us;
+} e2e_path_stats_t;
+
+static e2e_path_stats_t paths[E2E_PATH_COUNT];
+
+const char *const e2e_path_names[E2E_PATH_COUNT] = {
+    [E2E_SENSORS_SD] = "sensors_sd",
+    [E2E_GPS_SD] = "gps_sd",
+    [E2E_SENSORS_RADIO] = "sensors_radio",
+    [E2E_GPS_RADIO] = "gps_radio",
+};
+
+void e2e_latency_record(e2e_path_t path, uint64_t sample_us, uint64_t done_us)
+{
+    e2e_path_stats_t *p = &paths[path];
+    uint64_t age = (done_us > sample_us) ? done_us - sample_us : 0;
+    uint32_t us = (age > UINT32_MAX) ? UINT32_MAX : (uint32_t)age;
+
+    p->window[p->count % E2E_WINDOW] = us;
+    p->count++;
+    if (us > p->max_us) p->max_us = us;
+}
+
+// Nearest-rank percentile of a sorted array.
+static uint32_t percentile(const uint32_t *sorted, uint32_t n, uint32_t pct)
+{
+    uint32_t rank = (pct * n + 99) / 100;
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+void e2e_latency_summary(e2e_path_t path, e2e_summary_t *out)
+{
+    const e2e_path_stats_t *p = &paths[path];
+    uint32_t n = (p->count < E2E_WINDOW) ? p->count : E2E_WINDOW;
+    uint32_t sorted[E2E_WINDOW];
+
+    *out = (e2e_summary_t){ .count = p->count, .max_us = p->max_us };
+    if (n == 0) return;
+
+    // Insertion sort: the window is small and this runs once per log period.
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t v = p->window[i];
+        uint32_t j = i;
+
+        while (j > 0 && sorted[j - 1] > v)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    out->p50_us = percentile(sorted, n, 50);
+    out->p90_us = percentile(sorted, n, 90);
+    out->p99_us = percentile(sorted, n, 99);
+}
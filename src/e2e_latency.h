@@ -0,0 +1,64 @@
+/** @file e2e_latency.h
+ ** @brief End-to-end data latency: from acquisition to durable-on-card and on-air.
+ * @details Every reading carries its acquisition timestamp (`time_us_64()`) through the
+ * pipeline (`sensor_readings_t`, `gps_data_t`). When a record is committed to the microSD card
+ * (its file closed, hence synced) or its radio frame has been sent, the SD and radio layers
+ * stamp the completion time and record the difference here, per path.
+ *
+ * For each path the last `E2E_WINDOW` latencies are kept, so the percentiles describe the
+ * recent state of the pipeline; the count and the maximum are cumulative since boot.
+ * The SD latency bounds how much data a power failure can take with it, the on-air latency
+ * tells the ground station how old the telemetry it shows is.
+ */
+
+#ifndef E2E_LATENCY_H
+#define E2E_LATENCY_H
+
+#include <stdint.h>
+
+// CONFIGURATION MACROS
+
+/** @brief Number of most recent latencies kept per path. */
+#define E2E_WINDOW 128
+
+// DATA STRUCTURES
+
+/** @brief Data paths from acquisition to a sink. */
+typedef enum
+{
+    E2E_SENSORS_SD = 0, /// Oldest reading of a 'data_log.txt' record -> file closed.
+    E2E_GPS_SD, /// GPS fix -> 'gps_log.csv' closed.
+    E2E_SENSORS_RADIO, /// BMP280 reading -> telemetry frame sent.
+    E2E_GPS_RADIO, /// GPS fix -> position frame sent.
+    E2E_PATH_COUNT
+} e2e_path_t;
+
+/** @brief Latency summary of one path [us]. */
+typedef struct
+{
+    uint32_t count; /// Records delivered since boot.
+    uint32_t p50_us; /// Median over the window.
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us; /// Slowest since boot.
+} e2e_summary_t;
+
+// FUNCTIONS
+
+/** @brief Display names of the paths, indexed by `e2e_path_t`. */
+extern const char *const e2e_path_names[E2E_PATH_COUNT];
+
+/** @brief Records one delivered record.
+ ** @param[in] path Path the record took.
+ ** @param[in] sample_us Acquisition timestamp of the record.
+ ** @param[in] done_us `time_us_64()` at which the record became durable or was sent.
+ */
+extern void e2e_latency_record(e2e_path_t path, uint64_t sample_us, uint64_t done_us);
+
+/** @brief Computes the latency summary of one path (sorts a copy of its window).
+ ** @param[in] path Path to summarize.
+ ** @param[out] out Summary; the percentiles are 0 until a record has been delivered.
+ */
+extern void e2e_latency_summary(e2e_path_t path, e2e_summary_t *out);
+
+#endif // E2E_LATENCY_H
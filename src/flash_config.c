@@ -0,0 +1,129 @@
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "flash_config.h"
+#include "flash_io.h"
+#include "atm_sen_module.h"
+#include "time_manager.h"
+#include "debug_mode.h"
+#include "crc32.h"
+#include "lib/nRF905/nRF905.h"
+
+_Static_assert(sizeof(flash_config_t) == NRF905_PAYLOAD_SIZE, "the block must fill one radio payload");
+
+static const flash_config_t defaults = {
+    .magic = FLASH_CONFIG_MAGIC,
+    .version = FLASH_CONFIG_VERSION,
+    .sample_period_s = SAMPLE_PERIOD_S_DEFAULT,
+    .i2c_baud_hz = I2C_BAUD_RATE,
+    .spi_baud_hz = SPI_BAUD_RATE_DEFAULT,
+    .methane_sensitivity = METHANE_SENSITIVITY,
+    .ammonia_sensitivity = AMMONIA_SENSITIVITY,
+    .timezone_offset_h = TIMEZONE_OFFSET,
+    .radio_channel = RADIO_CHANNEL_DEFAULT,
+};
+
+static const flash_config_t *active = &defaults;
+
+// The block in use, once the sector it was read from is rewritten.
+static flash_config_t in_use;
+
+static const flash_config_t *stored(void)
+{
+    return flash_io_xip(FLASH_CONFIG_OFFSET);
+}
+
+static uint32_t block_crc(const flash_config_t *cfg)
+{
+    return crc32_compute(cfg, offsetof(flash_config_t, crc));
+}
+
+bool flash_config_valid(const flash_config_t *cfg)
+{
+    return cfg->magic == FLASH_CONFIG_MAGIC &&
+           cfg->version == FLASH_CONFIG_VERSION &&
+           cfg->crc == block_crc(cfg) &&
+           cfg->sample_period_s >= 1 && cfg->sample_period_s <= 60 &&
+           cfg->i2c_baud_hz >= 10000 && cfg->i2c_baud_hz <= 1000000 &&
+           cfg->spi_baud_hz >= 100000 && cfg->spi_baud_hz <= 25000000 &&
+           isfinite(cfg->methane_sensitivity) && cfg->methane_sensitivity > 0 &&
+           isfinite(cfg->ammonia_sensitivity) && cfg->ammonia_sensitivity > 0 &&
+           cfg->timezone_offset_h >= -12 && cfg->timezone_offset_h <= 14 &&
+           cfg->radio_channel <= 511;
+}
+
+bool flash_config_init(const flash_config_t *resume)
+{
+    // The retained state is checked by its own CRC (a run on the defaults has no block CRC).
+    if (resume)
+    {
+        in_use = *resume;
+        active = &in_use;
+        LOG("[Config] Kept from before the warm restart\n");
+        return memcmp(resume, &defaults, sizeof(defaults)) != 0;
+    }
+
+    bool from_flash = flash_config_valid(stored());
+
+    active = from_flash ? stored() : &defaults;
+    LOG("[Config] %s\n", from_flash ? "Loaded from flash" : "No valid block in flash, using defaults");
+    return from_flash;
+}
+
+const flash_config_t *flash_config(void)
+{
+    return active;
+}
+
+bool flash_config_write(const flash_config_t *cfg)
+{
+    if (!flash_config_valid(cfg)) return false;
+    if (memcmp(stored(), cfg, sizeof(*cfg)) == 0) return true;
+
+    // The values in use stay as they are until the next boot.
+    if (active == stored())
+    {
+        in_use = *stored();
+        active = &in_use;
+    }
+
+    // Programming works on whole pages; the rest of the page stays erased.
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, cfg, sizeof(*cfg));
+
+    flash_io_erase(FLASH_CONFIG_OFFSET, FLASH_SECTOR_SIZE);
+    flash_io_program(FLASH_CONFIG_OFFSET, page, sizeof(page));
+
+    return memcmp(stored(), cfg, sizeof(*cfg)) == 0;
+}
+
+flash_config_result_t flash_config_receive(const uint8_t *packet, bool writable, uint32_t *crc)
+{
+    flash_config_t cfg;
+
+    memcpy(&cfg, packet, sizeof(cfg));
+    if (cfg.magic != FLASH_CONFIG_MAGIC) return FLASH_CONFIG_NOT_A_BLOCK;
+
+    *crc = cfg.crc;
+    if (!writable)
+    {
+        LOG("[Config] Block %08lx from the ground refused in flight\n", (unsigned long)cfg.crc);
+        return FLASH_CONFIG_LOCKED;
+    }
+    if (!flash_config_valid(&cfg))
+    {
+        LOG("[Config] Block %08lx from the ground rejected\n", (unsigned long)cfg.crc);
+        return FLASH_CONFIG_REJECTED;
+    }
+    if (!flash_config_write(&cfg))
+    {
+        LOG("[Config] Block %08lx from the ground: flash write failed\n", (unsigned long)cfg.crc);
+        return FLASH_CONFIG_WRITE_FAILED;
+    }
+
+    LOG("[Config] Block %08lx from the ground stored, used from the next boot\n", (unsigned long)cfg.crc);
+    return FLASH_CONFIG_STORED;
+}
@@ -0,0 +1,110 @@
+/** @file flash_config.h
+ ** @brief Per-flight configuration kept in the last sector of flash.
+ * @details The tunable values of the firmware (sampling period, bus clocks, timezone, gas
+ * sensor sensitivities, radio channel) are read at boot from a block in the last flash
+ * sector, straight through the XIP window: no SD card mount, no file to parse. The block
+ * carries a magic number, a layout version and a CRC-32; a sector that holds none (a fresh
+ * board, or a block of another layout) gives the compiled-in defaults, which are the
+ * `*_DEFAULT` macros and the constants of the modules using them.
+ *
+ * The block is rewritten from the ground over the radio: it is exactly one nRF905 payload, so
+ * the ground station sends the whole block, CRC included, as one packet
+ * (`radio_module_poll()`). A valid block with values in range is programmed into flash and
+ * acknowledged, but only on the pad or after landing: a CRC does not prove the ground station
+ * sent the packet, and nothing may change the settings of a flight once it is under way. The
+ * new values take effect at the next cold boot, which keeps the buses and the radio link as
+ * they are for the rest of the current run; a warm restart carries on with the configuration
+ * the run booted with (warm_restart.h).
+ */
+
+#ifndef FLASH_CONFIG_H
+#define FLASH_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+
+// CONFIGURATION MACROS
+
+/** @brief Offset of the configuration block from the start of flash: the last sector. */
+#define FLASH_CONFIG_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
+/** @brief First word of the block: "CFG!" in memory order. */
+#define FLASH_CONFIG_MAGIC 0x21474643u
+
+/** @brief Layout version; blocks of another version are ignored. */
+#define FLASH_CONFIG_VERSION 1
+
+/** @brief Defaults of the values that have no module constant. */
+#define SAMPLE_PERIOD_S_DEFAULT 1
+#define SPI_BAUD_RATE_DEFAULT (1000 * 1000)
+#define RADIO_CHANNEL_DEFAULT 0x6C
+
+// DATA STRUCTURES
+
+/** @brief Outcome of a packet from the ground passed to `flash_config_receive()`. */
+typedef enum
+{
+    FLASH_CONFIG_NOT_A_BLOCK = 0, /// No configuration magic: the packet is something else.
+    FLASH_CONFIG_STORED, /// The block is in flash, for the next boot.
+    FLASH_CONFIG_REJECTED, /// Wrong version or CRC, or a value out of range.
+    FLASH_CONFIG_WRITE_FAILED, /// Flash did not read back the block.
+    FLASH_CONFIG_LOCKED, /// Not taken: the configuration is locked during the flight.
+} flash_config_result_t;
+
+/** @brief Configuration block, as stored in flash and sent over the radio (32 bytes, no padding). */
+typedef struct
+{
+    uint32_t magic; /// `FLASH_CONFIG_MAGIC`.
+    uint16_t version; /// `FLASH_CONFIG_VERSION`.
+    uint16_t sample_period_s; /// Seconds between two sensor samples and records (1-60).
+    uint32_t i2c_baud_hz; /// Clock of the sensor I2C bus (10 kHz-1 MHz).
+    uint32_t spi_baud_hz; /// Clock of spi0, shared by the microSD card and the radio (100 kHz-25 MHz).
+    float methane_sensitivity; /// Methane sensor sensitivity [ppm/V].
+    float ammonia_sensitivity; /// Ammonia sensor sensitivity [ppm/V].
+    int8_t timezone_offset_h; /// Local time offset from UTC applied to the GPS time [h] (-12 to 14).
+    uint8_t reserved; /// 0.
+    uint16_t radio_channel; /// nRF905 channel number CH_NO (0-511).
+    uint32_t crc; /// CRC-32 of the fields above.
+} flash_config_t;
+
+// FUNCTIONS
+
+/** @brief Selects the configuration at boot: the block in flash if it is valid, else the defaults.
+ * @details Call first in `main()`, before any module reads `flash_config()`.
+ ** @param[in] resume Configuration the run booted with, kept across a warm restart (a copy is
+ * used, whatever flash holds now); NULL on a cold boot.
+ ** @return true if the block in flash, or the one resumed, is used.
+ */
+extern bool flash_config_init(const flash_config_t *resume);
+
+/** @brief The configuration in use.
+ * @details Points into the XIP window when the block in flash is valid: reading it costs a
+ * (cached) flash read, no copy is kept in RAM.
+ */
+extern const flash_config_t *flash_config(void);
+
+/** @brief Checks a block: magic, version, CRC and the range of every value.
+ ** @param[in] cfg Block to check.
+ ** @return true if the block can be used.
+ */
+extern bool flash_config_valid(const flash_config_t *cfg);
+
+/** @brief Programs a valid block into the last flash sector, unless flash already holds it.
+ * @details Erasing the sector stalls the processor for tens of milliseconds (flash_io.h);
+ * the configuration in use does not change before the next boot.
+ ** @param[in] cfg Block to store; its CRC must be set.
+ ** @return true if flash holds `cfg` afterwards.
+ */
+extern bool flash_config_write(const flash_config_t *cfg);
+
+/** @brief Takes a packet received from the ground: a configuration block is checked and written.
+ ** @param[in] packet Received payload (`NRF905_PAYLOAD_SIZE` bytes).
+ ** @param[in] writable The block may be stored now (on the pad or landed); otherwise it is refused.
+ ** @param[out] crc CRC field of the block, to acknowledge it.
+ ** @return What was done with the packet.
+ */
+extern flash_config_result_t flash_config_receive(const uint8_t *packet, bool writable, uint32_t *crc);
+
+#endif // FLASH_CONFIG_H
@@ -0,0 +1,78 @@
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "flash_io.h"
+#include "gps_module.h"
+#include "trace.h"
+
+flash_io_stats_t flash_io_stats;
+
+/** @brief Interrupt lines disabled around a flash operation, one bit per line. */
+typedef struct
+{
+    uint64_t lines;
+    uint32_t status; /// Masking state, with `TRACING`.
+} irq_state_t;
+
+static irq_state_t quiet_begin(void)
+{
+    irq_state_t state = {0};
+
+#if TRACING
+    state.status = save_and_disable_interrupts();
+#else
+    for (uint irq = 0; irq < NUM_IRQS; irq++)
+    {
+        if (irq == UART_IRQ_NUM(GPS_UART_ID) || !irq_is_enabled(irq)) continue;
+
+        irq_set_enabled(irq, false);
+        state.lines |= 1ULL << irq;
+    }
+#endif
+    return state;
+}
+
+static void quiet_end(irq_state_t state)
+{
+#if TRACING
+    restore_interrupts(state.status);
+#else
+    for (uint irq = 0; irq < NUM_IRQS; irq++)
+    {
+        if (state.lines & (1ULL << irq)) irq_set_enabled(irq, true);
+    }
+#endif
+}
+
+static void record(uint32_t *worst_us, uint64_t start_us)
+{
+    uint64_t duration = time_us_64() - start_us;
+
+    if (duration > *worst_us) *worst_us = (duration > UINT32_MAX) ? UINT32_MAX : (uint32_t)duration;
+}
+
+void flash_io_erase(uint32_t offset, uint32_t size)
+{
+    irq_state_t state = quiet_begin();
+    uint64_t start = time_us_64();
+
+    flash_range_erase(offset, size);
+
+    record(&flash_io_stats.worst_erase_us, start);
+    quiet_end(state);
+    flash_io_stats.erases += size / FLASH_SECTOR_SIZE;
+}
+
+void flash_io_program(uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    irq_state_t state = quiet_begin();
+    uint64_t start = time_us_64();
+
+    flash_range_program(offset, data, size);
+
+    record(&flash_io_stats.worst_program_us, start);
+    quiet_end(state);
+    flash_io_stats.programs += size / FLASH_PAGE_SIZE;
+}
@@ -0,0 +1,62 @@
+/** @file flash_io.h
+ ** @brief Erase and program of the QSPI flash while the firmware keeps running.
+ * @details The firmware executes from the same flash through XIP: while a sector is erased
+ * (tens of milliseconds, up to 400 ms on a worn chip) or a page programmed (under a
+ * millisecond, 3 ms at most), no code or constant may be fetched from it, so the processor
+ * only waits inside the SDK routines, which run from RAM.
+ *
+ * Masking every interrupt for that long would overflow the 32-byte UART FIFO of the GNSS
+ * receiver at 115200 baud within 3 ms. Instead the GNSS receive interrupt, which is placed in
+ * RAM and touches nothing in flash (gps_module.c), stays on; every other interrupt line is
+ * disabled for the duration of the operation and restored afterwards. A build with
+ * `TRACING` calls the tracer, which lives in flash, from that interrupt, so there every
+ * interrupt is masked.
+ *
+ * Offsets count from the start of flash; erases are whole sectors and programs whole pages
+ * (`FLASH_SECTOR_SIZE`, `FLASH_PAGE_SIZE`). Both are timed into `flash_io_stats`.
+ */
+
+#ifndef FLASH_IO_H
+#define FLASH_IO_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+
+// DATA STRUCTURES
+
+/** @brief Operation counters and worst durations, cumulative since boot. */
+typedef struct
+{
+    uint32_t erases; /// Sectors erased.
+    uint32_t programs; /// Pages programmed.
+    uint32_t worst_erase_us; /// Longest sector erase.
+    uint32_t worst_program_us; /// Longest page program.
+} flash_io_stats_t;
+
+// FUNCTIONS
+
+/** @brief Counters of the operations done so far. */
+extern flash_io_stats_t flash_io_stats;
+
+/** @brief Address of a flash offset in the XIP window. */
+static inline const void *flash_io_xip(uint32_t offset)
+{
+    return (const void *)(XIP_BASE + offset);
+}
+
+/** @brief Erases whole sectors (to 0xFF).
+ ** @param[in] offset Start, a multiple of `FLASH_SECTOR_SIZE`.
+ ** @param[in] size Length, a multiple of `FLASH_SECTOR_SIZE`.
+ */
+extern void flash_io_erase(uint32_t offset, uint32_t size);
+
+/** @brief Programs whole pages. Bytes of 0xFF leave flash unchanged, so a page may be programmed
+ * several times to fill it piece by piece.
+ ** @param[in] offset Start, a multiple of `FLASH_PAGE_SIZE`.
+ ** @param[in] data Bytes to program.
+ ** @param[in] size Length, a multiple of `FLASH_PAGE_SIZE`.
+ */
+extern void flash_io_program(uint32_t offset, const uint8_t *data, uint32_t size);
+
+#endif // FLASH_IO_H
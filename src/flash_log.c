@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "flash_log.h"
+#include "flash_io.h"
+#include "microsd_module.h"
+#include "debug_mode.h"
+#include "profiler.h"
+#include "crc32.h"
+
+_Static_assert(sizeof(flash_log_record_t) == FLASH_LOG_RECORD_SIZE, "record layout");
+_Static_assert(FLASH_PAGE_SIZE % FLASH_LOG_RECORD_SIZE == 0, "records must not straddle pages");
+_Static_assert(sizeof(flash_log_sensors_t) <= FLASH_LOG_PAYLOAD_SIZE, "sensor record too large");
+_Static_assert(sizeof(gps_data_t) <= FLASH_LOG_PAYLOAD_SIZE, "GPS record too large");
+_Static_assert(sizeof(flash_log_baro_t) <= FLASH_LOG_PAYLOAD_SIZE, "barometer record too large");
+
+#define SLOTS_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_LOG_RECORD_SIZE)
+#define SECTOR_COUNT (FLASH_LOG_SIZE / FLASH_SECTOR_SIZE)
+#define SLOT_COUNT (SECTOR_COUNT * SLOTS_PER_SECTOR)
+
+#define FREE_SEQ 0xFFFFFFFFu
+#define NOT_DRAINED 0xFFFFFFFFu
+#define NO_SECTOR UINT32_MAX
+
+extern char __flash_binary_end; // End of the firmware image in flash (linker script).
+
+static uint32_t head = 0; // Next free slot.
+static uint32_t tail = 0; // Oldest record not yet on the card (head: none).
+static uint32_t next_seq = 0;
+static uint32_t erased_sector = NO_SECTOR; // Erased sector the head is at or is heading for.
+static uint64_t retry_at_us = 0;
+static flash_log_stats_t stats;
+static flash_log_baro_t baro; // Barometer samples not yet in a record.
+
+static const flash_log_record_t *slot_record(uint32_t slot)
+{
+    return flash_io_xip(FLASH_LOG_OFFSET + slot * FLASH_LOG_RECORD_SIZE);
+}
+
+static uint32_t next_slot(uint32_t slot)
+{
+    return (slot + 1) % SLOT_COUNT;
+}
+
+static uint32_t prev_slot(uint32_t slot)
+{
+    return (slot + SLOT_COUNT - 1) % SLOT_COUNT;
+}
+
+static bool record_intact(const flash_log_record_t *r)
+{
+    return r->type < FLASH_LOG_TYPE_COUNT && r->len <= FLASH_LOG_PAYLOAD_SIZE &&
+           r->crc == crc32_compute(r, offsetof(flash_log_record_t, crc));
+}
+
+/** @brief Programs `len` bytes at `offset` within a slot; the rest of its page stays as it is. */
+static void program_slot(uint32_t slot, size_t offset, const void *data, size_t len)
+{
+    static uint8_t page[FLASH_PAGE_SIZE];
+    uint32_t address = FLASH_LOG_OFFSET + slot * FLASH_LOG_RECORD_SIZE + offset;
+    uint32_t page_address = address & ~(FLASH_PAGE_SIZE - 1);
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(&page[address - page_address], data, len);
+    flash_io_program(page_address, page, sizeof(page));
+}
+
+static bool sector_blank(uint32_t sector)
+{
+    const uint32_t *words = flash_io_xip(FLASH_LOG_OFFSET + sector * FLASH_SECTOR_SIZE);
+
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / sizeof(uint32_t); i++)
+    {
+        if (words[i] != 0xFFFFFFFFu) return false;
+    }
+    return true;
+}
+
+static void erase_sector(uint32_t sector)
+{
+    // Records of that sector not yet on the card are lost: the tail moves past them.
+    while (tail != head && tail / SLOTS_PER_SECTOR == sector)
+    {
+        uint8_t type = slot_record(tail)->type;
+
+        if (type < FLASH_LOG_TYPE_COUNT) stats.overwritten[type]++;
+        tail = next_slot(tail);
+    }
+
+    PROF_ENTER(PROF_FLASH_LOG_ERASE);
+    if (!sector_blank(sector)) flash_io_erase(FLASH_LOG_OFFSET + sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+    PROF_EXIT(PROF_FLASH_LOG_ERASE);
+    erased_sector = sector;
+}
+
+uint32_t flash_log_init(void)
+{
+    // A grown image would be erased sector by sector under the running code.
+    if ((uintptr_t)&__flash_binary_end > XIP_BASE + FLASH_LOG_OFFSET)
+        panic("Firmware image (%u bytes) overlaps the flash log at %u\n",
+              (unsigned)((uintptr_t)&__flash_binary_end - XIP_BASE), (unsigned)FLASH_LOG_OFFSET);
+
+    // The newest sector is the one whose first record has the highest sequence number.
+    uint32_t newest_sector = NO_SECTOR;
+    uint32_t newest_seq = 0;
+
+    for (uint32_t sector = 0; sector < SECTOR_COUNT; sector++)
+    {
+        uint32_t seq = slot_record(sector * SLOTS_PER_SECTOR)->seq;
+
+        if (seq != FREE_SEQ && (newest_sector == NO_SECTOR || seq > newest_seq))
+        {
+            newest_sector = sector;
+            newest_seq = seq;
+        }
+    }
+
+    head = tail = 0;
+    next_seq = 0;
+
+    if (newest_sector != NO_SECTOR)
+    {
+        uint32_t last = newest_sector * SLOTS_PER_SECTOR;
+
+        while (last % SLOTS_PER_SECTOR != SLOTS_PER_SECTOR - 1 && slot_record(last + 1)->seq != FREE_SEQ) last++;
+
+        head = next_slot(last);
+        next_seq = slot_record(last)->seq + 1;
+
+        // Records are copied in order: walk back over the consecutive ones not yet on the card.
+        tail = head;
+        for (uint32_t expected = next_seq - 1; prev_slot(tail) != head; expected--)
+        {
+            const flash_log_record_t *r = slot_record(prev_slot(tail));
+
+            if (r->seq != expected || r->drained != NOT_DRAINED) break;
+            tail = prev_slot(tail);
+        }
+    }
+
+    erased_sector = NO_SECTOR;
+    retry_at_us = 0;
+
+    uint32_t pending = (head + SLOT_COUNT - tail) % SLOT_COUNT;
+    LOG("[Flash log] Next record %lu, %lu not yet on the card\n", (unsigned long)next_seq, (unsigned long)pending);
+    return pending;
+}
+
+static void append(flash_log_type_t type, const void *data, size_t len)
+{
+    flash_log_record_t r;
+
+    memset(&r, 0, sizeof(r));
+    r.seq = next_seq;
+    r.type = type;
+    r.len = (uint8_t)len;
+    memcpy(r.payload, data, len);
+    r.crc = crc32_compute(&r, offsetof(flash_log_record_t, crc));
+    r.drained = NOT_DRAINED;
+
+    // Normally erased ahead by flash_log_service().
+    uint32_t sector = head / SLOTS_PER_SECTOR;
+    if (head % SLOTS_PER_SECTOR == 0 && erased_sector != sector) erase_sector(sector);
+
+    program_slot(head, 0, &r, sizeof(r));
+
+    head = next_slot(head);
+    next_seq++;
+    stats.appended[type]++;
+}
+
+void flash_log_append_sensors(const sensor_readings_t *data, const current_time_t *time)
+{
+    flash_log_sensors_t record = {.readings = *data, .time = *time};
+
+    append(FLASH_LOG_SENSORS, &record, sizeof(record));
+}
+
+void flash_log_append_gps(const gps_data_t *gps)
+{
+    append(FLASH_LOG_GPS, gps, sizeof(*gps));
+}
+
+void flash_log_add_baro(uint64_t timestamp_us, float pressure_pa)
+{
+    if (baro.count == 0) baro.first_us = timestamp_us;
+
+    baro.offset_us[baro.count] = (uint32_t)(timestamp_us - baro.first_us);
+    baro.pressure_pa[baro.count] = pressure_pa;
+    if (++baro.count == FLASH_LOG_BARO_SAMPLES) flash_log_flush_baro();
+}
+
+void flash_log_flush_baro(void)
+{
+    if (baro.count == 0) return;
+
+    append(FLASH_LOG_BARO, &baro, sizeof(baro));
+    memset(&baro, 0, sizeof(baro));
+}
+
+/** @brief Writes a record to its file on the card. */
+static bool copy_to_card(const flash_log_record_t *r)
+{
+    bool ok;
+
+    if (r->type == FLASH_LOG_SENSORS)
+    {
+        flash_log_sensors_t record;
+        memcpy(&record, r->payload, sizeof(record));
+
+        PROF_ENTER(PROF_SAVE_SYSTEM_DATA);
+        ok = save_system_data(&record.readings, &record.time);
+        PROF_EXIT(PROF_SAVE_SYSTEM_DATA);
+    }
+    else if (r->type == FLASH_LOG_GPS)
+    {
+        gps_data_t gps;
+        memcpy(&gps, r->payload, sizeof(gps));
+
+        PROF_ENTER(PROF_SAVE_GPS_LOG);
+        ok = save_gps_log(&gps);
+        PROF_EXIT(PROF_SAVE_GPS_LOG);
+    }
+    else
+    {
+        flash_log_baro_t b;
+        memcpy(&b, r->payload, sizeof(b));
+
+        ok = save_baro_log(b.first_us, b.offset_us, b.pressure_pa, b.count);
+    }
+    return ok;
+}
+
+static bool record_fits(const flash_log_record_t *r)
+{
+    static const uint8_t lengths[FLASH_LOG_TYPE_COUNT] = {
+        [FLASH_LOG_SENSORS] = sizeof(flash_log_sensors_t),
+        [FLASH_LOG_GPS] = sizeof(gps_data_t),
+        [FLASH_LOG_BARO] = sizeof(flash_log_baro_t),
+    };
+
+    if (r->len != lengths[r->type]) return false;
+    if (r->type != FLASH_LOG_BARO) return true;
+
+    flash_log_baro_t b;
+    memcpy(&b, r->payload, sizeof(b));
+    return b.count >= 1 && b.count <= FLASH_LOG_BARO_SAMPLES;
+}
+
+uint32_t flash_log_drain(uint32_t max_records)
+{
+    uint32_t copied = 0;
+
+    if (time_us_64() < retry_at_us) return 0;
+
+    while (copied < max_records && tail != head)
+    {
+        const flash_log_record_t *r = slot_record(tail);
+
+        if (!record_intact(r) || !record_fits(r))
+        {
+            stats.corrupt++;
+        }
+        else if (copy_to_card(r))
+        {
+            stats.drained[r->type]++;
+            copied++;
+        }
+        else
+        {
+            LOG("[Flash log] Card not writable, next try in %d s\n", FLASH_LOG_SD_RETRY_S);
+            retry_at_us = time_us_64() + FLASH_LOG_SD_RETRY_S * 1000000ULL;
+            break;
+        }
+
+        static const uint32_t drained = 0;
+        program_slot(tail, offsetof(flash_log_record_t, drained), &drained, sizeof(drained));
+        tail = next_slot(tail);
+    }
+    return copied;
+}
+
+void flash_log_service(void)
+{
+    uint32_t sector = head / SLOTS_PER_SECTOR;
+    uint32_t target = (head % SLOTS_PER_SECTOR == 0) ? sector : (sector + 1) % SECTOR_COUNT;
+
+    if (erased_sector != target) erase_sector(target);
+}
+
+void flash_log_get_stats(flash_log_stats_t *out)
+{
+    *out = stats;
+    out->pending = (head + SLOT_COUNT - tail) % SLOT_COUNT;
+}
+
+void flash_log_command(int c)
+{
+    if (c == FLASH_LOG_DUMP_CHAR) flash_log_dump();
+}
+
+static void dump_record(const flash_log_record_t *r)
+{
+    char drained = (r->drained == NOT_DRAINED) ? '0' : '1';
+
+    if (!record_intact(r) || !record_fits(r))
+    {
+        printf("%lu,X\n", (unsigned long)r->seq);
+    }
+    else if (r->type == FLASH_LOG_SENSORS)
+    {
+        flash_log_sensors_t s;
+        memcpy(&s, r->payload, sizeof(s));
+
+        printf("%lu,S,%c,%02d:%02d:%02d," TIME_US_FMT ",%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+               (unsigned long)r->seq, drained, s.time.hour, s.time.min, s.time.sec,
+               TIME_US_ARGS(s.readings.pressure_us), s.readings.pressure_pa, s.readings.altitude_m,
+               s.readings.temperature_c, s.readings.humidity_pct, s.readings.methane_ppm,
+               s.readings.ammonia_ppm, s.readings.oxygen_pct);
+    }
+    else if (r->type == FLASH_LOG_BARO)
+    {
+        flash_log_baro_t b;
+        memcpy(&b, r->payload, sizeof(b));
+
+        for (uint32_t i = 0; i < b.count; i++)
+        {
+            printf("%lu,B,%c," TIME_US_FMT ",%.2f\n", (unsigned long)r->seq, drained,
+                   TIME_US_ARGS(b.first_us + b.offset_us[i]), b.pressure_pa[i]);
+        }
+    }
+    else
+    {
+        gps_data_t g;
+        memcpy(&g, r->payload, sizeof(g));
+
+        printf("%lu,G,%c," TIME_US_FMT ",%02d:%02d:%02d.%06lu," GPS_E7_FMT "," GPS_E7_FMT ",%.2f,%d,%d\n",
+               (unsigned long)r->seq, drained, TIME_US_ARGS(g.timestamp_us),
+               g.hour, g.min, g.sec, (unsigned long)g.microsec,
+               GPS_E7_ARGS(g.latitude_e7), GPS_E7_ARGS(g.longitude_e7), g.altitude, g.satellites, g.fix ? 1 : 0);
+    }
+}
+
+void flash_log_dump(void)
+{
+    // Oldest first: from the sector after the head's round to the head.
+    uint32_t start = ((head / SLOTS_PER_SECTOR + 1) % SECTOR_COUNT) * SLOTS_PER_SECTOR;
+    uint32_t records = 0;
+
+    for (uint32_t slot = 0; slot < SLOT_COUNT; slot++) records += slot_record(slot)->seq != FREE_SEQ;
+
+    printf("# flash log v1 records=%lu pending=%lu\n", (unsigned long)records,
+           (unsigned long)((head + SLOT_COUNT - tail) % SLOT_COUNT));
+    printf("# seq,type,on_card,...\n");
+
+    for (uint32_t n = 0, slot = start; n < SLOT_COUNT; n++, slot = next_slot(slot))
+    {
+        // Printing the whole log takes longer than the watchdog timeout.
+        if (n % SLOTS_PER_SECTOR == 0) watchdog_update();
+
+        const flash_log_record_t *r = slot_record(slot);
+        if (r->seq != FREE_SEQ) dump_record(r);
+    }
+    printf("# end\n");
+}
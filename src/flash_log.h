@@ -0,0 +1,177 @@
+/** @file flash_log.h
+ ** @brief Circular log of the flight records in the spare QSPI flash, copied to the microSD card.
+ * @details The microSD card is a poor primary store: a write can stall for hundreds of
+ * milliseconds while the card collects garbage, and the card can fail or come loose on
+ * impact. Every sensor and GPS record is therefore first appended to flash, where a record
+ * costs one page program (under a millisecond, bounded by the datasheet), and then copied to
+ * the card by `flash_log_drain()` while the card takes writes. The files on the card keep
+ * their format: the copy goes through `save_system_data()`, `save_gps_log()` and `save_baro_log()`.
+ *
+ * The log fills `FLASH_LOG_OFFSET` up to the last-fix sector (last_fix.h) with
+ * fixed-size records, each with a sequence number and a CRC-32. It is written as a ring, so
+ * every sector is erased once per turn (wear levelling), and the next sector is erased ahead
+ * of time by `flash_log_service()`, off the append path. A record copied to the card is
+ * marked by clearing its `drained` word in place; a record not yet copied when its sector
+ * comes round again is overwritten and counted. At boot `flash_log_init()` finds the newest
+ * record and the oldest one not yet copied by scanning the headers through XIP, so the log
+ * survives resets and power loss.
+ *
+ * After landing the whole log is read over USB: `FLASH_LOG_DUMP_CHAR` prints every record,
+ * oldest first, one CSV line each.
+ */
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "atm_sen_module.h"
+#include "gps_module.h"
+#include "time_manager.h"
+#include "last_fix.h"
+
+// CONFIGURATION MACROS
+
+/** @brief Start of the log from the start of flash; the firmware image must stay below it
+ ** (`flash_log_init()` halts otherwise). */
+#define FLASH_LOG_OFFSET (1024 * 1024)
+
+/** @brief Length of the log: up to the last-fix sector. */
+#define FLASH_LOG_SIZE (LAST_FIX_OFFSET - FLASH_LOG_OFFSET)
+
+/** @brief Size of a record, header and CRC included (two per page). */
+#define FLASH_LOG_RECORD_SIZE 128
+
+/** @brief Bytes of data a record carries. */
+#define FLASH_LOG_PAYLOAD_SIZE (FLASH_LOG_RECORD_SIZE - 16)
+
+/** @brief Most records copied to the card by one `flash_log_drain()` call of the main loop on the pad
+ ** (the other flight phases scale it, flight_phase.c). */
+#define FLASH_LOG_DRAIN_BATCH 4
+
+/** @brief Time after which the main loop starts no further copy in a tick [ms].
+ * @details A copy is an open, a write and a close on the card, and a card collecting garbage
+ * can stall one for hundreds of milliseconds: the batch ends early rather than the tick. */
+#define FLASH_LOG_DRAIN_BUDGET_MS 250
+
+/** @brief Wait after a failed copy before the card is tried again [s]. */
+#define FLASH_LOG_SD_RETRY_S 5
+
+/** @brief Barometer samples packed into one record. */
+#define FLASH_LOG_BARO_SAMPLES 12
+
+/** @brief Character that prints the log over stdio. */
+#define FLASH_LOG_DUMP_CHAR 'f'
+
+// DATA STRUCTURES
+
+/** @brief Kinds of record. */
+typedef enum
+{
+    FLASH_LOG_SENSORS = 0, /// `flash_log_sensors_t`, for 'data_log.txt'
+    FLASH_LOG_GPS, /// `gps_data_t`, for 'gps_log.csv'
+    FLASH_LOG_BARO, /// `flash_log_baro_t`, for 'baro_log.csv'
+    FLASH_LOG_TYPE_COUNT
+} flash_log_type_t;
+
+/** @brief One record as stored in flash. */
+typedef struct
+{
+    uint32_t seq; /// Sequence number, continued across boots (0xFFFFFFFF: free slot).
+    uint8_t type; /// `flash_log_type_t`.
+    uint8_t len; /// Bytes of `payload` used.
+    uint16_t reserved; /// 0.
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE]; /// The record's structure.
+    uint32_t crc; /// CRC-32 of the fields above.
+    uint32_t drained; /// 0xFFFFFFFF until the record is on the card, then 0 (outside the CRC).
+} flash_log_record_t;
+
+/** @brief Payload of a sensor record: the arguments of `save_system_data()`. */
+typedef struct
+{
+    sensor_readings_t readings;
+    current_time_t time;
+} flash_log_sensors_t;
+
+/** @brief Payload of a barometer record: consecutive BMP280 samples (flight_phase.h). */
+typedef struct
+{
+    uint64_t first_us; /// Time of the first sample.
+    uint32_t count; /// Samples used (1-`FLASH_LOG_BARO_SAMPLES`).
+    uint32_t offset_us[FLASH_LOG_BARO_SAMPLES]; /// Time of each sample after the first.
+    float pressure_pa[FLASH_LOG_BARO_SAMPLES]; /// Pressure of each sample [Pa].
+} flash_log_baro_t;
+
+/** @brief Counters, cumulative since boot and indexed by `flash_log_type_t`. */
+typedef struct
+{
+    uint32_t appended[FLASH_LOG_TYPE_COUNT]; /// Records written to flash.
+    uint32_t drained[FLASH_LOG_TYPE_COUNT]; /// Records copied to the card.
+    uint32_t overwritten[FLASH_LOG_TYPE_COUNT]; /// Records lost to the ring before they reached the card.
+    uint32_t corrupt; /// Records skipped by the copy for a bad CRC (e.g. cut by a power loss).
+    uint32_t pending; /// Records in flash not yet on the card.
+} flash_log_stats_t;
+
+// FUNCTIONS
+
+/** @brief Finds the newest record and the oldest one not yet on the card.
+ * @details Reads only record headers, through XIP; no flash is written. Call once at boot.
+ ** @return Records in flash not yet on the card.
+ */
+extern uint32_t flash_log_init(void);
+
+/** @brief Appends a sensor record.
+ ** @param[in] data Readings to record.
+ ** @param[in] time Calendar time of the readings.
+ */
+extern void flash_log_append_sensors(const sensor_readings_t *data, const current_time_t *time);
+
+/** @brief Appends a GPS record.
+ ** @param[in] gps GPS data to record.
+ */
+extern void flash_log_append_gps(const gps_data_t *gps);
+
+/** @brief Adds a barometer sample; a record is appended once `FLASH_LOG_BARO_SAMPLES` are collected.
+ ** @param[in] timestamp_us Time of the sample.
+ ** @param[in] pressure_pa Pressure [Pa].
+ */
+extern void flash_log_add_baro(uint64_t timestamp_us, float pressure_pa);
+
+/** @brief Appends the barometer samples collected so far, if any (e.g. when the stream stops). */
+extern void flash_log_flush_baro(void);
+
+/** @brief Copies the oldest records not yet on the card, up to `max_records`.
+ * @details Stops at the first record the card does not take and leaves the card alone for
+ * `FLASH_LOG_SD_RETRY_S`; that record is copied again later.
+ ** @param[in] max_records Most records to copy.
+ ** @return Records copied.
+ */
+extern uint32_t flash_log_drain(uint32_t max_records);
+
+/** @brief Erases the sector the next appends go to, if it is not erased yet.
+ * @details Call from the main loop at a point where a stall of tens of milliseconds does no
+ * harm; the appends then never wait for an erase.
+ */
+extern void flash_log_service(void);
+
+/** @brief Retrieves the counters.
+ ** @param[out] stats Pointer to the structure that receives them.
+ */
+extern void flash_log_get_stats(flash_log_stats_t *stats);
+
+/** @brief Handles a character received over stdio: `FLASH_LOG_DUMP_CHAR` prints the log. */
+extern void flash_log_command(int c);
+
+/** @brief Prints every record in flash over stdio, oldest first.
+ * @details "# flash log v1 records=<n> pending=<n>", then one line per record:
+ * `<seq>,S,<drained>,<hh:mm:ss>,<pressure t>,<Pa>,<m>,<C>,<%>,<CH4 ppm>,<NH3 ppm>,<O2 %>` for sensor
+ * records, `<seq>,G,<drained>,<t>,<UTC>,<lat>,<lon>,<m>,<satellites>,<fix>` for GPS records and
+ * `<seq>,B,<drained>,<t>,<Pa>` for each sample of a barometer record (times since boot in
+ * seconds), then "# end". Records with a bad CRC are printed as
+ * `<seq>,X`.
+ */
+extern void flash_log_dump(void);
+
+#endif // FLASH_LOG_H
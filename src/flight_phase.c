@@ -0,0 +1,223 @@
+#include <math.h>
+#include "pico/stdlib.h"
+#include "flight_phase.h"
+#include "flash_log.h"
+#include "debug_mode.h"
+
+// Samples kept for the vertical speed fit: a window's worth at the fastest barometer rate.
+#define HISTORY_LEN 64
+
+// Time constant of the pad altitude average [s].
+#define PAD_AVERAGE_TAU_S 30.0f
+
+const char *const flight_phase_names[FLIGHT_PHASE_COUNT] = {
+    [FLIGHT_PAD] = "pad",
+    [FLIGHT_ASCENT] = "ascent",
+    [FLIGHT_APOGEE] = "apogee",
+    [FLIGHT_DESCENT] = "descent",
+    [FLIGHT_LANDED] = "landed",
+};
+
+static const flight_profile_t profiles[FLIGHT_PHASE_COUNT] = {
+    [FLIGHT_PAD] = {.baro_period_ms = 100, .record_period_s = 1, .radio_period_s = 1, .drain_batch = FLASH_LOG_DRAIN_BATCH, .baro_stream = false},
+    [FLIGHT_ASCENT] = {.baro_period_ms = 20, .record_period_s = 1, .radio_period_s = 1, .drain_batch = 2 * FLASH_LOG_DRAIN_BATCH, .baro_stream = true},
+    [FLIGHT_APOGEE] = {.baro_period_ms = 20, .record_period_s = 1, .radio_period_s = 1, .drain_batch = 2 * FLASH_LOG_DRAIN_BATCH, .baro_stream = true},
+    [FLIGHT_DESCENT] = {.baro_period_ms = 20, .record_period_s = 1, .radio_period_s = 1, .drain_batch = 2 * FLASH_LOG_DRAIN_BATCH, .baro_stream = true},
+    [FLIGHT_LANDED] = {.baro_period_ms = 1000, .record_period_s = 10, .radio_period_s = 10, .drain_batch = 8 * FLASH_LOG_DRAIN_BATCH, .baro_stream = false},
+};
+
+uint64_t flight_phase_entered_us[FLIGHT_PHASE_COUNT];
+
+static flight_phase_t phase = FLIGHT_PAD;
+static float pad_altitude_m[FLIGHT_SOURCE_COUNT] = {NAN, NAN};
+static float max_altitude_m[FLIGHT_SOURCE_COUNT] = {NAN, NAN};
+static uint64_t pad_sample_us[FLIGHT_SOURCE_COUNT]; // Last sample in the pad average.
+static float vertical_speed_mps = 0.0f;
+static bool ground_slow = true; // GPS ground speed low enough for a landing, or no fix.
+static uint64_t last_baro_us = 0;
+static flight_source_t source = FLIGHT_SOURCE_BARO; // Source of the altitudes in the history.
+
+// Phase whose condition holds (FLIGHT_PHASE_COUNT: none), and since when.
+static flight_phase_t pending = FLIGHT_PHASE_COUNT;
+static uint64_t pending_since_us = 0;
+
+static struct
+{
+    uint64_t timestamp_us;
+    float altitude_m;
+} history[HISTORY_LEN];
+static uint32_t history_head = 0;
+static uint32_t history_count = 0;
+
+void flight_phase_init(const flight_state_t *resume)
+{
+    bool resumed = resume && resume->phase < FLIGHT_PHASE_COUNT;
+
+    phase = resumed ? resume->phase : FLIGHT_PAD;
+    for (int s = 0; s < FLIGHT_SOURCE_COUNT; s++)
+    {
+        pad_altitude_m[s] = resumed ? resume->pad_altitude_m[s] : NAN;
+        max_altitude_m[s] = resumed ? resume->max_altitude_m[s] : NAN;
+    }
+    flight_phase_entered_us[phase] = time_us_64();
+    LOG("[Flight] Phase: %s\n", flight_phase_names[phase]);
+}
+
+void flight_phase_save(flight_state_t *state)
+{
+    state->phase = (uint8_t)phase;
+    for (int s = 0; s < FLIGHT_SOURCE_COUNT; s++)
+    {
+        state->pad_altitude_m[s] = pad_altitude_m[s];
+        state->max_altitude_m[s] = max_altitude_m[s];
+    }
+}
+
+/** @brief Least-squares slope of the altitude over the samples of the last window [m/s]. */
+static float fit_vertical_speed(void)
+{
+    uint32_t newest = (history_head + HISTORY_LEN - 1) % HISTORY_LEN;
+    uint64_t t_end = history[newest].timestamp_us;
+    double n = 0, st = 0, sa = 0, stt = 0, sta = 0;
+
+    for (uint32_t i = 0; i < history_count; i++)
+    {
+        uint32_t k = (newest + HISTORY_LEN - i) % HISTORY_LEN;
+        uint64_t age = t_end - history[k].timestamp_us;
+
+        if (age > FLIGHT_VSPEED_WINDOW_US && n >= 2) break;
+
+        double t = -(double)age / 1e6;
+        n++;
+        st += t;
+        sa += history[k].altitude_m;
+        stt += t * t;
+        sta += t * history[k].altitude_m;
+    }
+
+    double den = n * stt - st * st;
+    return (n >= 2 && den > 0) ? (float)((n * sta - st * sa) / den) : 0.0f;
+}
+
+/** @brief The phase the conditions point to (FLIGHT_PHASE_COUNT: stay), with the hold time it needs. */
+static flight_phase_t next_phase(float altitude_m, uint64_t *hold_us)
+{
+    float v = vertical_speed_mps;
+    float pad = pad_altitude_m[source];
+    float max = max_altitude_m[source];
+
+    *hold_us = FLIGHT_CONFIRM_US;
+    switch (phase)
+    {
+        case FLIGHT_PAD:
+            if (altitude_m - pad > FLIGHT_LAUNCH_HEIGHT_M && v > FLIGHT_CLIMB_SPEED_MPS) return FLIGHT_ASCENT;
+            break;
+        case FLIGHT_ASCENT:
+            if (v <= 0.0f || altitude_m < max - FLIGHT_APOGEE_DROP_M) return FLIGHT_APOGEE;
+            break;
+        case FLIGHT_APOGEE:
+            if (v < -FLIGHT_SINK_SPEED_MPS) return FLIGHT_DESCENT;
+            if (v > FLIGHT_CLIMB_SPEED_MPS && altitude_m > max) return FLIGHT_ASCENT;
+            break;
+        case FLIGHT_DESCENT:
+            *hold_us = FLIGHT_LANDED_HOLD_US;
+            if (fabsf(v) < FLIGHT_LANDED_SPEED_MPS && ground_slow) return FLIGHT_LANDED;
+            break;
+        default:
+            break;
+    }
+    return FLIGHT_PHASE_COUNT;
+}
+
+/** @brief Folds a sample into the pad or highest altitude of its source. */
+static void track(flight_source_t s, float altitude_m, uint64_t timestamp_us)
+{
+    if (phase == FLIGHT_PAD)
+    {
+        if (isnan(pad_altitude_m[s])) pad_altitude_m[s] = altitude_m;
+        else
+        {
+            float alpha = (float)(timestamp_us - pad_sample_us[s]) / 1e6f / PAD_AVERAGE_TAU_S;
+            pad_altitude_m[s] += (alpha < 1.0f ? alpha : 1.0f) * (altitude_m - pad_altitude_m[s]);
+        }
+        pad_sample_us[s] = timestamp_us;
+    }
+    if (phase == FLIGHT_ASCENT || phase == FLIGHT_APOGEE)
+    {
+        if (!(altitude_m <= max_altitude_m[s])) max_altitude_m[s] = altitude_m;
+    }
+}
+
+/** @brief Runs the detector on a sample of the source in use. */
+static bool update(flight_source_t s, float altitude_m, uint64_t timestamp_us)
+{
+    // The fit starts over when the source changes.
+    if (s != source) history_count = 0;
+    source = s;
+
+    history[history_head].timestamp_us = timestamp_us;
+    history[history_head].altitude_m = altitude_m;
+    history_head = (history_head + 1) % HISTORY_LEN;
+    if (history_count < HISTORY_LEN) history_count++;
+
+    vertical_speed_mps = fit_vertical_speed();
+
+    uint64_t hold_us;
+    flight_phase_t next = next_phase(altitude_m, &hold_us);
+
+    if (next != pending)
+    {
+        pending = next;
+        pending_since_us = timestamp_us;
+    }
+    if (pending == FLIGHT_PHASE_COUNT || timestamp_us - pending_since_us < hold_us) return false;
+
+    if (next == FLIGHT_ASCENT && phase == FLIGHT_PAD)
+    {
+        // The other source starts its highest altitude from its next sample.
+        for (int i = 0; i < FLIGHT_SOURCE_COUNT; i++) max_altitude_m[i] = NAN;
+        max_altitude_m[s] = altitude_m;
+    }
+    phase = next;
+    pending = FLIGHT_PHASE_COUNT;
+    flight_phase_entered_us[phase] = timestamp_us;
+    LOG("[Flight] Phase: %s at %.1f m (%.1f m above the pad), %.1f m/s\n",
+        flight_phase_names[phase], altitude_m, altitude_m - pad_altitude_m[s], vertical_speed_mps);
+    return true;
+}
+
+bool flight_phase_baro(float altitude_m, uint64_t timestamp_us)
+{
+    last_baro_us = timestamp_us;
+    track(FLIGHT_SOURCE_BARO, altitude_m, timestamp_us);
+
+    return update(FLIGHT_SOURCE_BARO, altitude_m, timestamp_us);
+}
+
+bool flight_phase_gps(const gps_data_t *gps)
+{
+    ground_slow = !gps->fix || gps->ground_speed < FLIGHT_LANDED_GROUND_SPEED_MPS;
+
+    if (!gps->fix) return false;
+
+    // Tracked while the barometer works too, so the GPS has its own pad and highest altitudes.
+    track(FLIGHT_SOURCE_GPS, gps->altitude, gps->timestamp_us);
+    if (time_us_64() - last_baro_us < FLIGHT_BARO_TIMEOUT_US) return false;
+
+    return update(FLIGHT_SOURCE_GPS, gps->altitude, gps->timestamp_us);
+}
+
+flight_phase_t flight_phase(void)
+{
+    return phase;
+}
+
+float flight_phase_vertical_speed(void)
+{
+    return vertical_speed_mps;
+}
+
+const flight_profile_t *flight_profile(void)
+{
+    return &profiles[phase];
+}
@@ -0,0 +1,149 @@
+/** @file flight_phase.h
+ ** @brief Flight phase detector and the sampling, logging and radio profile of each phase.
+ * @details The phase follows the barometric altitude: every BMP280 sample taken by the main
+ * loop goes to `flight_phase_baro()`, which estimates the vertical speed by a least-squares
+ * fit over the last `FLIGHT_VSPEED_WINDOW_US`. While the barometer fails, the GPS altitude
+ * (`flight_phase_gps()`) takes its place; the GPS ground speed also has to be low for a landing.
+ *
+ * - PAD -> ASCENT: `FLIGHT_LAUNCH_HEIGHT_M` above the pad and climbing faster than
+ *   `FLIGHT_CLIMB_SPEED_MPS`,
+ * - ASCENT -> APOGEE: no longer climbing, or `FLIGHT_APOGEE_DROP_M` below the highest point,
+ * - APOGEE -> DESCENT: sinking faster than `FLIGHT_SINK_SPEED_MPS`
+ *   (APOGEE -> ASCENT if the climb resumes above the highest point),
+ * - DESCENT -> LANDED: vertical speed within `FLIGHT_LANDED_SPEED_MPS` for `FLIGHT_LANDED_HOLD_US`.
+ * Every condition has to hold for `FLIGHT_CONFIRM_US` (the landing for its own hold time)
+ * before the phase changes, so a gust or a noisy sample does not flip it. LANDED is final
+ * until the next cold boot. The pad altitude is a slow average taken while on the pad.
+ * Both are kept for each source, from every sample of it, so a GPS altitude is only ever
+ * compared with the GPS pad and highest altitudes, never with barometric ones.
+ *
+ * Each phase has a profile (`flight_profile()`): the BMP280 period, the period of the full
+ * record (every sensor, GPS), the radio period, how many records the flash log copies to the
+ * card per tick and whether every barometer sample is logged. The barometer runs fast from
+ * launch to landing, where the descent rate and the altitude are measured; once landed, the
+ * records slow down to one every 10 s and the flash log catches up with the card.
+ *
+ * The state is small and is carried across a watchdog reset (warm_restart.h), so a reset
+ * under the parachute does not send the detector back to the pad.
+ */
+
+#ifndef FLIGHT_PHASE_H
+#define FLIGHT_PHASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gps_module.h"
+
+// CONFIGURATION MACROS
+
+/** @brief Window of the vertical speed fit [us]. */
+#define FLIGHT_VSPEED_WINDOW_US 1000000
+
+/** @brief How long a transition condition has to hold [us]. */
+#define FLIGHT_CONFIRM_US 500000
+
+/** @brief Height above the pad that, with the climb, marks the launch [m]. */
+#define FLIGHT_LAUNCH_HEIGHT_M 15.0f
+
+/** @brief Vertical speed above which the CanSat climbs [m/s]. */
+#define FLIGHT_CLIMB_SPEED_MPS 2.0f
+
+/** @brief Drop below the highest point that marks the apogee, however slow the climb [m]. */
+#define FLIGHT_APOGEE_DROP_M 5.0f
+
+/** @brief Vertical speed below minus this marks the descent [m/s]. */
+#define FLIGHT_SINK_SPEED_MPS 2.0f
+
+/** @brief Vertical speed within plus or minus this counts as still [m/s]. */
+#define FLIGHT_LANDED_SPEED_MPS 0.5f
+
+/** @brief GPS ground speed below which the CanSat may have landed (when the GPS has a fix) [m/s]. */
+#define FLIGHT_LANDED_GROUND_SPEED_MPS 2.0f
+
+/** @brief How long the CanSat has to be still before it has landed [us]. */
+#define FLIGHT_LANDED_HOLD_US 5000000
+
+/** @brief Time without a valid barometer sample after which the GPS altitude is used [us]. */
+#define FLIGHT_BARO_TIMEOUT_US 2000000
+
+// DATA STRUCTURES
+
+/** @brief Phases of a flight, in order. */
+typedef enum
+{
+    FLIGHT_PAD = 0, /// On the ground before the launch.
+    FLIGHT_ASCENT, /// Carried up.
+    FLIGHT_APOGEE, /// At the top, released.
+    FLIGHT_DESCENT, /// Under the parachute.
+    FLIGHT_LANDED, /// On the ground after the descent.
+    FLIGHT_PHASE_COUNT
+} flight_phase_t;
+
+/** @brief What is sampled, logged and sent in a phase. */
+typedef struct
+{
+    uint32_t baro_period_ms; /// BMP280 sample period.
+    uint16_t record_period_s; /// Period of the full record (all sensors, GPS); `sample_period_s` of flash_config.h if longer.
+    uint16_t radio_period_s; /// Period of the telemetry and position frames.
+    uint16_t drain_batch; /// Records copied from the flash log to the card per tick.
+    bool baro_stream; /// Every barometer sample is logged ('baro_log.csv'), not only those of the records.
+} flight_profile_t;
+
+/** @brief Altitude sources. Barometric and GPS (MSL) altitudes have different references,
+ ** so the pad and highest altitudes are kept for each. */
+typedef enum
+{
+    FLIGHT_SOURCE_BARO,
+    FLIGHT_SOURCE_GPS,
+    FLIGHT_SOURCE_COUNT
+} flight_source_t;
+
+/** @brief Detector state carried across a watchdog reset. */
+typedef struct
+{
+    uint8_t phase; /// `flight_phase_t`.
+    float pad_altitude_m[FLIGHT_SOURCE_COUNT]; /// Average altitude on the pad (NAN before the first sample).
+    float max_altitude_m[FLIGHT_SOURCE_COUNT]; /// Highest altitude since the launch (NAN before the first sample).
+} flight_state_t;
+
+// FUNCTIONS
+
+/** @brief Display names of the phases, indexed by `flight_phase_t`. */
+extern const char *const flight_phase_names[FLIGHT_PHASE_COUNT];
+
+/** @brief `time_us_64()` at which each phase was entered (0: not yet), indexed by `flight_phase_t`. */
+extern uint64_t flight_phase_entered_us[FLIGHT_PHASE_COUNT];
+
+/** @brief Starts the detector on the pad, or where it was before a warm restart.
+ ** @param[in] resume State saved before the reset, NULL on a cold boot.
+ */
+extern void flight_phase_init(const flight_state_t *resume);
+
+/** @brief Copies the state to keep across a reset.
+ ** @param[out] state Pointer to the structure that receives it.
+ */
+extern void flight_phase_save(flight_state_t *state);
+
+/** @brief Feeds one barometer sample.
+ ** @param[in] altitude_m Barometric altitude [m].
+ ** @param[in] timestamp_us Time of the sample.
+ ** @return true if the phase changed.
+ */
+extern bool flight_phase_baro(float altitude_m, uint64_t timestamp_us);
+
+/** @brief Feeds new GPS data: ground speed for the landing, altitude while the barometer fails.
+ ** @param[in] gps Latest GPS data.
+ ** @return true if the phase changed.
+ */
+extern bool flight_phase_gps(const gps_data_t *gps);
+
+/** @brief Current phase. */
+extern flight_phase_t flight_phase(void);
+
+/** @brief Vertical speed of the last fit, positive upwards [m/s]. */
+extern float flight_phase_vertical_speed(void);
+
+/** @brief Profile of the current phase. */
+extern const flight_profile_t *flight_profile(void);
+
+#endif // FLIGHT_PHASE_H
@@ -8,22 +8,608 @@
 #include "gps_module.h"
 #include "time_manager.h"
 #include "debug_mode.h"
+#include "trace.h"
 #include "minmea.h"
+#include "ubx_protocol.h"
 #include "hardware/uart.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
 
 #define NMEA_BUFFER_LEN 85
 
+#define KNOTS_TO_MPS 0.514444f
+
+// Size of the interrupt-driven receive ring. At 115200 baud the 32-byte UART FIFO
+// would overflow within 3 ms, far shorter than a blocking sensor read.
+#define GPS_RX_RING_LEN 2048
+
+// Number of frame start times the interrupt can hold before they are consumed.
+#define GPS_STAMP_RING_LEN 32
+
+// How long to listen for receiver output when verifying a baud rate [ms].
+#define GPS_TRAFFIC_TIMEOUT_MS 1500
+
+// Framing errors that show, while listening, that the receiver uses another baud rate.
+#define GPS_WRONG_BAUD_FRAMING_ERRORS 8
+
+// How long to wait for a UBX-ACK after each configuration message [ms].
+#define GPS_ACK_TIMEOUT_MS 300
+
+// Time given to the receiver to change its baud rate after a CFG-PRT [ms].
+#define GPS_BAUD_SWITCH_MS 100
+
+static gps_data_t last_data = {0};
+
+// Baud rate of the Pico UART, i.e. of the receiver once configure_receiver() is done.
+static uint link_baud = 0;
+
+static volatile uint8_t rx_ring[GPS_RX_RING_LEN];
+static volatile uint16_t rx_head = 0;
+static volatile uint16_t rx_tail = 0;
+static volatile uint32_t rx_dropped = 0;
+static volatile uint32_t uart_overruns = 0;
+static volatile uint32_t uart_framing_errors = 0;
+
+// Arrival times of frame start characters ('$' or UBX sync), one per such byte in the ring,
+// so timestamps reflect reception rather than the moment the main loop got to the data.
+// The interrupt stores the low 32 bits of the timer (a register read, safe from RAM);
+// rx_pop() extends them to 64 bits.
+static volatile uint32_t stamp_ring[GPS_STAMP_RING_LEN];
+static volatile uint16_t stamp_head = 0;
+static volatile uint16_t stamp_tail = 0;
+static uint64_t last_start_us = 0;
+
+#if GPS_USE_UBX
+static ubx_parser_t ubx_parser;
+static uint64_t frame_start_us = 0;
+static int32_t clock_drift_ns_s = 0;
+static bool clock_drift_valid = false;
+#else
 static char line_buffer[NMEA_BUFFER_LEN];
 static int buffer_pos = 0;
-static gps_data_t last_data = {0};
+static uint64_t line_start_us = 0;
+static uint32_t checksum_failures = 0;
+#endif
 
-void gps_init(void)
+static __force_inline bool is_frame_start(uint8_t c)
+{
+    return c == '$' || c == UBX_SYNC_1;
+}
+
+/** @brief UART RX interrupt: moves every received byte from the FIFO into the ring.
+ * @details Runs from RAM and touches nothing in flash, so it keeps serving the receiver while
+ * flash is erased or programmed (flash_log.h); the flash operations leave this interrupt on.
+ * The UART and timer registers are therefore read directly: the SDK accessors
+ * (`uart_is_readable()`, `uart_get_hw()`, `time_us_32()`) are plain inline functions, which a
+ * build without optimisation places out of line, in flash.
+ */
+static void __not_in_flash_func(gps_uart_irq)(void)
+{
+    TRACE_BEGIN(TRACE_GPS_UART_IRQ);
+
+    while (!(GPS_UART_HW->fr & UART_UARTFR_RXFE_BITS))
+    {
+        // The data register also carries the error flags of the byte.
+        uint32_t dr = GPS_UART_HW->dr;
+        uint8_t c = (uint8_t)dr;
+
+        if (dr & UART_UARTDR_OE_BITS) uart_overruns++;
+        if (dr & (UART_UARTDR_FE_BITS | UART_UARTDR_BE_BITS)) uart_framing_errors++;
+
+        uint16_t next = (rx_head + 1) & (GPS_RX_RING_LEN - 1);
+
+        if (next == rx_tail)
+        {
+            rx_dropped++;
+            TRACE_INSTANT(TRACE_GPS_RX_OVERFLOW, 0);
+            continue;
+        }
+
+        if (is_frame_start(c))
+        {
+            uint16_t next_stamp = (stamp_head + 1) & (GPS_STAMP_RING_LEN - 1);
+            // Dropping the byte keeps stamps and start characters paired one to one.
+            if (next_stamp == stamp_tail)
+            {
+                rx_dropped++;
+                TRACE_INSTANT(TRACE_GPS_RX_OVERFLOW, 1);
+                continue;
+            }
+            stamp_ring[stamp_head] = timer_hw->timerawl;
+            stamp_head = next_stamp;
+        }
+
+        rx_ring[rx_head] = c;
+        rx_head = next;
+    }
+
+    TRACE_END(TRACE_GPS_UART_IRQ);
+}
+
+/** @brief Takes the next received byte from the ring.
+ * @details When the byte is a frame start character, its arrival time is stored in `last_start_us`.
+ */
+static bool rx_pop(uint8_t *c)
+{
+    if (rx_tail == rx_head) return false;
+
+    *c = rx_ring[rx_tail];
+    rx_tail = (rx_tail + 1) & (GPS_RX_RING_LEN - 1);
+
+    if (is_frame_start(*c))
+    {
+        uint64_t now = time_us_64();
+        last_start_us = now - (uint32_t)((uint32_t)now - stamp_ring[stamp_tail]);
+        stamp_tail = (stamp_tail + 1) & (GPS_STAMP_RING_LEN - 1);
+    }
+    return true;
+}
+
+static void rx_flush(void)
+{
+    uint32_t irq_state = save_and_disable_interrupts();
+    rx_tail = rx_head;
+    stamp_tail = stamp_head;
+    restore_interrupts(irq_state);
+}
+
+static void send_ubx(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len)
+{
+    uint8_t frame[32 + UBX_FRAME_OVERHEAD];
+
+    // A frame fits the 32-byte TX FIFO: the write only waits while an earlier frame is still going out.
+    uint16_t frame_len = ubx_build_frame(frame, msg_class, msg_id, payload, len);
+    uart_write_blocking(GPS_UART_ID, frame, frame_len);
+}
+
+/** @brief Steps of the receiver configuration run by `gps_configure_step()`. */
+typedef enum
+{
+    SETUP_LISTEN = 0, // Listening for receiver output at GPS_BAUD_RATE
+    SETUP_LISTEN_FAST, // Listening at GPS_FAST_BAUD_RATE, kept by the receiver from an earlier run
+    SETUP_FILTER, // Sending `filter_steps`, each after the ACK of the previous one
+    SETUP_SWITCH, // CFG-PRT sent, giving the receiver time to change its baud rate
+    SETUP_SWITCH_LISTEN, // Listening at the new baud rate
+    SETUP_RATE, // CFG-RATE sent, waiting for its ACK
+    SETUP_DONE,
+} setup_state_t;
+
+/** @brief A configuration message that the receiver acknowledges. */
+typedef struct
+{
+    uint8_t msg_id; // UBX_ID_CFG_*
+    uint8_t len;
+    uint8_t payload[10];
+} cfg_step_t;
+
+// Only the needed output: no unused NMEA sentences and no information messages ($GPTXT).
+static const cfg_step_t filter_steps[] = {
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NMEA, UBX_ID_NMEA_GLL, 0}},
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NMEA, UBX_ID_NMEA_GSA, 0}},
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NMEA, UBX_ID_NMEA_GSV, 0}},
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NMEA, UBX_ID_NMEA_VTG, 0}},
+#if GPS_USE_UBX
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NMEA, UBX_ID_NMEA_RMC, 0}},
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NMEA, UBX_ID_NMEA_GGA, 0}},
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1}},
+    {UBX_ID_CFG_MSG, 3, {UBX_CLASS_NAV, UBX_ID_NAV_CLK, GPS_NAV_RATE_HZ}}, // Drift for the next start-up
+#endif
+    {UBX_ID_CFG_INF, 10, {1}}, // UBX-CFG-INF: disable all NMEA information messages
+};
+
+// UBX-CFG-RATE: measurement period, one solution per measurement, aligned to GPS time
+static const cfg_step_t rate_step = {
+    UBX_ID_CFG_RATE, 6, {(uint8_t)(1000 / GPS_NAV_RATE_HZ), (uint8_t)((1000 / GPS_NAV_RATE_HZ) >> 8), 1, 0, 1, 0}
+};
+
+// Nothing to configure until gps_init(); gps_resume() leaves the receiver as it is.
+static setup_state_t setup_state = SETUP_DONE;
+static uint64_t setup_deadline_us = 0;
+static ubx_parser_t setup_parser;
+
+// Listening for output (traffic_start()): NMEA sentence in progress and framing errors at the start.
+static char setup_line[NMEA_BUFFER_LEN];
+static int setup_line_pos = -1;
+static uint32_t setup_framing_errors = 0;
+
+// Configuration message waiting for its ACK (cfg_start()).
+static const cfg_step_t *setup_cfg = NULL;
+static int setup_attempts = 0;
+static size_t setup_index = 0;
+static bool setup_filter_ok = true;
+
+// Baud rate requested by the last CFG-PRT.
+static uint32_t setup_baud = 0;
+
+/** @brief Starts listening for valid receiver output at the current baud rate, for at most
+ * `GPS_TRAFFIC_TIMEOUT_MS`, in setup step `state` (see `traffic_poll()`).
+ */
+static void traffic_start(setup_state_t state)
+{
+    setup_state = state;
+    setup_deadline_us = time_us_64() + GPS_TRAFFIC_TIMEOUT_MS * 1000ULL;
+    setup_framing_errors = uart_framing_errors;
+    setup_line_pos = -1;
+    ubx_parser_init(&setup_parser);
+}
+
+/** @brief Checks the output received since the last call.
+ ** @param[in] stop_on_framing_errors Gives up as soon as `GPS_WRONG_BAUD_FRAMING_ERRORS` bytes
+ * arrived with framing errors: the receiver is talking at another baud rate.
+ * @return 1 once a checksum-valid NMEA sentence or UBX frame has been received,
+ * -1 if none came in time, 0 while still listening.
+ */
+static int traffic_poll(bool stop_on_framing_errors)
+{
+    uint8_t c;
+
+    while (rx_pop(&c))
+    {
+        if (ubx_parser_feed(&setup_parser, c)) return 1;
+
+        if (c == '$') setup_line_pos = 0;
+        if (setup_line_pos < 0) continue;
+
+        if (c == '\r' || c == '\n')
+        {
+            setup_line[setup_line_pos] = '\0';
+            if (minmea_check(setup_line, true)) return 1;
+            setup_line_pos = -1;
+        }
+        else if (setup_line_pos < NMEA_BUFFER_LEN - 1) setup_line[setup_line_pos++] = (char)c;
+        else setup_line_pos = -1;
+    }
+
+    if (stop_on_framing_errors && uart_framing_errors - setup_framing_errors >= GPS_WRONG_BAUD_FRAMING_ERRORS) return -1;
+    return (time_us_64() < setup_deadline_us) ? 0 : -1;
+}
+
+static void cfg_send(void)
+{
+    send_ubx(UBX_CLASS_CFG, setup_cfg->msg_id, setup_cfg->payload, setup_cfg->len);
+    setup_attempts++;
+    setup_deadline_us = time_us_64() + GPS_ACK_TIMEOUT_MS * 1000ULL;
+    ubx_parser_init(&setup_parser);
+}
+
+/** @brief Sends a configuration message; `cfg_poll()` then waits for its ACK, retrying once. */
+static void cfg_start(const cfg_step_t *cfg)
+{
+    setup_cfg = cfg;
+    setup_attempts = 0;
+    cfg_send();
+}
+
+/** @brief Checks for the acknowledgement of the message sent by `cfg_start()`.
+ * @details NMEA text received in the meantime is skipped by the UBX framer. On UBX-ACK-NAK or
+ * after `GPS_ACK_TIMEOUT_MS` the message is sent once more.
+ * @return 1 on UBX-ACK-ACK, -1 if the second attempt fails too, 0 while waiting.
+ */
+static int cfg_poll(void)
+{
+    uint8_t c;
+    bool failed = false;
+
+    while (!failed && rx_pop(&c))
+    {
+        if (!ubx_parser_feed(&setup_parser, c)) continue;
+
+        if (setup_parser.msg_class == UBX_CLASS_ACK && setup_parser.length == 2 &&
+            setup_parser.payload[0] == UBX_CLASS_CFG && setup_parser.payload[1] == setup_cfg->msg_id)
+        {
+            if (setup_parser.msg_id == UBX_ID_ACK_ACK) return 1;
+            failed = true;
+        }
+    }
+
+    if (!failed && time_us_64() < setup_deadline_us) return 0;
+    if (setup_attempts >= 2) return -1;
+
+    cfg_send();
+    return 0;
+}
+
+static void set_pico_baud(uint baud)
+{
+    uart_tx_wait_blocking(GPS_UART_ID);
+    uart_set_baudrate(GPS_UART_ID, baud);
+    link_baud = baud;
+    sleep_ms(2);
+    rx_flush();
+}
+
+/** @brief Asks the receiver to switch its UART to a new baud rate (UBX-CFG-PRT).
+ * @details The ACK may be sent at either baud rate, so the switch is verified by listening
+ * instead: after `GPS_BAUD_SWITCH_MS` the Pico UART follows and `SETUP_SWITCH_LISTEN` begins.
+ */
+static void switch_start(uint32_t baud)
+{
+    uint8_t payload[20] = {0};
+
+    payload[0] = 1; // portID: UART1
+    // mode: 8 data bits, no parity, 1 stop bit
+    payload[4] = 0xD0;
+    payload[5] = 0x08;
+    payload[8] = (uint8_t)(baud);
+    payload[9] = (uint8_t)(baud >> 8);
+    payload[10] = (uint8_t)(baud >> 16);
+    payload[11] = (uint8_t)(baud >> 24);
+    payload[12] = 0x03; // inProtoMask: UBX + NMEA
+    payload[14] = 0x03; // outProtoMask: UBX + NMEA
+
+    send_ubx(UBX_CLASS_CFG, UBX_ID_CFG_PRT, payload, sizeof(payload));
+    setup_baud = baud;
+    setup_state = SETUP_SWITCH;
+    setup_deadline_us = time_us_64() + GPS_BAUD_SWITCH_MS * 1000ULL;
+}
+
+static void filter_start(void)
 {
-    uart_init(GPS_UART_ID, GPS_BAUD_RATE);
+    setup_state = SETUP_FILTER;
+    setup_index = 0;
+    setup_filter_ok = true;
+    cfg_start(&filter_steps[0]);
+}
+
+bool gps_configure_step(void)
+{
+    int result;
+
+    switch (setup_state)
+    {
+        // The receiver keeps its configuration while powered, so after a reset it may
+        // already be running at the fast baud rate; its output then arrives as framing errors.
+        case SETUP_LISTEN:
+            result = traffic_poll(true);
+            if (result > 0) filter_start();
+            else if (result < 0)
+            {
+                set_pico_baud(GPS_FAST_BAUD_RATE);
+                traffic_start(SETUP_LISTEN_FAST);
+            }
+            break;
+
+        case SETUP_LISTEN_FAST:
+            result = traffic_poll(false);
+            if (result > 0) filter_start();
+            else if (result < 0)
+            {
+                LOG("[GPS] ERROR: No receiver output at %d or %d baud.\n", GPS_BAUD_RATE, GPS_FAST_BAUD_RATE);
+                set_pico_baud(GPS_BAUD_RATE);
+                setup_state = SETUP_DONE;
+            }
+            break;
+
+        case SETUP_FILTER:
+            result = cfg_poll();
+            if (result == 0) break;
+
+            setup_filter_ok &= result > 0;
+            if (++setup_index < sizeof(filter_steps) / sizeof(filter_steps[0]))
+            {
+                cfg_start(&filter_steps[setup_index]);
+                break;
+            }
+            LOG("[GPS] Sentence filtering: %s\n", setup_filter_ok ? "OK" : "FAILED");
+            switch_start(GPS_FAST_BAUD_RATE);
+            break;
+
+        case SETUP_SWITCH:
+            if (time_us_64() < setup_deadline_us) break;
+            set_pico_baud(setup_baud);
+            traffic_start(SETUP_SWITCH_LISTEN);
+            break;
+
+        // If the faster baud rate cannot be verified, both ends are returned to GPS_BAUD_RATE and
+        // the navigation rate is left at its default, since a faster rate would not fit through.
+        case SETUP_SWITCH_LISTEN:
+            result = traffic_poll(false);
+            if (result == 0) break;
+
+            if (setup_baud != GPS_FAST_BAUD_RATE)
+            {
+                if (result < 0) LOG("[GPS] ERROR: Receiver not heard after fallback.\n");
+                setup_state = SETUP_DONE;
+            }
+            else if (result < 0)
+            {
+                LOG("[GPS] ERROR: Receiver not heard at %d baud, falling back to %d.\n", GPS_FAST_BAUD_RATE, GPS_BAUD_RATE);
+                // Sent at the fast rate in case the receiver did switch but its output was not recognised.
+                switch_start(GPS_BAUD_RATE);
+            }
+            else
+            {
+                LOG("[GPS] UART switched to %d baud.\n", GPS_FAST_BAUD_RATE);
+                setup_state = SETUP_RATE;
+                cfg_start(&rate_step);
+            }
+            break;
+
+        case SETUP_RATE:
+            result = cfg_poll();
+            if (result == 0) break;
+
+            if (result > 0) LOG("[GPS] Navigation rate set to %d Hz.\n", GPS_NAV_RATE_HZ);
+            else LOG("[GPS] ERROR: Navigation rate not acknowledged.\n");
+            setup_state = SETUP_DONE;
+            break;
+
+        case SETUP_DONE:
+            break;
+    }
+
+    if (setup_state != SETUP_DONE) return false;
+
+#if GPS_USE_UBX
+    ubx_parser_init(&ubx_parser);
+#endif
+    return true;
+}
+
+/** @brief Sets up the UART at `baud`, its pins and interrupt-driven reception. */
+static void start_uart(uint baud)
+{
+    uart_init(GPS_UART_ID, baud);
+    link_baud = baud;
     gpio_set_function(GPS_TX_PIN, GPIO_FUNC_UART);
     gpio_set_function(GPS_RX_PIN, GPIO_FUNC_UART);
+
+    irq_set_exclusive_handler(UART_IRQ_NUM(GPS_UART_ID), gps_uart_irq);
+    irq_set_enabled(UART_IRQ_NUM(GPS_UART_ID), true);
+    uart_set_irq_enables(GPS_UART_ID, true, false);
+}
+
+void gps_init(void)
+{
+    start_uart(GPS_BAUD_RATE);
+    traffic_start(SETUP_LISTEN);
+}
+
+void gps_resume(uint32_t baud)
+{
+    start_uart(baud);
+
+#if GPS_USE_UBX
+    ubx_parser_init(&ubx_parser);
+#endif
+}
+
+void gps_send_aiding(const gps_aid_t *aid, bool time_known)
+{
+    ubx_mga_ini_pos_llh_t pos = {
+        .type = UBX_MGA_INI_POS_LLH,
+        .lat_e7 = aid->latitude_e7,
+        .lon_e7 = aid->longitude_e7,
+        .alt_cm = aid->altitude_cm,
+        .pos_acc_cm = GPS_AID_POS_ACC_M * 100,
+    };
+    send_ubx(UBX_CLASS_MGA, UBX_ID_MGA_INI, (const uint8_t *)&pos, sizeof(pos));
+
+    if (time_known && GPS_AID_TIME_ACC_S > 0)
+    {
+        ubx_mga_ini_time_utc_t time = {
+            .type = UBX_MGA_INI_TIME_UTC,
+            .leap_secs = -128,
+            .year = aid->year,
+            .month = aid->month,
+            .day = aid->day,
+            .hour = aid->hour,
+            .min = aid->min,
+            .sec = aid->sec,
+            .t_acc_s = GPS_AID_TIME_ACC_S,
+        };
+        send_ubx(UBX_CLASS_MGA, UBX_ID_MGA_INI, (const uint8_t *)&time, sizeof(time));
+    }
+
+    if (aid->drift_valid)
+    {
+        ubx_mga_ini_clkd_t clkd = {
+            .type = UBX_MGA_INI_CLKD,
+            .clk_d_ns_s = aid->drift_ns_s,
+            .clk_d_acc_ns_s = GPS_AID_DRIFT_ACC_NS_S,
+        };
+        send_ubx(UBX_CLASS_MGA, UBX_ID_MGA_INI, (const uint8_t *)&clkd, sizeof(clkd));
+    }
+
+    LOG("[GPS] Aiding sent: " GPS_E7_FMT "," GPS_E7_FMT ", time %s, drift %s\n",
+        GPS_E7_ARGS(aid->latitude_e7), GPS_E7_ARGS(aid->longitude_e7),
+        time_known ? "yes" : "no", aid->drift_valid ? "yes" : "no");
+}
+
+bool gps_get_clock_drift(int32_t *drift_ns_s)
+{
+#if GPS_USE_UBX
+    *drift_ns_s = clock_drift_ns_s;
+    return clock_drift_valid;
+#else
+    (void)drift_ns_s;
+    return false;
+#endif
+}
+
+uint32_t gps_link_baud(void)
+{
+    return link_baud;
+}
+
+#if GPS_USE_UBX
+
+/** @brief Copies a decoded NAV-PVT message into the static `last_data` structure.
+ *
+ * Unlike the NMEA path, a single message carries position, altitude, velocity,
+ * satellite count and time, so every field is refreshed at once.
+ *
+ * @param[in] pvt   The decoded NAV-PVT payload.
+ * @param[in] rx_us `time_us_64()` at which the first byte of the frame was received.
+ */
+static void process_nav_pvt(const ubx_nav_pvt_t *pvt, uint64_t rx_us)
+{
+    last_data.fix = (pvt->flags & UBX_NAV_PVT_FLAGS_FIX_OK) &&
+                    (pvt->fix_type == UBX_FIX_2D || pvt->fix_type == UBX_FIX_3D ||
+                     pvt->fix_type == UBX_FIX_GNSS_DEAD_RECKONING);
+    last_data.satellites = pvt->num_sv;
+
+    if (last_data.fix)
+    {
+        last_data.latitude_e7 = pvt->lat_e7;
+        last_data.longitude_e7 = pvt->lon_e7;
+        last_data.altitude = (float)pvt->hmsl_mm / 1000.0f;
+        last_data.ground_speed = (float)pvt->g_speed_mm_s / 1000.0f;
+        last_data.vertical_speed = -(float)pvt->vel_d_mm_s / 1000.0f;
+    }
+
+    if ((pvt->valid & (UBX_NAV_PVT_VALID_DATE | UBX_NAV_PVT_VALID_TIME)) ==
+        (UBX_NAV_PVT_VALID_DATE | UBX_NAV_PVT_VALID_TIME))
+    {
+        last_data.hour = pvt->hour;
+        last_data.min = pvt->min;
+        last_data.sec = pvt->sec;
+        // A negative fraction belongs to the previous second; it only occurs around rounding.
+        last_data.microsec = (pvt->nano > 0) ? (uint32_t)pvt->nano / 1000 : 0;
+        last_data.timestamp_us = rx_us;
+
+        last_data.day = pvt->day;
+        last_data.month = pvt->month;
+        last_data.year = pvt->year;
+    }
 }
 
+bool gps_update(void)
+{
+    bool new_data = false;
+
+    // The receive ring belongs to gps_configure_step() until the receiver is set up.
+    if (setup_state != SETUP_DONE) return false;
+
+    uint8_t c;
+
+    while (rx_pop(&c))
+    {
+
+        if (c == UBX_SYNC_1 && ubx_parser.state == 0) frame_start_us = last_start_us;
+
+        if (ubx_parser_feed(&ubx_parser, c))
+        {
+            ubx_nav_pvt_t pvt;
+            ubx_nav_clk_t clk;
+            if (ubx_decode_nav_pvt(&ubx_parser, &pvt))
+            {
+                process_nav_pvt(&pvt, frame_start_us);
+                new_data = true;
+            }
+            else if (ubx_decode_nav_clk(&ubx_parser, &clk))
+            {
+                clock_drift_ns_s = clk.clk_d_ns_s;
+                clock_drift_valid = true;
+            }
+        }
+    }
+    return new_data;
+}
+
+#else
+
 /** @brief Reads a line of data received from the GPS module and parses it.   
  * 
  * It checks the sentence ID using the `minmea` library and parses specific frames:
@@ -35,13 +621,20 @@ void gps_init(void)
  *
  * @param[in] line  A null-terminated string containing the raw NMEA sentence
  * (e.g., "$GPRMC,123519,A,4807.038,N...").
+ * @param[in] rx_us `time_us_64()` at which the first character of the sentence was received.
  *
  * @note This function modifies the internal static variable `last_data`.
  * @warning This function assumes `line` is a valid C-string.
 */
-static void read_and_process(char *line)
+static void read_and_process(char *line, uint64_t rx_us)
 {
-    if (minmea_sentence_id(line, false) == MINMEA_SENTENCE_RMC)
+    enum minmea_sentence_id id = minmea_sentence_id(line, false);
+
+    if (id == MINMEA_INVALID)
+    {
+        checksum_failures++;
+    }
+    else if (id == MINMEA_SENTENCE_RMC)
     {
         struct minmea_sentence_rmc frame;
         
@@ -50,12 +643,15 @@ static void read_and_process(char *line)
             if (frame.valid)
             {
                 last_data.fix = true;
-                last_data.latitude = minmea_tocoord(&frame.latitude);
-                last_data.longitude = minmea_tocoord(&frame.longitude);
+                last_data.latitude_e7 = minmea_tocoord_e7(&frame.latitude);
+                last_data.longitude_e7 = minmea_tocoord_e7(&frame.longitude);
+                if (frame.speed.scale != 0) last_data.ground_speed = minmea_tofloat(&frame.speed) * KNOTS_TO_MPS;
 
                 last_data.hour = frame.time.hours;
                 last_data.min = frame.time.minutes;
                 last_data.sec = frame.time.seconds;
+                last_data.microsec = frame.time.microseconds;
+                last_data.timestamp_us = rx_us;
 
                 last_data.day = frame.date.day;
                 last_data.month = frame.date.month;
@@ -64,7 +660,7 @@ static void read_and_process(char *line)
             else last_data.fix = false;
         }
     } 
-    else if (minmea_sentence_id(line, false) == MINMEA_SENTENCE_GGA)
+    else if (id == MINMEA_SENTENCE_GGA)
     {
         struct minmea_sentence_gga frame;
         if (minmea_parse_gga(&frame, line)) 
@@ -82,30 +678,49 @@ static void read_and_process(char *line)
 bool gps_update(void)
 {
     bool new_data = false;
+
+    // The receive ring belongs to gps_configure_step() until the receiver is set up.
+    if (setup_state != SETUP_DONE) return false;
     
-    while (uart_is_readable(GPS_UART_ID)) 
+    uint8_t c;
+
+    while (rx_pop(&c)) 
     {
-        char c = uart_getc(GPS_UART_ID);
 
         if (c == '\n' || c == '\r') 
         {
             if (buffer_pos > 0)
             {
                 line_buffer[buffer_pos] = '\0';
-                read_and_process(line_buffer);
+                read_and_process(line_buffer, line_start_us);
                 new_data = true; // update flag - true
             }
             buffer_pos = 0; // cleaning the buffer for the next read sentence
         } else 
         {
-            if (buffer_pos < NMEA_BUFFER_LEN - 1) line_buffer[buffer_pos++] = c;
+            if (buffer_pos == 0) line_start_us = last_start_us;
+            if (buffer_pos < NMEA_BUFFER_LEN - 1) line_buffer[buffer_pos++] = (char)c;
             else buffer_pos = 0;
         }
     }
     return new_data;
 }
 
+#endif // GPS_USE_UBX
+
 void gps_get_data(gps_data_t *data) 
 { 
     *data = last_data;
+}
+
+void gps_get_stats(gps_stats_t *stats)
+{
+    stats->uart_overruns = uart_overruns;
+    stats->uart_framing_errors = uart_framing_errors;
+    stats->rx_dropped = rx_dropped;
+#if GPS_USE_UBX
+    stats->checksum_failures = ubx_parser.checksum_errors + ubx_parser.length_errors;
+#else
+    stats->checksum_failures = checksum_failures;
+#endif
 }
\ No newline at end of file
@@ -16,52 +16,170 @@
 
 // CONFIGURATION MACROS
 
-/** @brief UART Baud rate for the GPS module (Standard is usually 9600). */
+/** @brief UART Baud rate for the GPS module (Standard is usually 9600). 
+ * @details This is the receiver's factory default and the fallback rate. */
 #define GPS_BAUD_RATE 9600
 
+/** @brief UART Baud rate the receiver is switched to at boot. */
+#define GPS_FAST_BAUD_RATE 115200
+
+/** @brief Navigation (position update) rate requested from the receiver at boot [Hz]. */
+#define GPS_NAV_RATE_HZ 5
+
 /** @brief The hardware UART instance to use (uart0 or uart1). */
 #define GPS_UART_ID uart0
 
+/** @brief Register block of `GPS_UART_ID` (uart0_hw or uart1_hw), read directly by the receive interrupt. */
+#define GPS_UART_HW uart0_hw
+
 /** @brief GPIO pin for UART transmission (Pico TX). */
 #define GPS_TX_PIN 8
 
 /** @brief GPIO pin for UART reception (Pico RX). */
 #define GPS_RX_PIN 9
 
+/** @brief Selects the receive protocol: 0 parses NMEA text (RMC + GGA) with minmea,
+ * 1 decodes u-blox UBX NAV-PVT binary frames.
+ * @note With 1 the receiver has to be configured to output NAV-PVT on its UART.
+ */
+#ifndef GPS_USE_UBX
+#define GPS_USE_UBX 0
+#endif
+
+/** @brief Accuracy given with the position hint of `gps_send_aiding()` [m].
+ * @details The hint is the last fix of an earlier power cycle, usually the pad or the landing
+ * site; a launch elsewhere within this radius still profits from it.
+ */
+#define GPS_AID_POS_ACC_M 10000
+
+/** @brief Accuracy given with the time hint of `gps_send_aiding()` [s], 0 to leave it out.
+ * @details The hint is only sent while the calendar follows the GPS (`time_manager_synced()`),
+ * e.g. after a warm restart: its error is then the estimate of the time lost to the reset,
+ * within the watchdog timeout. The time of a stored fix is never sent: it is behind by however
+ * long the CanSat was off, possibly days, and aiding time worse than its stated accuracy slows
+ * the receiver down.
+ */
+#define GPS_AID_TIME_ACC_S 10
+
+/** @brief Accuracy given with the clock drift hint of `gps_send_aiding()` [ns/s]. */
+#define GPS_AID_DRIFT_ACC_NS_S 1000
+
+/** @brief printf/f_printf format for a coordinate kept in 1e-7 degrees, used with `GPS_E7_ARGS`.
+ * @details Prints the exact decimal value (e.g. "-37.8608333") without any float conversion.
+ */
+#define GPS_E7_FMT "%s%ld.%07ld"
+
+/** @brief Arguments matching `GPS_E7_FMT` for a coordinate in 1e-7 degrees. */
+#define GPS_E7_ARGS(e7) ((e7) < 0 ? "-" : ""), \
+    (long)(((e7) < 0 ? -(int64_t)(e7) : (int64_t)(e7)) / 10000000), \
+    (long)(((e7) < 0 ? -(int64_t)(e7) : (int64_t)(e7)) % 10000000)
+
 // DATA STRUCTURES
 
 /** @brief The structure keeps the parsed GPS position and time information.
- ** @details It is updated whenever a valid NMEA senstence ($GPRMC in this case) is succesfully parsed.
+ ** @details It is updated whenever a valid NMEA senstence ($GPRMC in this case) is succesfully parsed,
+ * or, with `GPS_USE_UBX`, whenever a valid NAV-PVT frame is decoded.
  */
 typedef struct 
 {
-    float latitude; /// Latitude in decimal degrees.
-    float longitude; /// Longitude in decimal degrees.
+    int32_t latitude_e7; /// Latitude in decimal degrees scaled by 1e7 (e.g. 51.1156808 -> 511156808).
+    int32_t longitude_e7; /// Longitude in decimal degrees scaled by 1e7.
     float altitude; /// Altitude above mean sea level in meters [m].
+    float ground_speed; /// Horizontal speed over ground [m/s].
+    float vertical_speed; /// Vertical speed, positive upwards [m/s]. Only reported by UBX, 0 with NMEA.
     uint8_t satellites; /// Number of satellites currently in view.
     uint8_t hour; /// UTC Hour
     uint8_t min; /// UTC Minute
     uint8_t sec; /// UTC Second
+    uint32_t microsec; /// UTC sub-second part of the fix time, in microseconds.
     uint16_t year;
     uint8_t month;
     uint8_t day;
     bool fix; /// True if a valid GPS fix is currently available.
+    uint64_t timestamp_us; /// `time_us_64()` at which the sentence carrying this fix was received.
 } gps_data_t;
 
+/** @brief What the receiver is told at start-up to find the satellites sooner (`gps_send_aiding()`). */
+typedef struct
+{
+    int32_t latitude_e7; /// Latitude [1e-7 deg].
+    int32_t longitude_e7; /// Longitude [1e-7 deg].
+    int32_t altitude_cm; /// Altitude above mean sea level [cm].
+    uint16_t year; /// UTC date and time of the fix.
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    bool drift_valid; /// `drift_ns_s` was measured (only reported by UBX).
+    int32_t drift_ns_s; /// Drift of the receiver's oscillator [ns/s].
+} gps_aid_t;
+
+/** @brief Receive error counters, cumulative since boot. */
+typedef struct
+{
+    uint32_t uart_overruns; /// Bytes lost because the UART FIFO overflowed before the interrupt emptied it.
+    uint32_t uart_framing_errors; /// Bytes received with a framing error or as a break condition.
+    uint32_t rx_dropped; /// Bytes dropped because the receive ring (or its timestamp ring) was full.
+    uint32_t checksum_failures; /// NMEA sentences (UBX frames with `GPS_USE_UBX`) rejected by their checksum or, for UBX, their length.
+} gps_stats_t;
+
 // FUNCTIONS
 
-/** @brief Initializes the GPS UART connection and GPIO pins.
+/** @brief Initializes the GPS UART connection and GPIO pins, and starts configuring the receiver.
  * @details Sets up the specified GPS_UART_ID with the baud rate defined in
- * GPS_BAUD_RATE and configures the TX/RX pins.
- ** @note This must be called once at system startup before the main loop.
+ * GPS_BAUD_RATE, configures the TX/RX pins and starts interrupt-driven reception.
+ * The receiver is then reconfigured over UBX by `gps_configure_step()`: unused sentences
+ * (GLL, GSA, GSV, VTG, TXT) are disabled, the UART is switched to GPS_FAST_BAUD_RATE and the
+ * navigation rate is set to GPS_NAV_RATE_HZ. Each step is verified by ACK or by observed
+ * traffic; if the faster baud rate cannot be verified, both ends stay at GPS_BAUD_RATE.
+ ** @note This must be called once at system startup, then `gps_configure_step()` from the main loop.
  */
 
 extern void gps_init(void);
 
+/** @brief Advances the receiver configuration started by `gps_init()`, without waiting for it.
+ * @details Each call sends at most one configuration message, or checks the output received
+ * since the previous call for its ACK; the waits for the receiver (up to a few seconds in
+ * all) are spread over the calls, so the caller keeps sampling in between. Until it is done
+ * `gps_update()` reports nothing.
+ ** @return true once the receiver is configured, or given up on; call it until then.
+ */
+extern bool gps_configure_step(void);
+
+/** @brief Restarts reception from a receiver that is already configured, without talking to it.
+ * @details For a warm restart (warm_restart.h): the receiver stayed powered through the reset
+ * of the Pico and kept its configuration, so only the UART is set up, at the baud rate
+ * `gps_link_baud()` returned before the reset. Takes no measurable time.
+ ** @param[in] baud Baud rate of the receiver's UART.
+ */
+extern void gps_resume(uint32_t baud);
+
+/** @brief Hands the receiver a position, clock drift and, if known, the time to start its search from.
+ * @details Sent as UBX MGA-INI messages (POS_LLH, TIME_UTC, CLKD) once `gps_configure_step()` is done;
+ * with them a cold receiver narrows its search for satellites and gets its first fix sooner.
+ * The receiver does not acknowledge them. The altitude is sent as the height above the
+ * ellipsoid, which is well within the accuracy of `GPS_AID_POS_ACC_M`.
+ ** @param[in] aid Hints, typically the last fix of an earlier power cycle (last_fix.h).
+ ** @param[in] time_known The date and time in `aid` are the current UTC time within
+ * `GPS_AID_TIME_ACC_S`; otherwise TIME_UTC is not sent.
+ */
+extern void gps_send_aiding(const gps_aid_t *aid, bool time_known);
+
+/** @brief Retrieves the drift of the receiver's oscillator (UBX NAV-CLK, with `GPS_USE_UBX`).
+ ** @param[out] drift_ns_s Drift of the last NAV-CLK message [ns/s].
+ ** @return true if a drift has been received since boot.
+ */
+extern bool gps_get_clock_drift(int32_t *drift_ns_s);
+
+/** @brief Baud rate the UART, and so the receiver, talks at once `gps_configure_step()` is done (0 before `gps_init()`). */
+extern uint32_t gps_link_baud(void);
+
 /** @brief Polls the UART for newly aquired GPS data and sends it to be parsed.
  * @details This function should be called frequently (e.g., in the main loop).
  * It reads available characters from the UART buffer and calls a function to process
- * NMEA sentences.
+ * NMEA sentences (or feeds them to the UBX frame parser when `GPS_USE_UBX` is set).
+ * While the receiver is being configured (`gps_configure_step()`) it leaves the data alone.
  ** @return true if a valid packet was fully parsed and data was updated.
  ** @return false if no new complete packet is available yet.
  */
@@ -73,4 +191,9 @@ extern bool gps_update(void);
  */
 extern void gps_get_data(gps_data_t *data);
 
+/** @brief Retrieves the receive error counters.
+ ** @param[out] stats Pointer to a 'gps_stats_t' structure where the counters will be copied.
+ */
+extern void gps_get_stats(gps_stats_t *stats);
+
 #endif // GPS_MODULE_H
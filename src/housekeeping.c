@@ -0,0 +1,69 @@
+#include "pico/stdlib.h"
+#include "housekeeping.h"
+#include "gps_module.h"
+#include "radio_module.h"
+#include "sd_latency.h"
+
+// Main loop figures of the current period, reset by housekeeping_collect().
+static uint64_t period_start_us = 0;
+static uint32_t period_iterations = 0;
+static uint64_t period_busy_us = 0;
+
+static uint32_t deadline_misses = 0;
+static uint32_t worst_lateness_us = 0;
+
+void housekeeping_loop_iteration(uint64_t start_us, bool busy)
+{
+    period_iterations++;
+    if (busy) period_busy_us += time_us_64() - start_us;
+}
+
+void housekeeping_loop_tick(uint32_t lateness_us)
+{
+    if (lateness_us > HOUSEKEEPING_TICK_DEADLINE_US) deadline_misses++;
+    if (lateness_us > worst_lateness_us) worst_lateness_us = lateness_us;
+}
+
+void housekeeping_collect(housekeeping_t *hk)
+{
+    uint64_t now = time_us_64();
+    uint64_t period_us = now - period_start_us;
+
+    hk->timestamp_us = now;
+    hk->loop_rate_hz = period_us ? (uint32_t)((uint64_t)period_iterations * 1000000ULL / period_us) : 0;
+    hk->busy_permille = period_us ? (uint16_t)(period_busy_us * 1000ULL / period_us) : 0;
+    hk->deadline_misses = deadline_misses;
+    hk->worst_lateness_us = worst_lateness_us;
+
+    period_start_us = now;
+    period_iterations = 0;
+    period_busy_us = 0;
+
+    gps_stats_t gps;
+    gps_get_stats(&gps);
+    hk->gps_uart_overruns = gps.uart_overruns;
+    hk->gps_uart_framing_errors = gps.uart_framing_errors;
+    hk->gps_rx_dropped = gps.rx_dropped;
+    hk->gps_checksum_failures = gps.checksum_failures;
+
+    for (int d = 0; d < I2C_DEV_COUNT; d++)
+    {
+        hk->i2c_errors[d] = i2c_device_stats[d].errors;
+        hk->i2c_timeouts[d] = i2c_device_stats[d].timeouts;
+    }
+
+    hk->sd_errors = 0;
+    hk->sd_stalls = 0;
+    hk->sd_worst_us = sd_latency_worst[0].duration_us;
+    for (int op = 0; op < SD_OP_COUNT; op++)
+    {
+        hk->sd_errors += sd_latency_stats[op].errors;
+        hk->sd_stalls += sd_latency_stats[op].stalls;
+    }
+
+    radio_stats_t radio;
+    radio_module_get_stats(&radio);
+    hk->radio_queued = radio.queued;
+    hk->radio_sent = radio.sent;
+    hk->radio_dropped = radio.dropped;
+}
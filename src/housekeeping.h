@@ -0,0 +1,75 @@
+/** @file housekeeping.h
+ ** @brief Periodic housekeeping record: performance and error counters of every subsystem.
+ * @details Every `HOUSEKEEPING_PERIOD_S` seconds the main loop collects one record, appends it
+ * to 'housekeeping.csv' on the microSD card (`save_housekeeping_log()`) and sends a condensed
+ * copy over the radio (`radio_module_send_housekeeping()`), so a flight that went slow leaves
+ * evidence of why, even if the card is lost.
+ *
+ * The counters are kept by the modules that own them:
+ * - main loop: iterations, busy time and 1 Hz deadline misses (`housekeeping_loop_*`),
+ * - gps_module.c: UART overruns, framing errors, dropped bytes, checksum failures,
+ * - atm_sen_module.c: I2C errors and timeouts per device,
+ * - sd_latency.c: SD errors, stalls and the slowest operation,
+ * - radio_module.c: frames queued, sent and dropped.
+ *
+ * Loop figures cover the last period; everything else is cumulative since boot.
+ */
+
+#ifndef HOUSEKEEPING_H
+#define HOUSEKEEPING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "atm_sen_module.h"
+
+// CONFIGURATION MACROS
+
+/** @brief Period of the housekeeping record [s]. */
+#define HOUSEKEEPING_PERIOD_S 10
+
+/** @brief A 1 Hz tick handled later than this after the second boundary is a deadline miss [us]. */
+#define HOUSEKEEPING_TICK_DEADLINE_US 100000
+
+// DATA STRUCTURES
+
+/** @brief One housekeeping record. */
+typedef struct
+{
+    uint64_t timestamp_us; /// `time_us_64()` at which the record was collected.
+    uint32_t loop_rate_hz; /// Main loop iterations per second over the last period.
+    uint16_t busy_permille; /// Share of the last period spent in iterations that did work [1/1000].
+    uint32_t deadline_misses; /// 1 Hz ticks handled later than `HOUSEKEEPING_TICK_DEADLINE_US`.
+    uint32_t worst_lateness_us; /// Latest 1 Hz tick since boot.
+    uint32_t gps_uart_overruns; /// See `gps_stats_t`.
+    uint32_t gps_uart_framing_errors;
+    uint32_t gps_rx_dropped;
+    uint32_t gps_checksum_failures;
+    uint32_t i2c_errors[I2C_DEV_COUNT]; /// Failed transfers per `i2c_device_t`.
+    uint32_t i2c_timeouts[I2C_DEV_COUNT]; /// Timed out transfers per `i2c_device_t`.
+    uint32_t sd_errors; /// Failed SD operations of any kind.
+    uint32_t sd_stalls; /// SD operations slower than `SD_STALL_THRESHOLD_US`.
+    uint32_t sd_worst_us; /// Slowest SD operation.
+    uint32_t radio_queued; /// Frames handed to the radio module.
+    uint32_t radio_sent; /// Frames whose transmission completed.
+    uint32_t radio_dropped; /// Frames whose transmission did not complete.
+} housekeeping_t;
+
+// FUNCTIONS
+
+/** @brief Counts one main loop iteration.
+ ** @param[in] start_us `time_us_64()` taken at the start of the iteration.
+ ** @param[in] busy true if the iteration did any work (new GPS data or the 1 Hz tick).
+ */
+extern void housekeeping_loop_iteration(uint64_t start_us, bool busy);
+
+/** @brief Records how late the 1 Hz tick was handled (see `time_manager_tick_lateness_us()`).
+ ** @param[in] lateness_us Time between the second boundary and the start of the 1 Hz work.
+ */
+extern void housekeeping_loop_tick(uint32_t lateness_us);
+
+/** @brief Fills a record from the counters of every module and starts a new loop period.
+ ** @param[out] hk Pointer to the record to fill.
+ */
+extern void housekeeping_collect(housekeeping_t *hk);
+
+#endif // HOUSEKEEPING_H
@@ -0,0 +1,36 @@
+#include "pico/stdlib.h"
+#include "i2c_trace.h"
+
+#if I2C_TRACING
+
+#include <stdio.h>
+#include "flash_config.h"
+
+i2c_trace_record_t i2c_trace_buffer[I2C_TRACE_BUFFER_LEN];
+uint32_t i2c_trace_head;
+
+void i2c_trace_dump(void)
+{
+    // Only the main loop talks on the bus, so the ring cannot change while it is printed.
+    uint32_t head = i2c_trace_head;
+    uint32_t count = (head < I2C_TRACE_BUFFER_LEN) ? head : I2C_TRACE_BUFFER_LEN;
+
+    printf("# i2c trace v1 baud=%lu records=%lu dropped=%lu\n",
+           (unsigned long)flash_config()->i2c_baud_hz, (unsigned long)count, (unsigned long)(head - count));
+    printf("# start_us,addr,dir,len,nostop,duration_us,result\n");
+
+    for (uint32_t n = head - count; n != head; n++)
+    {
+        const i2c_trace_record_t *r = &i2c_trace_buffer[n & (I2C_TRACE_BUFFER_LEN - 1)];
+        printf("%lu,0x%02x,%c,%u,%u,%u,%d\n", (unsigned long)r->start_us, r->addr, r->write ? 'W' : 'R',
+               r->len, r->nostop, r->duration_us, r->result);
+    }
+    printf("# end\n");
+}
+
+void i2c_trace_command(int c)
+{
+    if (c == I2C_TRACE_DUMP_CHAR) i2c_trace_dump();
+}
+
+#endif // I2C_TRACING
@@ -0,0 +1,99 @@
+/** @file i2c_trace.h
+ ** @brief I2C bus transaction tracer.
+ * @details Records every transfer on the sensor bus (address, direction, length, start time,
+ * duration and result) into a RAM ring of `I2C_TRACE_BUFFER_LEN` records; the oldest are
+ * overwritten. Transfers are captured in the link-time I2C wrappers of atm_sen_module.c, so
+ * the ones issued inside the sensor drivers are included.
+ *
+ * Sending `I2C_TRACE_DUMP_CHAR` over USB prints the ring as text; tools/i2c_analyze reads the
+ * dump and reports bus utilization per device, gaps between transfers and retries.
+ *
+ * With `I2C_TRACING` set to 0 (the default) every macro expands to nothing.
+ * Enable it with the CMake option `CS_I2C_TRACING=ON`.
+ */
+
+#ifndef I2C_TRACE_H
+#define I2C_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// CONFIGURATION MACROS
+
+/** @brief 1 builds the I2C tracer in, 0 compiles every `I2C_TRACE_*` macro to nothing. */
+#ifndef I2C_TRACING
+#define I2C_TRACING 0
+#endif
+
+/** @brief Number of records in the ring buffer (a power of two). */
+#define I2C_TRACE_BUFFER_LEN 1024
+
+/** @brief Character received over USB that triggers a dump of the I2C trace. */
+#define I2C_TRACE_DUMP_CHAR 'i'
+
+// DATA STRUCTURES
+
+/** @brief One I2C transfer. */
+typedef struct
+{
+    uint32_t start_us; /// Low 32 bits of `time_us_64()` when the transfer was started.
+    uint16_t duration_us; /// Transfer duration, saturated at 65535.
+    uint8_t addr; /// 7-bit device address.
+    uint8_t write; /// 1 for a write, 0 for a read.
+    uint8_t len; /// Bytes requested, saturated at 255.
+    int8_t result; /// Bytes transferred, or a negative `PICO_ERROR_*` code.
+    uint8_t nostop; /// 1 if the transfer kept the bus (repeated start follows).
+} i2c_trace_record_t;
+
+// FUNCTIONS
+
+#if I2C_TRACING
+
+#include "pico/stdlib.h"
+
+/** @brief The ring buffer; `i2c_trace_head` counts every transfer ever recorded. */
+extern i2c_trace_record_t i2c_trace_buffer[I2C_TRACE_BUFFER_LEN];
+extern uint32_t i2c_trace_head;
+
+/** @brief Records one finished transfer.
+ ** @param[in] addr 7-bit device address.
+ ** @param[in] write true for a write, false for a read.
+ ** @param[in] len Bytes requested.
+ ** @param[in] nostop true if the bus is kept for a repeated start.
+ ** @param[in] start_us `time_us_32()` taken right before the transfer.
+ ** @param[in] result Value returned by the SDK call.
+ */
+static inline void i2c_trace_record(uint8_t addr, bool write, size_t len, bool nostop, uint32_t start_us, int result)
+{
+    uint32_t duration = time_us_32() - start_us;
+
+    i2c_trace_buffer[i2c_trace_head++ & (I2C_TRACE_BUFFER_LEN - 1)] = (i2c_trace_record_t){
+        .start_us = start_us,
+        .duration_us = (duration > UINT16_MAX) ? UINT16_MAX : (uint16_t)duration,
+        .addr = addr,
+        .write = write,
+        .len = (len > UINT8_MAX) ? UINT8_MAX : (uint8_t)len,
+        .result = (result > INT8_MAX) ? INT8_MAX : (int8_t)result,
+        .nostop = nostop,
+    };
+}
+
+/** @brief Handles a character received over stdio: `I2C_TRACE_DUMP_CHAR` prints the ring. */
+extern void i2c_trace_command(int c);
+
+/** @brief Prints the whole ring over stdio, oldest transfer first. */
+extern void i2c_trace_dump(void);
+
+#define I2C_TRACE_RECORD(addr, write, len, nostop, start_us, result) i2c_trace_record((addr), (write), (len), (nostop), (start_us), (result))
+#define I2C_TRACE_COMMAND(c) i2c_trace_command(c)
+
+#else
+
+#define I2C_TRACE_RECORD(addr, write, len, nostop, start_us, result) \
+    ((void)(addr), (void)(write), (void)(len), (void)(nostop), (void)(start_us), (void)(result))
+#define I2C_TRACE_COMMAND(c) ((void)0)
+
+#endif // I2C_TRACING
+
+#endif // I2C_TRACE_H
@@ -0,0 +1,95 @@
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "last_fix.h"
+#include "flash_io.h"
+#include "debug_mode.h"
+#include "crc32.h"
+
+_Static_assert(sizeof(last_fix_record_t) == 32, "record layout");
+
+#define SLOT_COUNT (FLASH_SECTOR_SIZE / sizeof(last_fix_record_t))
+#define FREE_MAGIC 0xFFFFFFFFu
+
+static uint32_t next_slot = 0; // First free slot (SLOT_COUNT: the sector is full).
+static uint64_t last_save_us = 0;
+static bool saved = false;
+
+static const last_fix_record_t *slot_record(uint32_t slot)
+{
+    return flash_io_xip(LAST_FIX_OFFSET + slot * sizeof(last_fix_record_t));
+}
+
+static bool record_valid(const last_fix_record_t *r)
+{
+    return r->magic == LAST_FIX_MAGIC && r->crc == crc32_compute(r, offsetof(last_fix_record_t, crc));
+}
+
+bool last_fix_init(gps_aid_t *aid)
+{
+    next_slot = 0;
+    while (next_slot < SLOT_COUNT && slot_record(next_slot)->magic != FREE_MAGIC) next_slot++;
+
+    // The newest record may have been cut short by a power loss: fall back on the one before.
+    for (uint32_t slot = next_slot; slot > 0; slot--)
+    {
+        const last_fix_record_t *r = slot_record(slot - 1);
+
+        if (!record_valid(r)) continue;
+
+        *aid = r->aid;
+        LOG("[Last fix] " GPS_E7_FMT "," GPS_E7_FMT " at %04u-%02u-%02u %02u:%02u:%02u UTC\n",
+            GPS_E7_ARGS(aid->latitude_e7), GPS_E7_ARGS(aid->longitude_e7),
+            aid->year, aid->month, aid->day, aid->hour, aid->min, aid->sec);
+        return true;
+    }
+    LOG("[Last fix] None stored\n");
+    return false;
+}
+
+bool last_fix_save(const gps_data_t *gps)
+{
+    if (!gps->fix || gps->year == 0 || (gps->latitude_e7 == 0 && gps->longitude_e7 == 0)) return false;
+
+    last_fix_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.magic = LAST_FIX_MAGIC;
+    r.aid.latitude_e7 = gps->latitude_e7;
+    r.aid.longitude_e7 = gps->longitude_e7;
+    r.aid.altitude_cm = (int32_t)(gps->altitude * 100.0f);
+    r.aid.year = gps->year;
+    r.aid.month = gps->month;
+    r.aid.day = gps->day;
+    r.aid.hour = gps->hour;
+    r.aid.min = gps->min;
+    r.aid.sec = gps->sec;
+    r.aid.drift_valid = gps_get_clock_drift(&r.aid.drift_ns_s);
+    r.crc = crc32_compute(&r, offsetof(last_fix_record_t, crc));
+
+    if (next_slot == SLOT_COUNT)
+    {
+        flash_io_erase(LAST_FIX_OFFSET, FLASH_SECTOR_SIZE);
+        next_slot = 0;
+    }
+
+    // Programming works on whole pages; 0xFF leaves the other records of the page as they are.
+    static uint8_t page[FLASH_PAGE_SIZE];
+    uint32_t address = LAST_FIX_OFFSET + next_slot * sizeof(r);
+    uint32_t page_address = address & ~(FLASH_PAGE_SIZE - 1);
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(&page[address - page_address], &r, sizeof(r));
+    flash_io_program(page_address, page, sizeof(page));
+
+    next_slot++;
+    last_save_us = time_us_64();
+    saved = true;
+    return true;
+}
+
+void last_fix_update(const gps_data_t *gps)
+{
+    if (saved && time_us_64() - last_save_us < LAST_FIX_SAVE_PERIOD_S * 1000000ULL) return;
+
+    last_fix_save(gps);
+}
@@ -0,0 +1,69 @@
+/** @file last_fix.h
+ ** @brief Last GNSS fix, time and receiver clock drift kept in flash for the next start-up.
+ * @details A receiver that starts cold searches the whole sky over every possible Doppler
+ * shift and takes tens of seconds, often minutes, to its first fix. Told roughly where it is,
+ * what time it is and how far its oscillator is off, it searches only the satellites in view
+ * and gets there much sooner, so the CanSat is ready on the pad earlier.
+ *
+ * The main loop hands every GPS update to `last_fix_update()`, which stores a valid fix every
+ * `LAST_FIX_SAVE_PERIOD_S`; `last_fix_save()` stores one at once (at landing). At boot
+ * `last_fix_init()` returns the newest one: `main()` seeds the calendar with its date and time
+ * and passes its position and drift to `gps_send_aiding()` once the receiver is configured
+ * (its time, possibly days old, is not sent as aiding).
+ *
+ * The fixes take the sector below the configuration sector (flash_config.h) as 32-byte
+ * records with a magic number and a CRC-32, appended one after the other: a save costs one
+ * page program, and the sector is erased only once it is full.
+ */
+
+#ifndef LAST_FIX_H
+#define LAST_FIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "gps_module.h"
+#include "flash_config.h"
+
+// CONFIGURATION MACROS
+
+/** @brief Offset of the last-fix sector from the start of flash: below the configuration sector. */
+#define LAST_FIX_OFFSET (FLASH_CONFIG_OFFSET - FLASH_SECTOR_SIZE)
+
+/** @brief First word of a record: "FIX!" in memory order. */
+#define LAST_FIX_MAGIC 0x21584946u
+
+/** @brief Time between two stored fixes while the receiver has one [s]. */
+#define LAST_FIX_SAVE_PERIOD_S 60
+
+// DATA STRUCTURES
+
+/** @brief One stored fix (32 bytes). */
+typedef struct
+{
+    uint32_t magic; /// `LAST_FIX_MAGIC` (0xFFFFFFFF: free slot).
+    gps_aid_t aid; /// Position, UTC time and clock drift.
+    uint32_t crc; /// CRC-32 of the fields above.
+} last_fix_record_t;
+
+// FUNCTIONS
+
+/** @brief Finds the newest stored fix; reads flash through XIP only. Call once at boot.
+ ** @param[out] aid The newest fix, if there is one.
+ ** @return true if a valid fix was found.
+ */
+extern bool last_fix_init(gps_aid_t *aid);
+
+/** @brief Stores the fix if it is valid and the last one is `LAST_FIX_SAVE_PERIOD_S` old.
+ ** @param[in] gps Latest GPS data.
+ */
+extern void last_fix_update(const gps_data_t *gps);
+
+/** @brief Stores the fix now, if it is valid (e.g. at landing).
+ ** @param[in] gps Latest GPS data.
+ ** @return true if a fix was stored.
+ */
+extern bool last_fix_save(const gps_data_t *gps);
+
+#endif // LAST_FIX_H
@@ -6,85 +6,381 @@
 #include "time_manager.h"
 #include "gps_module.h"
 #include "radio_module.h"
+#include "profiler.h"
+#include "sd_latency.h"
+#include "housekeeping.h"
+#include "i2c_trace.h"
+#include "boot_timing.h"
+#include "warm_restart.h"
+#include "flash_config.h"
+#include "flash_log.h"
+#include "last_fix.h"
+#include "flight_phase.h"
+#ifdef PICO_VBUS_PIN
+#include "pico/stdio_usb.h"
+#endif
+
+/** @brief Gives a USB host the chance to open the console before the boot log is printed.
+ * @details Only when the board is powered over USB (VBUS sensed): on the battery, or after a
+ * reset in flight, there is nobody to wait for. Boards without VBUS sensing never wait.
+ */
+static void wait_for_usb_host(void)
+{
+#ifdef PICO_VBUS_PIN
+    gpio_init(PICO_VBUS_PIN);
+    gpio_set_dir(PICO_VBUS_PIN, GPIO_IN);
+    if (!gpio_get(PICO_VBUS_PIN)) return;
+
+    uint64_t deadline = time_us_64() + BOOT_USB_WAIT_MS * 1000ULL;
+    while (!stdio_usb_connected() && time_us_64() < deadline) sleep_ms(10);
+#endif
+}
+
+// When the next BMP280 sample of the flight phase's rate is due.
+static uint64_t next_baro_us = 0;
+
+/** @brief Takes a BMP280 sample if one is due at the rate of the flight phase.
+ * @details Every sample feeds the phase detector and, in the phases that stream the
+ * barometer, the flash log. A loop held up past several periods takes one sample, not a burst.
+ ** @return true if a sample was taken.
+ */
+static bool sample_baro(void)
+{
+    uint64_t now = time_us_64();
+
+    if (now < next_baro_us) return false;
+
+    const flight_profile_t *profile = flight_profile();
+    double pressure, altitude;
+    uint64_t timestamp_us;
+
+    bmp280_read(&pressure, &altitude, &timestamp_us);
+
+    next_baro_us += profile->baro_period_ms * 1000ULL;
+    if (next_baro_us <= now) next_baro_us = now + profile->baro_period_ms * 1000ULL;
+
+    if (pressure > 0)
+    {
+        if (profile->baro_stream) flash_log_add_baro(timestamp_us, (float)pressure);
+        flight_phase_baro((float)altitude, timestamp_us);
+    }
+    return true;
+}
+
+/** @brief Waits until the `time_us_64()` instant `end_us` and keeps the barometer sampled meanwhile. */
+static void wait_sampling_baro_until(uint64_t end_us)
+{
+    for (uint64_t now = time_us_64(); now < end_us; now = time_us_64())
+    {
+        sample_baro();
+
+        uint64_t until_us = (next_baro_us < end_us) ? next_baro_us : end_us;
+        now = time_us_64();
+        if (until_us > now) sleep_us(until_us - now);
+    }
+}
+
+/** @brief Waits `ms` and keeps the barometer sampled meanwhile. */
+static void wait_sampling_baro(uint32_t ms)
+{
+    wait_sampling_baro_until(time_us_64() + ms * 1000ULL);
+}
+
+/** @brief Hands the stored fix to the receiver, with the current time only while the calendar follows the GPS. */
+static void send_aiding(const gps_aid_t *last_fix)
+{
+    gps_aid_t aid = *last_fix;
+    bool time_known = time_manager_synced();
+
+    if (time_known)
+    {
+        current_time_t utc;
+
+        time_manager_get_utc(&utc);
+        aid.year = utc.year;
+        aid.month = utc.month;
+        aid.day = utc.day;
+        aid.hour = utc.hour;
+        aid.min = utc.min;
+        aid.sec = utc.sec;
+    }
+    gps_send_aiding(&aid, time_known);
+}
 
 int main(void)
 {  
     stdio_init_all();
+    PROF_INIT();
+    TRACE_INIT();
+
+    // After a watchdog reset the devices keep their configuration and the loop carries on.
+    warm_state_t warm_state;
+    bool warm = warm_restart_begin(&warm_state);
+    boot_timing.warm_restarts = warm ? warm_state.restarts : 0;
 
-    sleep_ms(5000);
-    LOG("[Main] System booting...\n");
+    // Per-flight settings, straight from flash (or as the run booted, after a watchdog reset);
+    // the modules read them as they start.
+    flash_config_init(warm ? &warm_state.config : NULL);
+    flash_log_init();
 
+    // Where and when the receiver last had a fix: aiding for it, and a first guess of the date.
+    gps_aid_t last_fix;
+    bool have_last_fix = last_fix_init(&last_fix);
 
+    if (!warm)
+    {
+        boot_timing_begin(BOOT_USB_WAIT);
+        wait_for_usb_host();
+        boot_timing_end(BOOT_USB_WAIT);
+    }
+    LOG("[Main] System booting (%s)...\n", warm ? "warm restart" : "cold boot");
+
+
+    // The first tick is due at once: sampling starts as soon as the loop runs.
     time_manager_init();
-    LOG("[Main] Init GPS...\n");
-    gps_init();
-    LOG("[Main] GPS initialized, .\n");
+    time_manager_set_timezone(flash_config()->timezone_offset_h);
+    if (warm) warm_restart_resume_time(&warm_state);
+    else if (have_last_fix) time_manager_seed(last_fix.year, last_fix.month, last_fix.day, last_fix.hour, last_fix.min, last_fix.sec);
 
     LOG("[Main] Init all sensors...\n");
-    init_all_sensors();
+    boot_timing_begin(BOOT_SENSORS);
+    if (warm) resume_all_sensors();
+    else init_all_sensors();
+    boot_timing_end(BOOT_SENSORS);
     LOG("[Main] Sensors initialized\n");
 
     LOG("[Main] Init radio module...\n");
+    boot_timing_begin(BOOT_RADIO);
     radio_module_init();
+    boot_timing_end(BOOT_RADIO);
     LOG("[Main] Radio communication initialized.\n");
-    
-    LOG("[Main] Init micro sd reader module...\n");
-    sd_init();
-    LOG("[Main] Micro sd reader initialized.\n");
 
+    // The card is mounted by the first save, the GPS is configured after the first record,
+    // one step per loop iteration.
+    bool gps_started = false;
+    bool gps_ready = false;
+    bool boot_logged = false;
+    uint32_t sample_countdown = 1;
+
+    if (warm && warm_state.gps_baud != 0)
+    {
+        LOG("[Main] Resume GPS...\n");
+        boot_timing_begin(BOOT_GPS);
+        gps_resume(warm_state.gps_baud);
+        boot_timing_end(BOOT_GPS);
+        gps_started = true;
+        gps_ready = true;
+    }
+
+    if (!warm)
+    {
+        warm_state = (warm_state_t){0};
+        warm_state.sd_latency_log_countdown = SD_LATENCY_LOG_PERIOD_S;
+        warm_state.housekeeping_countdown = HOUSEKEEPING_PERIOD_S;
+        warm_state.config = *flash_config();
+    }
+
+    // The flight phase sets the sensor, record and radio rates.
+    flight_phase_init(warm ? &warm_state.flight : NULL);
+    flight_phase_t phase = flight_phase();
+    uint32_t radio_countdown = 0;
+#if PROFILING
+    uint32_t profile_log_countdown = PROFILER_LOG_PERIOD_S;
+#endif
 
     sensor_readings_t current_sensor_data = {};
-    gps_data_t my_gps;
+    gps_data_t my_gps = {0};
 
 
     LOG("[Main] Entering Loop:\n");
        
     while (1)
     {
-        if (gps_update())
+        uint64_t iteration_start_us = time_us_64();
+        bool busy = false;
+
+        warm_restart_feed();
+
+        int command = getchar_timeout_us(0);
+        sd_latency_command(command);
+        PROF_COMMAND(command);
+        TRACE_COMMAND(command);
+        I2C_TRACE_COMMAND(command);
+        flash_log_command(command);
+
+        radio_module_poll();
+
+        if (sample_baro()) busy = true;
+
+        if (gps_started && !gps_ready && gps_configure_step())
+        {
+            gps_ready = true;
+            if (have_last_fix) send_aiding(&last_fix);
+            boot_timing_end(BOOT_GPS);
+            LOG("[Main] GPS initialized.\n");
+        }
+
+        PROF_ENTER(PROF_GPS_UPDATE);
+        bool gps_new_data = gps_update();
+        PROF_EXIT(PROF_GPS_UPDATE);
+
+        if (gps_new_data)
         {
+            busy = true;
             gps_get_data(&my_gps);
+            flight_phase_gps(&my_gps);
+            TRACE_INSTANT(TRACE_GPS_FIX, my_gps.satellites);
             if (my_gps.fix && my_gps.year > 0) 
             { 
-                time_manager_sync(my_gps.year, my_gps.month, my_gps.day, my_gps.hour, my_gps.min, my_gps.sec);
+                time_manager_sync(my_gps.year, my_gps.month, my_gps.day, my_gps.hour, my_gps.min, my_gps.sec,
+                                  my_gps.timestamp_us - my_gps.microsec);
             }
         }
 
+        if (flight_phase() != phase)
+        {
+            phase = flight_phase();
+
+            // The barometer stream ends with the samples collected so far; the landing site is kept for the next start.
+            if (!flight_profile()->baro_stream) flash_log_flush_baro();
+            if (phase == FLIGHT_LANDED) last_fix_save(&my_gps);
+        }
+
         if(time_manager_update())
         {
-            read_all(&current_sensor_data);
-
-            LOG("[Main] Temp: %.2f C | Press: %.2f Pa | Alt: %.2f m | Hum: %.2f %% | O2: %.2f %% | CH4: %.2f ppm | NH3: %.2f\r\n ppm",
-               current_sensor_data.temperature_c,
-               current_sensor_data.pressure_pa,
-               current_sensor_data.altitude_m,
-               current_sensor_data.humidity_pct,
-               current_sensor_data.oxygen_pct,
-               current_sensor_data.methane_ppm,
-               current_sensor_data.ammonia_ppm);
-
-            sleep_ms(500);
-
-            LOG("[Main] Logging data...\n");
-            save_system_data(&current_sensor_data, time_manager_get());
-            save_gps_log(&my_gps);
-
-            bool valid_fix = my_gps.fix && (my_gps.latitude != 0.0f);
-
-            current_time_t* t = time_manager_get();
-           
-            LOG("[Main] [%02d:%02d:%02d] Temp: %.2f | GPS Fix: %s\n",
-                t->hour, t->min, t->sec,
-                current_sensor_data.temperature_c,
-                valid_fix ? "YES" : "NO");
-
-
-            LOG("[Main] %.6f,%.6f,%.2f m,%d,%d\n",
-                        my_gps.latitude,
-                        my_gps.longitude,
-                        my_gps.altitude,
-                        my_gps.satellites,
-                        my_gps.fix ? 1 : 0);
+            TRACE_INSTANT(TRACE_SECOND_TICK, 0);
+            housekeeping_loop_tick(time_manager_tick_lateness_us());
+            busy = true;
+
+            // Every tick keeps the clock, the loop statistics and the periodic logs; the sensors
+            // are sampled and recorded every `sample_period_s` ticks (flash_config.h), or at the
+            // slower rate of the flight phase, and sent at most every `radio_period_s`.
+            const flight_profile_t *profile = flight_profile();
+            current_time_t now = {0};
+            bool sample = --sample_countdown == 0;
+
+            if (radio_countdown > 0) radio_countdown--;
+
+            if (sample)
+            {
+                sample_countdown = flash_config()->sample_period_s;
+                if (profile->record_period_s > sample_countdown) sample_countdown = profile->record_period_s;
+
+                // The SHTC3 and O2 conversions leave the bus free for the barometer.
+                uint64_t ready_us = read_all_start(&current_sensor_data);
+                wait_sampling_baro_until(ready_us);
+                read_all_finish(&current_sensor_data);
+                boot_timing_first_sample();
+
+                LOG("[Main] Temp: %.2f C | Press: %.2f Pa | Alt: %.2f m | Hum: %.2f %% | O2: %.2f %% | CH4: %.2f ppm | NH3: %.2f\r\n ppm",
+                   current_sensor_data.temperature_c,
+                   current_sensor_data.pressure_pa,
+                   current_sensor_data.altitude_m,
+                   current_sensor_data.humidity_pct,
+                   current_sensor_data.oxygen_pct,
+                   current_sensor_data.methane_ppm,
+                   current_sensor_data.ammonia_ppm);
+
+                wait_sampling_baro(500);
+
+                LOG("[Main] Logging data...\n");
+                time_manager_get(&now);
+
+                // Flash first; flash_log_drain() copies the records to the card.
+                PROF_ENTER(PROF_FLASH_LOG_APPEND);
+                flash_log_append_sensors(&current_sensor_data, &now);
+                flash_log_append_gps(&my_gps);
+                PROF_EXIT(PROF_FLASH_LOG_APPEND);
+            }
+
+            if (--warm_state.sd_latency_log_countdown == 0)
+            {
+                warm_state.sd_latency_log_countdown = SD_LATENCY_LOG_PERIOD_S;
+                save_sd_latency_log();
+            }
+
+            if (--warm_state.housekeeping_countdown == 0)
+            {
+                warm_state.housekeeping_countdown = HOUSEKEEPING_PERIOD_S;
+
+                housekeeping_t hk;
+                housekeeping_collect(&hk);
+                save_housekeeping_log(&hk);
+                radio_module_send_housekeeping(&hk);
+
+                save_e2e_latency_log();
+                radio_module_send_latency();
+            }
+
+#if PROFILING
+            if (--profile_log_countdown == 0)
+            {
+                profile_log_countdown = PROFILER_LOG_PERIOD_S;
+                save_profile_log();
+            }
+#endif
+
+            if (sample)
+            {
+                bool valid_fix = my_gps.fix && (my_gps.latitude_e7 != 0);
+
+                if (radio_countdown == 0)
+                {
+                    radio_countdown = profile->radio_period_s;
+                    radio_module_send_telemetry(current_sensor_data.pressure_us,
+                                                current_sensor_data.temperature_c,
+                                                current_sensor_data.pressure_pa,
+                                                current_sensor_data.altitude_m);
+
+                    if (valid_fix) radio_module_send_position(&my_gps);
+                }
+
+                LOG("[Main] [%02d:%02d:%02d] Temp: %.2f | GPS Fix: %s\n",
+                    now.hour, now.min, now.sec,
+                    current_sensor_data.temperature_c,
+                    valid_fix ? "YES" : "NO");
+
+
+                LOG("[Main] " GPS_E7_FMT "," GPS_E7_FMT ",%.2f m,%d,%d\n",
+                            GPS_E7_ARGS(my_gps.latitude_e7),
+                            GPS_E7_ARGS(my_gps.longitude_e7),
+                            my_gps.altitude,
+                            my_gps.satellites,
+                            my_gps.fix ? 1 : 0);
+            }
+
+            last_fix_update(&my_gps);
+            // One record at a time, so the card's writes leave no gap in the barometer stream,
+            // feeding the watchdog after each, within the time budget of the tick.
+            uint64_t drain_end_us = time_us_64() + FLASH_LOG_DRAIN_BUDGET_MS * 1000ULL;
+
+            for (uint32_t i = 0; i < profile->drain_batch && time_us_64() < drain_end_us && flash_log_drain(1); i++)
+            {
+                warm_restart_feed();
+                sample_baro();
+            }
+            flash_log_service();
+
+            if (!gps_started)
+            {
+                LOG("[Main] Init GPS...\n");
+                boot_timing_begin(BOOT_GPS);
+                gps_init();
+                gps_started = true;
+            }
+
+            if (!boot_logged && gps_ready)
+            {
+                boot_logged = true;
+                boot_timing_log();
+                save_boot_log();
+            }
+
+            warm_state.gps_baud = gps_ready ? gps_link_baud() : 0;
+            flight_phase_save(&warm_state.flight);
+            warm_restart_save(&warm_state);
         }
+
+        housekeeping_loop_iteration(iteration_start_us, busy);
     }
 }
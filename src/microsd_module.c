@@ -1,5 +1,11 @@
 #include "microsd_module.h"
 #include "debug_mode.h"
+#include "profiler.h"
+#include "sd_latency.h"
+#include "e2e_latency.h"
+#include "boot_timing.h"
+#include "flash_config.h"
+#include "sensor_conversion.h"
 #include "hardware/spi.h"
 #include "ff.h"
 #include "sd_card.h"
@@ -7,8 +13,56 @@
 
 extern sd_card_t *sd_get_by_num(size_t num);
 
+// Every FatFs call below is timed into the SD latency statistics (sd_latency.h).
+#define SD_PRINTF(fil, ...) \
+    do \
+    { \
+        uint64_t start_ = time_us_64(); \
+        int written_ = f_printf((fil), __VA_ARGS__); \
+        sd_latency_record(SD_OP_WRITE, start_, written_ >= 0); \
+    } while (0)
+
+// The volume stays mounted between saves; a failed open or close makes the next sd_init() mount it again.
+static bool mounted = false;
+
+static FRESULT sd_open_append(FIL *fil, const char *path)
+{
+    uint64_t start = time_us_64();
+    FRESULT fr = f_open(fil, path, FA_WRITE | FA_OPEN_APPEND);
+
+    sd_latency_record(SD_OP_OPEN, start, fr == FR_OK);
+    if (fr != FR_OK) mounted = false;
+    return fr;
+}
+
+static FRESULT sd_close(FIL *fil)
+{
+    PROF_ENTER(PROF_SD_CLOSE);
+    uint64_t start = time_us_64();
+    FRESULT fr = f_close(fil);
+
+    sd_latency_record(SD_OP_CLOSE, start, fr == FR_OK);
+    if (fr != FR_OK) mounted = false;
+    PROF_EXIT(PROF_SD_CLOSE);
+    return fr;
+}
+
+// Acquisition time of the oldest reading in a record: the record is only as fresh as that.
+static uint64_t oldest_sample_us(const sensor_readings_t *data)
+{
+    uint64_t oldest = data->pressure_us;
+
+    if (data->temperature_us < oldest) oldest = data->temperature_us;
+    if (data->methane_us < oldest) oldest = data->methane_us;
+    if (data->ammonia_us < oldest) oldest = data->ammonia_us;
+    if (data->oxygen_us < oldest) oldest = data->oxygen_us;
+    return oldest;
+}
+
 bool sd_init() 
 {
+    if (mounted) return true;
+
     sd_card_t *pSD = sd_get_by_num(0);
 
     if (!pSD) 
@@ -17,11 +71,17 @@ bool sd_init()
         return false;
     }
 
+    // spi0 is shared with the radio: both run at the configured clock.
+    pSD->spi->baud_rate = flash_config()->spi_baud_hz;
+
+    uint64_t start = time_us_64();
     FRESULT fr = f_mount(&pSD->fatfs, pSD->pcName, 1);
+    sd_latency_record(SD_OP_MOUNT, start, fr == FR_OK);
     
     if (fr == FR_OK) 
     {
         LOG("[SD] Mount Success!\n");
+        mounted = true;
         return true;
     } else 
     {
@@ -30,67 +90,307 @@ bool sd_init()
     }
 }
 
-void save_system_data(sensor_readings_t* data, current_time_t* time) 
+bool save_system_data(sensor_readings_t* data, current_time_t* time) 
 {
-    if (!sd_init()) return;
+    if (!sd_init()) return false;
 
     FIL fil;
     FRESULT fr;
 
-    fr = f_open(&fil, "data_log.txt", FA_WRITE | FA_OPEN_APPEND);
+    fr = sd_open_append(&fil, "data_log.txt");
 
     if (fr == FR_OK) 
     {
-        f_printf(&fil, "[%02d:%02d:%02d] [BMP280] Pressure: %.2f Pa | Altitude: %.2f m\n", 
-                 time->hour, time->min, time->sec, 
-                 data->pressure_pa, data->altitude_m);
+        SD_PRINTF(&fil, "[%02d:%02d:%02d] [BMP280] t=" TIME_US_FMT " s | Pressure: %.2f Pa | Altitude: %.2f m\n", 
+                  time->hour, time->min, time->sec, 
+                  TIME_US_ARGS(data->pressure_us),
+                  data->pressure_pa, data->altitude_m);
 
-        f_printf(&fil, "[%02d:%02d:%02d] [SHTC3] Temperature: %.2f C, Humidity: %.2f %%\n", 
-                 time->hour, time->min, time->sec, 
-                 data->temperature_c, data->humidity_pct);
+        SD_PRINTF(&fil, "[%02d:%02d:%02d] [SHTC3] t=" TIME_US_FMT " s | Temperature: %.2f C, Humidity: %.2f %%\n", 
+                  time->hour, time->min, time->sec, 
+                  TIME_US_ARGS(data->temperature_us),
+                  data->temperature_c, data->humidity_pct);
 
-        f_printf(&fil, "[%02d:%02d:%02d] [GASES] CH4: %.2f ppm, NH3: %.2f ppm, O2: %.2f %%\n", 
-                 time->hour, time->min, time->sec, 
-                 data->methane_ppm, data->ammonia_ppm, data->oxygen_pct);
+        SD_PRINTF(&fil, "[%02d:%02d:%02d] [GASES] CH4: %.2f ppm (t=" TIME_US_FMT " s), NH3: %.2f ppm (t=" TIME_US_FMT " s), O2: %.2f %% (t=" TIME_US_FMT " s)\n", 
+                  time->hour, time->min, time->sec, 
+                  data->methane_ppm, TIME_US_ARGS(data->methane_us),
+                  data->ammonia_ppm, TIME_US_ARGS(data->ammonia_us),
+                  data->oxygen_pct, TIME_US_ARGS(data->oxygen_us));
         
-        f_printf(&fil, "--------------------------------------------------\n");
+        SD_PRINTF(&fil, "--------------------------------------------------\n");
 
-        f_close(&fil);
+        if (sd_close(&fil) != FR_OK) return false;
+
+        e2e_latency_record(E2E_SENSORS_SD, oldest_sample_us(data), time_us_64());
         LOG("[SD] System data saved.\n");
+        return true;
     } 
     else 
     {
         LOG("[SD] Failed to open data_log.txt (Error: %d)\n", fr);
+        return false;
     }
 }
 
-void save_gps_log(gps_data_t* gps)
+bool save_gps_log(gps_data_t* gps)
 {
     // if(!gps->fix) return;
 
-    if (!sd_init()) return;
+    if (!sd_init()) return false;
 
     FIL fil;
     FRESULT fr;
 
-    fr = f_open(&fil, "gps_log.csv", FA_WRITE | FA_OPEN_APPEND);
+    fr = sd_open_append(&fil, "gps_log.csv");
 
     if (fr == FR_OK) 
     {
-        if (f_size(&fil) == 0) f_printf(&fil, "Latitude,Longitude,Altitude,Satellites\n"); // If file is empty - write to .csv header
+        if (f_size(&fil) == 0) SD_PRINTF(&fil, "Time_s,UTC,Latitude,Longitude,Altitude,Satellites,Fix\n"); // If file is empty - write to .csv header
 
-        f_printf(&fil, "%.6f,%.6f,%.2f,%d,%d\n", 
-                 gps->latitude, 
-                 gps->longitude, 
-                 gps->altitude, 
-                 gps->satellites, 
-                 gps->fix ? 1 : 0);
+        SD_PRINTF(&fil, TIME_US_FMT ",%02d:%02d:%02d.%06lu," GPS_E7_FMT "," GPS_E7_FMT ",%.2f,%d,%d\n", 
+                  TIME_US_ARGS(gps->timestamp_us),
+                  gps->hour, gps->min, gps->sec, (unsigned long)gps->microsec,
+                  GPS_E7_ARGS(gps->latitude_e7), 
+                  GPS_E7_ARGS(gps->longitude_e7), 
+                  gps->altitude, 
+                  gps->satellites, 
+                  gps->fix ? 1 : 0);
 
-        f_close(&fil);
+        if (sd_close(&fil) != FR_OK) return false;
+
+        // A zero timestamp means no sentence has been received yet.
+        if (gps->timestamp_us) e2e_latency_record(E2E_GPS_SD, gps->timestamp_us, time_us_64());
         LOG("[SD] GPS log saved.\n");
+        return true;
     } 
     else 
     {
         LOG("[SD] Failed to open gps_log.csv (Error: %d)\n", fr);
+        return false;
+    }
+}
+
+bool save_baro_log(uint64_t first_us, const uint32_t *offset_us, const float *pressure_pa, uint32_t count)
+{
+    if (!sd_init()) return false;
+
+    FIL fil;
+    FRESULT fr = sd_open_append(&fil, "baro_log.csv");
+
+    if (fr != FR_OK)
+    {
+        LOG("[SD] Failed to open baro_log.csv (Error: %d)\n", fr);
+        return false;
+    }
+
+    if (f_size(&fil) == 0) SD_PRINTF(&fil, "Time_s,Pressure_Pa,Altitude_m\n");
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        SD_PRINTF(&fil, TIME_US_FMT ",%.2f,%.2f\n", TIME_US_ARGS(first_us + offset_us[i]),
+                  pressure_pa[i], pressure_to_altitude(pressure_pa[i]));
+    }
+
+    return sd_close(&fil) == FR_OK;
+}
+
+#if PROFILING
+void save_profile_log(void)
+{
+    if (!sd_init()) return;
+
+    FIL fil;
+    FRESULT fr;
+
+    fr = sd_open_append(&fil, "profile_log.csv");
+
+    if (fr == FR_OK) 
+    {
+        if (f_size(&fil) == 0) SD_PRINTF(&fil, "Time_s,Scope,Count,Total_s,Min_cycles,Max_cycles\n");
+
+        uint64_t now_us = time_us_64();
+
+        for (int i = 0; i < PROF_SCOPE_COUNT; i++)
+        {
+            const profiler_stats_t *s = &profiler_table[i];
+
+            SD_PRINTF(&fil, TIME_US_FMT ",%s,%lu," TIME_US_FMT ",%lu,%lu\n",
+                      TIME_US_ARGS(now_us),
+                      profiler_scope_names[i],
+                      (unsigned long)s->count,
+                      TIME_US_ARGS(profiler_cycles_to_us(s->total_cycles)),
+                      (unsigned long)(s->count ? s->min_cycles : 0),
+                      (unsigned long)s->max_cycles);
+        }
+
+        sd_close(&fil);
+        LOG("[SD] Profile log saved.\n");
+    } 
+    else 
+    {
+        LOG("[SD] Failed to open profile_log.csv (Error: %d)\n", fr);
+    }
+}
+#endif
+
+void save_sd_latency_log(void)
+{
+    if (!sd_init()) return;
+
+    FIL fil;
+    FRESULT fr;
+
+    fr = sd_open_append(&fil, "sd_latency.csv");
+
+    if (fr == FR_OK) 
+    {
+        // H<k> columns are the log2 histogram buckets: [2^k, 2^(k+1)) microseconds.
+        if (f_size(&fil) == 0) 
+        {
+            SD_PRINTF(&fil, "Time_s,Op,Count,Errors,Stalls,Max_us");
+            for (int k = 0; k < SD_LATENCY_BUCKETS; k++) SD_PRINTF(&fil, ",H%d", k);
+            SD_PRINTF(&fil, "\n");
+        }
+
+        uint64_t now_us = time_us_64();
+
+        for (int op = 0; op < SD_OP_COUNT; op++)
+        {
+            const sd_op_stats_t *st = &sd_latency_stats[op];
+
+            SD_PRINTF(&fil, TIME_US_FMT ",%s,%lu,%lu,%lu,%lu",
+                      TIME_US_ARGS(now_us),
+                      sd_op_names[op],
+                      (unsigned long)st->count,
+                      (unsigned long)st->errors,
+                      (unsigned long)st->stalls,
+                      (unsigned long)st->max_us);
+            for (int k = 0; k < SD_LATENCY_BUCKETS; k++) SD_PRINTF(&fil, ",%lu", (unsigned long)st->histogram[k]);
+            SD_PRINTF(&fil, "\n");
+        }
+
+        sd_close(&fil);
+        LOG("[SD] Latency log saved.\n");
+    } 
+    else 
+    {
+        LOG("[SD] Failed to open sd_latency.csv (Error: %d)\n", fr);
     }
-}
\ No newline at end of file
+}
+
+void save_boot_log(void)
+{
+    if (!sd_init()) return;
+
+    FIL fil;
+    FRESULT fr;
+
+    fr = sd_open_append(&fil, "boot_log.csv");
+
+    if (fr == FR_OK) 
+    {
+        if (f_size(&fil) == 0) 
+        {
+            SD_PRINTF(&fil, "Warm_restarts,First_sample_s");
+            for (int step = 0; step < BOOT_STEP_COUNT; step++) SD_PRINTF(&fil, ",%s_us", boot_step_names[step]);
+            SD_PRINTF(&fil, "\n");
+        }
+
+        SD_PRINTF(&fil, "%lu," TIME_US_FMT, (unsigned long)boot_timing.warm_restarts, TIME_US_ARGS(boot_timing.first_sample_us));
+        for (int step = 0; step < BOOT_STEP_COUNT; step++) SD_PRINTF(&fil, ",%lu", (unsigned long)boot_timing.step_us[step]);
+        SD_PRINTF(&fil, "\n");
+
+        sd_close(&fil);
+        LOG("[SD] Boot record saved.\n");
+    } 
+    else 
+    {
+        LOG("[SD] Failed to open boot_log.csv (Error: %d)\n", fr);
+    }
+}
+
+void save_housekeeping_log(const housekeeping_t *hk)
+{
+    if (!sd_init()) return;
+
+    FIL fil;
+    FRESULT fr;
+
+    fr = sd_open_append(&fil, "housekeeping.csv");
+
+    if (fr == FR_OK) 
+    {
+        if (f_size(&fil) == 0) 
+        {
+            SD_PRINTF(&fil, "Time_s,Loop_Hz,Busy_permille,Deadline_misses,Worst_lateness_us,"
+                            "GPS_overruns,GPS_framing_errors,GPS_rx_dropped,GPS_checksum_failures");
+            for (int d = 0; d < I2C_DEV_COUNT; d++) SD_PRINTF(&fil, ",%s_errors,%s_timeouts", i2c_device_names[d], i2c_device_names[d]);
+            SD_PRINTF(&fil, ",SD_errors,SD_stalls,SD_worst_us,Radio_queued,Radio_sent,Radio_dropped\n");
+        }
+
+        SD_PRINTF(&fil, TIME_US_FMT ",%lu,%u,%lu,%lu,%lu,%lu,%lu,%lu",
+                  TIME_US_ARGS(hk->timestamp_us),
+                  (unsigned long)hk->loop_rate_hz,
+                  (unsigned)hk->busy_permille,
+                  (unsigned long)hk->deadline_misses,
+                  (unsigned long)hk->worst_lateness_us,
+                  (unsigned long)hk->gps_uart_overruns,
+                  (unsigned long)hk->gps_uart_framing_errors,
+                  (unsigned long)hk->gps_rx_dropped,
+                  (unsigned long)hk->gps_checksum_failures);
+        for (int d = 0; d < I2C_DEV_COUNT; d++) SD_PRINTF(&fil, ",%lu,%lu", (unsigned long)hk->i2c_errors[d], (unsigned long)hk->i2c_timeouts[d]);
+        SD_PRINTF(&fil, ",%lu,%lu,%lu,%lu,%lu,%lu\n",
+                  (unsigned long)hk->sd_errors,
+                  (unsigned long)hk->sd_stalls,
+                  (unsigned long)hk->sd_worst_us,
+                  (unsigned long)hk->radio_queued,
+                  (unsigned long)hk->radio_sent,
+                  (unsigned long)hk->radio_dropped);
+
+        sd_close(&fil);
+        LOG("[SD] Housekeeping record saved.\n");
+    } 
+    else 
+    {
+        LOG("[SD] Failed to open housekeeping.csv (Error: %d)\n", fr);
+    }
+}
+
+void save_e2e_latency_log(void)
+{
+    if (!sd_init()) return;
+
+    FIL fil;
+    FRESULT fr;
+
+    fr = sd_open_append(&fil, "e2e_latency.csv");
+
+    if (fr == FR_OK) 
+    {
+        if (f_size(&fil) == 0) SD_PRINTF(&fil, "Time_s,Path,Count,P50_us,P90_us,P99_us,Max_us\n");
+
+        uint64_t now_us = time_us_64();
+
+        for (int path = 0; path < E2E_PATH_COUNT; path++)
+        {
+            e2e_summary_t s;
+            e2e_latency_summary(path, &s);
+
+            SD_PRINTF(&fil, TIME_US_FMT ",%s,%lu,%lu,%lu,%lu,%lu\n",
+                      TIME_US_ARGS(now_us),
+                      e2e_path_names[path],
+                      (unsigned long)s.count,
+                      (unsigned long)s.p50_us,
+                      (unsigned long)s.p90_us,
+                      (unsigned long)s.p99_us,
+                      (unsigned long)s.max_us);
+        }
+
+        sd_close(&fil);
+        LOG("[SD] End-to-end latency log saved.\n");
+    } 
+    else 
+    {
+        LOG("[SD] Failed to open e2e_latency.csv (Error: %d)\n", fr);
+    }
+}
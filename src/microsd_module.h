@@ -16,10 +16,15 @@
 #include "atm_sen_module.h"
 #include "time_manager.h"
 #include "gps_module.h"
+#include "profiler.h"
+#include "housekeeping.h"
 
 // FUNCTIONS
 
 /** @brief Initializes the Micro SD reader SPI connection and checks for successful mounting of the card.
+ * @details The card is mounted by the first call, which every save function makes, so it need not
+ * be called at boot. Later calls return at once while the volume is mounted; after a failed
+ * open or close the next call mounts it again.
  ** @return true if the reader is correctly initialized and the microSD card is mounted.
  ** @return false if the reader setup or the microSD card mount fails.
  */
@@ -33,14 +38,60 @@ extern bool sd_init();
  * to be saved on the microSD card.
  ** @param[in] time Pointer to a time-keeping structure that plays a role in time management
  * for the timestamps in the 'data_log.txt' file.
+ ** @return true if the record is on the card (the file was closed without error).
  */
-extern void save_system_data(sensor_readings_t *data, current_time_t *time);
+extern bool save_system_data(sensor_readings_t *data, current_time_t *time);
 
 /** @brief Saves all GPS data onto the microSD card in a 'gps_log.csv' file.
  * @details It uses the functions available in the beforementioned library to save formatted strings with
  * values read from the GPS kept in a 'gps_data_t' structure onto the microSD.
  ** @param[in] gps_data_t Pointer to a structure keeping data read from GPS and properly parsed.
+ ** @return true if the row is on the card (the file was closed without error).
  */
-extern void save_gps_log(gps_data_t *gps);
+extern bool save_gps_log(gps_data_t *gps);
+
+/** @brief Appends consecutive barometer samples to 'baro_log.csv', one row each
+ * (time since boot, pressure, barometric altitude).
+ ** @param[in] first_us Time of the first sample.
+ ** @param[in] offset_us Time of each sample after the first.
+ ** @param[in] pressure_pa Pressure of each sample [Pa].
+ ** @param[in] count Number of samples.
+ ** @return true if the rows are on the card (the file was closed without error).
+ */
+extern bool save_baro_log(uint64_t first_us, const uint32_t *offset_us, const float *pressure_pa, uint32_t count);
+
+/** @brief Appends the SD latency statistics (see sd_latency.h) to 'sd_latency.csv' on the microSD card.
+ * @details One row per operation type: time since boot, operation, count, errors, stalls,
+ * slowest latency and the log2 histogram buckets `H0`..`H19`. The counters are cumulative
+ * since boot.
+ */
+extern void save_sd_latency_log(void);
+
+/** @brief Appends the boot figures (see boot_timing.h) to 'boot_log.csv' on the microSD card.
+ * @details One row per boot: warm restarts since the last cold boot (0 for a cold boot), time
+ * from reset to the first sample, then the duration of each start-up step in microseconds.
+ */
+extern void save_boot_log(void);
+
+/** @brief Appends a housekeeping record (see housekeeping.h) to 'housekeeping.csv' on the microSD card.
+ * @details One row per record; the I2C counters get one errors/timeouts column pair per device.
+ ** @param[in] hk Pointer to the record to save.
+ */
+extern void save_housekeeping_log(const housekeeping_t *hk);
+
+/** @brief Appends the end-to-end latency summary (see e2e_latency.h) to 'e2e_latency.csv' on the microSD card.
+ * @details One row per path: time since boot, path, records delivered, p50/p90/p99 over the
+ * recent window and the maximum since boot, all in microseconds.
+ */
+extern void save_e2e_latency_log(void);
+
+#if PROFILING
+/** @brief Appends the current profile table to 'profile_log.csv' on the microSD card.
+ * @details One row per scope: time since boot, scope name, pass count, total time
+ * spent in the scope and the shortest/longest pass in cycles. The totals are cumulative
+ * since boot, so consecutive snapshots can be subtracted to get per-period figures.
+ */
+extern void save_profile_log(void);
+#endif
 
 #endif // MICROSD_MODULE_H
\ No newline at end of file
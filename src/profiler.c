@@ -0,0 +1,66 @@
+#include "profiler.h"
+
+const char *const profiler_scope_names[PROF_SCOPE_COUNT] = {
+    [PROF_READ_ALL] = "read_all",
+    [PROF_SHTC3_READ] = "shtc3_read",
+    [PROF_MEMS_READ] = "mems_sensor_read",
+    [PROF_BMP280_READ] = "bmp280_read",
+    [PROF_OXYGEN_READ] = "oxygen_read",
+    [PROF_GPS_UPDATE] = "gps_update",
+    [PROF_SAVE_SYSTEM_DATA] = "save_system_data",
+    [PROF_SAVE_GPS_LOG] = "save_gps_log",
+    [PROF_SD_CLOSE] = "f_close",
+    [PROF_NRF905_TX] = "nrf905_tx",
+    [PROF_FLASH_LOG_APPEND] = "flash_log_append",
+    [PROF_FLASH_LOG_ERASE] = "flash_log_erase",
+};
+
+#if PROFILING
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+profiler_stats_t profiler_table[PROF_SCOPE_COUNT];
+
+void profiler_init(void)
+{
+    cycle_counter_init();
+
+    memset(profiler_table, 0, sizeof(profiler_table));
+    for (int i = 0; i < PROF_SCOPE_COUNT; i++) profiler_table[i].min_cycles = UINT32_MAX;
+}
+
+uint64_t profiler_cycles_to_us(uint64_t cycles)
+{
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+
+    return mhz ? cycles / mhz : 0;
+}
+
+void profiler_dump(void)
+{
+    printf("[PROF] scope,count,total_us,avg_us,min_cycles,max_cycles\n");
+
+    for (int i = 0; i < PROF_SCOPE_COUNT; i++)
+    {
+        const profiler_stats_t *s = &profiler_table[i];
+        uint64_t total_us = profiler_cycles_to_us(s->total_cycles);
+
+        printf("[PROF] %s,%lu,%llu,%lu,%lu,%lu\n",
+               profiler_scope_names[i],
+               (unsigned long)s->count,
+               (unsigned long long)total_us,
+               (unsigned long)(s->count ? total_us / s->count : 0),
+               (unsigned long)(s->count ? s->min_cycles : 0),
+               (unsigned long)s->max_cycles);
+    }
+}
+
+void profiler_command(int c)
+{
+    if (c == PROFILER_DUMP_CHAR) profiler_dump();
+}
+
+#endif // PROFILING
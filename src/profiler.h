@@ -0,0 +1,119 @@
+/** @file profiler.h
+ ** @brief Scoped cycle profiler for the flight software.
+ * @details `PROF_ENTER(scope)` / `PROF_EXIT(scope)` pairs, placed around the main
+ * per-second work, measure each pass with the DWT cycle counter and accumulate count,
+ * total, min and max cycles per scope in a static table. The table can be printed over
+ * USB on demand (send `PROFILER_DUMP_CHAR`) and is appended to 'profile_log.csv' on the
+ * SD card every `PROFILER_LOG_PERIOD_S` seconds. When tracing is enabled (trace.h), every
+ * scope is also recorded as a begin/end pair on the event timeline.
+ *
+ * With `PROFILING` set to 0 (the default, used for flight builds) every macro expands to
+ * nothing, so the instrumented code is identical to the uninstrumented one.
+ * Enable it with the CMake option `CS_PROFILING=ON`.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace.h"
+
+// CONFIGURATION MACROS
+
+/** @brief 1 builds the profiler in, 0 compiles every `PROF_*` macro to nothing. */
+#ifndef PROFILING
+#define PROFILING 0
+#endif
+
+/** @brief Character received over USB that triggers a dump of the profile table. */
+#define PROFILER_DUMP_CHAR 'p'
+
+/** @brief Period of the SD card profile log [s]. */
+#define PROFILER_LOG_PERIOD_S 10
+
+// DATA STRUCTURES
+
+/** @brief Profiled scopes. Keep `profiler_scope_names` in profiler.c in the same order. */
+typedef enum
+{
+    PROF_READ_ALL = 0,
+    PROF_SHTC3_READ,
+    PROF_MEMS_READ,
+    PROF_BMP280_READ,
+    PROF_OXYGEN_READ,
+    PROF_GPS_UPDATE,
+    PROF_SAVE_SYSTEM_DATA,
+    PROF_SAVE_GPS_LOG,
+    PROF_SD_CLOSE,
+    PROF_NRF905_TX,
+    PROF_FLASH_LOG_APPEND,
+    PROF_FLASH_LOG_ERASE,
+    PROF_SCOPE_COUNT
+} profiler_scope_t;
+
+/** @brief Accumulated statistics of one scope. */
+typedef struct
+{
+    uint32_t count; /// Number of completed passes.
+    uint64_t total_cycles; /// Sum of all passes.
+    uint32_t min_cycles; /// Shortest pass.
+    uint32_t max_cycles; /// Longest pass.
+} profiler_stats_t;
+
+// FUNCTIONS
+
+/** @brief Display names of the scopes, indexed by `profiler_scope_t`. */
+extern const char *const profiler_scope_names[PROF_SCOPE_COUNT];
+
+#if PROFILING
+
+#include "cycle_counter.h"
+
+/** @brief The profile table, indexed by `profiler_scope_t`. */
+extern profiler_stats_t profiler_table[PROF_SCOPE_COUNT];
+
+/** @brief Enables the cycle counter and clears the table. */
+extern void profiler_init(void);
+
+/** @brief Handles a character received over stdio: `PROFILER_DUMP_CHAR` prints the table. */
+extern void profiler_command(int c);
+
+/** @brief Prints the table over stdio. */
+extern void profiler_dump(void);
+
+/** @brief Converts a cycle count into microseconds at the current system clock. */
+extern uint64_t profiler_cycles_to_us(uint64_t cycles);
+
+/** @brief Adds one pass of `cycles` to the statistics of `scope`. */
+static inline void profiler_record(profiler_scope_t scope, uint32_t cycles)
+{
+    profiler_stats_t *s = &profiler_table[scope];
+
+    s->count++;
+    s->total_cycles += cycles;
+    if (cycles < s->min_cycles) s->min_cycles = cycles;
+    if (cycles > s->max_cycles) s->max_cycles = cycles;
+}
+
+#define PROF_CYCLES_ENTER(scope) uint32_t prof_start_##scope = cycle_counter_read()
+#define PROF_CYCLES_EXIT(scope) profiler_record(scope, cycle_counter_read() - prof_start_##scope)
+#define PROF_INIT() profiler_init()
+#define PROF_COMMAND(c) profiler_command(c)
+
+#else
+
+#define PROF_CYCLES_ENTER(scope) ((void)0)
+#define PROF_CYCLES_EXIT(scope) ((void)0)
+#define PROF_INIT() ((void)0)
+#define PROF_COMMAND(c) ((void)0)
+
+#endif // PROFILING
+
+/** @brief Opens a profiled scope. Must be paired with `PROF_EXIT` in the same block. */
+#define PROF_ENTER(scope) PROF_CYCLES_ENTER(scope); TRACE_BEGIN(scope)
+
+/** @brief Closes a profiled scope opened with `PROF_ENTER`. */
+#define PROF_EXIT(scope) TRACE_END(scope); PROF_CYCLES_EXIT(scope)
+
+#endif // PROFILER_H
@@ -2,23 +2,154 @@
 #include <string.h>
 #include <stdint.h>
 #include "debug_mode.h"
+#include "profiler.h"
 #include "radio_module.h"
-#include "lib/nrf905/nrf905.h"
+#include "e2e_latency.h"
+#include "flash_config.h"
+#include "flight_phase.h"
+#include "lib/nRF905/nRF905.h"
+
+static radio_stats_t radio_stats = {0};
 
 void radio_module_init(void) 
 {
+    const flash_config_t *cfg = flash_config();
+
     nrf905_init();
+    spi_set_baudrate(NRF_SPI_PORT, cfg->spi_baud_hz);
+    if (cfg->radio_channel != RADIO_CHANNEL_DEFAULT) nrf905_set_channel(cfg->radio_channel);
     printf("[nRF905]: Radio Module Initialized (433 MHz)\n");
 }
 
-void radio_module_send_telemetry(float temp, float press, float alt) 
+static bool radio_send(char *buffer)
+{
+    LOG("[nRF905 RADIO TX] %s\n", buffer);
+
+    radio_stats.queued++;
+
+    // Casting the char* to uint8_t* because the driver expects raw bytes
+    PROF_ENTER(PROF_NRF905_TX);
+    bool sent = nrf905_tx((uint8_t*)buffer, strlen(buffer));
+    PROF_EXIT(PROF_NRF905_TX);
+
+    if (sent) radio_stats.sent++;
+    else radio_stats.dropped++;
+    return sent;
+}
+
+/** @brief Sends a frame formatted into `buffer`, unless snprintf() had to cut it.
+ ** @param len The snprintf() return value: the length of the whole frame.
+ */
+static bool radio_send_frame(char *buffer, int len)
+{
+    if (len < 0 || len >= NRF905_PAYLOAD_SIZE)
+    {
+        LOG("[nRF905 RADIO TX] %d-byte frame does not fit, not sent: %s\n", len, buffer);
+        radio_stats.oversized++;
+        return false;
+    }
+    return radio_send(buffer);
+}
+
+void radio_module_send_telemetry(uint64_t sample_us, float temp, float press, float alt) 
 {
     char buffer[NRF905_PAYLOAD_SIZE]; // 32 bytes max
 
-    snprintf(buffer, sizeof(buffer), "T:%.1f P:%.0f A:%.1f", temp, press, alt);
+    // A wrapped millisecond count leaves room for the readings in the fixed 32-byte payload.
+    unsigned long stamp_ms = (unsigned long)(sample_us / 1000 % RADIO_STAMP_WRAP_MS);
+    int len = snprintf(buffer, sizeof(buffer), "%lu T:%.1f P:%.0f A:%.1f", stamp_ms, temp, press, alt);
 
-    LOG("[nRF905 RADIO TX] %s\n", buffer);
+    if (len < 0 || len >= (int)sizeof(buffer))
+    {
+        len = snprintf(buffer, sizeof(buffer), "%lu T:%.0f P:%.0f A:%.0f", stamp_ms, temp, press, alt);
+    }
 
-    // Casting the char* to uint8_t* because the driver expects raw bytes
-    nrf905_tx((uint8_t*)buffer, strlen(buffer));
-}
\ No newline at end of file
+    if (radio_send_frame(buffer, len)) e2e_latency_record(E2E_SENSORS_RADIO, sample_us, time_us_64());
+}
+
+void radio_module_send_position(const gps_data_t *gps)
+{
+    char buffer[NRF905_PAYLOAD_SIZE]; // 32 bytes max
+
+    int len = snprintf(buffer, sizeof(buffer), "G:%ld,%ld,%d",
+                       (long)gps->latitude_e7, (long)gps->longitude_e7, (int)gps->altitude);
+
+    if (radio_send_frame(buffer, len)) e2e_latency_record(E2E_GPS_RADIO, gps->timestamp_us, time_us_64());
+}
+
+/** @brief A counter or a duration in a frame, saturated at `RADIO_FIELD_MAX`. */
+static unsigned long field(uint64_t value)
+{
+    return (value < RADIO_FIELD_MAX) ? (unsigned long)value : RADIO_FIELD_MAX;
+}
+
+void radio_module_send_housekeeping(const housekeeping_t *hk)
+{
+    char buffer[NRF905_PAYLOAD_SIZE]; // 32 bytes max
+    uint64_t i2c_errors = 0, i2c_timeouts = 0;
+    int len;
+
+    for (int d = 0; d < I2C_DEV_COUNT; d++)
+    {
+        i2c_errors += hk->i2c_errors[d];
+        i2c_timeouts += hk->i2c_timeouts[d];
+    }
+
+    len = snprintf(buffer, sizeof(buffer), "H:%lu,%lu,%lu,%lu",
+                   field(hk->loop_rate_hz), field(hk->busy_permille),
+                   field(hk->deadline_misses), field(hk->worst_lateness_us / 1000));
+    radio_send_frame(buffer, len);
+
+    len = snprintf(buffer, sizeof(buffer), "E:%lu,%lu,%lu,%lu",
+                   field(hk->gps_uart_overruns), field(hk->gps_uart_framing_errors),
+                   field(hk->gps_rx_dropped), field(hk->gps_checksum_failures));
+    radio_send_frame(buffer, len);
+
+    len = snprintf(buffer, sizeof(buffer), "F:%lu,%lu,%lu,%lu,%lu",
+                   field(i2c_errors), field(i2c_timeouts),
+                   field(hk->sd_errors), field(hk->sd_worst_us / 1000), field(hk->radio_dropped));
+    radio_send_frame(buffer, len);
+}
+
+void radio_module_send_latency(void)
+{
+    char buffer[NRF905_PAYLOAD_SIZE]; // 32 bytes max
+    e2e_summary_t sd, air;
+
+    e2e_latency_summary(E2E_SENSORS_SD, &sd);
+    e2e_latency_summary(E2E_SENSORS_RADIO, &air);
+
+    int len = snprintf(buffer, sizeof(buffer), "L:%lu,%lu,%lu,%lu",
+                       field(sd.p50_us / 1000), field(sd.p99_us / 1000),
+                       field(air.p50_us / 1000), field(air.p99_us / 1000));
+    radio_send_frame(buffer, len);
+}
+
+void radio_module_poll(void)
+{
+    if (!nrf905_data_ready()) return;
+
+    uint8_t packet[NRF905_PAYLOAD_SIZE];
+    nrf905_rx(packet);
+
+    uint32_t crc = 0;
+    bool writable = flight_phase() == FLIGHT_PAD || flight_phase() == FLIGHT_LANDED;
+    flash_config_result_t result = flash_config_receive(packet, writable, &crc);
+    if (result == FLASH_CONFIG_NOT_A_BLOCK) return;
+
+    static const char *const result_names[] = {
+        [FLASH_CONFIG_STORED] = "OK",
+        [FLASH_CONFIG_REJECTED] = "BAD",
+        [FLASH_CONFIG_WRITE_FAILED] = "ERR",
+        [FLASH_CONFIG_LOCKED] = "LOCK",
+    };
+    char buffer[NRF905_PAYLOAD_SIZE]; // 32 bytes max
+
+    int len = snprintf(buffer, sizeof(buffer), "C:%08lx,%s", (unsigned long)crc, result_names[result]);
+    radio_send_frame(buffer, len);
+}
+
+void radio_module_get_stats(radio_stats_t *stats)
+{
+    *stats = radio_stats;
+}
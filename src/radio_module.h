@@ -9,23 +9,84 @@
 #define RADIO_MODULE_H
 
 #include "pico/stdlib.h"
+#include "gps_module.h"
+#include "housekeeping.h"
+
+/** @brief The telemetry timestamp counts milliseconds modulo this, so that it fits the
+ ** 32-byte payload with the readings (it wraps every 1000 s; frames are sent far more often). */
+#define RADIO_STAMP_WRAP_MS 1000000UL
+
+/** @brief Counters and milliseconds in the housekeeping and latency frames saturate at this, so
+ ** that every field has at most 5 digits and a whole frame always fits the payload. */
+#define RADIO_FIELD_MAX 99999UL
+
+/** @brief Frame counters, cumulative since boot. */
+typedef struct
+{
+    uint32_t queued; /// Frames handed to the driver.
+    uint32_t sent; /// Frames whose transmission completed (the radio raised DR).
+    uint32_t dropped; /// Frames whose transmission did not complete in time.
+    uint32_t oversized; /// Frames not sent because they did not fit the 32-byte payload.
+} radio_stats_t;
 
 /** @brief Initializes the radio hardware and driver.
  * @details This function calls the underlying driver initialization routine. It sets up 
  * the SPI interface, configures GPIO pins for radio control (TX_EN, TRX_CE, PWR), 
- * and writes the default configuration registers (Frequency, Power, CRC).
+ * and writes the default configuration registers (Frequency, Power, CRC), then applies the
+ * SPI clock and channel of the flash configuration.
  ** @note Must be called once at system startup before attempting any transmissions.
  */
 extern void radio_module_init(void);
 
 /** @brief Formats sensor data and broadcasts it via radio.
  * @details This function takes individual sensor readings, formats them into a standard 
- * ASCII telemetry string (e.g., "T:24.5 P:1001 A:150"), and broadcasts the 
- * packet via the nRF905 radio.
+ * ASCII telemetry string (e.g., "123456 T:24.5 P:1001 A:150"), and broadcasts the 
+ * packet via the nRF905 radio. The leading number is the sample timestamp in
+ * milliseconds since boot, modulo `RADIO_STAMP_WRAP_MS`. Readings too wide for the payload
+ * are sent without their decimals.
+ ** @param sample_us `time_us_64()` at which the readings were taken.
  ** @param temp  Temperature (Celsius)
  ** @param press Pressure (Pascals)
  ** @param alt   Altitude (Meters)
  */
-extern void radio_module_send_telemetry(float temp, float press, float alt);
+extern void radio_module_send_telemetry(uint64_t sample_us, float temp, float press, float alt);
+
+/** @brief Formats the GPS position and broadcasts it via radio.
+ * @details Coordinates are sent as integers in 1e-7 degrees, so the full receiver
+ * precision reaches the ground station (e.g., "G:511156808,170252815,128").
+ ** @param gps Pointer to the latest GPS data. Altitude is sent in whole meters.
+ */
+extern void radio_module_send_position(const gps_data_t *gps);
+
+/** @brief Broadcasts a condensed housekeeping record in three frames.
+ * @details "H:<loop Hz>,<busy permille>,<deadline misses>,<worst lateness ms>",
+ * "E:<UART overruns>,<framing errors>,<RX dropped>,<NMEA checksum failures>" for the GPS link and
+ * "F:<I2C errors>,<I2C timeouts>,<SD errors>,<SD worst ms>,<radio dropped>", with the I2C counters
+ * summed over all devices. Each field saturates at `RADIO_FIELD_MAX`. The full record goes to
+ * the microSD card.
+ ** @param hk Pointer to the record to send.
+ */
+extern void radio_module_send_housekeeping(const housekeeping_t *hk);
+
+/** @brief Broadcasts the end-to-end latency of the sensor data (see e2e_latency.h).
+ * @details "L:<to card p50>,<to card p99>,<on air p50>,<on air p99>" in milliseconds, for the
+ * sensor record paths, so the ground station knows how old the telemetry it shows is. Each
+ * value saturates at `RADIO_FIELD_MAX` (100 s).
+ */
+extern void radio_module_send_latency(void);
+
+/** @brief Handles a packet sent up by the ground station, if the radio holds one.
+ * @details The radio listens between transmissions. A configuration block (flash_config.h) is
+ * stored and acknowledged with "C:<block CRC in hex>,<OK|BAD|ERR|LOCK>": stored for the next
+ * boot, rejected (version, CRC or range), not read back from flash, or refused because the
+ * CanSat is neither on the pad nor landed (flight_phase.h). Other packets are dropped.
+ * Call once per main loop iteration; without a packet it costs one GPIO read.
+ */
+extern void radio_module_poll(void);
+
+/** @brief Retrieves the frame counters.
+ ** @param[out] stats Pointer to a 'radio_stats_t' structure where the counters will be copied.
+ */
+extern void radio_module_get_stats(radio_stats_t *stats);
 
 #endif
\ No newline at end of file
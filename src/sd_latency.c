@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "diskio.h"
+#include "sd_latency.h"
+#include "time_manager.h"
+
+sd_op_stats_t sd_latency_stats[SD_OP_COUNT];
+sd_latency_event_t sd_latency_worst[SD_WORST_EVENTS];
+
+const char *const sd_op_names[SD_OP_COUNT] = {
+    [SD_OP_MOUNT] = "f_mount",
+    [SD_OP_OPEN] = "f_open",
+    [SD_OP_WRITE] = "f_printf",
+    [SD_OP_CLOSE] = "f_close",
+    [SD_OP_DISK_WRITE] = "disk_write",
+};
+
+static uint8_t bucket_of(uint32_t us)
+{
+    uint8_t k = 0;
+
+    while (us > 1 && k < SD_LATENCY_BUCKETS - 1)
+    {
+        us >>= 1;
+        k++;
+    }
+    return k;
+}
+
+void sd_latency_record(sd_op_t op, uint64_t start_us, bool ok)
+{
+    uint64_t elapsed = time_us_64() - start_us;
+    uint32_t us = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+    sd_op_stats_t *s = &sd_latency_stats[op];
+
+    s->count++;
+    if (!ok) s->errors++;
+    if (us >= SD_STALL_THRESHOLD_US) s->stalls++;
+    if (us > s->max_us) s->max_us = us;
+    s->histogram[bucket_of(us)]++;
+
+    // Worst-N list, slowest first: insert and shift the faster entries down.
+    if (us <= sd_latency_worst[SD_WORST_EVENTS - 1].duration_us) return;
+
+    int i = SD_WORST_EVENTS - 1;
+    while (i > 0 && sd_latency_worst[i - 1].duration_us < us)
+    {
+        sd_latency_worst[i] = sd_latency_worst[i - 1];
+        i--;
+    }
+    sd_latency_worst[i] = (sd_latency_event_t){ .start_us = start_us, .duration_us = us, .op = op };
+}
+
+void sd_latency_dump(void)
+{
+    printf("[SDLAT] op,count,errors,stalls,max_us,histogram (bucket k = [2^k, 2^(k+1)) us)\n");
+
+    for (int op = 0; op < SD_OP_COUNT; op++)
+    {
+        const sd_op_stats_t *s = &sd_latency_stats[op];
+
+        printf("[SDLAT] %s,%lu,%lu,%lu,%lu,", sd_op_names[op],
+               (unsigned long)s->count, (unsigned long)s->errors,
+               (unsigned long)s->stalls, (unsigned long)s->max_us);
+        for (int k = 0; k < SD_LATENCY_BUCKETS; k++)
+        {
+            printf("%lu%c", (unsigned long)s->histogram[k], (k == SD_LATENCY_BUCKETS - 1) ? '\n' : ';');
+        }
+    }
+
+    for (int i = 0; i < SD_WORST_EVENTS && sd_latency_worst[i].duration_us > 0; i++)
+    {
+        const sd_latency_event_t *e = &sd_latency_worst[i];
+
+        printf("[SDLAT] worst,%d,t=" TIME_US_FMT ",%s,%lu us\n", i,
+               TIME_US_ARGS(e->start_us), sd_op_names[e->op], (unsigned long)e->duration_us);
+    }
+}
+
+void sd_latency_command(int c)
+{
+    if (c == SD_LATENCY_DUMP_CHAR) sd_latency_dump();
+}
+
+// Every block write issued by FatFs goes through here (linked with --wrap=disk_write).
+extern DRESULT __real_disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count);
+
+DRESULT __wrap_disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    uint64_t start = time_us_64();
+    DRESULT res = __real_disk_write(pdrv, buff, sector, count);
+
+    sd_latency_record(SD_OP_DISK_WRITE, start, res == RES_OK);
+    return res;
+}
@@ -0,0 +1,92 @@
+/** @file sd_latency.h
+ ** @brief SD card operation latency histogram and stall detection.
+ * @details Every FatFs call made by `microsd_module.c` and every block write reaching the
+ * card driver (`disk_write`, intercepted with the linker option `--wrap=disk_write`) is
+ * timed into a per-operation log2 histogram: bucket `k` counts operations that took
+ * [2^k, 2^(k+1)) microseconds, the last bucket collects everything slower.
+ * Operations slower than `SD_STALL_THRESHOLD_US` are counted as stalls, and the
+ * `SD_WORST_EVENTS` slowest operations are kept with the time they started.
+ *
+ * The statistics are printed over USB on `SD_LATENCY_DUMP_CHAR` and appended to
+ * 'sd_latency.csv' by `save_sd_latency_log()` every `SD_LATENCY_LOG_PERIOD_S` seconds.
+ */
+
+#ifndef SD_LATENCY_H
+#define SD_LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// CONFIGURATION MACROS
+
+/** @brief Number of log2 histogram buckets (the last one is open-ended, >= ~0.5 s). */
+#define SD_LATENCY_BUCKETS 20
+
+/** @brief Operations at least this slow are counted as stalls [us]. */
+#define SD_STALL_THRESHOLD_US 50000
+
+/** @brief Number of slowest operations kept. */
+#define SD_WORST_EVENTS 8
+
+/** @brief Character received over USB that triggers a dump of the statistics. */
+#define SD_LATENCY_DUMP_CHAR 's'
+
+/** @brief Period of the 'sd_latency.csv' summary record [s]. */
+#define SD_LATENCY_LOG_PERIOD_S 60
+
+// DATA STRUCTURES
+
+/** @brief Timed SD operations. */
+typedef enum
+{
+    SD_OP_MOUNT = 0, /// f_mount
+    SD_OP_OPEN, /// f_open
+    SD_OP_WRITE, /// f_printf (buffered write through f_write)
+    SD_OP_CLOSE, /// f_close (f_sync plus release)
+    SD_OP_DISK_WRITE, /// disk_write: block write reaching the card
+    SD_OP_COUNT
+} sd_op_t;
+
+/** @brief Statistics of one operation type. */
+typedef struct
+{
+    uint32_t count; /// Completed operations.
+    uint32_t errors; /// Operations that returned an error.
+    uint32_t stalls; /// Operations at least `SD_STALL_THRESHOLD_US` long.
+    uint32_t max_us; /// Slowest operation.
+    uint32_t histogram[SD_LATENCY_BUCKETS]; /// log2 latency buckets.
+} sd_op_stats_t;
+
+/** @brief One of the slowest operations seen. */
+typedef struct
+{
+    uint64_t start_us; /// `time_us_64()` at the start of the operation.
+    uint32_t duration_us; /// Operation latency.
+    uint8_t op; /// `sd_op_t`.
+} sd_latency_event_t;
+
+// FUNCTIONS
+
+/** @brief Per-operation statistics, indexed by `sd_op_t`. */
+extern sd_op_stats_t sd_latency_stats[SD_OP_COUNT];
+
+/** @brief The slowest operations, slowest first; unused entries have `duration_us` 0. */
+extern sd_latency_event_t sd_latency_worst[SD_WORST_EVENTS];
+
+/** @brief Display names of the operations, indexed by `sd_op_t`. */
+extern const char *const sd_op_names[SD_OP_COUNT];
+
+/** @brief Records one operation that started at `start_us` and has just finished.
+ ** @param[in] op Operation type.
+ ** @param[in] start_us `time_us_64()` taken right before the operation.
+ ** @param[in] ok false if the operation returned an error.
+ */
+extern void sd_latency_record(sd_op_t op, uint64_t start_us, bool ok);
+
+/** @brief Handles a character received over stdio: `SD_LATENCY_DUMP_CHAR` prints the statistics. */
+extern void sd_latency_command(int c);
+
+/** @brief Prints the histograms and the slowest operations over stdio. */
+extern void sd_latency_dump(void);
+
+#endif // SD_LATENCY_H
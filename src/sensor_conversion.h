@@ -0,0 +1,60 @@
+/** @file sensor_conversion.h
+ ** @brief Conversions from raw sensor values to physical units.
+ * @details Pure arithmetic shared by the sensor drivers in `atm_sen_module.c`. It has no
+ * hardware dependencies, so the exact same expressions can also be compiled and timed on
+ * the host (see tools/bench).
+ */
+
+#ifndef SENSOR_CONVERSION_H
+#define SENSOR_CONVERSION_H
+
+#include <math.h>
+#include <stdint.h>
+
+// CONFIGURATION MACROS
+
+/** @brief Sea-level reference pressure of the barometric formula [Pa]. */
+#define SEA_LEVEL_PRESSURE_PA 101325.0f
+
+/** @brief Full-scale reading of the 12-bit ADC. */
+#define ADC_FULL_SCALE 4095
+
+/** @brief ADC reference voltage [V]. */
+#define ADC_VREF 3.3f
+
+// FUNCTIONS
+
+/** @brief Converts a pressure into altitude with the international barometric formula.
+ ** @param[in] pressure_pa Pressure in Pascals.
+ ** @return Altitude above the `SEA_LEVEL_PRESSURE_PA` reference level in meters.
+ */
+static inline double pressure_to_altitude(double pressure_pa)
+{
+    return 44330.0f * (1.0f - powf(pressure_pa / SEA_LEVEL_PRESSURE_PA, 0.1903f));
+}
+
+/** @brief Converts a raw SHTC3 temperature word into Celsius degrees (datasheet formula). */
+static inline float shtc3_raw_to_celsius(uint16_t raw)
+{
+    return -45.0f + 175 * ((float)raw / 65535.0f);
+}
+
+/** @brief Converts a raw SHTC3 humidity word into relative humidity percentage (datasheet formula). */
+static inline float shtc3_raw_to_humidity(uint16_t raw)
+{
+    return 100.0f * ((float)raw / 65535.0f);
+}
+
+/** @brief Converts a raw ADC sample of a MEMS gas sensor into a concentration.
+ ** @param[in] raw 12-bit ADC sample.
+ ** @param[in] sensitivity_factor Sensor sensitivity [ppm/V].
+ ** @return Gas concentration in particles per million.
+ */
+static inline float adc_raw_to_ppm(uint16_t raw, float sensitivity_factor)
+{
+    float voltage = (float)raw * ADC_VREF / ADC_FULL_SCALE;
+
+    return voltage * sensitivity_factor;
+}
+
+#endif // SENSOR_CONVERSION_H
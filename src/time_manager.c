@@ -4,107 +4,271 @@
 #include "microsd_module.h"
 #include <stdio.h>
 
-#define TIMEZONE_OFFSET 1
-
-// This is a standard counter that holds the total seconds elapsed since a specific starting point (January 1, 2026, as in the init function).
-static time_t raw_seconds = 0;
+#define US_PER_SECOND 1000000ULL
 
+// The broken-down calendar time. It is advanced one second at a time by time_manager_update(),
+// so reading it never needs a gmtime() conversion (starts at January 1, 2026, as in the init function).
 static current_time_t system_time;
 
-// This tracks the millisecond timer from the processor to detect when exactly 1 second has passed.
-static uint32_t last_second_ms = 0; 
+// Local time offset applied to the GPS time (time_manager_set_timezone()).
+static int8_t timezone_offset_h = TIMEZONE_OFFSET;
+
+// This tracks the microsecond timer from the processor to detect when exactly 1 second has passed.
+// A GPS sync may place it up to a second ahead of now, when the calendar has run ahead of the GPS,
+// so it is compared through the signed `since_second_us()`.
+static uint64_t last_second_us = 0;
+
+// UTC second of the last fix time_manager_sync() phased the tick to (year 0: none yet).
+static current_time_t synced_second;
+
+// The calendar has been set from the GPS since the cold boot.
+static bool synced = false;
+
+static bool is_leap_year(uint16_t year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+static uint8_t days_in_month(uint16_t year, uint8_t month)
+{
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    if (month == 2 && is_leap_year(year)) return 29;
+    return days[month - 1];
+}
+
+static void calendar_next_day(current_time_t *t)
+{
+    if (++t->day > days_in_month(t->year, t->month))
+    {
+        t->day = 1;
+        if (++t->month > 12)
+        {
+            t->month = 1;
+            t->year++;
+        }
+    }
+}
+
+static void calendar_prev_day(current_time_t *t)
+{
+    if (--t->day == 0)
+    {
+        if (--t->month == 0)
+        {
+            t->month = 12;
+            t->year--;
+        }
+        t->day = days_in_month(t->year, t->month);
+    }
+}
+
+static int32_t seconds_of_day(const current_time_t *t)
+{
+    return (int32_t)t->hour * 3600 + t->min * 60 + t->sec;
+}
+
+static void calendar_next_second(current_time_t *t)
+{
+    if (++t->sec < 60) return;
+    t->sec = 0;
+
+    if (++t->min < 60) return;
+    t->min = 0;
+
+    if (++t->hour < 24) return;
+    t->hour = 0;
+
+    calendar_next_day(t);
+    t->photo_count = 0;
+}
 
 void time_manager_init(void)
 {
-    struct tm t = {0};
-    t.tm_year = 2026 - 1900;
-    t.tm_mon  = 0;
-    t.tm_mday = 1;
-    t.tm_hour = 0;
-    t.tm_min  = 0;
-    t.tm_sec  = 0;
-    
-    raw_seconds = mktime(&t);
-    
-    last_second_ms = to_ms_since_boot(get_absolute_time());
+    system_time.year  = 2026;
+    system_time.month = 1;
+    system_time.day   = 1;
+    system_time.hour  = 0;
+    system_time.min   = 0;
+    system_time.sec   = 0;
+    system_time.photo_count = 0;
+
+    // The first tick is due at once, so sampling starts as soon as the main loop runs
+    // (unsigned arithmetic: this may wrap shortly after reset).
+    last_second_us = time_us_64() - US_PER_SECOND;
+    synced_second = (current_time_t){0};
+    synced = false;
+}
+
+// Time since the last second boundary, negative while a sync has it ahead of now.
+static int64_t since_second_us(uint64_t now)
+{
+    return (int64_t)(now - last_second_us);
+}
+
+void time_manager_resume(const current_time_t *calendar, uint64_t tick_age_us, bool was_synced)
+{
+    system_time = *calendar;
+    synced = was_synced;
+
+    // The seconds that went by without a tick are skipped, not caught up.
+    for (uint64_t s = tick_age_us / US_PER_SECOND; s > 0; s--) calendar_next_second(&system_time);
+
+    last_second_us = time_us_64() - tick_age_us % US_PER_SECOND;
+}
+
+void time_manager_set_timezone(int8_t offset_h)
+{
+    timezone_offset_h = offset_h;
 }
 
 bool time_manager_update(void)
 {
-    uint32_t now = to_ms_since_boot(get_absolute_time());
-    
-    if (now - last_second_ms >= 1000) 
+    uint64_t now = time_us_64();
+
+    if (since_second_us(now) >= (int64_t)US_PER_SECOND)
     {
-        last_second_ms += 1000;
-        
-        raw_seconds++;
-        
-        return true; 
+        last_second_us += US_PER_SECOND;
+
+        calendar_next_second(&system_time);
+
+        return true;
     }
     return false;
 }
 
-current_time_t *time_manager_get(void)
-{
-    struct tm *t_info;
-    
-    t_info = gmtime(&raw_seconds);
-    
-    system_time.year  = t_info->tm_year + 1900;
-    system_time.month = t_info->tm_mon + 1;
-    system_time.day   = t_info->tm_mday;
-    system_time.hour  = t_info->tm_hour;
-    system_time.min   = t_info->tm_min;
-    system_time.sec   = t_info->tm_sec;
-    
-    if (system_time.hour == 0 && system_time.min == 0 && system_time.sec == 0) 
+uint32_t time_manager_tick_lateness_us(void)
+{
+    int64_t late = since_second_us(time_us_64());
+
+    if (late < 0) return 0;
+    return (late > UINT32_MAX) ? UINT32_MAX : (uint32_t)late;
+}
+
+void time_manager_get(current_time_t *out)
+{
+    *out = system_time;
+}
+
+/** @brief Moves a calendar by whole hours, carrying into the date. */
+static void shift_hours(current_time_t *t, int hours)
+{
+    int hour = t->hour + hours;
+
+    while (hour >= 24)
     {
-        system_time.photo_count = 0;
+        hour -= 24;
+        calendar_next_day(t);
     }
+    while (hour < 0)
+    {
+        hour += 24;
+        calendar_prev_day(t);
+    }
+    t->hour = hour;
+}
+
+void time_manager_get_utc(current_time_t *out)
+{
+    *out = system_time;
+    shift_hours(out, -timezone_offset_h);
+}
+
+bool time_manager_synced(void)
+{
+    return synced;
+}
+
+void time_manager_snapshot(time_snapshot_t *out)
+{
+    out->mono_us = time_us_64();
+    out->calendar = system_time;
 
-    return &system_time;
+    // time_manager_update() may not have caught up with the last second boundary yet, or a
+    // sync may have moved the boundary ahead of the calendar.
+    int64_t elapsed = since_second_us(out->mono_us);
+    if (elapsed < 0) elapsed = 0;
+    out->sub_us = (elapsed < (int64_t)US_PER_SECOND) ? (uint32_t)elapsed : (uint32_t)(US_PER_SECOND - 1);
 }
 
-void time_manager_sync(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
+/** @brief Converts a UTC date and time into the local calendar (`timezone_offset_h`). */
+static current_time_t local_calendar(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
 {
-    struct tm t = {0};
+    current_time_t t = system_time;
 
-    t.tm_year = year - 1900;
-    t.tm_mon  = month - 1;
-    t.tm_mday = day;
-    t.tm_min  = min;
-    t.tm_sec  = sec;
+    t.year  = year;
+    t.month = month;
+    t.day   = day;
+    t.hour  = hour;
+    t.min   = min;
+    t.sec   = sec;
+    shift_hours(&t, timezone_offset_h);
+    return t;
+}
 
-    t.tm_hour = hour + TIMEZONE_OFFSET; 
+void time_manager_seed(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
+{
+    system_time = local_calendar(year, month, day, hour, min, sec);
+}
 
-    raw_seconds = mktime(&t);
-    last_second_ms = to_ms_since_boot(get_absolute_time());
+static bool same_day(const current_time_t *a, const current_time_t *b)
+{
+    return a->year == b->year && a->month == b->month && a->day == b->day;
+}
+
+void time_manager_sync(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec, uint64_t second_us)
+{
+    // Fixes come several times a second; the first one of each GPS second phases the tick.
+    current_time_t utc = {.year = year, .month = month, .day = day, .hour = hour, .min = min, .sec = sec};
+
+    if (same_day(&utc, &synced_second) && seconds_of_day(&utc) == seconds_of_day(&synced_second)) return;
+    synced_second = utc;
+    synced = true;
+
+    current_time_t t = local_calendar(year, month, day, hour, min, sec);
+
+    // Within a second of the GPS, the calendar is kept and only its second boundary moves onto
+    // the GPS one: a tick that is due comes at once, and none is repeated or skipped.
+    if (same_day(&t, &system_time))
+    {
+        int32_t ahead_s = seconds_of_day(&system_time) - seconds_of_day(&t);
+
+        if (ahead_s >= -1 && ahead_s <= 1)
+        {
+            last_second_us = second_us + (int64_t)ahead_s * (int64_t)US_PER_SECOND;
+            return;
+        }
+    }
+
+    system_time = t;
+    last_second_us = second_us;
 }
 
 DWORD get_fattime(void)
 {
-    current_time_t *t = time_manager_get();
+    current_time_t t;
+    time_manager_get(&t);
 
     DWORD fattime = 0;
 
     // 32-bit format expected by FatFS
     // Year:  Bits 31-25 (Offset from 1980)
-    fattime |= (DWORD)(t->year - 1980) << 25;
-    
+    fattime |= (DWORD)(t.year - 1980) << 25;
+
     // Month: Bits 24-21 (1-12)
-    fattime |= (DWORD)(t->month) << 21;
-    
+    fattime |= (DWORD)(t.month) << 21;
+
     // Day:   Bits 20-16 (1-31)
-    fattime |= (DWORD)(t->day) << 16;
-    
+    fattime |= (DWORD)(t.day) << 16;
+
     // Hour:  Bits 15-11 (0-23)
-    fattime |= (DWORD)(t->hour) << 11;
-    
+    fattime |= (DWORD)(t.hour) << 11;
+
     // Min:   Bits 10-5  (0-59)
-    fattime |= (DWORD)(t->min) << 5;
-    
+    fattime |= (DWORD)(t.min) << 5;
+
     // Sec:   Bits 4-0   (0-29, in 2-second intervals)
-    fattime |= (DWORD)(t->sec / 2);
+    fattime |= (DWORD)(t.sec / 2);
 
     return fattime;
-}
\ No newline at end of file
+}
@@ -1,12 +1,15 @@
 /** @file time_manager.h
  ** @brief Software RTC with GPS synchronization and FatFS integration.
- * @details Maintains system time using system ticks (`to_ms_since_boot`), independent 
- * of hardware RTC. 
+ * @details Maintains system time using the 64-bit microsecond system timer (`time_us_64`),
+ * independent of hardware RTC.
  * It features:
+ * - an incremental calendar: the broken-down date/time is advanced only when a second rolls over,
+ *   so reading the time never requires a `gmtime()` conversion.
+ * - a monotonic timebase: 64-bit microseconds since boot, suitable for per-sample timestamps.
  * - a sync with GPS: corrects drift and sets time/date via NMEA data.
  * - a FatFS backend: provides timestamps for SD card files.
- * - timezones: applies static offsets defined by `TIMEZONE_OFFSET`.
- * * Usage: Calling `time_manager_init()` at startup, `time_manager_update()` 
+ * - timezones: applies a static offset, `TIMEZONE_OFFSET` unless `time_manager_set_timezone()` sets another.
+ * * Usage: Calling `time_manager_init()` at startup, `time_manager_update()`
  * periodically in the loop, and `time_manager_sync()` when valid GPS data exists.
  * * @note Replaces the default `rtc.c` to remove hardware dependencies that were trublesome.
  */
@@ -16,15 +19,27 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <time.h>
+#include "pico/stdlib.h"
+
+// CONFIGURATION MACROS
+
+/** @brief printf format for a monotonic timestamp, printed as seconds since boot with microsecond resolution.
+ * @details The value is split into two 32-bit halves because FatFs `f_printf` has no 64-bit conversion.
+ * Use together with `TIME_US_ARGS`: `printf("t=" TIME_US_FMT, TIME_US_ARGS(us));`
+ */
+#define TIME_US_FMT "%lu.%06lu"
+#define TIME_US_ARGS(us) (unsigned long)((us) / 1000000ULL), (unsigned long)((us) % 1000000ULL)
+
+/** @brief Default local time offset from UTC [h]. */
+#define TIMEZONE_OFFSET 1
 
 // DATA STRUCTURES
 
 /** @brief The structure stores data about the date, hour, minutes and seconds a reading
- * was made and saved. 
+ * was made and saved.
  * @details It is used in the process of synchronizing timestamps with the GPS-read time data.
  */
-typedef struct 
+typedef struct
 {
     uint16_t year;
     uint8_t month;
@@ -35,51 +50,133 @@ typedef struct
     uint16_t photo_count; /// Needed for the future 'camera_module' to keep track of taken photographs.
 } current_time_t;
 
+/** @brief A consistent copy of both clocks, taken at a single instant.
+ * @details `calendar` is the wall-clock time of the current second and `sub_us` is how far
+ * into that second the snapshot was taken, so `calendar` + `sub_us` gives microsecond wall time.
+ */
+typedef struct
+{
+    current_time_t calendar; /// Calendar time of the current second.
+    uint64_t mono_us; /// Monotonic microseconds since boot at the moment of the snapshot.
+    uint32_t sub_us; /// Microseconds elapsed since `calendar` last ticked (0-999999).
+} time_snapshot_t;
+
 // FUNCTIONS
 
 /** @brief Initializes the Software Real-Time Clock (RTC).
- * @details Sets the internal system time to a default start date (January 1, 2026).
- * It captures the current processor boot time (`to_ms_since_boot`) to establish
- * a baseline for the 1-second tick counter.
+ * @details Sets the internal calendar to a default start date (January 1, 2026).
+ * It captures the current processor time (`time_us_64`) to establish
+ * a baseline for the 1-second tick counter, one second in the past: the first
+ * `time_manager_update()` ticks right away.
  * * @note This must be called once at system startup before the main loop.
  */
 extern void time_manager_init(void);
 
+/** @brief Carries on from a calendar saved before a reset (warm_restart.h), instead of the
+ * default date set by `time_manager_init()`.
+ * @details The calendar is advanced by the whole seconds of `tick_age_us` and the next tick is
+ * placed where it would have been had the clock run through the reset. Call after
+ * `time_manager_init()`.
+ ** @param[in] calendar Calendar at the last tick before the reset.
+ ** @param[in] tick_age_us Time since that tick, the reset included.
+ ** @param[in] was_synced The calendar had been synchronized with the GPS before the reset
+ * (`time_manager_synced()`).
+ */
+extern void time_manager_resume(const current_time_t *calendar, uint64_t tick_age_us, bool was_synced);
+
+/** @brief Replaces the default `TIMEZONE_OFFSET` (e.g. by the flash configuration).
+ ** @param[in] offset_h Local time offset from UTC [h], applied by the next `time_manager_sync()`.
+ */
+extern void time_manager_set_timezone(int8_t offset_h);
+
+/** @brief Starts the calendar from a UTC date and time known to be in the past, instead of
+ * the default date set by `time_manager_init()` (e.g. the last fix of an earlier power cycle,
+ * last_fix.h), until the GPS corrects it.
+ * @details Applies the timezone offset like `time_manager_sync()` but leaves the second
+ * boundary alone, so the first tick stays due at once. Call after `time_manager_init()`
+ * and `time_manager_set_timezone()`.
+ ** @param[in] year Full year (e.g., 2026).
+ ** @param[in] month Month number (1-12).
+ ** @param[in] day Day of the month (1-31).
+ ** @param[in] hour UTC Hour (0-23).
+ ** @param[in] min Minute (0-59).
+ ** @param[in] sec Second (0-59).
+ */
+extern void time_manager_seed(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec);
+
 /** @brief Ticks the internal clock forward.
- * @details This function checks the system's millisecond timer. If 1000ms have passed
- * since the last tick, it increments the internal `raw_seconds` counter
- * and updates the reference timer.
- * This function is non-blocking and is designed to be called frequently 
+ * @details This function checks the system's microsecond timer. If a full second has passed
+ * since the last tick, it advances the internal calendar by one second (carrying into minutes,
+ * hours, days, months and years as needed) and updates the reference timer.
+ * This function is non-blocking and is designed to be called frequently
  * inside the main `while(1)` loop.
  * * @return true If a full second has passed during this call (useful for triggering 1Hz events like LED blinks).
  * @return false If less than 1 second has passed since the last update.
  */
 extern bool time_manager_update(void);
 
+/** @brief Returns how late the last second tick was noticed.
+ * @details Meant to be called right after `time_manager_update()` returned true: the result is
+ * the time between the second boundary and now, i.e. how long the caller's 1 Hz work was
+ * held up by whatever ran before it.
+ ** @return Lateness in microseconds.
+ */
+extern uint32_t time_manager_tick_lateness_us(void);
+
 /** @brief Retrieves the current system time in a human-readable format.
- * @details Converts the internal epoch timestamp (`raw_seconds`) into a `current_time_t` structure
- * containing year, month, day, hour, minute, and second.
- * If the time is exactly 00:00:00 (Midnight), this function automatically 
- * resets the `photo_count` field to 0.
- * * @return current_time_t* Pointer to the structure holding the current time.
+ * @details Copies the internal calendar into the caller's structure. No conversion is done,
+ * so this is cheap enough to call for every record.
+ * The `photo_count` field is reset to 0 whenever the calendar rolls over midnight.
+ ** @param[out] out Pointer to the structure that receives the current time.
+ */
+extern void time_manager_get(current_time_t *out);
+
+/** @brief Retrieves the calendar in UTC, without the timezone offset.
+ ** @param[out] out Pointer to the structure that receives the current UTC time.
+ */
+extern void time_manager_get_utc(current_time_t *out);
+
+/** @brief Tells whether the calendar follows the GPS.
+ * @details True once `time_manager_sync()` has run since the last cold boot (carried across a
+ * warm restart by `time_manager_resume()`); a calendar only seeded or left at the default date
+ * may be off by any amount.
+ */
+extern bool time_manager_synced(void);
+
+/** @brief Takes a snapshot of the calendar and the monotonic clock at the same instant.
+ ** @param[out] out Pointer to the structure that receives the snapshot.
  */
-extern current_time_t* time_manager_get(void);
+extern void time_manager_snapshot(time_snapshot_t *out);
+
+/** @brief Returns the monotonic time in microseconds since boot.
+ * @details Thin wrapper over the 64-bit hardware timer; it never wraps during a flight
+ * and is the timebase for every per-sample timestamp.
+ */
+static inline uint64_t time_manager_now_us(void)
+{
+    return time_us_64();
+}
 
 /** @brief Synchronizes the internal clock with an external source (e.g., GPS).
- * Overwrites the internal time counter with new values provided by the GPS.
- * @details 
- * - Automatically applies the defined `TIMEZONE_OFFSET` to the provided UTC hour.
- * - Uses `mktime()` to safe-handle hour overflows. For example, if the 
+ * Overwrites the internal calendar with new values provided by the GPS.
+ * @details
+ * - Automatically applies the timezone offset (`TIMEZONE_OFFSET` or `time_manager_set_timezone()`) to the provided UTC hour.
+ * - Carries hour overflows into the date. For example, if the
  * GPS says 23:00 UTC and your offset is +2, the date automatically moves on to the next day.
- * - Resets the millisecond counter (`last_second_ms`) to zero, ensuring 
- * the next software "tick" happens exactly 1 second after this sync occurs.
+ * - Phases the second reference (`last_second_us`) from the fix itself, once per GPS second (the
+ * first fix of each second; the others change nothing), so the software "tick" follows the GPS
+ * second boundary, late only by the receiver's output delay.
+ * - Keeps the calendar while it is within 1 second of the GPS time: a tick it still owes comes
+ * at once, and a tick it took early is not repeated. Further off, the calendar is overwritten.
  * * @param[in] year  Full year (e.g., 2026).
  ** @param[in] month Month number (1-12).
  ** @param[in] day   Day of the month (1-31).
  ** @param[in] hour  UTC Hour (0-23).
  ** @param[in] min   Minute (0-59).
  ** @param[in] sec   Second (0-59).
+ ** @param[in] second_us `time_us_64()` at which the GPS second `sec` began: the fix's
+ * `timestamp_us` less its `microsec`.
  */
-extern void time_manager_sync(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec);
+extern void time_manager_sync(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec, uint64_t second_us);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,54 @@
+#include "trace.h"
+
+#if TRACING
+
+#include <stdio.h>
+#include <string.h>
+#include "profiler.h"
+
+trace_record_t trace_buffer[TRACE_BUFFER_LEN];
+uint32_t trace_head;
+volatile bool trace_paused;
+
+static const char *const trace_event_names[TRACE_EVENT_END - TRACE_EVENT_FIRST] = {
+    [TRACE_SECOND_TICK - TRACE_EVENT_FIRST] = "second_tick",
+    [TRACE_GPS_UART_IRQ - TRACE_EVENT_FIRST] = "gps_uart_irq",
+    [TRACE_GPS_FIX - TRACE_EVENT_FIRST] = "gps_fix",
+    [TRACE_GPS_RX_OVERFLOW - TRACE_EVENT_FIRST] = "gps_rx_overflow",
+};
+
+void trace_init(void)
+{
+    memset(trace_buffer, 0, sizeof(trace_buffer));
+    trace_head = 0;
+    trace_paused = false;
+}
+
+void trace_dump(void)
+{
+    trace_paused = true;
+
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+    uint32_t count = (head < TRACE_BUFFER_LEN) ? head : TRACE_BUFFER_LEN;
+
+    // The header carries the ID -> name table, so the converter needs no copy of the enums.
+    printf("# trace v1 events=%lu dropped=%lu\n", (unsigned long)count, (unsigned long)(head - count));
+    for (int i = 0; i < PROF_SCOPE_COUNT; i++) printf("# name %d %s\n", i, profiler_scope_names[i]);
+    for (int i = TRACE_EVENT_FIRST; i < TRACE_EVENT_END; i++) printf("# name %d %s\n", i, trace_event_names[i - TRACE_EVENT_FIRST]);
+
+    for (uint32_t n = head - count; n != head; n++)
+    {
+        const trace_record_t *r = &trace_buffer[n & (TRACE_BUFFER_LEN - 1)];
+        printf("%lu,%c,%u,%u,%u\n", (unsigned long)r->time_us, r->phase, r->id, r->core, r->arg);
+    }
+    printf("# end\n");
+
+    trace_paused = false;
+}
+
+void trace_command(int c)
+{
+    if (c == TRACE_DUMP_CHAR) trace_dump();
+}
+
+#endif // TRACING
@@ -0,0 +1,125 @@
+/** @file trace.h
+ ** @brief Event timeline tracing into a RAM ring buffer.
+ * @details Records timestamped begin/end/instant events from the main loop, the drivers
+ * and interrupt handlers into a fixed ring of `TRACE_BUFFER_LEN` 8-byte records; the
+ * oldest events are overwritten. Every `PROF_ENTER`/`PROF_EXIT` scope (see profiler.h)
+ * is traced as a begin/end pair, and the events below add what aggregate counters miss:
+ * interrupt handlers, second ticks and GPS fixes.
+ *
+ * Sending `TRACE_DUMP_CHAR` over USB prints the buffer as text; tools/trace2json turns the
+ * dump into Chrome trace JSON, which opens in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Recording an event is one atomic increment, one timer register read and one 8-byte
+ * store, and is safe from interrupt handlers and from both cores.
+ * With `TRACING` set to 0 (the default) every macro expands to nothing.
+ * Enable it with the CMake option `CS_TRACING=ON`.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// CONFIGURATION MACROS
+
+/** @brief 1 builds the tracer in, 0 compiles every `TRACE_*` macro to nothing. */
+#ifndef TRACING
+#define TRACING 0
+#endif
+
+/** @brief Number of records in the ring buffer (a power of two). */
+#define TRACE_BUFFER_LEN 2048
+
+/** @brief Character received over USB that triggers a dump of the trace buffer. */
+#define TRACE_DUMP_CHAR 't'
+
+// DATA STRUCTURES
+
+/** @brief Phase of a trace record (the same letters as the Chrome trace format). */
+typedef enum
+{
+    TRACE_PHASE_BEGIN = 'B',
+    TRACE_PHASE_END = 'E',
+    TRACE_PHASE_INSTANT = 'i',
+} trace_phase_t;
+
+/** @brief Trace-only event IDs. IDs below `TRACE_EVENT_FIRST` are `profiler_scope_t` scopes. */
+typedef enum
+{
+    TRACE_EVENT_FIRST = 32,
+    TRACE_SECOND_TICK = TRACE_EVENT_FIRST, /// Instant: the 1 Hz calendar ticked.
+    TRACE_GPS_UART_IRQ, /// Begin/end: GPS UART receive interrupt.
+    TRACE_GPS_FIX, /// Instant: new GPS data; arg = satellites.
+    TRACE_GPS_RX_OVERFLOW, /// Instant: a received byte was dropped because the ring was full.
+    TRACE_EVENT_END
+} trace_event_t;
+
+/** @brief One trace record. */
+typedef struct
+{
+    uint32_t time_us; /// Low 32 bits of `time_us_64()` (wraps every ~71 minutes).
+    uint8_t id; /// `profiler_scope_t` or `trace_event_t`.
+    uint8_t phase; /// `trace_phase_t`.
+    uint8_t core; /// Core that recorded the event.
+    uint8_t arg; /// Event-specific argument.
+} trace_record_t;
+
+// FUNCTIONS
+
+#if TRACING
+
+#include "pico/stdlib.h"
+#include "pico/platform.h"
+
+/** @brief The ring buffer; `trace_head` counts every event ever recorded. */
+extern trace_record_t trace_buffer[TRACE_BUFFER_LEN];
+extern uint32_t trace_head;
+
+/** @brief Recording is paused while the buffer is being dumped. */
+extern volatile bool trace_paused;
+
+/** @brief Clears the buffer. */
+extern void trace_init(void);
+
+/** @brief Handles a character received over stdio: `TRACE_DUMP_CHAR` prints the buffer. */
+extern void trace_command(int c);
+
+/** @brief Prints the whole buffer over stdio, oldest event first. */
+extern void trace_dump(void);
+
+/** @brief Records one event. */
+static inline void trace_emit(uint8_t id, uint8_t phase, uint8_t arg)
+{
+    if (trace_paused) return;
+
+    // Low word of the 64-bit timer: a single register read, unlike time_us_64().
+    uint32_t now = time_us_32();
+    uint32_t slot = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED) & (TRACE_BUFFER_LEN - 1);
+
+    trace_buffer[slot] = (trace_record_t){
+        .time_us = now,
+        .id = id,
+        .phase = phase,
+        .core = (uint8_t)get_core_num(),
+        .arg = arg,
+    };
+}
+
+#define TRACE_BEGIN(id) trace_emit((id), TRACE_PHASE_BEGIN, 0)
+#define TRACE_END(id) trace_emit((id), TRACE_PHASE_END, 0)
+#define TRACE_INSTANT(id, arg) trace_emit((id), TRACE_PHASE_INSTANT, (uint8_t)(arg))
+#define TRACE_INIT() trace_init()
+#define TRACE_COMMAND(c) trace_command(c)
+
+#else
+
+#define TRACE_BEGIN(id) ((void)0)
+#define TRACE_END(id) ((void)0)
+#define TRACE_INSTANT(id, arg) ((void)0)
+#define TRACE_INIT() ((void)0)
+#define TRACE_COMMAND(c) ((void)0)
+
+#endif // TRACING
+
+#endif // TRACE_H
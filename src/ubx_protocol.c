@@ -0,0 +1,163 @@
+/** @file ubx_protocol.c
+ *  @brief Implementation of the UBX frame parser and NAV-PVT decoder.
+ *
+ * @see ubx_protocol.h for the public API and data structures.
+ */
+
+#include <string.h>
+#include "ubx_protocol.h"
+
+enum
+{
+    UBX_STATE_SYNC_1 = 0,
+    UBX_STATE_SYNC_2,
+    UBX_STATE_CLASS,
+    UBX_STATE_ID,
+    UBX_STATE_LEN_LO,
+    UBX_STATE_LEN_HI,
+    UBX_STATE_PAYLOAD,
+    UBX_STATE_CK_A,
+    UBX_STATE_CK_B,
+};
+
+static inline void checksum_add(ubx_parser_t *parser, uint8_t byte)
+{
+    parser->ck_a += byte;
+    parser->ck_b += parser->ck_a;
+}
+
+void ubx_parser_init(ubx_parser_t *parser)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->state = UBX_STATE_SYNC_1;
+}
+
+void ubx_checksum(const uint8_t *data, uint16_t len, uint8_t *ck_a, uint8_t *ck_b)
+{
+    uint8_t a = 0, b = 0;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        a += data[i];
+        b += a;
+    }
+
+    *ck_a = a;
+    *ck_b = b;
+}
+
+uint16_t ubx_build_frame(uint8_t *out, uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len)
+{
+    out[0] = UBX_SYNC_1;
+    out[1] = UBX_SYNC_2;
+    out[2] = msg_class;
+    out[3] = msg_id;
+    out[4] = (uint8_t)(len & 0xFF);
+    out[5] = (uint8_t)(len >> 8);
+    if (len > 0) memcpy(&out[6], payload, len);
+
+    ubx_checksum(&out[2], len + 4, &out[6 + len], &out[7 + len]);
+
+    return len + UBX_FRAME_OVERHEAD;
+}
+
+bool ubx_parser_feed(ubx_parser_t *parser, uint8_t byte)
+{
+    switch (parser->state)
+    {
+        case UBX_STATE_SYNC_1:
+            if (byte == UBX_SYNC_1) parser->state = UBX_STATE_SYNC_2;
+            break;
+
+        case UBX_STATE_SYNC_2:
+            if (byte == UBX_SYNC_2) parser->state = UBX_STATE_CLASS;
+            else if (byte != UBX_SYNC_1) parser->state = UBX_STATE_SYNC_1;
+            break;
+
+        case UBX_STATE_CLASS:
+            parser->ck_a = 0;
+            parser->ck_b = 0;
+            checksum_add(parser, byte);
+            parser->msg_class = byte;
+            parser->state = UBX_STATE_ID;
+            break;
+
+        case UBX_STATE_ID:
+            checksum_add(parser, byte);
+            parser->msg_id = byte;
+            parser->state = UBX_STATE_LEN_LO;
+            break;
+
+        case UBX_STATE_LEN_LO:
+            checksum_add(parser, byte);
+            parser->length = byte;
+            parser->state = UBX_STATE_LEN_HI;
+            break;
+
+        case UBX_STATE_LEN_HI:
+            checksum_add(parser, byte);
+            parser->length |= (uint16_t)byte << 8;
+            parser->index = 0;
+            if (parser->length > UBX_MAX_PAYLOAD)
+            {
+                parser->length_errors++;
+                parser->state = UBX_STATE_SYNC_1;
+            }
+            else
+            {
+                parser->state = (parser->length > 0) ? UBX_STATE_PAYLOAD : UBX_STATE_CK_A;
+            }
+            break;
+
+        case UBX_STATE_PAYLOAD:
+            checksum_add(parser, byte);
+            parser->payload[parser->index] = byte;
+            if (++parser->index >= parser->length) parser->state = UBX_STATE_CK_A;
+            break;
+
+        case UBX_STATE_CK_A:
+            if (byte == parser->ck_a)
+            {
+                parser->state = UBX_STATE_CK_B;
+            }
+            else
+            {
+                parser->checksum_errors++;
+                parser->state = UBX_STATE_SYNC_1;
+            }
+            break;
+
+        case UBX_STATE_CK_B:
+            parser->state = UBX_STATE_SYNC_1;
+            if (byte != parser->ck_b)
+            {
+                parser->checksum_errors++;
+                return false;
+            }
+            return true;
+
+        default:
+            parser->state = UBX_STATE_SYNC_1;
+            break;
+    }
+
+    return false;
+}
+
+bool ubx_decode_nav_pvt(const ubx_parser_t *parser, ubx_nav_pvt_t *pvt)
+{
+    if (parser->msg_class != UBX_CLASS_NAV || parser->msg_id != UBX_ID_NAV_PVT) return false;
+    if (parser->length != UBX_NAV_PVT_LEN) return false;
+
+    memcpy(pvt, parser->payload, UBX_NAV_PVT_LEN);
+    return true;
+}
+
+bool ubx_decode_nav_clk(const ubx_parser_t *parser, ubx_nav_clk_t *clk)
+{
+    if (parser->msg_class != UBX_CLASS_NAV || parser->msg_id != UBX_ID_NAV_CLK) return false;
+    if (parser->length != UBX_NAV_CLK_LEN) return false;
+
+    memcpy(clk, parser->payload, UBX_NAV_CLK_LEN);
+    return true;
+}
@@ -0,0 +1,267 @@
+/** @file ubx_protocol.h
+ ** @brief u-blox UBX binary protocol framer and NAV-PVT decoder.
+ * @details The UBX protocol carries the same information as the NMEA sentences in a
+ * compact binary form. A single NAV-PVT message (92-byte payload) holds the position,
+ * altitude, velocity, fix type, satellite count and UTC time of one navigation epoch,
+ * with coordinates already in integer 1e-7 degrees, so no text or float parsing is needed.
+ * Frame layout: `0xB5 0x62 | class | id | length (LE16) | payload | CK_A | CK_B`,
+ * where the checksum is an 8-bit Fletcher sum over class, id, length and payload.
+ ** @see u-blox 8 / M8 Receiver Description, Protocol Specification, section "UBX Protocol".
+ */
+
+#ifndef UBX_PROTOCOL_H
+#define UBX_PROTOCOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// CONFIGURATION MACROS
+
+/** @brief First synchronization character of every UBX frame. */
+#define UBX_SYNC_1 0xB5
+
+/** @brief Second synchronization character of every UBX frame. */
+#define UBX_SYNC_2 0x62
+
+/** @brief Largest payload accepted by the framer: the largest message the receiver is configured
+ ** to send (NAV-PVT, 92 bytes) with some margin. A longer length field is taken as corruption. */
+#define UBX_MAX_PAYLOAD 100
+
+/** @brief Message class and ID of the NAV-PVT (Navigation Position Velocity Time) message. */
+#define UBX_CLASS_NAV 0x01
+#define UBX_ID_NAV_PVT 0x07
+
+/** @brief Message ID of NAV-CLK (receiver clock bias and drift). */
+#define UBX_ID_NAV_CLK 0x22
+
+/** @brief Message class and ID of the MGA-INI aiding messages (initial position, time, clock drift).
+ * @details The receiver does not acknowledge them unless told to (CFG-NAVX5).
+ */
+#define UBX_CLASS_MGA 0x13
+#define UBX_ID_MGA_INI 0x40
+
+/** @brief `type` of the MGA-INI messages used. */
+#define UBX_MGA_INI_POS_LLH 0x01
+#define UBX_MGA_INI_TIME_UTC 0x10
+#define UBX_MGA_INI_CLKD 0x21
+
+/** @brief Message classes and IDs used to acknowledge and configure the receiver. */
+#define UBX_CLASS_ACK 0x05
+#define UBX_ID_ACK_NAK 0x00
+#define UBX_ID_ACK_ACK 0x01
+#define UBX_CLASS_CFG 0x06
+#define UBX_ID_CFG_PRT 0x00
+#define UBX_ID_CFG_MSG 0x01
+#define UBX_ID_CFG_INF 0x02
+#define UBX_ID_CFG_RATE 0x08
+
+/** @brief Message class of the standard NMEA sentences, as used by CFG-MSG. */
+#define UBX_CLASS_NMEA 0xF0
+#define UBX_ID_NMEA_GGA 0x00
+#define UBX_ID_NMEA_GLL 0x01
+#define UBX_ID_NMEA_GSA 0x02
+#define UBX_ID_NMEA_GSV 0x03
+#define UBX_ID_NMEA_RMC 0x04
+#define UBX_ID_NMEA_VTG 0x05
+
+/** @brief Framing overhead (sync, class, id, length and checksum) added to every payload. */
+#define UBX_FRAME_OVERHEAD 8
+
+/** @brief Length of the NAV-PVT payload in bytes. */
+#define UBX_NAV_PVT_LEN 92
+
+/** @brief Length of the NAV-CLK payload in bytes. */
+#define UBX_NAV_CLK_LEN 20
+
+/** @brief `valid` field bits: UTC date and UTC time of day are valid. */
+#define UBX_NAV_PVT_VALID_DATE 0x01
+#define UBX_NAV_PVT_VALID_TIME 0x02
+
+/** @brief `flags` field bit: the fix is valid (within DOP and accuracy masks). */
+#define UBX_NAV_PVT_FLAGS_FIX_OK 0x01
+
+// DATA STRUCTURES
+
+/** @brief GNSS fix type reported in the NAV-PVT `fix_type` field. */
+typedef enum
+{
+    UBX_FIX_NONE = 0,
+    UBX_FIX_DEAD_RECKONING = 1,
+    UBX_FIX_2D = 2,
+    UBX_FIX_3D = 3,
+    UBX_FIX_GNSS_DEAD_RECKONING = 4,
+    UBX_FIX_TIME_ONLY = 5,
+} ubx_fix_type_t;
+
+/** @brief NAV-PVT payload, laid out exactly as it is sent by the receiver (little-endian).
+ * @details Both the RP2350 and the host are little-endian, so the payload is decoded
+ * with a single copy into this packed structure.
+ */
+typedef struct __attribute__((packed))
+{
+    uint32_t itow_ms; /// GPS time of week of the navigation epoch [ms].
+    uint16_t year; /// UTC year.
+    uint8_t month; /// UTC month (1-12).
+    uint8_t day; /// UTC day of month (1-31).
+    uint8_t hour; /// UTC hour (0-23).
+    uint8_t min; /// UTC minute (0-59).
+    uint8_t sec; /// UTC second (0-60).
+    uint8_t valid; /// Validity flags (`UBX_NAV_PVT_VALID_*`).
+    uint32_t time_acc_ns; /// Time accuracy estimate [ns].
+    int32_t nano; /// Fraction of second, range -1e9 .. 1e9 [ns].
+    uint8_t fix_type; /// GNSS fix type (`ubx_fix_type_t`).
+    uint8_t flags; /// Fix status flags (`UBX_NAV_PVT_FLAGS_*`).
+    uint8_t flags2; /// Additional flags.
+    uint8_t num_sv; /// Number of satellites used in the solution.
+    int32_t lon_e7; /// Longitude [1e-7 deg].
+    int32_t lat_e7; /// Latitude [1e-7 deg].
+    int32_t height_mm; /// Height above ellipsoid [mm].
+    int32_t hmsl_mm; /// Height above mean sea level [mm].
+    uint32_t h_acc_mm; /// Horizontal accuracy estimate [mm].
+    uint32_t v_acc_mm; /// Vertical accuracy estimate [mm].
+    int32_t vel_n_mm_s; /// NED north velocity [mm/s].
+    int32_t vel_e_mm_s; /// NED east velocity [mm/s].
+    int32_t vel_d_mm_s; /// NED down velocity [mm/s].
+    int32_t g_speed_mm_s; /// Ground speed (2-D) [mm/s].
+    int32_t head_mot_e5; /// Heading of motion (2-D) [1e-5 deg].
+    uint32_t s_acc_mm_s; /// Speed accuracy estimate [mm/s].
+    uint32_t head_acc_e5; /// Heading accuracy estimate [1e-5 deg].
+    uint16_t pdop_e2; /// Position DOP [0.01].
+    uint8_t flags3; /// Additional flags.
+    uint8_t reserved[5];
+    int32_t head_veh_e5; /// Heading of vehicle (2-D) [1e-5 deg].
+    int16_t mag_dec_e2; /// Magnetic declination [1e-2 deg].
+    uint16_t mag_acc_e2; /// Magnetic declination accuracy [1e-2 deg].
+} ubx_nav_pvt_t;
+
+_Static_assert(sizeof(ubx_nav_pvt_t) == UBX_NAV_PVT_LEN, "NAV-PVT layout must match the 92-byte payload");
+
+/** @brief NAV-CLK payload (little-endian). */
+typedef struct __attribute__((packed))
+{
+    uint32_t itow_ms; /// GPS time of week of the navigation epoch [ms].
+    int32_t clk_b_ns; /// Clock bias [ns].
+    int32_t clk_d_ns_s; /// Clock drift [ns/s].
+    uint32_t t_acc_ns; /// Time accuracy estimate [ns].
+    uint32_t f_acc_ps_s; /// Frequency accuracy estimate [ps/s].
+} ubx_nav_clk_t;
+
+_Static_assert(sizeof(ubx_nav_clk_t) == UBX_NAV_CLK_LEN, "NAV-CLK layout must match the 20-byte payload");
+
+/** @brief MGA-INI-POS_LLH payload: initial position. */
+typedef struct __attribute__((packed))
+{
+    uint8_t type; /// `UBX_MGA_INI_POS_LLH`.
+    uint8_t version; /// 0.
+    uint8_t reserved[2];
+    int32_t lat_e7; /// Latitude [1e-7 deg].
+    int32_t lon_e7; /// Longitude [1e-7 deg].
+    int32_t alt_cm; /// Height above ellipsoid [cm].
+    uint32_t pos_acc_cm; /// Position accuracy, standard deviation [cm].
+} ubx_mga_ini_pos_llh_t;
+
+/** @brief MGA-INI-TIME_UTC payload: initial UTC time. */
+typedef struct __attribute__((packed))
+{
+    uint8_t type; /// `UBX_MGA_INI_TIME_UTC`.
+    uint8_t version; /// 0.
+    uint8_t ref; /// 0: the time is valid on receipt of the message.
+    int8_t leap_secs; /// Leap seconds since 1980 (-128: unknown).
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    uint8_t reserved1;
+    uint32_t ns; /// Fraction of the second [ns].
+    uint16_t t_acc_s; /// Accuracy, whole seconds [s].
+    uint8_t reserved2[2];
+    uint32_t t_acc_ns; /// Accuracy, fraction of a second [ns].
+} ubx_mga_ini_time_utc_t;
+
+/** @brief MGA-INI-CLKD payload: initial clock drift. */
+typedef struct __attribute__((packed))
+{
+    uint8_t type; /// `UBX_MGA_INI_CLKD`.
+    uint8_t version; /// 0.
+    uint8_t reserved[2];
+    int32_t clk_d_ns_s; /// Clock drift [ns/s].
+    uint32_t clk_d_acc_ns_s; /// Clock drift accuracy [ns/s].
+} ubx_mga_ini_clkd_t;
+
+_Static_assert(sizeof(ubx_mga_ini_pos_llh_t) == 20 && sizeof(ubx_mga_ini_time_utc_t) == 24 &&
+               sizeof(ubx_mga_ini_clkd_t) == 12, "MGA-INI layouts must match their payloads");
+
+/** @brief State of the byte-by-byte UBX frame parser.
+ * @details After `ubx_parser_feed()` returns true, `msg_class`, `msg_id`, `length`
+ * and `payload` describe the frame that has just been completed.
+ */
+typedef struct
+{
+    uint8_t state; /// Position within the frame (internal).
+    uint8_t msg_class; /// Class of the current/last frame.
+    uint8_t msg_id; /// ID of the current/last frame.
+    uint16_t length; /// Payload length of the current/last frame.
+    uint16_t index; /// Number of payload bytes received so far (internal).
+    uint8_t ck_a; /// Running Fletcher checksum, first byte (internal).
+    uint8_t ck_b; /// Running Fletcher checksum, second byte (internal).
+    uint32_t checksum_errors; /// Number of frames dropped because of a checksum mismatch.
+    uint32_t length_errors; /// Number of frames dropped because their length exceeds `UBX_MAX_PAYLOAD`.
+    uint8_t payload[UBX_MAX_PAYLOAD]; /// Payload of the current/last frame.
+} ubx_parser_t;
+
+// FUNCTIONS
+
+/** @brief Resets the parser to wait for the next frame start.
+ ** @param[out] parser Parser state to reset. Error counters are cleared as well.
+ */
+extern void ubx_parser_init(ubx_parser_t *parser);
+
+/** @brief Feeds one received byte into the frame parser.
+ * @details Bytes that do not belong to a UBX frame (e.g. interleaved NMEA text) are skipped
+ * while the parser hunts for the sync characters. Frames with a bad checksum are dropped. A
+ * length field over `UBX_MAX_PAYLOAD` sends the parser back to the sync hunt at once, so a
+ * corrupted length byte costs a few bytes instead of up to 64 KiB of the stream.
+ ** @param[in,out] parser Parser state.
+ ** @param[in] byte The received byte.
+ ** @return true if this byte completed a valid frame.
+ ** @return false otherwise.
+ */
+extern bool ubx_parser_feed(ubx_parser_t *parser, uint8_t byte);
+
+/** @brief Computes the UBX Fletcher checksum over a buffer.
+ ** @param[in] data Bytes to sum (class, id, length and payload of a frame).
+ ** @param[in] len Number of bytes.
+ ** @param[out] ck_a First checksum byte.
+ ** @param[out] ck_b Second checksum byte.
+ */
+extern void ubx_checksum(const uint8_t *data, uint16_t len, uint8_t *ck_a, uint8_t *ck_b);
+
+/** @brief Builds a complete UBX frame (sync characters, header, payload and checksum).
+ ** @param[out] out Buffer receiving the frame, at least `len + UBX_FRAME_OVERHEAD` bytes long.
+ ** @param[in] msg_class Message class.
+ ** @param[in] msg_id Message ID.
+ ** @param[in] payload Payload bytes (may be NULL when `len` is 0).
+ ** @param[in] len Payload length.
+ ** @return Total number of bytes written to `out`.
+ */
+extern uint16_t ubx_build_frame(uint8_t *out, uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len);
+
+/** @brief Decodes the last completed frame as NAV-PVT.
+ ** @param[in] parser Parser that has just returned true from `ubx_parser_feed()`.
+ ** @param[out] pvt Structure receiving the decoded message.
+ ** @return true if the frame is a NAV-PVT message of the expected length.
+ ** @return false otherwise.
+ */
+extern bool ubx_decode_nav_pvt(const ubx_parser_t *parser, ubx_nav_pvt_t *pvt);
+
+/** @brief Decodes the last completed frame as NAV-CLK.
+ ** @param[in] parser Parser that has just returned true from `ubx_parser_feed()`.
+ ** @param[out] clk Structure receiving the decoded message.
+ ** @return true if the frame is a NAV-CLK message of the expected length.
+ ** @return false otherwise.
+ */
+extern bool ubx_decode_nav_clk(const ubx_parser_t *parser, ubx_nav_clk_t *clk);
+
+#endif // UBX_PROTOCOL_H
@@ -0,0 +1,83 @@
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "warm_restart.h"
+#include "crc32.h"
+
+#define WARM_MAGIC 0x57524D31u // "WRM1"
+
+// A last feed later than this after the last tick means the feed time is not trusted [us].
+#define FEED_AGE_MAX_US (60ULL * 1000000ULL)
+
+/** @brief State block kept across a watchdog reset. */
+typedef struct
+{
+    uint32_t magic;
+    warm_state_t state;
+    uint64_t tick_us; /// Monotonic time of the tick the state was saved at.
+    uint32_t crc; /// CRC-32 of the fields above.
+} retained_t;
+
+// Not cleared by the C runtime: both survive a watchdog reset. The feed time is written every
+// loop iteration and stays out of the CRC; it is only checked for range.
+static retained_t __uninitialized_ram(retained);
+static uint64_t __uninitialized_ram(fed_us);
+
+static uint32_t retained_crc(void)
+{
+    return crc32_compute(&retained, offsetof(retained_t, crc));
+}
+
+bool warm_restart_begin(warm_state_t *state)
+{
+    bool warm = watchdog_enable_caused_reboot() &&
+                retained.magic == WARM_MAGIC &&
+                retained.crc == retained_crc();
+
+    // Whatever happens next, a stale block must not be taken for this run's.
+    retained.magic = 0;
+
+    if (warm)
+    {
+        *state = retained.state;
+        state->restarts++;
+    }
+
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    return warm;
+}
+
+void warm_restart_feed(void)
+{
+    watchdog_update();
+    fed_us = time_us_64();
+}
+
+void warm_restart_save(warm_state_t *state)
+{
+    time_snapshot_t snap;
+    time_manager_snapshot(&snap);
+
+    state->calendar = snap.calendar;
+    state->time_synced = time_manager_synced();
+
+    memset(&retained, 0, sizeof(retained));
+    retained.magic = WARM_MAGIC;
+    retained.state = *state;
+    retained.tick_us = snap.mono_us - snap.sub_us;
+    retained.crc = retained_crc();
+}
+
+void warm_restart_resume_time(const warm_state_t *state)
+{
+    uint64_t before_reset_us = 0;
+
+    if (fed_us >= retained.tick_us && fed_us - retained.tick_us <= FEED_AGE_MAX_US)
+    {
+        before_reset_us = fed_us - retained.tick_us;
+    }
+
+    // The timer restarts from 0 with the reset.
+    time_manager_resume(&state->calendar, before_reset_us + WATCHDOG_TIMEOUT_MS * 1000ULL + time_us_64(), state->time_synced);
+}
@@ -0,0 +1,74 @@
+/** @file warm_restart.h
+ ** @brief Hardware watchdog and the state that lets the firmware carry on after it fires.
+ * @details The main loop feeds the watchdog every iteration (`warm_restart_feed()`); a loop
+ * that hangs for `WATCHDOG_TIMEOUT_MS` resets the Pico. RAM keeps its contents through that
+ * reset, so at every second tick the loop stores what it needs to carry on
+ * (`warm_restart_save()`) in a block that the C runtime does not clear at boot, checked by a
+ * magic number and a CRC-32.
+ *
+ * At boot `warm_restart_begin()` tells a watchdog reset with a valid block (warm restart)
+ * from a power-on or a manual reset (cold boot). On a warm restart `main()` skips the
+ * cold-boot path: no wait for the USB console, the sensors and the GNSS receiver keep their
+ * configuration and only the Pico's side of the links is set up again, the calendar carries on
+ * from the saved one (`warm_restart_resume_time()`), the periodic logs keep their phase, the
+ * flight phase detector carries on where it was and the configuration stays the one the run
+ * booted with, whatever block was stored since (flash_config.h).
+ * The first record follows within milliseconds of the reset.
+ */
+
+#ifndef WARM_RESTART_H
+#define WARM_RESTART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "time_manager.h"
+#include "flight_phase.h"
+#include "flash_config.h"
+
+// CONFIGURATION MACROS
+
+/** @brief Time without a feed after which the watchdog resets the Pico [ms].
+ * @details Well above a normal loop iteration, which includes the 500 ms sensor settling
+ * wait and the card writes; the GNSS set-up feeds it inside its own waits.
+ */
+#define WATCHDOG_TIMEOUT_MS 3000
+
+// DATA STRUCTURES
+
+/** @brief What the main loop carries across a watchdog reset. */
+typedef struct
+{
+    uint32_t restarts; /// Warm restarts since the last cold boot.
+    current_time_t calendar; /// Calendar at the last tick (filled by `warm_restart_save()`).
+    bool time_synced; /// The calendar follows the GPS (filled by `warm_restart_save()`).
+    uint32_t gps_baud; /// Baud rate of the configured GNSS link (0: not configured yet).
+    uint32_t sd_latency_log_countdown; /// Ticks to the next SD latency log.
+    uint32_t housekeeping_countdown; /// Ticks to the next housekeeping log.
+    flight_state_t flight; /// Flight phase detector.
+    flash_config_t config; /// Configuration the run booted with, kept until the next cold boot.
+} warm_state_t;
+
+// FUNCTIONS
+
+/** @brief Starts the watchdog and reports how the Pico came out of reset.
+ ** @param[out] state Saved state on a warm restart, with `restarts` counted; untouched otherwise.
+ ** @return true for a warm restart, false for a cold boot.
+ */
+extern bool warm_restart_begin(warm_state_t *state);
+
+/** @brief Feeds the watchdog; call once per main loop iteration and in long bounded waits. */
+extern void warm_restart_feed(void);
+
+/** @brief Stores the state, with the calendar and time of the current tick.
+ ** @param[in,out] state State to keep; its `calendar` and `time_synced` are updated.
+ */
+extern void warm_restart_save(warm_state_t *state);
+
+/** @brief Carries the calendar on from the saved state, counting the time lost to the reset.
+ * @details The time from the last tick to the reset is taken from the last feed plus the
+ * watchdog timeout. Call after `time_manager_init()`.
+ ** @param[in] state State returned by `warm_restart_begin()`.
+ */
+extern void warm_restart_resume_time(const warm_state_t *state);
+
+#endif // WARM_RESTART_H
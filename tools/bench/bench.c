@@ -0,0 +1,202 @@
+/** @file bench.c
+ ** @brief Host microbenchmarks of the firmware's per-sample kernels.
+ * @details Every kernel is the firmware's own code, compiled for the host: the BMP280
+ * driver on top of a register-file HAL, the conversions from `sensor_conversion.h`,
+ * lib/minmea, `time_manager.c` on the simulated clock, and the SD record formats.
+ * Each kernel is run `REPEATS` times for `ITERATIONS` calls over a table of realistic
+ * inputs, and the median time per call is reported together with the fastest and
+ * slowest repeat. Record a baseline before a performance change and compare against it.
+ *
+ * Build with the host tools project and run `bench` (optionally with a substring of
+ * the kernel names to run only some of them).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "atm_sen_module.h"
+#include "bmp280_i2c.h"
+#include "bmp280_host.h"
+#include "gps_module.h"
+#include "minmea.h"
+#include "sensor_conversion.h"
+#include "time_manager.h"
+
+#define REPEATS 11
+#define ITERATIONS 200000
+
+/** @brief Size of every input table (a power of two, indexed with `i & INPUT_MASK`). */
+#define INPUTS 256
+#define INPUT_MASK (INPUTS - 1)
+
+// Calibration words dig_T1..dig_P9 from the BMP280 datasheet, section 3.12.
+static const uint16_t bmp280_calib[12] = {
+    27504, 26435, (uint16_t)-1000, 36477, (uint16_t)-10685, 3024,
+    2855, 140, (uint16_t)-7, 15500, (uint16_t)-14600, 6000,
+};
+
+static const char *rmc_sentences[] = {
+    "$GNRMC,092751.000,A,5321.6802,N,00630.3371,W,0.06,31.66,280511,,,A*45",
+    "$GPRMC,123205.00,A,5106.94085,N,01701.51689,E,0.016,,280214,,,A*7B",
+};
+
+static const char *gga_sentences[] = {
+    "$GNGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.2,M,,*76",
+    "$GPGGA,123204.00,5106.94086,N,01701.51680,E,1,06,3.86,127.9,M,40.5,M,,*51",
+};
+
+static double pressures[INPUTS];
+static uint16_t shtc3_raw[INPUTS];
+static struct minmea_float coords[INPUTS];
+static sensor_readings_t readings[INPUTS];
+static gps_data_t fixes[INPUTS];
+
+static volatile double sink_d;
+static volatile int sink_i;
+
+static const char *filter;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *samples)
+{
+    qsort(samples, REPEATS, sizeof(double), compare_double);
+    printf("%-32s %10.1f %10.1f %10.1f\n", name, samples[REPEATS / 2], samples[0], samples[REPEATS - 1]);
+}
+
+/** @brief Times `body` (which may use the loop index `i`) and prints ns per call. */
+#define BENCH(name, body) \
+    do \
+    { \
+        if (filter && !strstr(name, filter)) break; \
+        double samples[REPEATS]; \
+        for (int i = 0; i < ITERATIONS / 10; i++) { body; } \
+        for (int r = 0; r < REPEATS; r++) \
+        { \
+            double start = now_ns(); \
+            for (int i = 0; i < ITERATIONS; i++) { body; } \
+            samples[r] = (now_ns() - start) / ITERATIONS; \
+        } \
+        report(name, samples); \
+    } while (0)
+
+static void prepare_inputs(void)
+{
+    bmp280_host_load_calib(bmp280_calib);
+    bmp280_host_set_raw(415148, 519888);
+    bmp280_i2c_set_calib();
+
+    for (int i = 0; i < INPUTS; i++)
+    {
+        // Ground level up to roughly 3 km, the flight envelope.
+        pressures[i] = 101325.0 - i * (101325.0 - 70000.0) / INPUTS;
+        shtc3_raw[i] = (uint16_t)(20000 + i * 97);
+
+        struct minmea_sentence_rmc rmc;
+        minmea_parse_rmc(&rmc, rmc_sentences[i & 1]);
+        coords[i] = (i & 2) ? rmc.longitude : rmc.latitude;
+        coords[i].value += i;
+
+        readings[i] = (sensor_readings_t){
+            .pressure_pa = pressures[i], .altitude_m = pressure_to_altitude(pressures[i]),
+            .temperature_c = shtc3_raw_to_celsius(shtc3_raw[i]), .humidity_pct = 41.7f,
+            .methane_ppm = 12.5f, .ammonia_ppm = 3.25f, .oxygen_pct = 20.9f,
+            .pressure_us = 1000000ULL * i + 123456, .temperature_us = 1000000ULL * i + 103456,
+            .methane_us = 1000000ULL * i + 104000, .ammonia_us = 1000000ULL * i + 104100,
+            .oxygen_us = 1000000ULL * i + 130000,
+        };
+
+        fixes[i] = (gps_data_t){
+            .latitude_e7 = 535280033 + i * 17, .longitude_e7 = -65056183 - i * 23,
+            .altitude = 61.7f + i, .satellites = 8, .hour = 9, .min = 27, .sec = 51,
+            .microsec = 200000, .year = 2026, .month = 5, .day = 28, .fix = true,
+            .timestamp_us = 1000000ULL * i + 4200,
+        };
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) filter = argv[1];
+
+    prepare_inputs();
+    time_manager_init();
+
+    char line[256];
+
+    printf("%-32s %10s %10s %10s\n", "kernel", "median ns", "min ns", "max ns");
+
+    // atm_sen_module
+    BENCH("bmp280_i2c_read_data", {
+        bmp280_data_t dt;
+        sink_i += bmp280_i2c_read_data(&dt);
+        sink_i += dt.pressure;
+    });
+    BENCH("pressure_to_altitude (powf)", sink_d += pressure_to_altitude(pressures[i & INPUT_MASK]));
+    BENCH("shtc3_raw_to_celsius+humidity", {
+        uint16_t raw = shtc3_raw[i & INPUT_MASK];
+        sink_d += shtc3_raw_to_celsius(raw) + shtc3_raw_to_humidity(raw ^ 0x5555);
+    });
+    BENCH("adc_raw_to_ppm", sink_d += adc_raw_to_ppm((uint16_t)(i & 0xFFF), 100.0f));
+
+    // gps_module (NMEA path)
+    BENCH("minmea_check (RMC)", sink_i += minmea_check(rmc_sentences[i & 1], true));
+    BENCH("minmea_parse_rmc", {
+        struct minmea_sentence_rmc rmc;
+        sink_i += minmea_parse_rmc(&rmc, rmc_sentences[i & 1]);
+    });
+    BENCH("minmea_parse_gga", {
+        struct minmea_sentence_gga gga;
+        sink_i += minmea_parse_gga(&gga, gga_sentences[i & 1]);
+    });
+    BENCH("minmea_tocoord", sink_d += minmea_tocoord(&coords[i & INPUT_MASK]));
+    BENCH("minmea_tocoord_e7", sink_i += minmea_tocoord_e7(&coords[i & INPUT_MASK]));
+
+    // time_manager: the calendar ticks once per simulated second.
+    BENCH("time_manager_update (tick)", {
+        host_time_us += 1000000;
+        sink_i += time_manager_update();
+    });
+    BENCH("time_manager_get", {
+        current_time_t t;
+        time_manager_get(&t);
+        sink_i += t.sec;
+    });
+    BENCH("gmtime_r (previous get)", {
+        time_t epoch = 1767225600 + i;
+        struct tm tm;
+        gmtime_r(&epoch, &tm);
+        sink_i += tm.tm_sec;
+    });
+
+    // microsd_module record formats
+    BENCH("snprintf data_log BMP280 line", {
+        const sensor_readings_t *d = &readings[i & INPUT_MASK];
+        sink_i += snprintf(line, sizeof(line), "[%02d:%02d:%02d] [BMP280] t=" TIME_US_FMT " s | Pressure: %.2f Pa | Altitude: %.2f m\n",
+                           9, 27, 51, TIME_US_ARGS(d->pressure_us), d->pressure_pa, d->altitude_m);
+    });
+    BENCH("snprintf gps_log row", {
+        const gps_data_t *g = &fixes[i & INPUT_MASK];
+        sink_i += snprintf(line, sizeof(line), TIME_US_FMT ",%02d:%02d:%02d.%06lu," GPS_E7_FMT "," GPS_E7_FMT ",%.2f,%d,%d\n",
+                           TIME_US_ARGS(g->timestamp_us), g->hour, g->min, g->sec, (unsigned long)g->microsec,
+                           GPS_E7_ARGS(g->latitude_e7), GPS_E7_ARGS(g->longitude_e7), g->altitude,
+                           g->satellites, g->fix ? 1 : 0);
+    });
+
+    return EXIT_SUCCESS;
+}
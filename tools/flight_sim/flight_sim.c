@@ -0,0 +1,385 @@
+/** @file flight_sim.c
+ ** @brief Host tool: flies the firmware's acquisition pipeline through a simulated flight and
+ * finds the sampling rate at which it saturates.
+ * @details The flight profile generator (tools/sim/sim_flight.h) drives the device models at
+ * 1 kHz from the pad to the landing. For each pipeline
+ * - `baro`: `bmp280_read()` only (the apogee detection path),
+ * - `sensors`: `read_all()` (every sensor, as the flight loop does once per second),
+ * and each requested rate, the pipeline is scheduled at that rate together with
+ * `gps_update()` and the tool reports the achieved rate, the slots skipped by overrunning cycles,
+ * the time one cycle takes, the altitude error of the barometer against the true trajectory
+ * (reading age and the BMP280 measurement period included) and the GPS fixes and receive
+ * losses. A pipeline saturates at the first rate it cannot sustain (below 95 % achieved).
+ *
+ * The `firmware` sweep then flies the whole of src/main.c (`firmware_main`) through the same
+ * profile, from boot to past the landing, once as flown and then with the barometer rate of
+ * every flight phase raised to each of `firmware_baro_hz` and a record every 1 Hz tick in every
+ * phase (the tick bounds the record rate). Each run reports the 1 Hz ticks handled later than
+ * `HOUSEKEEPING_TICK_DEADLINE_US` and the latest one, and the flash log (flash_log.h): its
+ * largest backlog after the copy of a tick, the backlog at the end, and records overwritten
+ * before they reached the card. The rates are imposed by wrapping `flight_profile()` at link
+ * time, and the firmware keeps its state in static variables, so each run is a process of its own.
+ *
+ * Usage:
+ * - `flight_sim [seed]`: saturation sweeps,
+ * - `flight_sim profile [hz]`: prints the flight profile as CSV (default 10 Hz) without
+ *   running the firmware.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "atm_sen_module.h"
+#include "flash_log.h"
+#include "flight_phase.h"
+#include "gps_module.h"
+#include "housekeeping.h"
+#include "sim.h"
+#include "sim_flight.h"
+
+/** @brief Time simulated after the landing [s]. */
+#define AFTER_LANDING_S 5
+
+/** @brief Share of the requested rate below which a pipeline counts as saturated. */
+#define SATURATION_RATIO 0.95
+
+/** @brief Simulated time of each firmware run from boot, past the landing [s]. */
+#define FIRMWARE_RUN_S 180
+
+typedef enum
+{
+    PIPELINE_BARO = 0,
+    PIPELINE_SENSORS,
+    PIPELINE_COUNT
+} pipeline_t;
+
+static const char *const pipeline_names[PIPELINE_COUNT] = {"baro", "sensors"};
+
+static const uint32_t rates_hz[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+#define RATE_COUNT (sizeof(rates_hz) / sizeof(rates_hz[0]))
+
+/** @brief Barometer rates of the firmware sweep, after the run as flown (0) [Hz]. */
+static const uint32_t firmware_baro_hz[] = {0, 50, 100, 200, 500, 1000};
+
+#define FIRMWARE_RUN_COUNT (sizeof(firmware_baro_hz) / sizeof(firmware_baro_hz[0]))
+
+typedef struct
+{
+    uint32_t cycles;
+    uint32_t missed; /// Slots skipped because the previous cycle overran them.
+    double flight_s;
+    uint64_t busy_us;
+    uint64_t max_cycle_us;
+    double alt_err_sq; /// Sum of squared barometric altitude errors [m^2].
+    double alt_err_max;
+    uint32_t alt_samples;
+    double apogee_err; /// Highest barometric altitude minus the true apogee [m].
+    uint32_t fixes;
+    uint32_t gps_lost; /// Overruns plus bytes dropped by the receive ring.
+} run_result_t;
+
+/** @brief Figures of one firmware run, written by its process. */
+typedef struct
+{
+    bool done; /// The process ran to the end.
+    uint32_t deadline_misses;
+    uint32_t worst_lateness_us;
+    uint32_t records; /// Records appended to the flash log, all types.
+    uint32_t baro_records;
+    uint32_t backlog_max; /// Most records in flash not yet on the card, after the copy of a tick.
+    uint32_t backlog_end;
+    uint32_t overwritten; /// Records lost to the ring before they reached the card.
+} firmware_result_t;
+
+// Barometer period imposed on every flight phase by `__wrap_flight_profile()` (0: as flown).
+static uint32_t forced_baro_period_ms = 0;
+static flight_profile_t forced_profile;
+
+static uint32_t backlog_max = 0;
+
+/** @brief src/main.c, built with `main` renamed. */
+extern int firmware_main(void);
+
+extern const flight_profile_t *__real_flight_profile(void);
+extern void __real_flash_log_service(void);
+
+// Linked with --wrap=flight_profile: the profile of the current phase, at the rates of the sweep.
+const flight_profile_t *__wrap_flight_profile(void)
+{
+    const flight_profile_t *profile = __real_flight_profile();
+
+    if (forced_baro_period_ms == 0) return profile;
+
+    forced_profile = *profile;
+    if (forced_profile.baro_period_ms > forced_baro_period_ms) forced_profile.baro_period_ms = forced_baro_period_ms;
+    forced_profile.record_period_s = 1;
+    return &forced_profile;
+}
+
+// Linked with --wrap=flash_log_service: main.c calls it once per tick, after the copy to the card.
+void __wrap_flash_log_service(void)
+{
+    flash_log_stats_t stats;
+
+    __real_flash_log_service();
+    flash_log_get_stats(&stats);
+    if (stats.pending > backlog_max) backlog_max = stats.pending;
+}
+
+static void run(pipeline_t pipeline, uint32_t rate_hz, uint64_t seed, run_result_t *r)
+{
+    const sim_flight_state_t *flight = sim_flight_state();
+    gps_stats_t gps_before, gps_after;
+    uint64_t period_us = 1000000 / rate_hz;
+    double highest = 0;
+    uint64_t last_fix_us = 0;
+
+    memset(r, 0, sizeof(*r));
+    sim_init(seed);
+    gps_get_stats(&gps_before);
+    gps_init();
+    while (!gps_configure_step()) sleep_ms(1);
+    init_all_sensors();
+    sim_flight_start(&sim_flight_default);
+
+    uint64_t start_us = host_time_us;
+    uint64_t slot_us = start_us;
+    uint64_t landed_us = 0;
+
+    while (landed_us == 0 || host_time_us < landed_us + AFTER_LANDING_S * 1000000ULL)
+    {
+        if (host_time_us < slot_us) sleep_us(slot_us - host_time_us);
+
+        uint64_t cycle_start = host_time_us;
+
+        if (gps_update())
+        {
+            gps_data_t gps;
+            gps_get_data(&gps);
+            if (gps.fix && gps.timestamp_us != last_fix_us)
+            {
+                r->fixes++;
+                last_fix_us = gps.timestamp_us;
+            }
+        }
+
+        double pressure, altitude = -1;
+        uint64_t sample_us;
+
+        if (pipeline == PIPELINE_BARO)
+        {
+            bmp280_read(&pressure, &altitude, &sample_us);
+        }
+        else
+        {
+            sensor_readings_t readings;
+            read_all(&readings);
+            altitude = readings.altitude_m;
+        }
+
+        if (altitude != -1)
+        {
+            // The truth at the end of the read: what the reading is used as.
+            double err = altitude - sim_env.altitude_m;
+
+            r->alt_err_sq += err * err;
+            r->alt_err_max = fmax(r->alt_err_max, fabs(err));
+            r->alt_samples++;
+            highest = fmax(highest, altitude);
+        }
+
+        uint64_t cycle_us = host_time_us - cycle_start;
+        r->busy_us += cycle_us;
+        if (cycle_us > r->max_cycle_us) r->max_cycle_us = cycle_us;
+        r->cycles++;
+
+        // A cycle that overran its slot is followed immediately; missed slots are skipped.
+        slot_us += period_us;
+        if (host_time_us > slot_us)
+        {
+            uint64_t skipped = (host_time_us - slot_us) / period_us;
+            r->missed += (uint32_t)skipped;
+            slot_us += skipped * period_us;
+        }
+
+        if (landed_us == 0 && flight->phase == SIM_FLIGHT_LANDED) landed_us = host_time_us;
+    }
+
+    gps_get_stats(&gps_after);
+    r->flight_s = (host_time_us - start_us) / 1e6;
+    r->apogee_err = highest - (sim_flight_default.ground_altitude_m + flight->apogee_m);
+    r->gps_lost = (gps_after.uart_overruns - gps_before.uart_overruns) + (gps_after.rx_dropped - gps_before.rx_dropped);
+}
+
+static void sweep(uint64_t seed)
+{
+    for (int p = 0; p < PIPELINE_COUNT; p++)
+    {
+        uint32_t saturated_hz = 0;
+        double saturated_achieved = 0;
+
+        printf("== %s\n", pipeline_names[p]);
+        printf("  %8s %9s %6s %10s %10s %9s %9s %9s %6s %6s\n",
+               "req Hz", "achieved", "missed", "cycle ms", "max ms", "alt rms", "alt max", "apogee", "fixes", "lost");
+
+        for (size_t i = 0; i < RATE_COUNT; i++)
+        {
+            run_result_t r;
+            run((pipeline_t)p, rates_hz[i], seed, &r);
+
+            double achieved = r.cycles / r.flight_s;
+            double rms = r.alt_samples ? sqrt(r.alt_err_sq / r.alt_samples) : 0;
+
+            printf("  %8u %9.1f %6u %10.3f %10.3f %9.2f %9.2f %+9.2f %6u %6u\n",
+                   rates_hz[i], achieved, r.missed, r.busy_us / 1000.0 / r.cycles, r.max_cycle_us / 1000.0,
+                   rms, r.alt_err_max, r.apogee_err, r.fixes, r.gps_lost);
+
+            if (!saturated_hz && achieved < SATURATION_RATIO * rates_hz[i])
+            {
+                saturated_hz = rates_hz[i];
+                saturated_achieved = achieved;
+            }
+        }
+
+        if (saturated_hz) printf("  saturates at %u Hz (%.1f Hz achieved)\n\n", saturated_hz, saturated_achieved);
+        else printf("  sustains every rate up to %u Hz\n\n", rates_hz[RATE_COUNT - 1]);
+    }
+}
+
+static void run_firmware(void)
+{
+    firmware_main();
+}
+
+/** @brief Flies the firmware once (in its own process) and fills its figures. */
+static void run_firmware_instance(uint32_t baro_hz, uint64_t seed, firmware_result_t *r)
+{
+    sim_init(seed);
+    sim_flight_start(&sim_flight_default);
+    forced_baro_period_ms = baro_hz ? (1000 + baro_hz - 1) / baro_hz : 0;
+
+    sim_run_until(run_firmware, FIRMWARE_RUN_S * 1000000ULL);
+
+    housekeeping_t hk;
+    flash_log_stats_t log;
+
+    housekeeping_collect(&hk);
+    flash_log_get_stats(&log);
+
+    r->deadline_misses = hk.deadline_misses;
+    r->worst_lateness_us = hk.worst_lateness_us;
+    for (int t = 0; t < FLASH_LOG_TYPE_COUNT; t++)
+    {
+        r->records += log.appended[t];
+        r->overwritten += log.overwritten[t];
+    }
+    r->baro_records = log.appended[FLASH_LOG_BARO];
+    r->backlog_max = backlog_max;
+    r->backlog_end = log.pending;
+    r->done = true;
+}
+
+static void firmware_sweep(uint64_t seed)
+{
+    firmware_result_t *results = mmap(NULL, sizeof(firmware_result_t) * FIRMWARE_RUN_COUNT,
+                                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results == MAP_FAILED)
+    {
+        perror("mmap");
+        return;
+    }
+    memset(results, 0, sizeof(firmware_result_t) * FIRMWARE_RUN_COUNT);
+
+    printf("== firmware (%d s from boot, record every tick when raised)\n", FIRMWARE_RUN_S);
+    printf("  %8s %7s %9s %8s %8s %8s %8s %8s\n",
+           "baro Hz", "misses", "worst ms", "records", "baro", "backlog", "at end", "lost");
+
+    for (size_t i = 0; i < FIRMWARE_RUN_COUNT; i++)
+    {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            run_firmware_instance(firmware_baro_hz[i], seed, &results[i]);
+            _exit(EXIT_SUCCESS);
+        }
+        if (pid < 0)
+        {
+            perror("fork");
+            break;
+        }
+        waitpid(pid, NULL, 0);
+
+        const firmware_result_t *r = &results[i];
+        char rate[16];
+
+        if (firmware_baro_hz[i]) snprintf(rate, sizeof(rate), "%u", firmware_baro_hz[i]);
+        else snprintf(rate, sizeof(rate), "flown");
+
+        if (!r->done)
+        {
+            printf("  %8s did not complete\n", rate);
+            continue;
+        }
+        printf("  %8s %7u %9.1f %8u %8u %8u %8u %8u\n",
+               rate, r->deadline_misses, r->worst_lateness_us / 1000.0, r->records, r->baro_records,
+               r->backlog_max, r->backlog_end, r->overwritten);
+    }
+    printf("\n");
+    munmap(results, sizeof(firmware_result_t) * FIRMWARE_RUN_COUNT);
+}
+
+static void profile(uint32_t hz)
+{
+    const sim_flight_state_t *s = sim_flight_state();
+    uint64_t period_us = 1000000 / hz;
+
+    sim_init(1);
+    sim_flight_start(&sim_flight_default);
+
+    printf("t_s,phase,height_m,vertical_speed_mps,pressure_pa,temperature_c,humidity_pct,"
+           "methane_ppm,ammonia_ppm,latitude_deg,longitude_deg,ground_speed_mps\n");
+
+    uint64_t landed_us = 0;
+    while (landed_us == 0 || host_time_us < landed_us + AFTER_LANDING_S * 1000000ULL)
+    {
+        printf("%.3f,%s,%.2f,%.2f,%.1f,%.2f,%.2f,%.2f,%.2f,%.7f,%.7f,%.2f\n",
+               s->t_s, sim_flight_phase_names[s->phase], s->height_m, s->vertical_speed_mps,
+               sim_env.pressure_pa, sim_env.temperature_c, sim_env.humidity_pct,
+               sim_env.methane_ppm, sim_env.ammonia_ppm, sim_env.latitude_deg, sim_env.longitude_deg,
+               sim_env.ground_speed_mps);
+
+        if (landed_us == 0 && s->phase == SIM_FLIGHT_LANDED) landed_us = host_time_us;
+        sleep_us(period_us);
+    }
+
+    fprintf(stderr, "apogee %.1f m above ground at %.1f s, landed at %.1f s, drift %.0f m\n",
+            s->apogee_m, s->apogee_t_s, s->t_s, hypot(s->east_m, s->north_m));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "profile") == 0)
+    {
+        long hz = (argc > 2) ? atol(argv[2]) : 10;
+        if (hz <= 0 || hz > SIM_FLIGHT_MAX_SAMPLE_HZ)
+        {
+            fprintf(stderr, "%s: profile rate must be 1..%d Hz\n", argv[0], SIM_FLIGHT_MAX_SAMPLE_HZ);
+            return EXIT_FAILURE;
+        }
+        profile((uint32_t)hz);
+        return EXIT_SUCCESS;
+    }
+
+    uint64_t seed = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1;
+
+    sweep(seed);
+    firmware_sweep(seed);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+/** @file bmp280_hal_host.c
+ ** @brief Host implementation of the BMP280 driver HAL (lib/bmp280/bmp280_i2c_hal.h).
+ * @details Register reads and writes go to an in-memory register file, `bmp280_host_regs`,
+ * which the host program fills with calibration and raw ADC values. The unmodified
+ * driver (lib/bmp280/bmp280_i2c.c) then runs on top of it.
+ */
+
+#include <string.h>
+#include "bmp280_i2c_hal.h"
+#include "bmp280_host.h"
+
+uint8_t bmp280_host_regs[256];
+
+int16_t bmp280_i2c_hal_init()
+{
+    return BMP280_OK;
+}
+
+int16_t bmp280_i2c_hal_read(uint8_t address, uint8_t *reg, uint8_t *data, uint16_t count)
+{
+    (void)address;
+    if ((size_t)*reg + count > sizeof(bmp280_host_regs)) return BMP280_ERR;
+
+    memcpy(data, &bmp280_host_regs[*reg], count);
+    return BMP280_OK;
+}
+
+int16_t bmp280_i2c_hal_write(uint8_t address, uint8_t *data, uint16_t count)
+{
+    (void)address;
+    if (count < 1 || (size_t)data[0] + count - 1 > sizeof(bmp280_host_regs)) return BMP280_ERR;
+
+    memcpy(&bmp280_host_regs[data[0]], &data[1], count - 1);
+    return BMP280_OK;
+}
+
+void bmp280_i2c_hal_ms_delay(uint32_t ms)
+{
+    (void)ms;
+}
+
+void bmp280_host_load_calib(const uint16_t calib[12])
+{
+    for (int i = 0; i < 12; i++)
+    {
+        bmp280_host_regs[0x88 + 2 * i] = (uint8_t)(calib[i] & 0xFF);
+        bmp280_host_regs[0x89 + 2 * i] = (uint8_t)(calib[i] >> 8);
+    }
+}
+
+void bmp280_host_set_raw(int32_t press_raw, int32_t temp_raw)
+{
+    bmp280_host_regs[0xF7] = (uint8_t)(press_raw >> 12);
+    bmp280_host_regs[0xF8] = (uint8_t)(press_raw >> 4);
+    bmp280_host_regs[0xF9] = (uint8_t)(press_raw << 4);
+    bmp280_host_regs[0xFA] = (uint8_t)(temp_raw >> 12);
+    bmp280_host_regs[0xFB] = (uint8_t)(temp_raw >> 4);
+    bmp280_host_regs[0xFC] = (uint8_t)(temp_raw << 4);
+}
@@ -0,0 +1,19 @@
+/** @file bmp280_host.h
+ ** @brief Register-file backend of the host BMP280 HAL.
+ */
+
+#ifndef BMP280_HOST_H
+#define BMP280_HOST_H
+
+#include <stdint.h>
+
+/** @brief BMP280 register file, indexed by register address. */
+extern uint8_t bmp280_host_regs[256];
+
+/** @brief Writes the 12 calibration words (dig_T1..dig_P9) into registers 0x88..0x9F. */
+extern void bmp280_host_load_calib(const uint16_t calib[12]);
+
+/** @brief Writes 20-bit raw pressure and temperature ADC values into registers 0xF7..0xFC. */
+extern void bmp280_host_set_raw(int32_t press_raw, int32_t temp_raw);
+
+#endif // BMP280_HOST_H
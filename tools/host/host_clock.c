@@ -0,0 +1,9 @@
+/** @file host_clock.c
+ ** @brief Simulated system timer and GPIO levels behind the host `pico/stdlib.h`.
+ */
+
+#include "pico/stdlib.h"
+
+uint64_t host_time_us = 0;
+
+bool host_gpio_level[HOST_GPIO_COUNT];
@@ -0,0 +1,30 @@
+/** @file diskio.h
+ ** @brief Host stand-in for the FatFs `diskio.h` header, backed by tools/sim/sim_sd.c.
+ */
+
+#ifndef HOST_DISKIO_H
+#define HOST_DISKIO_H
+
+#include "ff.h"
+
+typedef BYTE DSTATUS;
+
+typedef enum
+{
+    RES_OK = 0,
+    RES_ERROR,
+    RES_WRPRT,
+    RES_NOTRDY,
+    RES_PARERR,
+} DRESULT;
+
+#define STA_NOINIT 0x01
+#define STA_NODISK 0x02
+#define STA_PROTECT 0x04
+
+DSTATUS disk_initialize(BYTE pdrv);
+DSTATUS disk_status(BYTE pdrv);
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count);
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count);
+
+#endif // HOST_DISKIO_H
@@ -0,0 +1,79 @@
+/** @file ff.h
+ ** @brief Host stand-in for the FatFs `ff.h` header.
+ * @details The integer types used by the firmware's `get_fattime()`, and the file API the
+ * logging code uses, implemented by tools/sim/sim_fatfs.c: files live in memory and every
+ * volume access goes through `disk_read()` / `disk_write()` as FatFs would issue it.
+ */
+
+#ifndef HOST_FF_H
+#define HOST_FF_H
+
+#include <stdint.h>
+
+typedef uint32_t DWORD;
+typedef uint16_t WORD;
+typedef uint8_t BYTE;
+typedef unsigned int UINT;
+typedef uint32_t LBA_t;
+typedef uint32_t FSIZE_t;
+
+typedef enum
+{
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM,
+} FRESULT;
+
+#define FA_READ 0x01
+#define FA_WRITE 0x02
+#define FA_OPEN_EXISTING 0x00
+#define FA_CREATE_NEW 0x04
+#define FA_CREATE_ALWAYS 0x08
+#define FA_OPEN_ALWAYS 0x10
+#define FA_OPEN_APPEND 0x30
+
+/** @brief Volume: mounted or not, and the sector held in its window. */
+typedef struct
+{
+    BYTE fs_type; /// 0: not mounted.
+    BYTE wflag; /// The window holds changes not yet written.
+    BYTE fsi_flag; /// The free cluster count in FSInfo is out of date.
+    LBA_t winsect; /// Sector cached in the window (directory, FAT).
+} FATFS;
+
+/** @brief Open file: its position and the dirty state of its sector buffer. */
+typedef struct
+{
+    FATFS *fs; /// NULL: not open.
+    int file; /// Index of the file in sim_fatfs.c.
+    FSIZE_t fptr;
+    FSIZE_t fsize;
+    BYTE flag;
+    BYTE err; /// Sticky error: once an access fails, every later one does.
+    BYTE dirty; /// The sector buffer holds data not yet written to the card.
+} FIL;
+
+FRESULT f_mount(FATFS *fs, const char *path, BYTE opt);
+FRESULT f_open(FIL *fp, const char *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_sync(FIL *fp);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+int f_printf(FIL *fp, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#define f_size(fp) ((fp)->fsize)
+#define f_tell(fp) ((fp)->fptr)
+
+DWORD get_fattime(void);
+
+#endif // HOST_FF_H
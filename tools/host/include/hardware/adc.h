@@ -0,0 +1,15 @@
+/** @file adc.h
+ ** @brief Host stand-in for the Pico SDK `hardware/adc.h`, backed by tools/sim/sim_adc.c.
+ */
+
+#ifndef HOST_HARDWARE_ADC_H
+#define HOST_HARDWARE_ADC_H
+
+#include "pico/stdlib.h"
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint16_t adc_read(void);
+
+#endif // HOST_HARDWARE_ADC_H
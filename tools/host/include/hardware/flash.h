@@ -0,0 +1,29 @@
+/** @file flash.h
+ ** @brief Host stand-in for the Pico SDK `hardware/flash.h`, backed by tools/sim/sim_flash.c.
+ * @details The QSPI flash is an array of `PICO_FLASH_SIZE_BYTES` that reads through
+ * `XIP_BASE` like the XIP window. Erase and program keep the NOR semantics (erase to 0xFF,
+ * program only clears bits) and take their datasheet time on the simulated clock, during
+ * which nothing else runs.
+ */
+
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+#include "pico/stdlib.h"
+
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (4 * 1024 * 1024)
+#endif
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+
+/** @brief Flash content (defined in sim_flash.c). */
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+#define XIP_BASE ((uintptr_t)host_flash)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif // HOST_HARDWARE_FLASH_H
@@ -0,0 +1,58 @@
+/** @file gpio.h
+ ** @brief Host stand-in for the Pico SDK `hardware/gpio.h`.
+ * @details Pin functions and pulls are ignored; output levels are kept in `host_gpio_level`
+ * so that device models can read them, and inputs read back the same array. With `HOST_SIM`
+ * set, output changes are also passed to the device models (`host_gpio_put()`, tools/sim/sim.c).
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef HOST_SIM
+#define HOST_SIM 0
+#endif
+
+#define HOST_GPIO_COUNT 48
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_function
+{
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_SIO = 5,
+};
+
+/** @brief Level of every pin (defined in host_clock.c). */
+extern bool host_gpio_level[HOST_GPIO_COUNT];
+
+#if HOST_SIM
+/** @brief Sets an output level and tells the models that see the pin. */
+extern void host_gpio_put(unsigned int gpio, bool level);
+#endif
+
+static inline void gpio_init(unsigned int gpio) { (void)gpio; }
+static inline void gpio_set_function(unsigned int gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+static inline void gpio_set_dir(unsigned int gpio, bool out) { (void)gpio; (void)out; }
+static inline void gpio_pull_up(unsigned int gpio) { (void)gpio; }
+
+static inline void gpio_put(unsigned int gpio, bool value)
+{
+#if HOST_SIM
+    host_gpio_put(gpio, value);
+#else
+    host_gpio_level[gpio] = value;
+#endif
+}
+
+static inline bool gpio_get(unsigned int gpio)
+{
+    return host_gpio_level[gpio];
+}
+
+#endif // HOST_HARDWARE_GPIO_H
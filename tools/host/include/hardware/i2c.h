@@ -0,0 +1,28 @@
+/** @file i2c.h
+ ** @brief Host stand-in for the Pico SDK `hardware/i2c.h`.
+ * @details Implemented by the simulated bus in tools/sim/sim_i2c.c: transfers are routed to
+ * the device models attached at their address and take their wire time on the simulated clock.
+ */
+
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+#include "pico/stdlib.h"
+
+typedef struct
+{
+    uint baudrate; /// Set by `i2c_init()`.
+} i2c_inst_t;
+
+extern i2c_inst_t host_i2c[2];
+
+#define i2c0 (&host_i2c[0])
+#define i2c1 (&host_i2c[1])
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
+
+#endif // HOST_HARDWARE_I2C_H
@@ -0,0 +1,19 @@
+/** @file irq.h
+ ** @brief Host stand-in for the Pico SDK `hardware/irq.h`: handlers are run by the device models.
+ */
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+/** @brief Interrupt lines of the RP2350. */
+#define NUM_IRQS 52
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+bool irq_is_enabled(uint num);
+
+#endif // HOST_HARDWARE_IRQ_H
@@ -0,0 +1,24 @@
+/** @file spi.h
+ ** @brief Host stand-in for the Pico SDK `hardware/spi.h`, backed by tools/sim/sim_radio.c.
+ * @details Transfers take their time on the wire at the configured clock. spi0 carries the
+ * radio only; the SD card is modelled at the `disk_*` level (tools/sim/sim_sd.c).
+ */
+
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include "pico/stdlib.h"
+
+typedef struct spi_inst spi_inst_t;
+
+extern spi_inst_t host_spi0, host_spi1;
+
+#define spi0 (&host_spi0)
+#define spi1 (&host_spi1)
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+
+#endif // HOST_HARDWARE_SPI_H
@@ -0,0 +1,13 @@
+/** @file sync.h
+ ** @brief Host stand-in for the Pico SDK `hardware/sync.h`: masks the simulated interrupts.
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+#endif // HOST_HARDWARE_SYNC_H
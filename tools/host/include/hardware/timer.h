@@ -0,0 +1,26 @@
+/** @file timer.h
+ ** @brief Host stand-in for the Pico SDK `hardware/timer.h`: the timer registers read directly.
+ * @details `timer_hw->timerawl` is filled from the simulated clock (`time_us_32()`) on each access.
+ */
+
+#ifndef HOST_HARDWARE_TIMER_H
+#define HOST_HARDWARE_TIMER_H
+
+#include "pico/stdlib.h"
+
+typedef struct
+{
+    uint32_t timerawl; /// Low word of the microsecond counter.
+} timer_hw_t;
+
+static inline timer_hw_t *host_timer_hw(void)
+{
+    static timer_hw_t hw;
+
+    hw.timerawl = time_us_32();
+    return &hw;
+}
+
+#define timer_hw (host_timer_hw())
+
+#endif // HOST_HARDWARE_TIMER_H
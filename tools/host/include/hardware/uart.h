@@ -0,0 +1,53 @@
+/** @file uart.h
+ ** @brief Host stand-in for the Pico SDK `hardware/uart.h`, backed by tools/sim/sim_uart.c.
+ * @details Received bytes arrive at the configured baud rate into a 32-byte FIFO, as on the
+ * PL011. The registers are read through `uart0_hw` / `uart1_hw` (or `uart_get_hw()`), which
+ * here are calls into the model: `uart_get_hw()` pops the next byte (with its error flags)
+ * into `dr`; `uartN_hw` refreshes `fr`, and pops into `dr` on the access that follows one
+ * showing a non-empty FIFO. Both therefore expect the firmware's pattern: check the FIFO,
+ * then read the data register once per byte.
+ */
+
+#ifndef HOST_HARDWARE_UART_H
+#define HOST_HARDWARE_UART_H
+
+#include "pico/stdlib.h"
+
+#define UART_UARTDR_OE_BITS 0x00000800u
+#define UART_UARTDR_BE_BITS 0x00000400u
+#define UART_UARTDR_PE_BITS 0x00000200u
+#define UART_UARTDR_FE_BITS 0x00000100u
+#define UART_UARTFR_RXFE_BITS 0x00000010u
+
+typedef struct
+{
+    uint32_t dr; /// Last byte popped, with its error flags.
+    uint32_t fr; /// Flags: `UART_UARTFR_RXFE_BITS` while the receive FIFO is empty.
+} uart_hw_t;
+
+typedef struct uart_inst uart_inst_t;
+
+extern uart_inst_t *const host_uart[2];
+
+#define uart0 (host_uart[0])
+#define uart1 (host_uart[1])
+
+uart_hw_t *host_uart_hw(uart_inst_t *uart);
+
+#define uart0_hw (host_uart_hw(uart0))
+#define uart1_hw (host_uart_hw(uart1))
+
+#define UART0_IRQ 33
+#define UART1_IRQ 34
+#define UART_IRQ_NUM(uart) ((uart) == uart0 ? UART0_IRQ : UART1_IRQ)
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate);
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+uart_hw_t *uart_get_hw(uart_inst_t *uart);
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len);
+void uart_tx_wait_blocking(uart_inst_t *uart);
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data, bool tx_needs_data);
+
+#endif // HOST_HARDWARE_UART_H
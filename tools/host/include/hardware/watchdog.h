@@ -0,0 +1,26 @@
+/** @file watchdog.h
+ ** @brief Host stand-in for the Pico SDK `hardware/watchdog.h`: a watchdog that never fires.
+ * @details The host has no reset to give, so every boot is a cold boot.
+ */
+
+#ifndef HOST_HARDWARE_WATCHDOG_H
+#define HOST_HARDWARE_WATCHDOG_H
+
+#include "pico/stdlib.h"
+
+static inline void watchdog_enable(uint32_t delay_ms, bool pause_on_debug)
+{
+    (void)delay_ms;
+    (void)pause_on_debug;
+}
+
+static inline void watchdog_update(void)
+{
+}
+
+static inline bool watchdog_enable_caused_reboot(void)
+{
+    return false;
+}
+
+#endif // HOST_HARDWARE_WATCHDOG_H
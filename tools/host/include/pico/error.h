@@ -0,0 +1,10 @@
+/** @file error.h
+ ** @brief Host stand-in for the Pico SDK `pico/error.h` (the codes live in the host `pico/stdlib.h`).
+ */
+
+#ifndef HOST_PICO_ERROR_H
+#define HOST_PICO_ERROR_H
+
+#include "pico/stdlib.h"
+
+#endif // HOST_PICO_ERROR_H
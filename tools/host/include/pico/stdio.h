@@ -0,0 +1,23 @@
+/** @file stdio.h
+ ** @brief Host stand-in for the Pico SDK `pico/stdio.h`.
+ * @details There is no console input on the host: `getchar_timeout_us()` waits out its
+ * timeout and reports it.
+ */
+
+#ifndef HOST_PICO_STDIO_H
+#define HOST_PICO_STDIO_H
+
+#include "pico/stdlib.h"
+
+static inline bool stdio_init_all(void)
+{
+    return true;
+}
+
+static inline int getchar_timeout_us(uint32_t timeout_us)
+{
+    sleep_us(timeout_us);
+    return PICO_ERROR_TIMEOUT;
+}
+
+#endif // HOST_PICO_STDIO_H
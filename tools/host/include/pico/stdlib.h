@@ -0,0 +1,98 @@
+/** @file stdlib.h
+ ** @brief Host stand-in for the Pico SDK `pico/stdlib.h`.
+ * @details Provides just enough of the SDK for firmware sources to compile on the host.
+ * Time is simulated: `time_us_64()` returns `host_time_us`, and the sleep functions
+ * advance it instead of blocking, so code under test runs as fast as the host allows.
+ *
+ * With `HOST_SIM` set (the simulator library, tools/sim) the clock is advanced through the
+ * device models (`host_advance_to()`), and every timer read costs `HOST_TIME_READ_COST_US`,
+ * so polling loops in the firmware make progress.
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef unsigned int uint;
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC (-1)
+#define PICO_ERROR_TIMEOUT (-2)
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+/** @brief Variables kept across a reset on the target; ordinary variables on the host. */
+#define __uninitialized_ram(group) group
+
+/** @brief Code placed in RAM on the target; ordinary code on the host. */
+#define __not_in_flash_func(func) func
+#define __force_inline inline __attribute__((always_inline))
+
+#ifndef HOST_SIM
+#define HOST_SIM 0
+#endif
+
+/** @brief Simulated time taken by one timer read [us]. */
+#define HOST_TIME_READ_COST_US 1
+
+/** @brief Simulated microseconds since boot (defined in host_clock.c). */
+extern uint64_t host_time_us;
+
+#if HOST_SIM
+
+/** @brief Advances the clock to `t_us`, running the device models at every event on the way
+ * (tools/sim/sim.c), so interrupts are taken when they would be on the target.
+ */
+extern void host_advance_to(uint64_t t_us);
+
+static inline uint64_t time_us_64(void)
+{
+    host_advance_to(host_time_us + HOST_TIME_READ_COST_US);
+    return host_time_us;
+}
+
+static inline void sleep_us(uint64_t us)
+{
+    host_advance_to(host_time_us + us);
+}
+
+#else
+
+static inline uint64_t time_us_64(void)
+{
+    return host_time_us;
+}
+
+static inline void sleep_us(uint64_t us)
+{
+    host_time_us += us;
+}
+
+#endif // HOST_SIM
+
+static inline uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+
+static inline void sleep_ms(uint32_t ms)
+{
+    sleep_us((uint64_t)ms * 1000);
+}
+
+static inline void tight_loop_contents(void)
+{
+}
+
+/** @brief Prints the message and stops; the SDK halts the core, the host exits. */
+#define panic(...) (fprintf(stderr, __VA_ARGS__), abort())
+
+#include "hardware/gpio.h"
+#include "pico/stdio.h"
+
+#endif // HOST_PICO_STDLIB_H
@@ -0,0 +1,35 @@
+/** @file sd_card.h
+ ** @brief Host stand-in for the no-OS-FatFS-SD-SPI-RPi-Pico `sd_card.h` header.
+ * @details The card and bus descriptions of src/hw_config.c; tools/sim/sim_sd.c takes the
+ * SPI clock of the card from them.
+ */
+
+#ifndef HOST_SD_CARD_H
+#define HOST_SD_CARD_H
+
+#include <stdbool.h>
+#include "ff.h"
+#include "hardware/spi.h"
+
+typedef struct
+{
+    spi_inst_t *hw_inst;
+    uint miso_gpio;
+    uint mosi_gpio;
+    uint sck_gpio;
+    uint baud_rate;
+} spi_t;
+
+typedef struct
+{
+    const char *pcName;
+    spi_t *spi;
+    uint ss_gpio;
+    bool use_card_detect;
+    uint card_detect_gpio;
+    uint card_detected_true;
+    int m_Status;
+    FATFS fatfs;
+} sd_card_t;
+
+#endif // HOST_SD_CARD_H
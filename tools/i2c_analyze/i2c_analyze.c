@@ -0,0 +1,258 @@
+/** @file i2c_analyze.c
+ ** @brief Host tool: bus utilization report from a firmware I2C trace dump.
+ * @details Reads the text printed by `i2c_trace_dump()` (src/i2c_trace.c), typically a capture
+ * of the USB serial console, and prints per device:
+ * - transfers, bytes, errors and timeouts,
+ * - bus time and its share of the traced window,
+ * - the time the same bytes need on the wire at the traced clock, and the estimated bus time
+ *   at 400 kHz (the non-wire part, e.g. clock stretching and SDK overhead, is kept as is),
+ * - the interval between transactions (a transaction is a run of transfers joined by
+ *   repeated starts),
+ * - retries: transfers repeating a failed one (same device, direction and length) within
+ *   `RETRY_WINDOW_US`.
+ *
+ * It also reports the idle gaps between consecutive transfers on the whole bus.
+ * Other console output around the dump is ignored; when the capture holds several dumps the
+ * last one is used.
+ *
+ * Usage: `i2c_analyze [dump.txt]` (stdin when omitted).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_ADDR 128
+#define FAST_MODE_BAUD 400000.0
+#define RETRY_WINDOW_US 200000
+#define PICO_ERROR_TIMEOUT -2
+
+typedef struct
+{
+    uint64_t start_us;
+    uint32_t duration_us;
+    uint8_t addr;
+    bool write;
+    bool nostop;
+    unsigned len;
+    int result;
+} transfer_t;
+
+typedef struct
+{
+    unsigned long transfers, reads, writes, bytes, errors, timeouts, retries;
+    uint64_t busy_us;
+    double wire_us;
+    uint64_t last_txn_us; /// Start of the previous transaction (0: none yet).
+    bool in_txn; /// The previous transfer ended with a repeated start.
+    uint64_t *intervals;
+    size_t n_intervals, cap_intervals;
+    const transfer_t *last_failed;
+} device_t;
+
+static device_t devices[MAX_ADDR];
+
+static void push(uint64_t **v, size_t *n, size_t *cap, uint64_t x)
+{
+    if (*n == *cap)
+    {
+        *cap = *cap ? *cap * 2 : 64;
+        *v = realloc(*v, *cap * sizeof(**v));
+        if (!*v)
+        {
+            perror("i2c_analyze");
+            exit(EXIT_FAILURE);
+        }
+    }
+    (*v)[(*n)++] = x;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Bits on the wire for one transfer: start, address byte and data bytes with their ACK, stop. */
+static double wire_bits(unsigned len)
+{
+    return 1 + 9.0 * (1 + len) + 1;
+}
+
+static void print_spread(const char *label, uint64_t *v, size_t n)
+{
+    if (n == 0)
+    {
+        printf("  %-22s -\n", label);
+        return;
+    }
+    qsort(v, n, sizeof(*v), cmp_u64);
+    printf("  %-22s min %.3f ms, median %.3f ms, max %.3f ms (%zu)\n", label,
+           v[0] / 1000.0, v[n / 2] / 1000.0, v[n - 1] / 1000.0, n);
+}
+
+static double percent(double part, double whole)
+{
+    return (whole > 0) ? 100.0 * part / whole : 0.0;
+}
+
+static const char *device_name(unsigned addr)
+{
+    switch (addr)
+    {
+        case 0x70: return "SHTC3";
+        case 0x76: return "BMP280";
+        case 0x74: return "O2";
+        default: return "?";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = (argc > 1) ? fopen(argv[1], "r") : stdin;
+    if (!in)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    char line[256];
+    transfer_t *t = NULL;
+    size_t n = 0, cap = 0;
+    double baud = 100000.0;
+    unsigned long dropped = 0;
+    uint64_t epoch = 0;
+    uint32_t prev = 0;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        unsigned long baud_in, records, dropped_in;
+        unsigned long start;
+        unsigned addr, len, nostop, duration;
+        char dir;
+        int result;
+
+        if (sscanf(line, "# i2c trace v1 baud=%lu records=%lu dropped=%lu", &baud_in, &records, &dropped_in) == 3)
+        {
+            // A new dump starts: only the last one is analyzed.
+            baud = (double)baud_in;
+            dropped = dropped_in;
+            n = 0;
+            epoch = 0;
+            continue;
+        }
+        if (sscanf(line, "%lu,%x,%c,%u,%u,%u,%d", &start, &addr, &dir, &len, &nostop, &duration, &result) != 7) continue;
+        if (addr >= MAX_ADDR || (dir != 'R' && dir != 'W')) continue;
+
+        uint32_t s = (uint32_t)start;
+        if (n > 0 && s < prev && prev - s > 0x80000000u) epoch += 1ULL << 32;
+        prev = s;
+
+        if (n == cap)
+        {
+            cap = cap ? cap * 2 : 1024;
+            t = realloc(t, cap * sizeof(*t));
+            if (!t)
+            {
+                perror("i2c_analyze");
+                return EXIT_FAILURE;
+            }
+        }
+        t[n++] = (transfer_t){
+            .start_us = epoch + s,
+            .duration_us = duration,
+            .addr = (uint8_t)addr,
+            .write = (dir == 'W'),
+            .nostop = nostop != 0,
+            .len = len,
+            .result = result,
+        };
+    }
+    if (in != stdin) fclose(in);
+
+    if (n == 0)
+    {
+        fprintf(stderr, "i2c_analyze: no I2C trace records found\n");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t first = t[0].start_us;
+    uint64_t last_end = t[n - 1].start_us + t[n - 1].duration_us;
+    uint64_t window = (last_end > first) ? last_end - first : 1;
+
+    uint64_t *gaps = NULL;
+    size_t n_gaps = 0, cap_gaps = 0;
+    uint64_t busy_total = 0;
+    double wire_total = 0, fast_total = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const transfer_t *x = &t[i];
+        device_t *d = &devices[x->addr];
+        double wire = wire_bits(x->len) * 1e6 / baud;
+
+        d->transfers++;
+        if (x->write) d->writes++;
+        else d->reads++;
+        if (x->result > 0) d->bytes += (unsigned long)x->result;
+        if (x->result == PICO_ERROR_TIMEOUT) d->timeouts++;
+        else if (x->result < 0) d->errors++;
+        d->busy_us += x->duration_us;
+        d->wire_us += wire;
+
+        const transfer_t *f = d->last_failed;
+        if (f && f->write == x->write && f->len == x->len && x->start_us - f->start_us <= RETRY_WINDOW_US) d->retries++;
+        d->last_failed = (x->result < 0) ? x : NULL;
+
+        // Transfers joined by a repeated start form one transaction (e.g. register address + read).
+        if (!d->in_txn)
+        {
+            if (d->last_txn_us) push(&d->intervals, &d->n_intervals, &d->cap_intervals, x->start_us - d->last_txn_us);
+            d->last_txn_us = x->start_us;
+        }
+        d->in_txn = x->nostop && x->result >= 0;
+
+        if (i > 0)
+        {
+            uint64_t prev_end = t[i - 1].start_us + t[i - 1].duration_us;
+            push(&gaps, &n_gaps, &cap_gaps, (x->start_us > prev_end) ? x->start_us - prev_end : 0);
+        }
+
+        busy_total += x->duration_us;
+        wire_total += wire;
+        fast_total += (x->duration_us > wire ? x->duration_us - wire : 0) + wire * baud / FAST_MODE_BAUD;
+    }
+
+    printf("I2C trace: %zu transfers over %.3f s at %.0f kHz", n, window / 1e6, baud / 1000.0);
+    if (dropped) printf(" (%lu older transfers overwritten)", dropped);
+    printf("\n\n");
+
+    printf("Bus: busy %.2f %% (wire %.2f %%), estimated %.2f %% at %.0f kHz\n",
+           percent(busy_total, window), percent(wire_total, window),
+           percent(fast_total, window), FAST_MODE_BAUD / 1000.0);
+    print_spread("idle gap:", gaps, n_gaps);
+    printf("\n");
+
+    for (unsigned a = 0; a < MAX_ADDR; a++)
+    {
+        device_t *d = &devices[a];
+        if (d->transfers == 0) continue;
+
+        double fast = (d->busy_us > d->wire_us ? d->busy_us - d->wire_us : 0) + d->wire_us * baud / FAST_MODE_BAUD;
+
+        printf("0x%02x %s\n", a, device_name(a));
+        printf("  transfers              %lu (%lu W, %lu R), %lu bytes\n", d->transfers, d->writes, d->reads, d->bytes);
+        printf("  errors                 %lu, timeouts %lu, retries %lu\n", d->errors, d->timeouts, d->retries);
+        printf("  bus time               %.3f ms = %.2f %% of window, %.1f %% of bus time\n",
+               d->busy_us / 1000.0, percent(d->busy_us, window), percent(d->busy_us, busy_total));
+        printf("  wire time              %.3f ms (%.0f %% of bus time), %.2f %% at %.0f kHz\n",
+               d->wire_us / 1000.0, percent(d->wire_us, d->busy_us), percent(fast, window), FAST_MODE_BAUD / 1000.0);
+        print_spread("transaction interval:", d->intervals, d->n_intervals);
+        free(d->intervals);
+    }
+
+    free(gaps);
+    free(t);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,391 @@
+/** @file montecarlo.c
+ ** @brief Host tool: flies many independent firmware instances and aggregates their losses and
+ * tail latencies.
+ * @details Each instance is src/main.c on the device models of tools/sim, from boot through a
+ * simulated flight (tools/sim/sim_flight.h), with its own seed. The seed draws the instance's
+ * conditions:
+ * - I2C sensors: NAK and corrupt-byte probabilities,
+ * - GNSS: corrupt-byte probability,
+ * - SD card: block programming time, failed operations, stall probability and stall length,
+ * - radio: packet loss on the link,
+ * - flight: wind speed and direction, descent rate,
+ * and then every fault of the run, so any instance can be run again alone (`-s seed -n 1`).
+ *
+ * The firmware keeps its state in static variables of its modules, so every instance runs in
+ * a process of its own, forked from the driver; up to `-j` of them run at a time, one per core
+ * by default, and each hands its figures back through shared memory.
+ *
+ * Per instance:
+ * - deadline misses: 1 Hz ticks handled later than `HOUSEKEEPING_TICK_DEADLINE_US`, and the
+ *   latest tick,
+ * - records lost: sensor records appended to the flash log (flash_log.h) that are neither
+ *   complete in data_log.txt on the card (a record written twice counts once) nor still in
+ *   flash waiting to be copied,
+ * - worst SD operation (a stall of the card shows up here), SD errors,
+ * - radio delivery ratio: packets decoded on the ground over frames handed to the radio module.
+ * The report gives the mean, median, 99th percentile and maximum over the instances, with the
+ * seed of the worst one.
+ *
+ * Usage: `montecarlo [-n instances] [-j jobs] [-t seconds] [-s seed]`
+ * - `-n`: number of instances (default 100),
+ * - `-j`: instances run at a time (default: online CPUs),
+ * - `-t`: simulated time per instance from boot (default 180 s, past the landing),
+ * - `-s`: seed of the first instance; instance i uses seed + i (default 1).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "flash_log.h"
+#include "housekeeping.h"
+#include "microsd_module.h"
+#include "sim.h"
+#include "sim_flight.h"
+
+/** @brief Rate at which the flight refreshes `sim_env`; the firmware samples at 1 Hz [Hz]. */
+#define FLIGHT_SAMPLE_HZ 50
+
+// Ranges the instance conditions are drawn from, uniformly.
+#define I2C_NAK_PROB_MAX 1e-3
+#define I2C_CORRUPT_PROB_MAX 1e-4
+#define GNSS_CORRUPT_PROB_MAX 1e-4
+#define SD_BLOCK_US_MIN 500
+#define SD_BLOCK_US_MAX 3000
+#define SD_ERROR_PROB_MAX 1e-3
+#define SD_STALL_PROB_MAX 0.02
+#define SD_STALL_US_MIN 20000
+#define SD_STALL_US_MAX 500000
+#define RADIO_LOSS_PROB_MAX 0.3
+#define WIND_MPS_MAX 10.0
+#define DESCENT_MPS_MIN 6.0
+#define DESCENT_MPS_MAX 10.0
+
+// DATA STRUCTURES
+
+/** @brief Figures of one instance, written by its process. */
+typedef struct
+{
+    bool done; /// The process ran to the end.
+    uint32_t deadline_misses;
+    uint32_t worst_lateness_us;
+    uint32_t records_saved; /// Sensor records appended to the flash log.
+    uint32_t records_written; /// Distinct complete records in data_log.txt.
+    uint32_t records_pending; /// Sensor records still in flash, not yet copied to the card.
+    uint32_t sd_worst_us;
+    uint32_t sd_errors;
+    uint32_t radio_queued;
+    uint32_t radio_received;
+} instance_result_t;
+
+typedef enum
+{
+    METRIC_DEADLINE_MISSES = 0,
+    METRIC_WORST_LATENESS_MS,
+    METRIC_RECORDS_LOST,
+    METRIC_SD_WORST_MS,
+    METRIC_SD_ERRORS,
+    METRIC_RADIO_DELIVERY,
+    METRIC_COUNT
+} metric_t;
+
+static const char *const metric_names[METRIC_COUNT] = {
+    [METRIC_DEADLINE_MISSES] = "deadline misses",
+    [METRIC_WORST_LATENESS_MS] = "worst tick [ms]",
+    [METRIC_RECORDS_LOST] = "records lost",
+    [METRIC_SD_WORST_MS] = "worst SD op [ms]",
+    [METRIC_SD_ERRORS] = "SD errors",
+    [METRIC_RADIO_DELIVERY] = "radio delivery",
+};
+
+/** @brief src/main.c, built with `main` renamed. */
+extern int firmware_main(void);
+
+static void run_firmware(void)
+{
+    firmware_main();
+}
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * sim_random();
+}
+
+/** @brief Draws the conditions of an instance from the fault generator. */
+static void draw_conditions(sim_flight_config_t *flight)
+{
+    for (int d = 0; d < SIM_DEV_GNSS; d++)
+    {
+        sim_faults[d].nak_prob = uniform(0, I2C_NAK_PROB_MAX);
+        sim_faults[d].corrupt_prob = uniform(0, I2C_CORRUPT_PROB_MAX);
+    }
+    sim_faults[SIM_DEV_GNSS].corrupt_prob = uniform(0, GNSS_CORRUPT_PROB_MAX);
+
+    sim_faults[SIM_DEV_SD].conversion_us = (uint32_t)uniform(SD_BLOCK_US_MIN, SD_BLOCK_US_MAX);
+    sim_faults[SIM_DEV_SD].nak_prob = uniform(0, SD_ERROR_PROB_MAX);
+    sim_faults[SIM_DEV_SD].stall_prob = uniform(0, SD_STALL_PROB_MAX);
+    sim_faults[SIM_DEV_SD].stall_us = (uint32_t)uniform(SD_STALL_US_MIN, SD_STALL_US_MAX);
+
+    sim_faults[SIM_DEV_RADIO].nak_prob = uniform(0, RADIO_LOSS_PROB_MAX);
+
+    *flight = sim_flight_default;
+    flight->sample_hz = FLIGHT_SAMPLE_HZ;
+    flight->wind_mps = uniform(0, WIND_MPS_MAX);
+    flight->wind_from_deg = uniform(0, 360);
+    flight->descent_rate_mps = uniform(DESCENT_MPS_MIN, DESCENT_MPS_MAX);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Distinct complete records in data_log.txt: each one ends with its separator line.
+ * @details A copy retried after a failed close writes its records a second time. Every record
+ * carries its sample timestamps, so two different records never have the same text: records
+ * are told apart by a hash of their text, and a duplicate is counted once.
+ */
+static uint32_t records_on_card(void)
+{
+    static const char separator[] = "--------------------------------------------------\n";
+    uint64_t *hashes = NULL;
+    size_t count = 0, capacity = 0;
+
+    for (int i = 0; i < sim_fatfs_file_count(); i++)
+    {
+        const uint8_t *data;
+        size_t size;
+
+        if (strcmp(sim_fatfs_file(i, &data, &size), "data_log.txt") != 0) continue;
+
+        uint64_t hash = 14695981039346656037ULL; // FNV-1a of the record so far.
+
+        for (size_t line = 0, k = 0; k < size; k++)
+        {
+            hash = (hash ^ data[k]) * 1099511628211ULL;
+            if (data[k] != '\n') continue;
+            if (k + 1 - line == sizeof(separator) - 1 && memcmp(data + line, separator, k + 1 - line) == 0)
+            {
+                if (count == capacity)
+                {
+                    capacity = capacity ? 2 * capacity : 1024;
+                    hashes = realloc(hashes, capacity * sizeof(*hashes));
+                }
+                hashes[count++] = hash;
+                hash = 14695981039346656037ULL;
+            }
+            line = k + 1;
+        }
+    }
+
+    uint32_t distinct = 0;
+
+    qsort(hashes, count, sizeof(*hashes), compare_u64);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i == 0 || hashes[i] != hashes[i - 1]) distinct++;
+    }
+    free(hashes);
+    return distinct;
+}
+
+/** @brief Runs one instance (in its own process) and fills its figures. */
+static void run_instance(uint64_t seed, uint64_t duration_us, instance_result_t *r)
+{
+    sim_flight_config_t flight;
+
+    sim_init(seed);
+    draw_conditions(&flight);
+    sim_flight_start(&flight);
+
+    sim_run_until(run_firmware, duration_us);
+
+    housekeeping_t hk;
+    housekeeping_collect(&hk);
+
+    r->deadline_misses = hk.deadline_misses;
+    r->worst_lateness_us = hk.worst_lateness_us;
+    flash_log_stats_t log;
+    flash_log_get_stats(&log);
+
+    r->records_saved = log.appended[FLASH_LOG_SENSORS];
+    r->records_written = records_on_card();
+    r->records_pending = log.appended[FLASH_LOG_SENSORS] - log.drained[FLASH_LOG_SENSORS] - log.overwritten[FLASH_LOG_SENSORS];
+    r->sd_worst_us = hk.sd_worst_us;
+    r->sd_errors = hk.sd_errors;
+    r->radio_queued = hk.radio_queued;
+    r->radio_received = sim_stats[SIM_DEV_RADIO].conversions;
+    r->done = true;
+}
+
+static double metric_value(const instance_result_t *r, metric_t m)
+{
+    switch (m)
+    {
+        case METRIC_DEADLINE_MISSES: return r->deadline_misses;
+        case METRIC_WORST_LATENESS_MS: return r->worst_lateness_us / 1000.0;
+        case METRIC_RECORDS_LOST: return (double)r->records_saved - r->records_written - r->records_pending;
+        case METRIC_SD_WORST_MS: return r->sd_worst_us / 1000.0;
+        case METRIC_SD_ERRORS: return r->sd_errors;
+        case METRIC_RADIO_DELIVERY: return r->radio_queued ? (double)r->radio_received / r->radio_queued : 1.0;
+        default: return 0;
+    }
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Nearest-rank percentile of sorted values. */
+static double percentile(const double *sorted, uint32_t n, double p)
+{
+    uint32_t rank = (uint32_t)(p / 100.0 * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+static void report(const instance_result_t *results, uint32_t n, uint64_t seed)
+{
+    double *values = malloc(n * sizeof(double));
+    uint32_t done = 0;
+
+    for (uint32_t i = 0; i < n; i++) done += results[i].done;
+    printf("  %u of %u instances completed\n", done, n);
+    if (!values || done == 0)
+    {
+        free(values);
+        return;
+    }
+
+    printf("  %-18s %10s %10s %10s %10s %12s\n", "metric", "mean", "p50", "p99", "worst", "worst seed");
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        // Worst is the highest value, except for the delivery ratio.
+        bool lowest_worst = m == METRIC_RADIO_DELIVERY;
+        uint32_t count = 0, worst = 0;
+        double sum = 0;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (!results[i].done) continue;
+
+            double v = metric_value(&results[i], m);
+            double w = metric_value(&results[worst], m);
+            if (!results[worst].done || (lowest_worst ? v < w : v > w)) worst = i;
+            values[count++] = v;
+            sum += v;
+        }
+        qsort(values, count, sizeof(double), compare_double);
+
+        double p99 = lowest_worst ? percentile(values, count, 1) : percentile(values, count, 99);
+        printf("  %-18s %10.3f %10.3f %10.3f %10.3f %12llu\n", metric_names[m], sum / count,
+               percentile(values, count, 50), p99, metric_value(&results[worst], m),
+               (unsigned long long)(seed + worst));
+    }
+    printf("  (radio delivery: p99 column is the 1st percentile)\n");
+
+    uint64_t saved = 0, written = 0, pending = 0, queued = 0, received = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (!results[i].done) continue;
+        saved += results[i].records_saved;
+        written += results[i].records_written;
+        pending += results[i].records_pending;
+        queued += results[i].radio_queued;
+        received += results[i].radio_received;
+    }
+    uint64_t lost = saved - written - pending;
+    printf("  records: %llu saved, %llu on the card, %llu still in flash (%.4f%% lost); radio: %llu queued, %llu received (%.2f%%)\n",
+           (unsigned long long)saved, (unsigned long long)written, (unsigned long long)pending,
+           saved ? 100.0 * lost / saved : 0.0,
+           (unsigned long long)queued, (unsigned long long)received, queued ? 100.0 * received / queued : 0.0);
+
+    free(values);
+}
+
+int main(int argc, char **argv)
+{
+    long instances = 100, jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    double duration_s = 180;
+    uint64_t seed = 1;
+    bool usage = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) instances = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-j") && i + 1 < argc) jobs = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) duration_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else usage = true;
+    }
+
+    if (usage || instances <= 0 || jobs <= 0 || duration_s <= 0)
+    {
+        fprintf(stderr, "usage: %s [-n instances] [-j jobs] [-t seconds] [-s seed]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Shared with the instance processes; each writes its own entry.
+    size_t size = (size_t)instances * sizeof(instance_result_t);
+    instance_result_t *results = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results == MAP_FAILED)
+    {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    memset(results, 0, size);
+
+    printf("== %ld instances of %.0f s, seeds %llu..%llu, %ld at a time\n", instances, duration_s,
+           (unsigned long long)seed, (unsigned long long)(seed + instances - 1), jobs);
+    fflush(stdout);
+
+    uint64_t duration_us = (uint64_t)(duration_s * 1e6);
+    struct timespec t0, t1;
+    long next = 0, running = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (next < instances || running > 0)
+    {
+        if (next < instances && running < jobs)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                run_instance(seed + next, duration_us, &results[next]);
+                _exit(EXIT_SUCCESS);
+            }
+            if (pid < 0)
+            {
+                perror("fork");
+                if (running == 0) return EXIT_FAILURE;
+            }
+            else
+            {
+                next++;
+                running++;
+                continue;
+            }
+        }
+
+        int status;
+        if (wait(&status) > 0) running--;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    report(results, (uint32_t)instances, seed);
+
+    double host_s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    fprintf(stderr, "host time %.2f s (%.0f simulated s per host s)\n", host_s,
+            host_s > 0 ? instances * duration_s / host_s : 0);
+
+    munmap(results, size);
+    return EXIT_SUCCESS;
+}
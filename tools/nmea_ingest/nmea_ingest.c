@@ -0,0 +1,538 @@
+/** @file nmea_ingest.c
+ ** @brief Host tool: bulk conversion of raw NMEA captures into a packed position/time table.
+ * @details The capture is memory-mapped and split into newline-aligned chunks, one per
+ * core. Each worker finds line ends and verifies checksums a word (8 bytes) at a time
+ * (SWAR), and only the RMC and GGA sentences are handed to lib/minmea. Every RMC sentence
+ * becomes one row; altitude and satellite count are taken from the GGA sentence of the
+ * same epoch.
+ *
+ * Usage: `nmea_ingest [-j threads] [--compare] <capture.nmea> <table.bin>`
+ * - `-j` sets the number of worker threads (default: number of online cores).
+ * - `--compare` also runs the plain one-line-at-a-time `minmea_check` + `minmea_parse_*`
+ *   loop over the same capture, checks that it produces an identical table and
+ *   reports both throughputs.
+ *
+ * Output: an `nmea_table_header_t` followed by `count` `nmea_pos_record_t` rows.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "minmea.h"
+
+// DATA STRUCTURES
+
+/** @brief Row flag: the RMC sentence reported a valid fix ('A'). */
+#define ROW_FLAG_VALID 0x01
+
+/** @brief Row flag: altitude and satellite count were filled from a GGA sentence. */
+#define ROW_FLAG_GGA 0x02
+
+/** @brief One row of the output table (one navigation epoch). */
+typedef struct __attribute__((packed))
+{
+    uint32_t date; /// UTC date as YYYYMMDD.
+    uint32_t time_ms; /// UTC milliseconds since midnight.
+    int32_t lat_e7; /// Latitude [1e-7 deg].
+    int32_t lon_e7; /// Longitude [1e-7 deg].
+    int32_t alt_mm; /// Altitude above mean sea level [mm].
+    uint8_t satellites; /// Satellites used in the fix.
+    uint8_t flags; /// `ROW_FLAG_*` bits.
+} nmea_pos_record_t;
+
+/** @brief Header at the start of the output file. */
+typedef struct __attribute__((packed))
+{
+    char magic[8]; /// "NMEAPOS1"
+    uint32_t record_size; /// sizeof(nmea_pos_record_t)
+    uint64_t count; /// Number of rows that follow.
+} nmea_table_header_t;
+
+/** @brief Sentence counters collected by a worker. */
+typedef struct
+{
+    uint64_t lines;
+    uint64_t sentences; /// Lines with a valid checksum.
+    uint64_t checksum_errors; /// Lines starting with '$' that failed the check.
+    uint64_t rmc;
+    uint64_t gga;
+} ingest_stats_t;
+
+/** @brief A GGA sentence waiting for the RMC sentence of the same epoch. */
+typedef struct
+{
+    bool valid;
+    uint32_t time_ms;
+    int32_t alt_mm;
+    uint8_t satellites;
+} pending_gga_t;
+
+/** @brief Growable table of rows plus the epoch-pairing state that produced it. */
+typedef struct
+{
+    nmea_pos_record_t *rows;
+    size_t count;
+    size_t capacity;
+    pending_gga_t pending; /// GGA not yet matched to a row (state at the end of the chunk).
+    pending_gga_t lead; /// First GGA of the chunk, if it came before any RMC.
+} row_table_t;
+
+/** @brief Work item for one thread. */
+typedef struct
+{
+    const char *begin;
+    const char *end;
+    row_table_t table;
+    ingest_stats_t stats;
+} chunk_t;
+
+// SWAR HELPERS
+
+#define ONES 0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+static inline uint64_t load64(const char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/** @brief Marks (with bit 7) every byte of `v` equal to `c`. Exact for the lowest marked byte. */
+static inline uint64_t match_bytes(uint64_t v, uint8_t c)
+{
+    uint64_t x = v ^ (ONES * c);
+    return (x - ONES) & ~x & HIGHS;
+}
+
+/** @brief Marks bytes outside the printable ASCII range 0x20..0x7E. */
+static inline uint64_t nonprint_bytes(uint64_t v)
+{
+    uint64_t below_space = (v - ONES * 0x20) & ~v & HIGHS;
+    return below_space | (v & HIGHS) | match_bytes(v, 0x7F);
+}
+
+/** @brief Finds the first occurrence of `c` in [p, end), 8 bytes at a time. */
+static const char *find_byte(const char *p, const char *end, uint8_t c)
+{
+    while (end - p >= 8)
+    {
+        uint64_t m = match_bytes(load64(p), c);
+        if (m) return p + (__builtin_ctzll(m) >> 3);
+        p += 8;
+    }
+    while (p < end && (uint8_t)*p != c) p++;
+    return p;
+}
+
+static inline int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/** @brief Strict checksum verification of one line (without its line terminator).
+ * @details Same acceptance as `minmea_check(line, true)`: '$', printable payload,
+ * '*' and two hex digits, optionally followed by '\r'.
+ */
+static bool swar_check(const char *line, const char *end)
+{
+    if (line >= end || *line != '$') return false;
+
+    const char *p = line + 1;
+    uint64_t sum = 0;
+
+    while (end - p >= 8)
+    {
+        uint64_t v = load64(p);
+        uint64_t star = match_bytes(v, '*');
+        if (star)
+        {
+            int n = __builtin_ctzll(star) >> 3;
+            uint64_t mask = n ? (~0ULL >> (64 - 8 * n)) : 0;
+            if (nonprint_bytes(v) & mask) return false;
+            sum ^= v & mask;
+            p += n;
+            goto found;
+        }
+        if (nonprint_bytes(v)) return false;
+        sum ^= v;
+        p += 8;
+    }
+    while (p < end && *p != '*')
+    {
+        if (*p < 0x20 || *p > 0x7E) return false;
+        sum ^= (uint8_t)*p++;
+    }
+    if (p >= end) return false;
+
+found:
+    sum ^= sum >> 32;
+    sum ^= sum >> 16;
+    sum ^= sum >> 8;
+
+    if (end - p < 3) return false;
+    int hi = hex_value(p[1]);
+    int lo = hex_value(p[2]);
+    if (hi < 0 || lo < 0) return false;
+    if ((uint8_t)sum != (uint8_t)(hi << 4 | lo)) return false;
+
+    for (p += 3; p < end; p++)
+    {
+        if (*p != '\r') return false;
+    }
+    return true;
+}
+
+// ROW BUILDING
+
+static void table_push(row_table_t *t, const nmea_pos_record_t *row)
+{
+    if (t->count == t->capacity)
+    {
+        t->capacity = t->capacity ? t->capacity * 2 : 4096;
+        t->rows = realloc(t->rows, t->capacity * sizeof(*t->rows));
+        if (!t->rows)
+        {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    t->rows[t->count++] = *row;
+}
+
+static uint32_t time_of_day_ms(const struct minmea_time *t)
+{
+    if (t->hours < 0) return UINT32_MAX;
+    return ((t->hours * 60 + t->minutes) * 60 + t->seconds) * 1000 + t->microseconds / 1000;
+}
+
+static void add_rmc(row_table_t *t, const struct minmea_sentence_rmc *rmc)
+{
+    nmea_pos_record_t row = {0};
+
+    row.date = (rmc->date.year < 0) ? 0 : (uint32_t)((2000 + rmc->date.year) * 10000 + rmc->date.month * 100 + rmc->date.day);
+    row.time_ms = time_of_day_ms(&rmc->time);
+    row.lat_e7 = minmea_tocoord_e7(&rmc->latitude);
+    row.lon_e7 = minmea_tocoord_e7(&rmc->longitude);
+    row.flags = rmc->valid ? ROW_FLAG_VALID : 0;
+
+    if (t->pending.valid && t->pending.time_ms == row.time_ms)
+    {
+        row.alt_mm = t->pending.alt_mm;
+        row.satellites = t->pending.satellites;
+        row.flags |= ROW_FLAG_GGA;
+    }
+    t->pending.valid = false;
+
+    table_push(t, &row);
+}
+
+static void add_gga(row_table_t *t, const struct minmea_sentence_gga *gga)
+{
+    pending_gga_t g = {
+        .valid = true,
+        .time_ms = time_of_day_ms(&gga->time),
+        .alt_mm = minmea_rescale(&gga->altitude, 1000),
+        .satellites = (uint8_t)gga->satellites_tracked,
+    };
+
+    if (t->count == 0 && !t->lead.valid) t->lead = g;
+
+    nmea_pos_record_t *last = t->count ? &t->rows[t->count - 1] : NULL;
+    if (last && !(last->flags & ROW_FLAG_GGA) && last->time_ms == g.time_ms)
+    {
+        last->alt_mm = g.alt_mm;
+        last->satellites = g.satellites;
+        last->flags |= ROW_FLAG_GGA;
+        return;
+    }
+    t->pending = g;
+}
+
+static void dispatch(row_table_t *t, ingest_stats_t *st, const char *sentence)
+{
+    // The talker ID is skipped: "$GPRMC", "$GNRMC" and "$GLRMC" are all accepted.
+    if (!memcmp(sentence + 3, "RMC", 3))
+    {
+        struct minmea_sentence_rmc rmc;
+        if (minmea_parse_rmc(&rmc, sentence))
+        {
+            st->rmc++;
+            add_rmc(t, &rmc);
+        }
+    }
+    else if (!memcmp(sentence + 3, "GGA", 3))
+    {
+        struct minmea_sentence_gga gga;
+        if (minmea_parse_gga(&gga, sentence))
+        {
+            st->gga++;
+            add_gga(t, &gga);
+        }
+    }
+}
+
+// WORKERS
+
+static void *ingest_chunk(void *arg)
+{
+    chunk_t *c = arg;
+    char sentence[MINMEA_MAX_SENTENCE_LENGTH + 8];
+    const char *p = c->begin;
+
+    while (p < c->end)
+    {
+        const char *eol = find_byte(p, c->end, '\n');
+        size_t len = eol - p;
+        c->stats.lines++;
+
+        if (len > 0 && *p == '$')
+        {
+            if (len < sizeof(sentence) && swar_check(p, eol))
+            {
+                c->stats.sentences++;
+                // Only RMC and GGA are copied out and parsed.
+                if (len > 6 && (!memcmp(p + 3, "RMC", 3) || !memcmp(p + 3, "GGA", 3)))
+                {
+                    memcpy(sentence, p, len);
+                    sentence[len] = '\0';
+                    dispatch(&c->table, &c->stats, sentence);
+                }
+            }
+            else
+            {
+                c->stats.checksum_errors++;
+            }
+        }
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+/** @brief Reference path: one line at a time through the public minmea API only. */
+static void ingest_plain(const char *data, size_t size, row_table_t *t, ingest_stats_t *st)
+{
+    char line[MINMEA_MAX_SENTENCE_LENGTH + 8];
+    const char *p = data, *end = data + size;
+
+    while (p < end)
+    {
+        const char *eol = memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        size_t len = eol - p;
+        st->lines++;
+
+        if (len > 0 && *p == '$')
+        {
+            bool ok = false;
+            if (len < sizeof(line))
+            {
+                memcpy(line, p, len);
+                line[len] = '\0';
+                ok = minmea_check(line, true);
+            }
+            if (ok)
+            {
+                st->sentences++;
+                switch (minmea_sentence_id(line, true))
+                {
+                    case MINMEA_SENTENCE_RMC:
+                    case MINMEA_SENTENCE_GGA:
+                        dispatch(t, st, line);
+                        break;
+                    default:
+                        break;
+                }
+            }
+            else
+            {
+                st->checksum_errors++;
+            }
+        }
+        p = eol + 1;
+    }
+}
+
+/** @brief Joins the per-chunk tables, pairing GGA/RMC sentences split across a chunk boundary. */
+static row_table_t merge_chunks(chunk_t *chunks, int n)
+{
+    row_table_t out = {0};
+
+    for (int i = 0; i < n; i++)
+    {
+        row_table_t *t = &chunks[i].table;
+
+        if (i > 0 && out.count > 0)
+        {
+            nmea_pos_record_t *last = &out.rows[out.count - 1];
+            pending_gga_t *lead = &t->lead;
+
+            if (lead->valid && !(last->flags & ROW_FLAG_GGA) && last->time_ms == lead->time_ms)
+            {
+                last->alt_mm = lead->alt_mm;
+                last->satellites = lead->satellites;
+                last->flags |= ROW_FLAG_GGA;
+            }
+            else if (!lead->valid && t->count > 0 && out.pending.valid &&
+                     !(t->rows[0].flags & ROW_FLAG_GGA) && t->rows[0].time_ms == out.pending.time_ms)
+            {
+                t->rows[0].alt_mm = out.pending.alt_mm;
+                t->rows[0].satellites = out.pending.satellites;
+                t->rows[0].flags |= ROW_FLAG_GGA;
+            }
+        }
+
+        for (size_t r = 0; r < t->count; r++) table_push(&out, &t->rows[r]);
+        if (t->count > 0 || t->pending.valid) out.pending = t->pending;
+        free(t->rows);
+    }
+    return out;
+}
+
+static void add_stats(ingest_stats_t *a, const ingest_stats_t *b)
+{
+    a->lines += b->lines;
+    a->sentences += b->sentences;
+    a->checksum_errors += b->checksum_errors;
+    a->rmc += b->rmc;
+    a->gga += b->gga;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void print_stats(const char *label, const ingest_stats_t *st, size_t rows, double seconds, size_t bytes)
+{
+    printf("%-9s %10.3f s  %12.0f sentences/s  %8.1f MB/s  lines=%llu valid=%llu bad=%llu rmc=%llu gga=%llu rows=%zu\n",
+           label, seconds, st->sentences / seconds, bytes / seconds / 1e6,
+           (unsigned long long)st->lines, (unsigned long long)st->sentences,
+           (unsigned long long)st->checksum_errors, (unsigned long long)st->rmc,
+           (unsigned long long)st->gga, rows);
+}
+
+int main(int argc, char **argv)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    bool compare = false;
+    const char *in_path = NULL, *out_path = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--compare")) compare = true;
+        else if (!in_path) in_path = argv[i];
+        else if (!out_path) out_path = argv[i];
+    }
+    if (!in_path || !out_path || threads < 1)
+    {
+        fprintf(stderr, "usage: %s [-j threads] [--compare] <capture.nmea> <table.bin>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int fd = open(in_path, O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) < 0)
+    {
+        fprintf(stderr, "%s: %s\n", in_path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    size_t size = (size_t)sb.st_size;
+    const char *data = "";
+    if (size > 0)
+    {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            perror("mmap");
+            return EXIT_FAILURE;
+        }
+        madvise((void *)data, size, MADV_SEQUENTIAL | MADV_WILLNEED);
+    }
+
+    // Newline-aligned chunks: each boundary is moved just past the next '\n'.
+    chunk_t *chunks = calloc(threads, sizeof(chunk_t));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    const char *cursor = data, *end = data + size;
+    for (int i = 0; i < threads; i++)
+    {
+        const char *stop = (i == threads - 1) ? end : data + size / threads * (i + 1);
+        if (stop < cursor) stop = cursor;
+        if (stop < end)
+        {
+            stop = find_byte(stop, end, '\n');
+            if (stop < end) stop++;
+        }
+        chunks[i].begin = cursor;
+        chunks[i].end = stop;
+        cursor = stop;
+    }
+
+    double t0 = now_s();
+    for (int i = 0; i < threads; i++) pthread_create(&tids[i], NULL, ingest_chunk, &chunks[i]);
+    for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+
+    ingest_stats_t stats = {0};
+    for (int i = 0; i < threads; i++) add_stats(&stats, &chunks[i].stats);
+    row_table_t table = merge_chunks(chunks, threads);
+    double t_parallel = now_s() - t0;
+
+    FILE *out = fopen(out_path, "wb");
+    if (!out)
+    {
+        fprintf(stderr, "%s: %s\n", out_path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    nmea_table_header_t header = {.magic = "NMEAPOS1", .record_size = sizeof(nmea_pos_record_t), .count = table.count};
+    fwrite(&header, sizeof(header), 1, out);
+    if (table.count > 0) fwrite(table.rows, sizeof(nmea_pos_record_t), table.count, out);
+    fclose(out);
+
+    printf("threads=%d\n", threads);
+    print_stats("parallel", &stats, table.count, t_parallel, size);
+
+    int status = EXIT_SUCCESS;
+    if (compare)
+    {
+        row_table_t plain = {0};
+        ingest_stats_t plain_stats = {0};
+
+        t0 = now_s();
+        ingest_plain(data, size, &plain, &plain_stats);
+        double t_plain = now_s() - t0;
+
+        print_stats("plain", &plain_stats, plain.count, t_plain, size);
+        printf("speedup   %.2fx\n", t_plain / t_parallel);
+
+        if (plain.count != table.count ||
+            (table.count > 0 && memcmp(plain.rows, table.rows, table.count * sizeof(nmea_pos_record_t))))
+        {
+            fprintf(stderr, "ERROR: parallel and plain tables differ\n");
+            status = EXIT_FAILURE;
+        }
+        free(plain.rows);
+    }
+
+    free(table.rows);
+    free(chunks);
+    free(tids);
+    return status;
+}
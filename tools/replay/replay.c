@@ -0,0 +1,189 @@
+/** @file replay.c
+ ** @brief Host tool: replays a recorded flight into the unmodified firmware.
+ * @details src/main.c runs on the device models of tools/sim, from boot to the end of the
+ * recording, with `sim_env` and the GNSS output driven by the recorded data
+ * (tools/sim/sim_replay.h): the same GPS, time, acquisition, logging and radio code as on
+ * the CanSat, against the simulated card and radio.
+ *
+ * The run is deterministic for a given recording, speed and seed, so the files the firmware
+ * writes on the card (`-o`) and the report can be compared between two versions of the code:
+ * the report covers the GPS receive counters, the SD latency statistics, the flash log, the
+ * flight phases the detector went through, what
+ * the files on the card hold, the radio counters and the ground station, and the end-to-end latencies.
+ * The host time the run took goes to stderr.
+ *
+ * Usage: `replay [-d data_log.txt] [-g gps_log.csv] [-n capture.nmea] [-x speed] [-s seed] [-o dir]`
+ * - `-d`, `-g`, `-n`: recordings (at least one), see sim_replay.h,
+ * - `-x`: replay speed, 1 (default) for the recorded timing,
+ * - `-s`: seed of the fault generator (default 1),
+ * - `-o`: directory that receives the card's files and `radio_rx.txt`, the packets decoded
+ *   on the ground.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "e2e_latency.h"
+#include "flash_io.h"
+#include "flash_log.h"
+#include "flight_phase.h"
+#include "gps_module.h"
+#include "radio_module.h"
+#include "sd_latency.h"
+#include "sim.h"
+#include "sim_replay.h"
+
+/** @brief Time the firmware keeps running after the end of the recording [s]. */
+#define AFTER_END_S 2
+
+/** @brief src/main.c, built with `main` renamed. */
+extern int firmware_main(void);
+
+static void run_firmware(void)
+{
+    firmware_main();
+}
+
+static void report(void)
+{
+    gps_stats_t gps;
+    radio_stats_t radio;
+
+    gps_get_stats(&gps);
+    printf("  gps: overruns %lu, framing errors %lu, rx dropped %lu, checksum failures %lu\n",
+           (unsigned long)gps.uart_overruns, (unsigned long)gps.uart_framing_errors,
+           (unsigned long)gps.rx_dropped, (unsigned long)gps.checksum_failures);
+
+    printf("  %-10s %8s %8s %8s %10s\n", "sd op", "count", "errors", "stalls", "max ms");
+    for (int op = 0; op < SD_OP_COUNT; op++)
+    {
+        const sd_op_stats_t *s = &sd_latency_stats[op];
+        printf("  %-10s %8lu %8lu %8lu %10.3f\n", sd_op_names[op], (unsigned long)s->count,
+               (unsigned long)s->errors, (unsigned long)s->stalls, s->max_us / 1000.0);
+    }
+
+    flash_log_stats_t log;
+    flash_log_get_stats(&log);
+    printf("  flash log: appended %lu/%lu/%lu, on card %lu/%lu/%lu (sensors/GPS/baro), pending %lu, overwritten %lu, corrupt %lu;"
+           " %lu erases (max %.3f ms), %lu programs (max %.3f ms)\n",
+           (unsigned long)log.appended[FLASH_LOG_SENSORS], (unsigned long)log.appended[FLASH_LOG_GPS],
+           (unsigned long)log.appended[FLASH_LOG_BARO], (unsigned long)log.drained[FLASH_LOG_SENSORS],
+           (unsigned long)log.drained[FLASH_LOG_GPS], (unsigned long)log.drained[FLASH_LOG_BARO], (unsigned long)log.pending,
+           (unsigned long)(log.overwritten[FLASH_LOG_SENSORS] + log.overwritten[FLASH_LOG_GPS] + log.overwritten[FLASH_LOG_BARO]),
+           (unsigned long)log.corrupt, (unsigned long)flash_io_stats.erases, flash_io_stats.worst_erase_us / 1000.0,
+           (unsigned long)flash_io_stats.programs, flash_io_stats.worst_program_us / 1000.0);
+
+    printf("  flight:");
+    for (int phase = 0; phase < FLIGHT_PHASE_COUNT; phase++)
+    {
+        if (phase && !flight_phase_entered_us[phase]) continue;
+        printf(" %s %.1f s", flight_phase_names[phase], flight_phase_entered_us[phase] / 1e6);
+    }
+    printf("\n");
+
+    printf("  %-18s %10s %8s\n", "card file", "bytes", "lines");
+    for (int i = 0; i < sim_fatfs_file_count(); i++)
+    {
+        const uint8_t *data;
+        size_t size, lines = 0;
+        const char *name = sim_fatfs_file(i, &data, &size);
+
+        for (size_t k = 0; k < size; k++) lines += data[k] == '\n';
+        printf("  %-18s %10zu %8zu\n", name, size, lines);
+    }
+
+    radio_module_get_stats(&radio);
+    printf("  radio: queued %lu, sent %lu, dropped %lu, oversized %lu; ground received %u, lost %u\n",
+           (unsigned long)radio.queued, (unsigned long)radio.sent, (unsigned long)radio.dropped, (unsigned long)radio.oversized,
+           sim_stats[SIM_DEV_RADIO].conversions, sim_stats[SIM_DEV_RADIO].naks_injected);
+
+    printf("  %-14s %8s %10s %10s %10s\n", "e2e path", "count", "p50 ms", "p99 ms", "max ms");
+    for (int p = 0; p < E2E_PATH_COUNT; p++)
+    {
+        e2e_summary_t s;
+        e2e_latency_summary(p, &s);
+        printf("  %-14s %8lu %10.3f %10.3f %10.3f\n", e2e_path_names[p], (unsigned long)s.count,
+               s.p50_us / 1000.0, s.p99_us / 1000.0, s.max_us / 1000.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *data_path = NULL, *gps_path = NULL, *nmea_path = NULL, *out_dir = NULL;
+    double speed = 1.0;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-d") && i + 1 < argc) data_path = argv[++i];
+        else if (!strcmp(argv[i], "-g") && i + 1 < argc) gps_path = argv[++i];
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) nmea_path = argv[++i];
+        else if (!strcmp(argv[i], "-x") && i + 1 < argc) speed = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) out_dir = argv[++i];
+        else
+        {
+            data_path = gps_path = nmea_path = NULL;
+            break;
+        }
+    }
+
+    if ((!data_path && !gps_path && !nmea_path) || speed <= 0)
+    {
+        fprintf(stderr, "usage: %s [-d data_log.txt] [-g gps_log.csv] [-n capture.nmea] [-x speed] [-s seed] [-o dir]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *paths[3] = {data_path, gps_path, nmea_path};
+    bool (*const loaders[3])(const char *) = {sim_replay_load_data_log, sim_replay_load_gps_log, sim_replay_load_nmea};
+    for (int i = 0; i < 3; i++)
+    {
+        if (paths[i] && !loaders[i](paths[i]))
+        {
+            fprintf(stderr, "%s: cannot read %s\n", argv[0], paths[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *radio_log = NULL;
+    if (out_dir)
+    {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/radio_rx.txt", out_dir);
+        if (!(radio_log = fopen(path, "w")))
+        {
+            fprintf(stderr, "%s: cannot write %s\n", argv[0], path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const sim_replay_info_t *info = sim_replay_info();
+    printf("== replay at %gx: %.1f s recorded, %u sensor samples (%u skipped), %u GPS rows, %u sentences in %u epochs\n",
+           speed, info->duration_s, info->sensor_samples, info->skipped_samples,
+           info->gps_rows, info->nmea_sentences, info->nmea_epochs);
+
+    sim_init(seed);
+    sim_radio_log = radio_log;
+    sim_replay_start(speed);
+
+    clock_t host_start = clock();
+    bool stopped = sim_run_until(run_firmware, sim_replay_end_us() + AFTER_END_S * 1000000ULL);
+    double host_s = (double)(clock() - host_start) / CLOCKS_PER_SEC;
+
+    printf("  firmware %s after %.1f s simulated\n", stopped ? "stopped" : "returned", host_time_us / 1e6);
+    report();
+    fprintf(stderr, "host time %.2f s (%.0fx real time)\n", host_s, host_s > 0 ? host_time_us / 1e6 / host_s : 0);
+
+    bool ok = true;
+    if (radio_log) ok = fclose(radio_log) == 0;
+    sim_radio_log = NULL;
+    if (out_dir && !sim_fatfs_save(out_dir)) ok = false;
+    if (!ok)
+    {
+        fprintf(stderr, "%s: cannot write the card's files into %s\n", argv[0], out_dir);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,295 @@
+/** @file sensor_sim.c
+ ** @brief Host tool: runs the firmware's sensor and GPS drivers against the device models
+ * of tools/sim under injected faults.
+ * @details Every scenario starts from a fresh simulator, runs `init_all_sensors()` and then
+ * `read_all()` repeatedly, one read per simulated second, while the environment drifts.
+ * Each reading is compared with the environment it measured and reported as
+ * - failed: the driver flagged an error, or left the field untouched,
+ * - wrong: accepted by the driver but outside the model's resolution (e.g. a corrupted byte
+ *   that no checksum caught),
+ * together with the simulated time spent in `read_all()` and the I2C counters of the firmware
+ * (`i2c_device_stats`) and of the models (`sim_stats`).
+ *
+ * The GPS scenarios run `gps_init()` (receiver configuration over UBX) and then `gps_update()`
+ * every 10 ms, and report the fixes received and `gps_stats_t`.
+ *
+ * Usage: `sensor_sim [reads] [seed]` (default 300 reads, seed 1).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atm_sen_module.h"
+#include "gps_module.h"
+#include "sensor_conversion.h"
+#include "sim.h"
+
+#define GPS_RUN_S 60
+#define GPS_POLL_MS 10
+
+/** @brief Quantities checked per reading. */
+enum
+{
+    Q_PRESSURE = 0,
+    Q_TEMPERATURE,
+    Q_HUMIDITY,
+    Q_METHANE,
+    Q_AMMONIA,
+    Q_OXYGEN,
+    Q_COUNT
+};
+
+static const char *const quantity_names[Q_COUNT] = {"pressure", "temp", "humidity", "methane", "ammonia", "oxygen"};
+
+typedef struct
+{
+    const char *name;
+    void (*setup)(void);
+} scenario_t;
+
+static void nominal(void)
+{
+}
+
+static void naks(void)
+{
+    sim_faults[SIM_DEV_BMP280].nak_prob = 0.05;
+    sim_faults[SIM_DEV_SHTC3].nak_prob = 0.05;
+    sim_faults[SIM_DEV_O2].nak_prob = 0.05;
+}
+
+static void corrupt(void)
+{
+    sim_faults[SIM_DEV_BMP280].corrupt_prob = 0.01;
+    sim_faults[SIM_DEV_SHTC3].corrupt_prob = 0.01;
+    sim_faults[SIM_DEV_O2].corrupt_prob = 0.01;
+    sim_faults[SIM_DEV_MEMS].corrupt_prob = 0.01;
+}
+
+static void slow(void)
+{
+    // Beyond the fixed waits of the drivers (SHTC3 20 ms, O2 100 ms).
+    sim_faults[SIM_DEV_SHTC3].conversion_us = 25000;
+    sim_faults[SIM_DEV_O2].conversion_us = 120000;
+}
+
+static void stuck_shtc3(void)
+{
+    sim_faults[SIM_DEV_SHTC3].stuck = true;
+}
+
+static void stuck_o2(void)
+{
+    sim_faults[SIM_DEV_O2].stuck = true;
+}
+
+static void mems_disconnected(void)
+{
+    sim_faults[SIM_DEV_MEMS].stuck = true;
+}
+
+static void gnss_corrupt(void)
+{
+    sim_faults[SIM_DEV_GNSS].corrupt_prob = 0.001;
+}
+
+static void gnss_silent(void)
+{
+    sim_faults[SIM_DEV_GNSS].stuck = true;
+}
+
+static const scenario_t sensor_scenarios[] = {
+    {"nominal", nominal},
+    {"5% NAK", naks},
+    {"1% corrupt bytes", corrupt},
+    {"slow conversions", slow},
+    {"SHTC3 bus stuck", stuck_shtc3},
+    {"O2 bus stuck", stuck_o2},
+    {"MEMS disconnected", mems_disconnected},
+};
+
+static const scenario_t gps_scenarios[] = {
+    {"nominal", nominal},
+    {"0.1% corrupt bytes", gnss_corrupt},
+    {"receiver silent", gnss_silent},
+};
+
+/** @brief Resolution of each quantity through the model and the driver. */
+static double tolerance(int q)
+{
+    double lsb_v = ADC_VREF / ADC_FULL_SCALE;
+
+    switch (q)
+    {
+        case Q_PRESSURE: return 1.0;
+        case Q_TEMPERATURE: return 0.01;
+        case Q_HUMIDITY: return 0.01;
+        case Q_METHANE: return 3 * lsb_v * METHANE_SENSITIVITY;
+        case Q_AMMONIA: return 3 * lsb_v * AMMONIA_SENSITIVITY;
+        default: return 0.051;
+    }
+}
+
+/** @brief Slow drift of the environment between reads. */
+static void drift(void)
+{
+    sim_env.pressure_pa += (sim_random() - 0.5) * 20.0;
+    sim_env.temperature_c += (sim_random() - 0.5) * 0.2;
+    sim_env.humidity_pct = fmin(100, fmax(0, sim_env.humidity_pct + (sim_random() - 0.5)));
+    sim_env.methane_ppm = fmax(10, sim_env.methane_ppm + (sim_random() - 0.5) * 2.0);
+    sim_env.ammonia_ppm = fmax(5, sim_env.ammonia_ppm + (sim_random() - 0.5) * 0.5);
+    sim_env.o2_pct = fmin(25, fmax(15, sim_env.o2_pct + (sim_random() - 0.5) * 0.2));
+}
+
+static void run_sensors(const scenario_t *sc, int reads, uint64_t seed)
+{
+    unsigned failed[Q_COUNT] = {0}, wrong[Q_COUNT] = {0};
+    double worst[Q_COUNT] = {0};
+    uint64_t total_us = 0, max_us = 0;
+
+    sim_init(seed);
+    memset(i2c_device_stats, 0, sizeof(i2c_device_stats));
+    sc->setup();
+
+    uint64_t init_start = host_time_us;
+    init_all_sensors();
+    uint64_t init_us = host_time_us - init_start;
+
+    for (int i = 0; i < reads; i++)
+    {
+        sensor_readings_t r;
+        double expected[Q_COUNT] = {
+            sim_env.pressure_pa, sim_env.temperature_c, sim_env.humidity_pct,
+            sim_env.methane_ppm, sim_env.ammonia_ppm, sim_env.o2_pct,
+        };
+
+        // NaN marks a field the driver did not write.
+        r.pressure_pa = NAN;
+        r.temperature_c = r.humidity_pct = r.methane_ppm = r.ammonia_ppm = r.oxygen_pct = NAN;
+
+        uint64_t start = host_time_us;
+        read_all(&r);
+        uint64_t us = host_time_us - start;
+        total_us += us;
+        if (us > max_us) max_us = us;
+
+        bool shtc3_failed = r.temperature_c == 0.0f && r.humidity_pct == 0.0f;
+        double got[Q_COUNT] = {r.pressure_pa, r.temperature_c, r.humidity_pct, r.methane_ppm, r.ammonia_ppm, r.oxygen_pct};
+        bool flagged[Q_COUNT] = {
+            r.pressure_pa == -1.0, shtc3_failed, shtc3_failed,
+            r.methane_ppm == -1.0f, r.ammonia_ppm == -1.0f, false,
+        };
+
+        for (int q = 0; q < Q_COUNT; q++)
+        {
+            if (flagged[q] || isnan(got[q]))
+            {
+                failed[q]++;
+                continue;
+            }
+            double err = fabs(got[q] - expected[q]);
+            if (err > tolerance(q)) wrong[q]++;
+            if (err > worst[q]) worst[q] = err;
+        }
+
+        // One read per second, as the flight loop does.
+        uint64_t next = start + 1000000;
+        if (host_time_us < next) sleep_us(next - host_time_us);
+        drift();
+    }
+
+    printf("== %s: init %.1f ms, read_all mean %.1f ms, max %.1f ms\n",
+           sc->name, init_us / 1000.0, total_us / 1000.0 / reads, max_us / 1000.0);
+    printf("  %-10s %8s %8s %12s\n", "quantity", "failed", "wrong", "worst error");
+    for (int q = 0; q < Q_COUNT; q++)
+    {
+        printf("  %-10s %8u %8u %12.4f\n", quantity_names[q], failed[q], wrong[q], worst[q]);
+    }
+
+    printf("  %-10s %9s %8s %8s\n", "i2c", "transfers", "errors", "timeouts");
+    for (int d = 0; d < I2C_DEV_COUNT; d++)
+    {
+        const i2c_device_stats_t *s = &i2c_device_stats[d];
+        if (s->transfers) printf("  %-10s %9u %8u %8u\n", i2c_device_names[d], s->transfers, s->errors, s->timeouts);
+    }
+
+    printf("  %-10s %9s %8s %8s %8s %8s %9s\n", "model", "transfers", "naks", "busy", "timeouts", "hangs", "corrupted");
+    for (int d = 0; d < SIM_DEV_GNSS; d++)
+    {
+        const sim_stats_t *s = &sim_stats[d];
+        printf("  %-10s %9u %8u %8u %8u %8u %9u\n", sim_device_names[d],
+               s->transfers, s->naks_injected, s->busy_naks, s->timeouts, s->hangs, s->bytes_corrupted);
+    }
+    printf("\n");
+}
+
+static void run_gps(const scenario_t *sc, uint64_t seed)
+{
+    static gps_stats_t before;
+    gps_stats_t after;
+    unsigned updates = 0, fixes = 0;
+
+    sim_init(seed);
+    sc->setup();
+    gps_get_stats(&before);
+
+    uint64_t init_start = host_time_us;
+    gps_init();
+    while (!gps_configure_step()) sleep_ms(1);
+    uint64_t init_us = host_time_us - init_start;
+
+    uint64_t end = host_time_us + GPS_RUN_S * 1000000ULL;
+    uint64_t last_fix_us = 0;
+
+    while (host_time_us < end)
+    {
+        if (gps_update())
+        {
+            gps_data_t data;
+
+            updates++;
+            gps_get_data(&data);
+            if (data.fix && data.timestamp_us != last_fix_us)
+            {
+                fixes++;
+                last_fix_us = data.timestamp_us;
+            }
+        }
+        sleep_ms(GPS_POLL_MS);
+    }
+    gps_get_stats(&after);
+
+    printf("== GPS %s: init %.1f ms, %u updates, %u fixes in %d s\n",
+           sc->name, init_us / 1000.0, updates, fixes, GPS_RUN_S);
+    printf("  sentences sent %u, bytes corrupted %u\n",
+           sim_stats[SIM_DEV_GNSS].transfers, sim_stats[SIM_DEV_GNSS].bytes_corrupted);
+    printf("  overruns %u, framing errors %u, rx dropped %u, checksum failures %u\n\n",
+           after.uart_overruns - before.uart_overruns,
+           after.uart_framing_errors - before.uart_framing_errors,
+           after.rx_dropped - before.rx_dropped,
+           after.checksum_failures - before.checksum_failures);
+}
+
+int main(int argc, char **argv)
+{
+    int reads = (argc > 1) ? atoi(argv[1]) : 300;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1;
+
+    if (reads <= 0)
+    {
+        fprintf(stderr, "usage: %s [reads] [seed]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < sizeof(sensor_scenarios) / sizeof(sensor_scenarios[0]); i++)
+    {
+        run_sensors(&sensor_scenarios[i], reads, seed);
+    }
+    for (size_t i = 0; i < sizeof(gps_scenarios) / sizeof(gps_scenarios[0]); i++)
+    {
+        run_gps(&gps_scenarios[i], seed);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/** @file sim.c
+ ** @brief Simulator core: clock hook, environment, fault configuration and random numbers.
+ */
+
+#include <setjmp.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "sim.h"
+
+sim_env_t sim_env;
+sim_faults_t sim_faults[SIM_DEV_COUNT];
+sim_stats_t sim_stats[SIM_DEV_COUNT];
+
+const char *const sim_device_names[SIM_DEV_COUNT] = {
+    [SIM_DEV_BMP280] = "BMP280",
+    [SIM_DEV_SHTC3] = "SHTC3",
+    [SIM_DEV_O2] = "O2",
+    [SIM_DEV_MEMS] = "MEMS",
+    [SIM_DEV_GNSS] = "GNSS",
+    [SIM_DEV_SD] = "SD",
+    [SIM_DEV_RADIO] = "nRF905",
+};
+
+static uint64_t rng_state = 1;
+
+// sim_run_until(): where the clock leaves the code under test, and when.
+static jmp_buf *run_exit;
+static uint64_t run_end_us = UINT64_MAX;
+
+// Conversion times from the datasheets: BMP280 with x4 pressure / x1 temperature
+// oversampling (max), SHTC3 normal mode (max), ADC sample. The O2 sensor answers within
+// the 100 ms the driver waits; the GNSS outputs its epoch shortly after the second. A
+// microSD card programs a block in about a millisecond; the nRF905 settles into TX in 650 us.
+static const uint32_t default_conversion_us[SIM_DEV_COUNT] = {
+    [SIM_DEV_BMP280] = 13300,
+    [SIM_DEV_SHTC3] = 12100,
+    [SIM_DEV_O2] = 50000,
+    [SIM_DEV_MEMS] = 2,
+    [SIM_DEV_GNSS] = 50000,
+    [SIM_DEV_SD] = 1000,
+    [SIM_DEV_RADIO] = 650,
+};
+
+void sim_init(uint64_t seed)
+{
+    host_time_us = 0;
+    rng_state = seed ? seed : 1;
+
+    sim_env = (sim_env_t){
+        .pressure_pa = 101325.0,
+        .temperature_c = 20.0,
+        .humidity_pct = 50.0,
+        .o2_pct = 20.9,
+        .methane_ppm = 50.0,
+        .ammonia_ppm = 10.0,
+        .latitude_deg = 51.1156808,
+        .longitude_deg = 17.0252815,
+        .altitude_m = 120.0,
+        .satellites = 9,
+        .fix = true,
+        .utc_at_boot_s = 1782864000, // 2026-07-01 00:00:00 UTC
+    };
+
+    for (int d = 0; d < SIM_DEV_COUNT; d++)
+    {
+        sim_faults[d] = (sim_faults_t){ .conversion_us = default_conversion_us[d] };
+    }
+    memset(sim_stats, 0, sizeof(sim_stats));
+
+    sim_bmp280_reset();
+    sim_shtc3_reset();
+    sim_o2_reset();
+    sim_uart_reset();
+    sim_gnss_reset();
+    sim_flight_reset();
+    sim_fatfs_reset();
+    sim_sd_reset();
+    sim_radio_reset();
+    sim_replay_reset();
+    sim_flash_reset();
+}
+
+double sim_random(void)
+{
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (double)((rng_state * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+
+bool sim_chance(double p)
+{
+    return p > 0 && sim_random() < p;
+}
+
+void sim_corrupt(sim_device_t dev, uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (sim_chance(sim_faults[dev].corrupt_prob))
+        {
+            data[i] ^= (uint8_t)(1u << (int)(sim_random() * 8));
+            sim_stats[dev].bytes_corrupted++;
+        }
+    }
+}
+
+bool sim_run_until(void (*fn)(void), uint64_t end_us)
+{
+    jmp_buf exit;
+    bool stopped = true;
+
+    if (setjmp(exit) == 0)
+    {
+        run_exit = &exit;
+        run_end_us = end_us;
+        fn();
+        stopped = false;
+    }
+    run_exit = NULL;
+    run_end_us = UINT64_MAX;
+    return stopped;
+}
+
+void host_advance_to(uint64_t t_us)
+{
+    if (run_exit && host_time_us >= run_end_us) longjmp(*run_exit, 1);
+
+    do
+    {
+        // Step from event to event (flight samples, recorded output, byte arrivals, receiver
+        // output, end of a radio packet) so that the environment, the UART interrupt and DR
+        // change when they would on the target rather than once per sleep.
+        uint64_t next = sim_uart_next_event_us();
+        uint64_t gnss = sim_gnss_next_event_us();
+        uint64_t flight = sim_flight_next_event_us();
+        uint64_t replay = sim_replay_next_event_us();
+        uint64_t radio = sim_radio_next_event_us();
+
+        if (gnss < next) next = gnss;
+        if (flight < next) next = flight;
+        if (replay < next) next = replay;
+        if (radio < next) next = radio;
+        if (next > t_us) next = t_us;
+        if (next > host_time_us) host_time_us = next;
+
+        sim_flight_step();
+        sim_replay_step();
+        sim_gnss_step();
+        sim_uart_pump();
+        sim_radio_step();
+    } while (host_time_us < t_us);
+}
+
+void host_gpio_put(unsigned int gpio, bool level)
+{
+    bool changed = host_gpio_level[gpio] != level;
+
+    host_gpio_level[gpio] = level;
+    if (changed) sim_radio_gpio(gpio, level);
+}
@@ -0,0 +1,224 @@
+/** @file sim.h
+ ** @brief Behavioural device models behind the host SDK stand-ins (tools/host/include).
+ * @details The firmware's drivers run unmodified on the host against these models:
+ * - BMP280 (0x76): register map, datasheet calibration constants, raw ADC values computed
+ *   from the environment by inverting the compensation, normal and forced mode timing,
+ * - SHTC3 (0x70): command set, sleep/wake-up, conversion time (NAK while busy), CRC-8,
+ * - DFRobot O2 (0x74): 9-byte command/response protocol with checksum,
+ * - MEMS gas sensors: ADC voltages on GPIO 26 and 28,
+ * - GNSS receiver on uart0: NMEA output (GGA, GLL, GSA, GSV, RMC, VTG, TXT) at the receiver's
+ *   navigation rate and baud rate, and the UBX-CFG messages the firmware sends (MSG, PRT,
+ *   RATE, INF) with ACKs,
+ * - microSD card: FatFs volume (files in memory) and the timing of each block transfer,
+ * - nRF905 radio on spi0: ShockBurst transmission time from its configuration, DR, the
+ *   ground station receiving the packets, and packets sent up by the ground station,
+ * - QSPI flash: NOR erase/program semantics and timing, read through the XIP window.
+ *
+ * The models read the physical state from `sim_env`. Every device has a `sim_faults_t`:
+ * conversion time, NAK probability, stuck bus (every transfer times out, the GNSS goes
+ * silent, the card is missing, the radio never finishes a packet), corrupt-byte probability
+ * and, for the card, stalls. Faults are drawn from a seeded generator, so a run is
+ * reproducible.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// DATA STRUCTURES
+
+/** @brief Simulated devices. */
+typedef enum
+{
+    SIM_DEV_BMP280 = 0,
+    SIM_DEV_SHTC3,
+    SIM_DEV_O2,
+    SIM_DEV_MEMS,
+    SIM_DEV_GNSS,
+    SIM_DEV_SD,
+    SIM_DEV_RADIO,
+    SIM_DEV_COUNT
+} sim_device_t;
+
+/** @brief Physical state the models measure. */
+typedef struct
+{
+    double pressure_pa;
+    double temperature_c;
+    double humidity_pct;
+    double o2_pct;
+    double methane_ppm;
+    double ammonia_ppm;
+    double latitude_deg; /// Positive north.
+    double longitude_deg; /// Positive east.
+    double altitude_m; /// Above mean sea level.
+    double ground_speed_mps;
+    double course_deg; /// Course over ground, clockwise from north.
+    uint8_t satellites;
+    bool fix;
+    int64_t utc_at_boot_s; /// Unix time of simulated time 0.
+} sim_env_t;
+
+/** @brief Fault and timing configuration of one device.
+ * @details For the card a "transfer" is a block operation (`disk_read()` / `disk_write()`) and
+ * a NAK is an operation that fails; for the radio it is a packet and a NAK is a packet lost on
+ * the link.
+ */
+typedef struct
+{
+    uint32_t conversion_us; /// Measurement time (GNSS: delay from the epoch to its output, SD: block programming time, radio: TX settling time).
+    double nak_prob; /// Probability that a transfer is not acknowledged.
+    double corrupt_prob; /// Probability that a byte sent by the device has one bit flipped.
+    bool stuck; /// The device holds the bus (every transfer times out) or, for the GNSS, goes silent.
+    double stall_prob; /// Probability that a write is held up by `stall_us` (SD: internal garbage collection).
+    uint32_t stall_us;
+} sim_faults_t;
+
+/** @brief What the models did, per device. */
+typedef struct
+{
+    uint32_t transfers; /// Transfers addressed to the device (GNSS: sentences sent).
+    uint32_t naks_injected; /// Transfers NAKed by `nak_prob`.
+    uint32_t busy_naks; /// Transfers NAKed because a conversion was still running.
+    uint32_t timeouts; /// Transfers that timed out on a stuck bus.
+    uint32_t hangs; /// Blocking transfers on a stuck bus (they would never return on the target).
+    uint32_t bytes_corrupted; /// Bytes altered by `corrupt_prob`.
+    uint32_t conversions; /// Measurements completed (SD: blocks written, radio: packets received on the ground).
+    uint32_t stalls; /// Writes held up by `stall_us`.
+} sim_stats_t;
+
+// FUNCTIONS
+
+/** @brief Current physical state, read by every model. */
+extern sim_env_t sim_env;
+
+/** @brief Fault configuration per `sim_device_t`. */
+extern sim_faults_t sim_faults[SIM_DEV_COUNT];
+
+/** @brief Model statistics per `sim_device_t`. */
+extern sim_stats_t sim_stats[SIM_DEV_COUNT];
+
+/** @brief Display names of the devices, indexed by `sim_device_t`. */
+extern const char *const sim_device_names[SIM_DEV_COUNT];
+
+/** @brief Resets the clock, the environment (sea level, 20 C), the faults (datasheet conversion
+ * times, no errors), the statistics and every model, and seeds the fault generator.
+ */
+extern void sim_init(uint64_t seed);
+
+/** @brief Uniform random number in [0, 1) from the seeded generator. */
+extern double sim_random(void);
+
+/** @brief true with probability `p`. */
+extern bool sim_chance(double p);
+
+/** @brief Applies `corrupt_prob` of a device to bytes it is sending. */
+extern void sim_corrupt(sim_device_t dev, uint8_t *data, size_t len);
+
+/** @brief Runs `fn` until it returns or the simulated time reaches `end_us`.
+ * @details For code that never returns, such as the firmware's main loop: the clock leaves it
+ * (`longjmp`) at the first timer read or sleep at or after `end_us`.
+ ** @return true if the run was stopped at `end_us`.
+ */
+extern bool sim_run_until(void (*fn)(void), uint64_t end_us);
+
+/** @brief Files on the simulated card (sim_fatfs.c): their count, and the name and content of
+ * the i-th, as a reader would find them after power is removed (up to the last `f_sync()` /
+ * `f_close()`).
+ */
+extern int sim_fatfs_file_count(void);
+extern const char *sim_fatfs_file(int i, const uint8_t **data, size_t *size);
+
+/** @brief Writes every file on the simulated card into the host directory `dir`.
+ ** @return false if a file could not be written.
+ */
+extern bool sim_fatfs_save(const char *dir);
+
+/** @brief Receives every packet the ground station decodes, one line per packet with its arrival
+ * time (NULL, the default: not logged).
+ */
+extern FILE *sim_radio_log;
+
+/** @brief Has the ground station send a packet up (padded with zeros to the payload width).
+ * @details The radio receives it the next time it listens (RX mode), raising DR until the
+ * payload is read. Packets sent while it does not listen wait for it.
+ */
+extern void sim_radio_uplink(const uint8_t *payload, size_t len);
+
+// Model hooks, called by sim.c and by the SDK stand-ins.
+
+extern void sim_bmp280_reset(void);
+extern void sim_shtc3_reset(void);
+extern void sim_o2_reset(void);
+extern void sim_uart_reset(void);
+extern void sim_gnss_reset(void);
+extern void sim_flight_reset(void);
+extern void sim_fatfs_reset(void);
+extern void sim_sd_reset(void);
+extern void sim_radio_reset(void);
+extern void sim_replay_reset(void);
+extern void sim_flash_reset(void);
+
+/** @brief I2C transfers reaching a device model: return the byte count, or
+ * `PICO_ERROR_GENERIC` to NAK (e.g. while a conversion is running).
+ */
+extern int sim_bmp280_write(const uint8_t *src, size_t len);
+extern int sim_bmp280_read(uint8_t *dst, size_t len);
+extern int sim_shtc3_write(const uint8_t *src, size_t len);
+extern int sim_shtc3_read(uint8_t *dst, size_t len);
+extern int sim_o2_write(const uint8_t *src, size_t len);
+extern int sim_o2_read(uint8_t *dst, size_t len);
+
+/** @brief Simulated time of the next event of a model (UINT64_MAX: none pending). */
+extern uint64_t sim_uart_next_event_us(void);
+extern uint64_t sim_gnss_next_event_us(void);
+extern uint64_t sim_flight_next_event_us(void);
+extern uint64_t sim_radio_next_event_us(void);
+extern uint64_t sim_replay_next_event_us(void);
+
+/** @brief Refreshes `sim_env` from the flight profile when a sample is due (sim_flight.c). */
+extern void sim_flight_step(void);
+
+/** @brief Refreshes `sim_env` from the recording and sends the receiver output due by now (sim_replay.c). */
+extern void sim_replay_step(void);
+
+/** @brief Ends a radio transmission that is due by now (raises DR). */
+extern void sim_radio_step(void);
+
+/** @brief Output pin changes reaching the radio model. */
+extern void sim_radio_gpio(unsigned int gpio, bool level);
+
+/** @brief Moves received bytes into the UART FIFO and runs the UART interrupt handler. */
+extern void sim_uart_pump(void);
+
+/** @brief Produces the receiver output due by now and queues it on the UART. */
+extern void sim_gnss_step(void);
+
+/** @brief A byte written by the firmware to the GNSS UART at `baudrate`. */
+extern void sim_gnss_receive(uint8_t byte, uint32_t baudrate);
+
+/** @brief Turns the receiver's own navigation output (NMEA, NAV-PVT) on or off; configuration
+ * ACKs are always sent. Off while a recording supplies the output.
+ */
+extern void sim_gnss_set_navigation_output(bool on);
+
+/** @brief Sends a recorded NMEA sentence (without its line end) through the receiver: at its baud
+ * rate, with its faults, and only if the firmware has not turned the message type off and it
+ * fits into the transmit buffer.
+ */
+extern void sim_gnss_send_sentence(const char *sentence);
+
+/** @brief MGA-INI aiding messages the receiver has taken since reset. */
+extern uint32_t sim_gnss_aiding_count(void);
+
+/** @brief Queues bytes sent by the receiver; they arrive at `baudrate`. */
+extern void sim_uart_transmit(const uint8_t *data, size_t len, uint32_t baudrate);
+
+/** @brief Bytes sent by the receiver that are still on the line. */
+extern uint32_t sim_uart_tx_pending(void);
+
+#endif // SIM_H
@@ -0,0 +1,55 @@
+/** @file sim_adc.c
+ ** @brief ADC behind the host `hardware/adc.h`: MEMS gas sensor voltages.
+ * @details The sensors on GPIO 26 (methane) and 28 (ammonia) output a voltage proportional to
+ * the concentration in `sim_env` (sensitivities of atm_sen_module.h), sampled by a 12-bit ADC
+ * against 3.3 V with +-2 LSB of noise. A stuck MEMS fault reads 0 (sensor disconnected),
+ * corruption replaces a sample with a random one. Each conversion takes `conversion_us`.
+ */
+
+#include "hardware/adc.h"
+#include "atm_sen_module.h"
+#include "sensor_conversion.h"
+#include "sim.h"
+
+static uint selected_input;
+
+void adc_init(void)
+{
+}
+
+void adc_gpio_init(uint gpio)
+{
+    (void)gpio;
+}
+
+void adc_select_input(uint input)
+{
+    selected_input = input;
+}
+
+uint16_t adc_read(void)
+{
+    const sim_faults_t *f = &sim_faults[SIM_DEV_MEMS];
+    sim_stats_t *s = &sim_stats[SIM_DEV_MEMS];
+    double volts = 0;
+
+    sleep_us(f->conversion_us);
+    s->transfers++;
+    s->conversions++;
+
+    if (f->stuck) return 0;
+
+    if (selected_input + 26 == PIN_METHANE) volts = sim_env.methane_ppm / METHANE_SENSITIVITY;
+    else if (selected_input + 26 == PIN_AMMONIA) volts = sim_env.ammonia_ppm / AMMONIA_SENSITIVITY;
+
+    double raw = volts / ADC_VREF * ADC_FULL_SCALE + (sim_random() * 4.0 - 2.0);
+    if (raw < 0) raw = 0;
+    if (raw > ADC_FULL_SCALE) raw = ADC_FULL_SCALE;
+
+    if (sim_chance(f->corrupt_prob))
+    {
+        s->bytes_corrupted++;
+        raw = sim_random() * ADC_FULL_SCALE;
+    }
+    return (uint16_t)(raw + 0.5);
+}
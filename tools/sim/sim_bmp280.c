@@ -0,0 +1,224 @@
+/** @file sim_bmp280.c
+ ** @brief BMP280 model: register map, calibration, measurement timing.
+ * @details The calibration block holds the example constants of the datasheet (section 3.12).
+ * The raw ADC words for the current `sim_env` are found by searching the 20-bit range with the
+ * same integer compensation the driver uses (temperature rises with its raw value, pressure
+ * falls with it), so a reading through lib/bmp280 reproduces the environment to within the
+ * compensation's resolution.
+ *
+ * Measurements take `conversion_us`. In normal mode they repeat every conversion plus the
+ * standby time of `config`; in forced mode one is made and the device returns to sleep. The
+ * data registers are updated between transactions only (the device shadows them during a
+ * burst read), so separate pressure and temperature reads may come from different
+ * measurements, as on the real part.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "sim.h"
+
+#define REG_CALIB 0x88
+#define REG_ID 0xD0
+#define REG_RESET 0xE0
+#define REG_STATUS 0xF3
+#define REG_CTRL_MEAS 0xF4
+#define REG_CONFIG 0xF5
+#define REG_PRESS_MSB 0xF7
+#define REG_TEMP_MSB 0xFA
+
+#define CHIP_ID 0x58
+#define RESET_VAL 0xB6
+#define STATUS_MEASURING 0x08
+
+#define MODE_SLEEP 0x00
+#define MODE_NORMAL 0x03
+
+#define RAW_MAX 0xFFFFF
+
+typedef struct
+{
+    uint16_t t1;
+    int16_t t2, t3;
+    uint16_t p1;
+    int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+} calib_t;
+
+static const calib_t calib = {
+    27504, 26435, -1000,
+    36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+};
+
+// Standby time per config.t_sb [us].
+static const uint32_t standby_us[8] = {500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000};
+
+static uint8_t regs[256];
+static uint8_t reg_ptr;
+static uint64_t conversion_start_us;
+static bool converting;
+
+// Compensation as in lib/bmp280/bmp280_i2c.c (with the shifts of signed values written as
+// multiplications): temperature in 0.01 C, pressure in Pa/256.
+static int32_t compensate_t(int32_t raw, int32_t *t_fine)
+{
+    int32_t var1 = ((((raw >> 3) - ((int32_t)calib.t1 << 1))) * ((int32_t)calib.t2)) >> 11;
+    int32_t var2 = (((((raw >> 4) - ((int32_t)calib.t1)) * ((raw >> 4) - ((int32_t)calib.t1))) >> 12) * ((int32_t)calib.t3)) >> 14;
+
+    *t_fine = var1 + var2;
+    return (*t_fine * 5 + 128) >> 8;
+}
+
+static int64_t compensate_p(int32_t raw, int32_t t_fine)
+{
+    int64_t var1 = ((int64_t)t_fine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)calib.p6;
+    var2 = var2 + var1 * (int64_t)calib.p5 * 131072;
+    var2 = var2 + (((int64_t)calib.p4) << 35);
+    var1 = ((var1 * var1 * (int64_t)calib.p3) >> 8) + var1 * (int64_t)calib.p2 * 4096;
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib.p1) >> 33;
+    if (var1 == 0) return 0;
+
+    int64_t p = 1048576 - raw;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)calib.p9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)calib.p8) * p) >> 19;
+    return ((p + var1 + var2) >> 8) + (int64_t)calib.p7 * 16;
+}
+
+static void put_raw(uint8_t reg, int32_t raw)
+{
+    regs[reg] = (uint8_t)(raw >> 12);
+    regs[reg + 1] = (uint8_t)(raw >> 4);
+    regs[reg + 2] = (uint8_t)(raw << 4);
+}
+
+/** @brief Latches a measurement of the current environment into the data registers. */
+static void measure(void)
+{
+    int32_t target_t = (int32_t)lround(sim_env.temperature_c * 100.0);
+    int64_t target_p = llround(sim_env.pressure_pa * 256.0);
+    int32_t lo = 0, hi = RAW_MAX, t_fine;
+
+    // Smallest raw temperature that compensates to at least the target.
+    while (lo < hi)
+    {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (compensate_t(mid, &t_fine) < target_t) lo = mid + 1;
+        else hi = mid;
+    }
+    int32_t temp_raw = lo;
+    compensate_t(temp_raw, &t_fine);
+
+    // Smallest raw pressure that compensates to at most the target.
+    lo = 0;
+    hi = RAW_MAX;
+    while (lo < hi)
+    {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (compensate_p(mid, t_fine) > target_p) lo = mid + 1;
+        else hi = mid;
+    }
+
+    put_raw(REG_PRESS_MSB, lo);
+    put_raw(REG_TEMP_MSB, temp_raw);
+    sim_stats[SIM_DEV_BMP280].conversions++;
+}
+
+/** @brief Brings the measurement cycle up to the current time (called once per transaction). */
+static void update(void)
+{
+    uint8_t mode = regs[REG_CTRL_MEAS] & 0x03;
+    uint32_t conversion = sim_faults[SIM_DEV_BMP280].conversion_us;
+
+    if (converting && host_time_us >= conversion_start_us + conversion)
+    {
+        measure();
+        if (mode == MODE_NORMAL)
+        {
+            // Skip the cycles nobody observed; the registers hold the latest one.
+            uint64_t period = conversion + standby_us[regs[REG_CONFIG] >> 5];
+            uint64_t cycles = (host_time_us - conversion_start_us) / period;
+
+            conversion_start_us += cycles * period;
+            if (host_time_us >= conversion_start_us + conversion) conversion_start_us += period;
+        }
+        else
+        {
+            converting = false;
+            regs[REG_CTRL_MEAS] &= ~0x03;
+        }
+    }
+
+    regs[REG_STATUS] = (converting && host_time_us >= conversion_start_us) ? STATUS_MEASURING : 0;
+}
+
+void sim_bmp280_reset(void)
+{
+    memset(regs, 0, sizeof(regs));
+    const int16_t words[12] = {
+        (int16_t)calib.t1, calib.t2, calib.t3,
+        (int16_t)calib.p1, calib.p2, calib.p3, calib.p4, calib.p5, calib.p6, calib.p7, calib.p8, calib.p9,
+    };
+    for (int i = 0; i < 12; i++)
+    {
+        regs[REG_CALIB + 2 * i] = (uint8_t)words[i];
+        regs[REG_CALIB + 2 * i + 1] = (uint8_t)((uint16_t)words[i] >> 8);
+    }
+    regs[REG_ID] = CHIP_ID;
+    put_raw(REG_PRESS_MSB, 0x80000);
+    put_raw(REG_TEMP_MSB, 0x80000);
+    reg_ptr = 0;
+    converting = false;
+}
+
+static void write_reg(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+        case REG_RESET:
+            if (value == RESET_VAL) sim_bmp280_reset();
+            break;
+        case REG_CTRL_MEAS:
+        {
+            uint8_t old_mode = regs[reg] & 0x03;
+            uint8_t mode = value & 0x03;
+
+            regs[reg] = value;
+            if (mode == MODE_SLEEP) converting = false;
+            else if (mode != MODE_NORMAL || old_mode != MODE_NORMAL)
+            {
+                converting = true;
+                conversion_start_us = host_time_us;
+            }
+            break;
+        }
+        case REG_CONFIG:
+            regs[reg] = value;
+            break;
+        default:
+            break; // Read-only
+    }
+}
+
+int sim_bmp280_write(const uint8_t *src, size_t len)
+{
+    update();
+    if (len > 0) reg_ptr = src[0];
+
+    // Register address / value pairs.
+    for (size_t i = 0; i + 1 < len; i += 2)
+    {
+        write_reg(src[i], src[i + 1]);
+    }
+    return (int)len;
+}
+
+int sim_bmp280_read(uint8_t *dst, size_t len)
+{
+    update();
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = regs[reg_ptr++];
+    }
+    return (int)len;
+}
@@ -0,0 +1,394 @@
+/** @file sim_fatfs.c
+ ** @brief FatFs behind the host `ff.h`: a FAT32 volume on the simulated card (sim_sd.c).
+ * @details File contents are kept in memory. What is modelled is the sequence of block
+ * operations FatFs R0.15 issues for the calls the firmware makes, so that their time and
+ * failures come from the card model:
+ * - `f_mount(..., 1)`: card initialization if needed, then the MBR, the volume boot record
+ *   and FSInfo, every time (mounting invalidates the sector window),
+ * - `f_open()`: the directory sectors up to the entry; with `FA_OPEN_APPEND` the FAT sectors
+ *   of the cluster chain and the partial last sector,
+ * - `f_write()`: a sector is written when the file position leaves it; a new cluster updates
+ *   the FAT through the window,
+ * - `f_sync()` / `f_close()`: the dirty sector, the directory entry (size, `get_fattime()`),
+ *   the FAT window (both copies) and FSInfo.
+ * The directory and FAT share the single sector window of the volume, as in FatFs.
+ *
+ * A file holds what the card would show after power is removed: its size is the one in the
+ * directory entry, updated by `f_sync()` / `f_close()` only.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "diskio.h"
+#include "sim.h"
+
+#define MAX_FILES 32
+#define MAX_NAME 64
+
+#define SECTOR_SIZE 512
+#define CLUSTER_SECTORS 64
+#define CLUSTER_BYTES (CLUSTER_SECTORS * SECTOR_SIZE)
+#define FS_FAT32 3
+
+// Volume layout: one partition, 32 reserved sectors, two FATs, root directory in cluster 2.
+#define PARTITION_LBA 8192
+#define FSINFO_LBA (PARTITION_LBA + 1)
+#define FAT_LBA (PARTITION_LBA + 32)
+#define FAT_SECTORS 1904
+#define DATA_LBA (FAT_LBA + 2 * FAT_SECTORS)
+#define DIR_LBA DATA_LBA
+#define ENTRIES_PER_SECTOR 16
+#define CLUSTERS_PER_FAT_SECTOR 128
+#define FILE_CLUSTERS 4096 /// Clusters reserved per file (128 MiB): files are contiguous.
+#define NO_SECTOR 0xFFFFFFFFu
+
+#define FA_MODIFIED 0x40
+
+typedef struct
+{
+    char name[MAX_NAME];
+    uint8_t *data;
+    size_t capacity;
+    FSIZE_t dir_size; /// Size in the directory entry.
+    DWORD mtime; /// Modification time in the directory entry.
+} file_t;
+
+static file_t files[MAX_FILES];
+static int file_count;
+static FATFS *volume;
+static BYTE window[SECTOR_SIZE]; /// Sector window of the volume.
+static BYTE sector_buf[SECTOR_SIZE]; /// Data sector of the open file.
+
+void sim_fatfs_reset(void)
+{
+    for (int i = 0; i < file_count; i++) free(files[i].data);
+    memset(files, 0, sizeof(files));
+    file_count = 0;
+    volume = NULL;
+}
+
+static DWORD first_cluster(int file)
+{
+    return 3 + (DWORD)file * FILE_CLUSTERS;
+}
+
+static LBA_t data_sector(int file, FSIZE_t offset)
+{
+    return DATA_LBA + (first_cluster(file) - 2) * CLUSTER_SECTORS + offset / SECTOR_SIZE;
+}
+
+static LBA_t fat_sector(DWORD cluster)
+{
+    return FAT_LBA + cluster / CLUSTERS_PER_FAT_SECTOR;
+}
+
+static LBA_t dir_sector(int entry)
+{
+    // Entry 0 is the volume label.
+    return DIR_LBA + (LBA_t)(entry + 1) / ENTRIES_PER_SECTOR;
+}
+
+static FRESULT sync_window(FATFS *fs)
+{
+    if (!fs->wflag) return FR_OK;
+
+    if (disk_write(0, window, fs->winsect, 1) != RES_OK) return FR_DISK_ERR;
+    // The FAT is mirrored in the second copy.
+    if (fs->winsect >= FAT_LBA && fs->winsect < FAT_LBA + FAT_SECTORS)
+    {
+        if (disk_write(0, window, fs->winsect + FAT_SECTORS, 1) != RES_OK) return FR_DISK_ERR;
+    }
+    fs->wflag = 0;
+    return FR_OK;
+}
+
+static FRESULT move_window(FATFS *fs, LBA_t sector)
+{
+    if (sector == fs->winsect) return FR_OK;
+    if (sync_window(fs) != FR_OK) return FR_DISK_ERR;
+    if (disk_read(0, window, sector, 1) != RES_OK)
+    {
+        fs->winsect = NO_SECTOR;
+        return FR_DISK_ERR;
+    }
+    fs->winsect = sector;
+    return FR_OK;
+}
+
+static FRESULT mount_volume(void)
+{
+    if (!volume) return FR_NOT_ENABLED;
+    if (volume->fs_type && !(disk_status(0) & STA_NOINIT)) return FR_OK;
+
+    volume->fs_type = 0;
+    if (disk_initialize(0) & STA_NOINIT) return FR_NOT_READY;
+
+    // MBR, volume boot record, FSInfo.
+    if (move_window(volume, 0) != FR_OK) return FR_DISK_ERR;
+    if (move_window(volume, PARTITION_LBA) != FR_OK) return FR_DISK_ERR;
+    if (move_window(volume, FSINFO_LBA) != FR_OK) return FR_DISK_ERR;
+
+    volume->fs_type = FS_FAT32;
+    return FR_OK;
+}
+
+FRESULT f_mount(FATFS *fs, const char *path, BYTE opt)
+{
+    (void)path;
+
+    if (volume) volume->fs_type = 0;
+    volume = fs;
+    if (!fs) return FR_OK;
+
+    fs->fs_type = 0;
+    fs->wflag = 0;
+    fs->fsi_flag = 0;
+    fs->winsect = NO_SECTOR;
+    return opt ? mount_volume() : FR_OK;
+}
+
+static int find_file(const char *name)
+{
+    for (int i = 0; i < file_count; i++)
+    {
+        if (strcmp(files[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+FRESULT f_open(FIL *fp, const char *path, BYTE mode)
+{
+    FRESULT res;
+
+    memset(fp, 0, sizeof(*fp));
+    if ((res = mount_volume()) != FR_OK) return res;
+
+    // Drive prefix ("0:") and leading separators.
+    const char *colon = strchr(path, ':');
+    const char *name = colon ? colon + 1 : path;
+    while (*name == '/') name++;
+    if (!*name || strlen(name) >= MAX_NAME) return FR_INVALID_NAME;
+
+    int i = find_file(name);
+    int entry = (i < 0) ? file_count : i;
+
+    // Directory search, up to the entry (or the free one after the last).
+    for (LBA_t sector = DIR_LBA; sector <= dir_sector(entry); sector++)
+    {
+        if (move_window(volume, sector) != FR_OK) return FR_DISK_ERR;
+    }
+
+    if (i < 0)
+    {
+        if (!(mode & (FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS))) return FR_NO_FILE;
+        if (file_count == MAX_FILES) return FR_DENIED;
+
+        i = file_count++;
+        strcpy(files[i].name, name);
+        volume->wflag = 1; // New directory entry.
+    }
+    else if (mode & FA_CREATE_NEW)
+    {
+        return FR_EXIST;
+    }
+    else if ((mode & FA_CREATE_ALWAYS) && files[i].dir_size)
+    {
+        files[i].dir_size = 0;
+        volume->wflag = 1;
+    }
+
+    fp->fs = volume;
+    fp->file = i;
+    fp->flag = mode & (FA_READ | FA_WRITE);
+    fp->fsize = files[i].dir_size;
+
+    if ((mode & FA_OPEN_APPEND) == FA_OPEN_APPEND && fp->fsize)
+    {
+        // Follow the cluster chain to the end, then load the partial last sector.
+        DWORD last = first_cluster(i) + (fp->fsize - 1) / CLUSTER_BYTES;
+        for (DWORD c = first_cluster(i); ; c += CLUSTERS_PER_FAT_SECTOR)
+        {
+            if (c > last) c = last;
+            if (move_window(volume, fat_sector(c)) != FR_OK) return FR_DISK_ERR;
+            if (c == last) break;
+        }
+        if (fp->fsize % SECTOR_SIZE)
+        {
+            if (disk_read(0, sector_buf, data_sector(i, fp->fsize), 1) != RES_OK) return FR_DISK_ERR;
+        }
+        fp->fptr = fp->fsize;
+    }
+    return FR_OK;
+}
+
+/** @brief Checks that `fp` is an open file on the mounted volume. */
+static FRESULT validate(FIL *fp)
+{
+    if (!fp || !fp->fs || fp->fs != volume || !volume->fs_type) return FR_INVALID_OBJECT;
+    if (disk_status(0) & STA_NOINIT) return FR_NOT_READY;
+    return fp->err ? (FRESULT)fp->err : FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+    FRESULT res = validate(fp);
+    const uint8_t *src = buff;
+
+    *bw = 0;
+    if (res != FR_OK) return res;
+    if (!(fp->flag & FA_WRITE)) return FR_DENIED;
+
+    file_t *f = &files[fp->file];
+
+    while (btw)
+    {
+        if (fp->fptr % SECTOR_SIZE == 0)
+        {
+            // Leaving a sector: write it out. Entering a new cluster: allocate it in the FAT.
+            if (fp->dirty)
+            {
+                if (disk_write(0, sector_buf, data_sector(fp->file, fp->fptr - 1), 1) != RES_OK)
+                {
+                    fp->err = FR_DISK_ERR;
+                    return FR_DISK_ERR;
+                }
+                fp->dirty = 0;
+            }
+            if (fp->fptr % CLUSTER_BYTES == 0)
+            {
+                if ((FSIZE_t)fp->fptr / CLUSTER_BYTES >= FILE_CLUSTERS) return FR_DENIED;
+                if (move_window(fp->fs, fat_sector(first_cluster(fp->file) + fp->fptr / CLUSTER_BYTES)) != FR_OK)
+                {
+                    fp->err = FR_DISK_ERR;
+                    return FR_DISK_ERR;
+                }
+                fp->fs->wflag = 1;
+                fp->fs->fsi_flag = 1;
+            }
+        }
+
+        UINT n = SECTOR_SIZE - fp->fptr % SECTOR_SIZE;
+        if (n > btw) n = btw;
+
+        if (fp->fptr + n > f->capacity)
+        {
+            size_t capacity = f->capacity ? f->capacity * 2 : 4096;
+            while (capacity < fp->fptr + n) capacity *= 2;
+            uint8_t *data = realloc(f->data, capacity);
+            if (!data) return FR_INT_ERR;
+            f->data = data;
+            f->capacity = capacity;
+        }
+        memcpy(f->data + fp->fptr, src, n);
+
+        src += n;
+        btw -= n;
+        *bw += n;
+        fp->fptr += n;
+        if (fp->fptr > fp->fsize) fp->fsize = fp->fptr;
+        fp->dirty = 1;
+        fp->flag |= FA_MODIFIED;
+    }
+    return FR_OK;
+}
+
+FRESULT f_sync(FIL *fp)
+{
+    FRESULT res = validate(fp);
+
+    if (res != FR_OK) return res;
+    if (!(fp->flag & FA_MODIFIED)) return FR_OK;
+
+    FATFS *fs = fp->fs;
+    file_t *f = &files[fp->file];
+
+    if (fp->dirty)
+    {
+        if (disk_write(0, sector_buf, data_sector(fp->file, fp->fptr - 1), 1) != RES_OK) res = FR_DISK_ERR;
+        else fp->dirty = 0;
+    }
+    if (res == FR_OK) res = move_window(fs, dir_sector(fp->file));
+    if (res == FR_OK)
+    {
+        f->dir_size = fp->fsize;
+        f->mtime = get_fattime();
+        fs->wflag = 1;
+        res = sync_window(fs);
+    }
+    if (res == FR_OK && fs->fsi_flag)
+    {
+        if (disk_write(0, window, FSINFO_LBA, 1) != RES_OK) res = FR_DISK_ERR;
+        else fs->fsi_flag = 0;
+    }
+
+    if (res != FR_OK)
+    {
+        fp->err = (BYTE)res;
+        return res;
+    }
+    fp->flag &= (BYTE)~FA_MODIFIED;
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+    FRESULT res = f_sync(fp);
+
+    if (res == FR_OK) fp->fs = NULL;
+    return res;
+}
+
+int f_printf(FIL *fp, const char *fmt, ...)
+{
+    char text[1024];
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    if (n < 0) return -1;
+    if ((size_t)n >= sizeof(text)) n = sizeof(text) - 1;
+
+    UINT bw;
+    if (f_write(fp, text, (UINT)n, &bw) != FR_OK || bw != (UINT)n) return -1;
+    return n;
+}
+
+int sim_fatfs_file_count(void)
+{
+    return file_count;
+}
+
+const char *sim_fatfs_file(int i, const uint8_t **data, size_t *size)
+{
+    if (i < 0 || i >= file_count) return NULL;
+    if (data) *data = files[i].data;
+    if (size) *size = files[i].dir_size;
+    return files[i].name;
+}
+
+bool sim_fatfs_save(const char *dir)
+{
+    bool ok = true;
+
+    for (int i = 0; i < file_count; i++)
+    {
+        char path[512];
+        int n = snprintf(path, sizeof(path), "%s/%s", dir, files[i].name);
+
+        FILE *out = (n > 0 && (size_t)n < sizeof(path)) ? fopen(path, "wb") : NULL;
+        if (!out)
+        {
+            ok = false;
+            continue;
+        }
+        if (files[i].dir_size && fwrite(files[i].data, 1, files[i].dir_size, out) != files[i].dir_size) ok = false;
+        if (fclose(out) != 0) ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,51 @@
+/** @file sim_flash.c
+ ** @brief QSPI NOR flash behind the host `hardware/flash.h`.
+ * @details Timing of a W25Q-class device, as on the Pico 2: sector erase and page program
+ * take their typical datasheet time. The SDK functions run with XIP disabled, so the core
+ * only waits: the time passes on the simulated clock with the interrupts as the caller left
+ * them (normally disabled, as the SDK requires). `flash_range_program()` only clears bits,
+ * like the real array, so a write over data that was not erased is visible.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "sim.h"
+
+/** @brief Sector erase time (typical) [us]. */
+#define SECTOR_ERASE_US 45000
+
+/** @brief Page program time (typical) [us]. */
+#define PAGE_PROGRAM_US 700
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+void sim_flash_reset(void)
+{
+    memset(host_flash, 0xFF, sizeof(host_flash));
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count)
+{
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > sizeof(host_flash))
+    {
+        fprintf(stderr, "sim_flash: erase of 0x%lx+0x%zx is not sector aligned\n", (unsigned long)flash_offs, count);
+        abort();
+    }
+
+    memset(&host_flash[flash_offs], 0xFF, count);
+    sleep_us((uint64_t)(count / FLASH_SECTOR_SIZE) * SECTOR_ERASE_US);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count)
+{
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > sizeof(host_flash))
+    {
+        fprintf(stderr, "sim_flash: program of 0x%lx+0x%zx is not page aligned\n", (unsigned long)flash_offs, count);
+        abort();
+    }
+
+    for (size_t i = 0; i < count; i++) host_flash[flash_offs + i] &= data[i];
+    sleep_us((uint64_t)(count / FLASH_PAGE_SIZE) * PAGE_PROGRAM_US);
+}
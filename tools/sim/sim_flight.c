@@ -0,0 +1,201 @@
+/** @file sim_flight.c
+ ** @brief Flight profile generator (see sim_flight.h).
+ */
+
+#include <math.h>
+#include "pico/stdlib.h"
+#include "sim_flight.h"
+
+#define GRAVITY 9.80665
+#define EARTH_RADIUS_M 6371000.0
+#define MAX_STEP_S 0.001
+
+// ICAO standard atmosphere, troposphere.
+#define ISA_T0_K 288.15
+#define ISA_P0_PA 101325.0
+#define ISA_LAPSE_K_PER_M 0.0065
+#define ISA_EXPONENT 5.25588
+#define KELVIN 273.15
+
+#define DEG_TO_RAD (M_PI / 180.0)
+
+const sim_flight_config_t sim_flight_default = {
+    .pad_s = 10.0,
+    .boost_accel_mps2 = 120.0,
+    .burn_s = 1.5,
+    .drag_per_m = 0.0004,
+    .descent_rate_mps = 8.0,
+    .wind_mps = 5.0,
+    .wind_from_deg = 270.0,
+    .ground_altitude_m = 120.0,
+    .ground_temperature_c = 20.0,
+    .ground_humidity_pct = 60.0,
+    .humidity_scale_m = 2500.0,
+    .ground_methane_ppm = 50.0,
+    .ground_ammonia_ppm = 10.0,
+    .gas_scale_m = 300.0,
+    .o2_pct = 20.9,
+    .latitude_deg = 51.1156808,
+    .longitude_deg = 17.0252815,
+    .sample_hz = SIM_FLIGHT_MAX_SAMPLE_HZ,
+};
+
+const char *const sim_flight_phase_names[SIM_FLIGHT_PHASE_COUNT] = {
+    [SIM_FLIGHT_PAD] = "pad",
+    [SIM_FLIGHT_BOOST] = "boost",
+    [SIM_FLIGHT_COAST] = "coast",
+    [SIM_FLIGHT_DESCENT] = "descent",
+    [SIM_FLIGHT_LANDED] = "landed",
+};
+
+static sim_flight_config_t config;
+static sim_flight_state_t state;
+static bool active;
+static uint64_t start_us;
+static uint64_t period_us;
+static uint64_t next_sample_us;
+
+static double isa_temperature_k(double altitude_m)
+{
+    return ISA_T0_K - ISA_LAPSE_K_PER_M * altitude_m;
+}
+
+/** @brief Wind speed at a height above ground (1/7 power law from the 10 m reference). */
+static double wind_at(double height_m)
+{
+    return config.wind_mps * pow(fmax(height_m, 1.0) / 10.0, 1.0 / 7.0);
+}
+
+/** @brief Advances the trajectory by `dt` seconds. */
+static void integrate(double dt)
+{
+    sim_flight_state_t *s = &state;
+    double a = 0;
+
+    s->t_s += dt;
+
+    switch (s->phase)
+    {
+        case SIM_FLIGHT_PAD:
+            if (s->t_s >= config.pad_s) s->phase = SIM_FLIGHT_BOOST;
+            return;
+        case SIM_FLIGHT_BOOST:
+            a = config.boost_accel_mps2 - GRAVITY - config.drag_per_m * s->vertical_speed_mps * fabs(s->vertical_speed_mps);
+            if (s->t_s >= config.pad_s + config.burn_s) s->phase = SIM_FLIGHT_COAST;
+            break;
+        case SIM_FLIGHT_COAST:
+            a = -GRAVITY - config.drag_per_m * s->vertical_speed_mps * fabs(s->vertical_speed_mps);
+            break;
+        case SIM_FLIGHT_DESCENT:
+        {
+            // Parachute drag balances gravity at the descent rate.
+            double k = GRAVITY / (config.descent_rate_mps * config.descent_rate_mps);
+            double wind = wind_at(s->height_m);
+            double toward = (config.wind_from_deg + 180.0) * DEG_TO_RAD;
+
+            a = -GRAVITY - k * s->vertical_speed_mps * fabs(s->vertical_speed_mps);
+            s->east_m += wind * sin(toward) * dt;
+            s->north_m += wind * cos(toward) * dt;
+            break;
+        }
+        case SIM_FLIGHT_LANDED:
+        default:
+            return;
+    }
+
+    // Semi-implicit Euler: stable for the stiff parachute drag at millisecond steps.
+    s->vertical_speed_mps += a * dt;
+    s->height_m += s->vertical_speed_mps * dt;
+
+    if (s->height_m > s->apogee_m)
+    {
+        s->apogee_m = s->height_m;
+        s->apogee_t_s = s->t_s;
+    }
+    if (s->phase == SIM_FLIGHT_COAST && s->vertical_speed_mps <= 0) s->phase = SIM_FLIGHT_DESCENT;
+    if (s->height_m <= 0 && s->phase != SIM_FLIGHT_BOOST)
+    {
+        s->height_m = 0;
+        s->vertical_speed_mps = 0;
+        s->phase = SIM_FLIGHT_LANDED;
+    }
+}
+
+/** @brief Sets `sim_env` from the flight state. */
+static void apply(void)
+{
+    const sim_flight_state_t *s = &state;
+    double altitude = config.ground_altitude_m + s->height_m;
+    double t_std = isa_temperature_k(altitude);
+    double t_offset = config.ground_temperature_c + KELVIN - isa_temperature_k(config.ground_altitude_m);
+
+    sim_env.altitude_m = altitude;
+    sim_env.pressure_pa = ISA_P0_PA * pow(t_std / ISA_T0_K, ISA_EXPONENT);
+    sim_env.temperature_c = t_std + t_offset - KELVIN;
+    sim_env.humidity_pct = config.ground_humidity_pct * exp(-s->height_m / config.humidity_scale_m);
+    sim_env.methane_ppm = config.ground_methane_ppm * exp(-s->height_m / config.gas_scale_m);
+    sim_env.ammonia_ppm = config.ground_ammonia_ppm * exp(-s->height_m / config.gas_scale_m);
+    sim_env.o2_pct = config.o2_pct;
+
+    sim_env.latitude_deg = config.latitude_deg + s->north_m / EARTH_RADIUS_M / DEG_TO_RAD;
+    sim_env.longitude_deg = config.longitude_deg +
+                            s->east_m / (EARTH_RADIUS_M * cos(config.latitude_deg * DEG_TO_RAD)) / DEG_TO_RAD;
+
+    bool drifting = s->phase == SIM_FLIGHT_DESCENT;
+    sim_env.ground_speed_mps = drifting ? wind_at(s->height_m) : 0.0;
+    sim_env.course_deg = fmod(config.wind_from_deg + 180.0, 360.0);
+}
+
+void sim_flight_reset(void)
+{
+    active = false;
+}
+
+void sim_flight_start(const sim_flight_config_t *cfg)
+{
+    uint32_t hz = cfg->sample_hz;
+
+    if (hz == 0) hz = 1;
+    if (hz > SIM_FLIGHT_MAX_SAMPLE_HZ) hz = SIM_FLIGHT_MAX_SAMPLE_HZ;
+
+    config = *cfg;
+    config.sample_hz = hz;
+    state = (sim_flight_state_t){ .phase = SIM_FLIGHT_PAD };
+    active = true;
+    start_us = host_time_us;
+    period_us = 1000000 / hz;
+    next_sample_us = start_us + period_us;
+    apply();
+}
+
+void sim_flight_stop(void)
+{
+    active = false;
+}
+
+const sim_flight_state_t *sim_flight_state(void)
+{
+    return &state;
+}
+
+uint64_t sim_flight_next_event_us(void)
+{
+    return (active && state.phase != SIM_FLIGHT_LANDED) ? next_sample_us : UINT64_MAX;
+}
+
+void sim_flight_step(void)
+{
+    if (!active || state.phase == SIM_FLIGHT_LANDED || host_time_us < next_sample_us) return;
+
+    // Samples that fell between two clock reads are merged into the latest one.
+    uint64_t missed = (host_time_us - next_sample_us) / period_us;
+    uint64_t sample_us = next_sample_us + missed * period_us;
+    double target_s = (sample_us - start_us) / 1e6;
+
+    while (target_s - state.t_s > 1e-9 && state.phase != SIM_FLIGHT_LANDED)
+    {
+        integrate(fmin(MAX_STEP_S, target_s - state.t_s));
+    }
+    apply();
+    next_sample_us = sample_us + period_us;
+}
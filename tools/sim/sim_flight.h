@@ -0,0 +1,98 @@
+/** @file sim_flight.h
+ ** @brief Flight profile generator: drives `sim_env` along a physically consistent flight.
+ * @details A vertical point-mass trajectory (pad, motor boost, ballistic coast with quadratic
+ * drag, apogee, descent under the parachute at its terminal speed, landing) is integrated in
+ * steps of at most 1 ms, and `sim_env` is refreshed from it `sample_hz` times per simulated
+ * second (up to 1 kHz). From the altitude the generator derives:
+ * - pressure and temperature of the ICAO standard atmosphere (troposphere), the temperature
+ *   shifted by the difference between the configured ground temperature and the standard one,
+ * - relative humidity and the methane / ammonia concentrations, decaying exponentially with
+ *   height above ground from their ground values (oxygen stays at its ground fraction),
+ * - the GNSS position: during the descent the CanSat drifts with the wind, whose speed grows
+ *   with height by the 1/7 power law; altitude, ground speed and course follow.
+ *
+ * The device models read `sim_env`, so the BMP280, SHTC3, gas sensors and the NMEA / NAV-PVT
+ * output of the GNSS model all follow the flight.
+ */
+
+#ifndef SIM_FLIGHT_H
+#define SIM_FLIGHT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+// CONFIGURATION MACROS
+
+/** @brief Highest rate at which `sim_env` is refreshed [Hz]. */
+#define SIM_FLIGHT_MAX_SAMPLE_HZ 1000
+
+// DATA STRUCTURES
+
+/** @brief Flight phases. */
+typedef enum
+{
+    SIM_FLIGHT_PAD = 0,
+    SIM_FLIGHT_BOOST,
+    SIM_FLIGHT_COAST,
+    SIM_FLIGHT_DESCENT,
+    SIM_FLIGHT_LANDED,
+    SIM_FLIGHT_PHASE_COUNT
+} sim_flight_phase_t;
+
+/** @brief Flight and atmosphere parameters. */
+typedef struct
+{
+    double pad_s; /// Time on the pad before ignition [s].
+    double boost_accel_mps2; /// Motor thrust per unit mass [m/s^2].
+    double burn_s; /// Motor burn time [s].
+    double drag_per_m; /// Quadratic drag coefficient of the rocket, rho*Cd*A/(2m) [1/m].
+    double descent_rate_mps; /// Terminal descent speed under the parachute [m/s].
+    double wind_mps; /// Wind speed 10 m above ground [m/s].
+    double wind_from_deg; /// Direction the wind blows from, clockwise from north.
+    double ground_altitude_m; /// Launch site above mean sea level [m].
+    double ground_temperature_c;
+    double ground_humidity_pct;
+    double humidity_scale_m; /// Height over which the humidity falls by 1/e [m].
+    double ground_methane_ppm;
+    double ground_ammonia_ppm;
+    double gas_scale_m; /// Height over which the gas concentrations fall by 1/e [m].
+    double o2_pct;
+    double latitude_deg; /// Launch site.
+    double longitude_deg;
+    uint32_t sample_hz; /// Refresh rate of `sim_env` (at most `SIM_FLIGHT_MAX_SAMPLE_HZ`).
+} sim_flight_config_t;
+
+/** @brief True state of the flight at the last refresh. */
+typedef struct
+{
+    sim_flight_phase_t phase;
+    double t_s; /// Since the flight was started [s].
+    double height_m; /// Above ground [m].
+    double vertical_speed_mps; /// Positive upwards.
+    double east_m; /// Drift from the launch site [m].
+    double north_m;
+    double apogee_m; /// Highest point so far, above ground [m].
+    double apogee_t_s; /// Time of the apogee [s].
+} sim_flight_state_t;
+
+// FUNCTIONS
+
+/** @brief A CanSat launch: 1.5 s boost to roughly 1 km, 8 m/s descent, 5 m/s westerly wind, 1 kHz. */
+extern const sim_flight_config_t sim_flight_default;
+
+/** @brief Display names of the phases, indexed by `sim_flight_phase_t`. */
+extern const char *const sim_flight_phase_names[SIM_FLIGHT_PHASE_COUNT];
+
+/** @brief Starts a flight at the current simulated time and sets `sim_env` to the pad state.
+ ** @param[in] config Flight parameters (copied).
+ */
+extern void sim_flight_start(const sim_flight_config_t *config);
+
+/** @brief Stops refreshing `sim_env`; it keeps the last state. */
+extern void sim_flight_stop(void);
+
+/** @brief The state at the last refresh of `sim_env`. */
+extern const sim_flight_state_t *sim_flight_state(void);
+
+#endif // SIM_FLIGHT_H
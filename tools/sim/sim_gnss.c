@@ -0,0 +1,362 @@
+/** @file sim_gnss.c
+ ** @brief GNSS receiver model (u-blox M8/M10 class) on uart0.
+ * @details After reset the receiver talks at 9600 baud with a 1 s navigation period and
+ * outputs GGA, GLL, GSA, GSV, RMC and VTG every epoch, plus a TXT banner at start-up. Each
+ * epoch's output starts `conversion_us` after the epoch and describes `sim_env` at the epoch.
+ *
+ * The UBX configuration the firmware sends is applied and acknowledged:
+ * - CFG-MSG: output rate of an NMEA message, of NAV-PVT or of NAV-CLK,
+ * - CFG-PRT: baud rate (the ACK still leaves at the old rate),
+ * - CFG-RATE: navigation period,
+ * - CFG-INF: TXT output.
+ * MGA-INI aiding is taken without a reply, as by the receiver's default, and counted. Other
+ * messages are NAKed. Bytes sent at the wrong baud rate are not understood.
+ *
+ * A stuck GNSS stops all output; `corrupt_prob` applies to every byte sent. A message that
+ * does not fit into the transmit buffer, behind the bytes still on the line, is dropped.
+ *
+ * With the navigation output turned off (a replay, tools/sim/sim_replay.c) the recorded
+ * sentences take the place of the generated ones; types turned off by CFG-MSG are dropped.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "ubx_protocol.h"
+#include "sim.h"
+
+#define BOOT_BAUD_RATE 9600
+#define BOOT_NAV_PERIOD_MS 1000
+#define MPS_TO_KNOTS 1.943844
+#define MPS_TO_KMH 3.6
+#define TX_BUFFER_LEN 4096
+#define CLOCK_DRIFT_NS_S 1234
+
+/** @brief NMEA messages, indexed by their UBX message ID (`UBX_ID_NMEA_*`). */
+enum
+{
+    NMEA_GGA = 0,
+    NMEA_GLL,
+    NMEA_GSA,
+    NMEA_GSV,
+    NMEA_RMC,
+    NMEA_VTG,
+    NMEA_COUNT
+};
+
+static uint32_t baudrate;
+static uint32_t nav_period_ms;
+static uint8_t nmea_rate[NMEA_COUNT]; /// Output every n-th epoch (0: off).
+static uint8_t pvt_rate;
+static uint8_t clk_rate;
+static uint32_t aiding_count;
+static bool inf_enabled;
+static bool banner_sent;
+static bool navigation_output;
+static uint64_t epoch; /// Index of the next navigation epoch.
+static uint64_t epoch_us; /// Simulated time of the next epoch.
+static ubx_parser_t parser;
+
+void sim_gnss_reset(void)
+{
+    baudrate = BOOT_BAUD_RATE;
+    nav_period_ms = BOOT_NAV_PERIOD_MS;
+    for (int i = 0; i < NMEA_COUNT; i++) nmea_rate[i] = 1;
+    pvt_rate = 0;
+    clk_rate = 0;
+    aiding_count = 0;
+    inf_enabled = true;
+    banner_sent = false;
+    navigation_output = true;
+    epoch = 0;
+    epoch_us = 0;
+    ubx_parser_init(&parser);
+}
+
+static void send(uint8_t *data, size_t len)
+{
+    if (sim_faults[SIM_DEV_GNSS].stuck) return;
+    if (sim_uart_tx_pending() + len > TX_BUFFER_LEN) return;
+
+    sim_corrupt(SIM_DEV_GNSS, data, len);
+    sim_uart_transmit(data, len, baudrate);
+    sim_stats[SIM_DEV_GNSS].transfers++;
+}
+
+/** @brief Sends one sentence: `body` is the text between '$' and '*'. */
+static void send_nmea(const char *body)
+{
+    char line[288];
+    uint8_t cks = 0;
+
+    for (const char *p = body; *p; p++) cks ^= (uint8_t)*p;
+    int n = snprintf(line, sizeof(line), "$%s*%02X\r\n", body, cks);
+    if (n > 0) send((uint8_t *)line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+}
+
+static void send_ubx(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len)
+{
+    uint8_t frame[UBX_NAV_PVT_LEN + UBX_FRAME_OVERHEAD];
+
+    send(frame, ubx_build_frame(frame, msg_class, msg_id, payload, len));
+}
+
+static void send_ack(bool ack, uint8_t msg_class, uint8_t msg_id)
+{
+    uint8_t payload[2] = {msg_class, msg_id};
+
+    send_ubx(UBX_CLASS_ACK, ack ? UBX_ID_ACK_ACK : UBX_ID_ACK_NAK, payload, sizeof(payload));
+}
+
+/** @brief Formats an angle as NMEA (d)ddmm.mmmmm with its hemisphere letter. */
+static void nmea_angle(char *out, size_t size, double deg, int deg_digits, char pos, char neg)
+{
+    double a = fabs(deg);
+    int d = (int)a;
+    double m = (a - d) * 60.0;
+
+    snprintf(out, size, "%0*d%08.5f,%c", deg_digits, d, m, deg < 0 ? neg : pos);
+}
+
+static void output_epoch(uint64_t t_us)
+{
+    const sim_env_t *e = &sim_env;
+    int64_t utc_ms = e->utc_at_boot_s * 1000 + (int64_t)(t_us / 1000);
+    time_t utc_s = (time_t)(utc_ms / 1000);
+    struct tm tm;
+    gmtime_r(&utc_s, &tm);
+
+    char hms[32], date[32], lat[24], lon[24], body[256];
+    snprintf(hms, sizeof(hms), "%02d%02d%02d.%02d", tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(utc_ms % 1000) / 10);
+    snprintf(date, sizeof(date), "%02d%02d%02d", tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100);
+    nmea_angle(lat, sizeof(lat), e->latitude_deg, 2, 'N', 'S');
+    nmea_angle(lon, sizeof(lon), e->longitude_deg, 3, 'E', 'W');
+
+    bool fix = e->fix;
+    char status = fix ? 'A' : 'V';
+    double knots = e->ground_speed_mps * MPS_TO_KNOTS;
+
+    if (inf_enabled && !banner_sent)
+    {
+        send_nmea("GPTXT,01,01,02,u-blox AG - www.u-blox.com");
+        banner_sent = true;
+    }
+
+#define DUE(msg) (nmea_rate[msg] && epoch % nmea_rate[msg] == 0)
+
+    if (DUE(NMEA_RMC))
+    {
+        snprintf(body, sizeof(body), "GPRMC,%s,%c,%s,%s,%.3f,%.2f,%s,,,%c",
+                 hms, status, fix ? lat : ",", fix ? lon : ",", knots, e->course_deg, date, fix ? 'A' : 'N');
+        send_nmea(body);
+    }
+    if (DUE(NMEA_VTG))
+    {
+        snprintf(body, sizeof(body), "GPVTG,%.2f,T,,M,%.3f,N,%.3f,K,%c",
+                 e->course_deg, knots, e->ground_speed_mps * MPS_TO_KMH, fix ? 'A' : 'N');
+        send_nmea(body);
+    }
+    if (DUE(NMEA_GGA))
+    {
+        snprintf(body, sizeof(body), "GPGGA,%s,%s,%s,%d,%02u,1.01,%.1f,M,42.1,M,,",
+                 hms, fix ? lat : ",", fix ? lon : ",", fix ? 1 : 0, e->satellites, e->altitude_m);
+        send_nmea(body);
+    }
+    if (DUE(NMEA_GSA))
+    {
+        int n = snprintf(body, sizeof(body), "GPGSA,A,%d", fix ? 3 : 1);
+        for (int i = 0; i < 12; i++)
+        {
+            if (i < e->satellites) n += snprintf(body + n, sizeof(body) - (size_t)n, ",%02d", 2 + 3 * i);
+            else n += snprintf(body + n, sizeof(body) - (size_t)n, ",");
+        }
+        snprintf(body + n, sizeof(body) - (size_t)n, ",1.90,1.01,1.61");
+        send_nmea(body);
+    }
+    if (DUE(NMEA_GSV))
+    {
+        int msgs = (e->satellites + 3) / 4;
+        for (int m = 0; m < (msgs ? msgs : 1); m++)
+        {
+            int n = snprintf(body, sizeof(body), "GPGSV,%d,%d,%02u", msgs ? msgs : 1, m + 1, e->satellites);
+            for (int i = 4 * m; i < 4 * m + 4 && i < e->satellites; i++)
+            {
+                n += snprintf(body + n, sizeof(body) - (size_t)n, ",%02d,%02d,%03d,%02d",
+                              2 + 3 * i, 15 + (i * 17) % 70, (i * 47) % 360, 30 + (i * 7) % 20);
+            }
+            send_nmea(body);
+        }
+    }
+    if (DUE(NMEA_GLL))
+    {
+        snprintf(body, sizeof(body), "GPGLL,%s,%s,%s,%c,%c",
+                 fix ? lat : ",", fix ? lon : ",", hms, status, fix ? 'A' : 'N');
+        send_nmea(body);
+    }
+
+#undef DUE
+
+    if (pvt_rate && epoch % pvt_rate == 0)
+    {
+        ubx_nav_pvt_t pvt = {0};
+        double course = e->course_deg * M_PI / 180.0;
+
+        // GPS time: epoch 1980-01-06, 18 leap seconds ahead of UTC.
+        pvt.itow_ms = (uint32_t)((utc_ms - 315964800000LL + 18000) % (7 * 86400000LL));
+        pvt.year = (uint16_t)(tm.tm_year + 1900);
+        pvt.month = (uint8_t)(tm.tm_mon + 1);
+        pvt.day = (uint8_t)tm.tm_mday;
+        pvt.hour = (uint8_t)tm.tm_hour;
+        pvt.min = (uint8_t)tm.tm_min;
+        pvt.sec = (uint8_t)tm.tm_sec;
+        pvt.valid = UBX_NAV_PVT_VALID_DATE | UBX_NAV_PVT_VALID_TIME;
+        pvt.nano = (int32_t)(utc_ms % 1000) * 1000000;
+        pvt.fix_type = fix ? UBX_FIX_3D : UBX_FIX_NONE;
+        pvt.flags = fix ? UBX_NAV_PVT_FLAGS_FIX_OK : 0;
+        pvt.num_sv = e->satellites;
+        pvt.lon_e7 = (int32_t)lround(e->longitude_deg * 1e7);
+        pvt.lat_e7 = (int32_t)lround(e->latitude_deg * 1e7);
+        pvt.hmsl_mm = (int32_t)lround(e->altitude_m * 1000.0);
+        pvt.height_mm = pvt.hmsl_mm + 42100;
+        pvt.vel_n_mm_s = (int32_t)lround(e->ground_speed_mps * cos(course) * 1000.0);
+        pvt.vel_e_mm_s = (int32_t)lround(e->ground_speed_mps * sin(course) * 1000.0);
+        pvt.g_speed_mm_s = (int32_t)lround(e->ground_speed_mps * 1000.0);
+        pvt.head_mot_e5 = (int32_t)lround(e->course_deg * 1e5);
+        send_ubx(UBX_CLASS_NAV, UBX_ID_NAV_PVT, (const uint8_t *)&pvt, sizeof(pvt));
+    }
+
+    if (clk_rate && epoch % clk_rate == 0)
+    {
+        ubx_nav_clk_t clk = {0};
+
+        clk.itow_ms = (uint32_t)((utc_ms - 315964800000LL + 18000) % (7 * 86400000LL));
+        clk.clk_d_ns_s = CLOCK_DRIFT_NS_S;
+        send_ubx(UBX_CLASS_NAV, UBX_ID_NAV_CLK, (const uint8_t *)&clk, sizeof(clk));
+    }
+}
+
+uint64_t sim_gnss_next_event_us(void)
+{
+    return navigation_output ? epoch_us + sim_faults[SIM_DEV_GNSS].conversion_us : UINT64_MAX;
+}
+
+void sim_gnss_step(void)
+{
+    uint32_t delay = sim_faults[SIM_DEV_GNSS].conversion_us;
+    uint64_t period = (uint64_t)nav_period_ms * 1000;
+
+    if (!navigation_output || host_time_us < epoch_us + delay) return;
+
+    // Epochs nobody could have heard (e.g. a long sleep) are skipped, only the latest is sent.
+    if (host_time_us >= epoch_us + delay + period)
+    {
+        uint64_t skip = (host_time_us - epoch_us - delay) / period;
+        epoch += skip;
+        epoch_us += skip * period;
+    }
+
+    output_epoch(epoch_us);
+    sim_stats[SIM_DEV_GNSS].conversions++;
+    epoch++;
+    epoch_us += period;
+}
+
+void sim_gnss_set_navigation_output(bool on)
+{
+    if (on && !navigation_output)
+    {
+        // Resume with the next epoch rather than the ones missed while off.
+        uint64_t period = (uint64_t)nav_period_ms * 1000;
+        if (host_time_us > epoch_us) epoch_us += (host_time_us - epoch_us + period - 1) / period * period;
+    }
+    navigation_output = on;
+}
+
+void sim_gnss_send_sentence(const char *sentence)
+{
+    static const char *const types[NMEA_COUNT] = {
+        [NMEA_GGA] = "GGA", [NMEA_GLL] = "GLL", [NMEA_GSA] = "GSA",
+        [NMEA_GSV] = "GSV", [NMEA_RMC] = "RMC", [NMEA_VTG] = "VTG",
+    };
+    char line[288];
+    size_t len = strlen(sentence);
+
+    // "$ttsss,...": talker, then the sentence type.
+    if (len > 6)
+    {
+        for (int i = 0; i < NMEA_COUNT; i++)
+        {
+            if (strncmp(sentence + 3, types[i], 3) == 0 && nmea_rate[i] == 0) return;
+        }
+        if (strncmp(sentence + 3, "TXT", 3) == 0 && !inf_enabled) return;
+    }
+    if (len > sizeof(line) - 3) len = sizeof(line) - 3;
+
+    memcpy(line, sentence, len);
+    line[len++] = '\r';
+    line[len++] = '\n';
+    send((uint8_t *)line, len);
+}
+
+static void apply_cfg(void)
+{
+    const uint8_t *p = parser.payload;
+    bool ok = true;
+
+    switch (parser.msg_id)
+    {
+        case UBX_ID_CFG_MSG:
+            if (parser.length < 3) ok = false;
+            else if (p[0] == UBX_CLASS_NMEA && p[1] < NMEA_COUNT) nmea_rate[p[1]] = p[2];
+            else if (p[0] == UBX_CLASS_NAV && p[1] == UBX_ID_NAV_PVT) pvt_rate = p[2];
+            else if (p[0] == UBX_CLASS_NAV && p[1] == UBX_ID_NAV_CLK) clk_rate = p[2];
+            else ok = false;
+            break;
+        case UBX_ID_CFG_PRT:
+            if (parser.length != 20) ok = false;
+            break;
+        case UBX_ID_CFG_RATE:
+        {
+            uint16_t meas_ms = (uint16_t)(p[0] | p[1] << 8);
+            if (parser.length != 6 || meas_ms < 25) ok = false;
+            else
+            {
+                // The new period starts with the next epoch.
+                nav_period_ms = meas_ms;
+            }
+            break;
+        }
+        case UBX_ID_CFG_INF:
+            if (parser.length < 10 || p[0] != 1) ok = false;
+            else inf_enabled = (p[4] | p[5] | p[6] | p[7] | p[8] | p[9]) != 0;
+            break;
+        default:
+            ok = false;
+            break;
+    }
+
+    send_ack(ok, UBX_CLASS_CFG, parser.msg_id);
+
+    if (ok && parser.msg_id == UBX_ID_CFG_PRT)
+    {
+        baudrate = (uint32_t)(p[8] | p[9] << 8 | p[10] << 16 | (uint32_t)p[11] << 24);
+    }
+}
+
+void sim_gnss_receive(uint8_t byte, uint32_t rx_baudrate)
+{
+    if (rx_baudrate != baudrate) return; // Framing errors on the receiver side.
+
+    if (!ubx_parser_feed(&parser, byte)) return;
+
+    if (parser.msg_class == UBX_CLASS_CFG) apply_cfg();
+    else if (parser.msg_class == UBX_CLASS_MGA && parser.msg_id == UBX_ID_MGA_INI) aiding_count++;
+    else send_ack(false, parser.msg_class, parser.msg_id);
+}
+
+uint32_t sim_gnss_aiding_count(void)
+{
+    return aiding_count;
+}
@@ -0,0 +1,123 @@
+/** @file sim_i2c.c
+ ** @brief Simulated I2C bus behind the host `hardware/i2c.h`.
+ * @details Each transfer takes its wire time at the configured clock (start, address byte,
+ * data bytes with their ACK bit, stop) on the simulated clock and is routed to the model
+ * attached at the address. Unknown addresses are NAKed after the address byte.
+ */
+
+#include <stdio.h>
+#include "hardware/i2c.h"
+#include "sim.h"
+
+i2c_inst_t host_i2c[2];
+
+typedef struct
+{
+    uint8_t addr;
+    sim_device_t dev;
+    int (*write)(const uint8_t *src, size_t len);
+    int (*read)(uint8_t *dst, size_t len);
+} sim_i2c_device_t;
+
+static const sim_i2c_device_t devices[] = {
+    {0x76, SIM_DEV_BMP280, sim_bmp280_write, sim_bmp280_read},
+    {0x70, SIM_DEV_SHTC3, sim_shtc3_write, sim_shtc3_read},
+    {0x74, SIM_DEV_O2, sim_o2_write, sim_o2_read},
+};
+
+// Fractions of a microsecond left over by the wire time of previous transfers.
+static double wire_remainder_us = 0;
+
+static void wire_time(const i2c_inst_t *i2c, unsigned bits)
+{
+    uint baud = i2c->baudrate ? i2c->baudrate : 100000;
+    double us = wire_remainder_us + bits * 1e6 / baud;
+
+    wire_remainder_us = us - (uint64_t)us;
+    sleep_us((uint64_t)us);
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate)
+{
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+static int transfer(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, uint8_t *dst, size_t len,
+                    bool blocking, uint timeout_us)
+{
+    const sim_i2c_device_t *d = NULL;
+
+    for (size_t i = 0; i < sizeof(devices) / sizeof(devices[0]); i++)
+    {
+        if (devices[i].addr == addr) d = &devices[i];
+    }
+
+    if (d && sim_faults[d->dev].stuck)
+    {
+        sim_stats_t *s = &sim_stats[d->dev];
+
+        s->transfers++;
+        if (blocking)
+        {
+            // On the target this call never returns; the run goes on so the rest can be observed.
+            if (s->hangs++ == 0) fprintf(stderr, "[SIM] blocking I2C transfer to 0x%02x on a stuck bus would hang\n", addr);
+            return PICO_ERROR_GENERIC;
+        }
+        s->timeouts++;
+        sleep_us(timeout_us);
+        return PICO_ERROR_TIMEOUT;
+    }
+
+    // Start and address byte with its ACK.
+    wire_time(i2c, 1 + 9);
+
+    if (!d) return PICO_ERROR_GENERIC;
+
+    sim_stats_t *s = &sim_stats[d->dev];
+    s->transfers++;
+
+    if (sim_chance(sim_faults[d->dev].nak_prob))
+    {
+        s->naks_injected++;
+        wire_time(i2c, 1);
+        return PICO_ERROR_GENERIC;
+    }
+
+    int ret = src ? d->write(src, len) : d->read(dst, len);
+    if (ret < 0)
+    {
+        s->busy_naks++;
+        wire_time(i2c, 1);
+        return PICO_ERROR_GENERIC;
+    }
+    if (dst) sim_corrupt(d->dev, dst, len);
+
+    // Data bytes with their ACK and the stop (or repeated start) condition.
+    wire_time(i2c, 9 * (unsigned)len + 1);
+    return ret;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    (void)nostop;
+    return transfer(i2c, addr, src, NULL, len, true, 0);
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    (void)nostop;
+    return transfer(i2c, addr, NULL, dst, len, true, 0);
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us)
+{
+    (void)nostop;
+    return transfer(i2c, addr, src, NULL, len, false, timeout_us);
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us)
+{
+    (void)nostop;
+    return transfer(i2c, addr, NULL, dst, len, false, timeout_us);
+}
@@ -0,0 +1,66 @@
+/** @file sim_o2.c
+ ** @brief DFRobot SEN0465 oxygen sensor model: 9-byte command/response protocol.
+ * @details The sensor accepts a 9-byte frame `FF 01 86 00 00 00 00 00 cks` (read gas
+ * concentration) and has the answer `FF 86 hi lo 00 00 00 00 cks` ready `conversion_us` later,
+ * with the concentration in 0.1 % steps. The checksum is the two's complement of the sum of
+ * bytes 1..7. Reads before the answer is ready are NAKed; frames with a wrong length, command
+ * or checksum are acknowledged but ignored.
+ */
+
+#include <math.h>
+#include "pico/stdlib.h"
+#include "sim.h"
+
+#define FRAME_LEN 9
+#define CMD_READ_GAS 0x86
+
+static uint8_t response[FRAME_LEN];
+static bool pending;
+static uint64_t ready_at_us;
+
+static uint8_t checksum(const uint8_t *frame)
+{
+    uint8_t sum = 0;
+
+    for (int i = 1; i < FRAME_LEN - 1; i++) sum += frame[i];
+    return (uint8_t)((~sum) + 1);
+}
+
+void sim_o2_reset(void)
+{
+    pending = false;
+}
+
+int sim_o2_write(const uint8_t *src, size_t len)
+{
+    if (len == FRAME_LEN && src[0] == 0xFF && src[2] == CMD_READ_GAS && src[8] == checksum(src))
+    {
+        long raw = lround(sim_env.o2_pct * 10.0);
+        if (raw < 0) raw = 0;
+        if (raw > 0xFFFF) raw = 0xFFFF;
+
+        response[0] = 0xFF;
+        response[1] = CMD_READ_GAS;
+        response[2] = (uint8_t)(raw >> 8);
+        response[3] = (uint8_t)raw;
+        for (int i = 4; i < FRAME_LEN - 1; i++) response[i] = 0;
+        response[8] = checksum(response);
+
+        pending = true;
+        ready_at_us = host_time_us + sim_faults[SIM_DEV_O2].conversion_us;
+        sim_stats[SIM_DEV_O2].conversions++;
+    }
+    return (int)len;
+}
+
+int sim_o2_read(uint8_t *dst, size_t len)
+{
+    if (!pending || host_time_us < ready_at_us) return PICO_ERROR_GENERIC;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = (i < FRAME_LEN) ? response[i] : 0xFF;
+    }
+    pending = false;
+    return (int)len;
+}
@@ -0,0 +1,259 @@
+/** @file sim_radio.c
+ ** @brief nRF905 model on spi0 behind the host `hardware/spi.h`, and the ground station.
+ * @details SPI transfers take their time at the configured clock. With CSN low the first byte
+ * is the command: W_CONFIG, W_TX_ADDRESS and W_TX_PAYLOAD are stored, R_CONFIG reads back.
+ *
+ * A ShockBurst packet starts when TRX_CE rises with TX_EN high and PWR_UP set. It goes on air
+ * after the TX settling time (`conversion_us`) and takes preamble, address, payload and CRC,
+ * with the widths of the configuration, at 50 kbit/s (Manchester coded). DR rises at its end
+ * and falls when TRX_CE or TX_EN is released.
+ *
+ * The ground station receives a packet unless it is lost on the link (`nak_prob`) or
+ * corrupted (`corrupt_prob` per byte; the CRC rejects it); the packets it decodes are counted
+ * as conversions and written to `sim_radio_log`. A stuck radio never finishes a packet.
+ *
+ * Packets the ground station sends up (`sim_radio_uplink()`) wait in a queue until the radio
+ * listens (TRX_CE high, TX_EN low); the first one then raises DR, and R_RX_PAYLOAD reads it.
+ * DR falls when the read ends (CSN high) and the next one follows.
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "lib/nRF905/nRF905.h"
+#include "sim.h"
+
+#define CMD_W_CONFIG 0x00
+#define CMD_R_CONFIG 0x10
+#define CMD_W_TX_PAYLOAD 0x20
+#define CMD_W_TX_ADDRESS 0x22
+#define CMD_R_RX_PAYLOAD 0x24
+
+#define CONFIG_LEN 10
+#define PREAMBLE_BITS 10
+#define AIR_BIT_RATE 50000
+#define UPLINK_QUEUE_LEN 8
+
+struct spi_inst
+{
+    uint baudrate;
+};
+
+spi_inst_t host_spi0, host_spi1;
+
+FILE *sim_radio_log;
+
+static uint8_t config[CONFIG_LEN];
+static uint8_t tx_payload[NRF905_PAYLOAD_SIZE];
+static bool selected; /// CSN low.
+static int command; /// Command of the current SPI transaction (-1: next byte is one).
+static uint8_t data_index;
+static bool transmitting;
+static uint64_t tx_done_us;
+static double spi_remainder_us;
+static uint8_t uplink[UPLINK_QUEUE_LEN][NRF905_PAYLOAD_SIZE];
+static int uplink_count;
+static uint8_t rx_payload[NRF905_PAYLOAD_SIZE];
+static bool rx_ready; /// A received packet waits to be read (DR high in RX mode).
+
+void sim_radio_reset(void)
+{
+    // Power-on configuration of the datasheet: 4-byte addresses, 32-byte payloads, 16-bit CRC.
+    static const uint8_t reset_config[CONFIG_LEN] = {0x6C, 0x00, 0x44, 0x20, 0x20, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7};
+
+    host_spi0.baudrate = host_spi1.baudrate = 0;
+    memcpy(config, reset_config, sizeof(config));
+    memset(tx_payload, 0, sizeof(tx_payload));
+    selected = false;
+    command = -1;
+    transmitting = false;
+    spi_remainder_us = 0;
+    uplink_count = 0;
+    rx_ready = false;
+}
+
+static bool listening(void)
+{
+    return host_gpio_level[PIN_TRX_CE] && !host_gpio_level[PIN_TX_EN] && host_gpio_level[PIN_PWR];
+}
+
+/** @brief Hands the oldest queued uplink packet to a listening radio with nothing pending. */
+static void deliver_uplink(void)
+{
+    if (rx_ready || uplink_count == 0 || !listening() || sim_faults[SIM_DEV_RADIO].stuck) return;
+
+    memcpy(rx_payload, uplink[0], sizeof(rx_payload));
+    memmove(uplink[0], uplink[1], (size_t)(--uplink_count) * sizeof(uplink[0]));
+    rx_ready = true;
+    host_gpio_level[PIN_DR] = true;
+}
+
+void sim_radio_uplink(const uint8_t *payload, size_t len)
+{
+    if (uplink_count == UPLINK_QUEUE_LEN) return;
+
+    if (len > NRF905_PAYLOAD_SIZE) len = NRF905_PAYLOAD_SIZE;
+    memset(uplink[uplink_count], 0, sizeof(uplink[0]));
+    memcpy(uplink[uplink_count], payload, len);
+    uplink_count++;
+    deliver_uplink();
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate)
+{
+    spi->baudrate = baudrate;
+    return baudrate;
+}
+
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate)
+{
+    spi->baudrate = baudrate;
+    return baudrate;
+}
+
+static void wire_time(spi_inst_t *spi, size_t len)
+{
+    if (!spi->baudrate) return;
+
+    double us = spi_remainder_us + len * 8.0 * 1e6 / spi->baudrate;
+    spi_remainder_us = us - (uint64_t)us;
+    sleep_us((uint64_t)us);
+}
+
+static void radio_byte(uint8_t byte)
+{
+    if (command < 0)
+    {
+        command = byte;
+        data_index = 0;
+        return;
+    }
+
+    if (command == CMD_W_CONFIG && data_index < CONFIG_LEN) config[data_index] = byte;
+    else if (command == CMD_W_TX_PAYLOAD && data_index < NRF905_PAYLOAD_SIZE) tx_payload[data_index] = byte;
+    data_index++;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len)
+{
+    wire_time(spi, len);
+    if (spi == spi0 && selected)
+    {
+        for (size_t i = 0; i < len; i++) radio_byte(src[i]);
+    }
+    return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len)
+{
+    wire_time(spi, len);
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = 0;
+        if (spi != spi0 || !selected) continue;
+
+        if (command < 0) radio_byte(repeated_tx_data);
+        else
+        {
+            if (command == CMD_R_CONFIG && data_index < CONFIG_LEN) dst[i] = config[data_index];
+            else if (command == CMD_R_RX_PAYLOAD && data_index < NRF905_PAYLOAD_SIZE) dst[i] = rx_payload[data_index];
+            data_index++;
+        }
+    }
+    return (int)len;
+}
+
+/** @brief Time on air of one packet with the current configuration [us]. */
+static uint64_t air_time_us(void)
+{
+    uint32_t address_bytes = (config[2] >> 4) & 0x07;
+    uint32_t payload_bytes = config[4] & 0x3F;
+    bool crc = config[9] & 0x08;
+    uint32_t crc_bits = crc ? ((config[9] & 0x80) ? 16 : 8) : 0;
+    uint32_t bits = PREAMBLE_BITS + 8 * (address_bytes + payload_bytes) + crc_bits;
+
+    return (uint64_t)bits * 1000000 / AIR_BIT_RATE;
+}
+
+void sim_radio_gpio(unsigned int gpio, bool level)
+{
+    switch (gpio)
+    {
+        case PIN_CSN:
+            if (level && selected && command == CMD_R_RX_PAYLOAD && rx_ready)
+            {
+                rx_ready = false;
+                host_gpio_level[PIN_DR] = false;
+                deliver_uplink();
+            }
+            selected = !level;
+            command = -1;
+            break;
+        case PIN_TRX_CE:
+        case PIN_TX_EN:
+        {
+            bool tx = host_gpio_level[PIN_TRX_CE] && host_gpio_level[PIN_TX_EN] && host_gpio_level[PIN_PWR];
+
+            if (!tx)
+            {
+                // Standby or RX: DR of a finished packet falls; a packet on air is still completed.
+                // In RX, DR flags a received packet instead.
+                host_gpio_level[PIN_DR] = rx_ready && listening();
+                deliver_uplink();
+            }
+            else if (!transmitting && gpio == PIN_TRX_CE)
+            {
+                transmitting = true;
+                tx_done_us = host_time_us + sim_faults[SIM_DEV_RADIO].conversion_us + air_time_us();
+                sim_stats[SIM_DEV_RADIO].transfers++;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+uint64_t sim_radio_next_event_us(void)
+{
+    return (transmitting && !sim_faults[SIM_DEV_RADIO].stuck) ? tx_done_us : UINT64_MAX;
+}
+
+/** @brief The ground station's side of a packet that has gone out. */
+static void receive(void)
+{
+    uint8_t payload[NRF905_PAYLOAD_SIZE];
+    uint32_t len = config[4] & 0x3F;
+
+    if (len > sizeof(payload)) len = sizeof(payload);
+    memcpy(payload, tx_payload, len);
+
+    if (sim_chance(sim_faults[SIM_DEV_RADIO].nak_prob))
+    {
+        sim_stats[SIM_DEV_RADIO].naks_injected++;
+        return;
+    }
+
+    uint32_t corrupted = sim_stats[SIM_DEV_RADIO].bytes_corrupted;
+    sim_corrupt(SIM_DEV_RADIO, payload, len);
+    if (sim_stats[SIM_DEV_RADIO].bytes_corrupted != corrupted) return;
+
+    sim_stats[SIM_DEV_RADIO].conversions++;
+    if (sim_radio_log)
+    {
+        // The firmware sends text padded with zeros.
+        fprintf(sim_radio_log, "%llu.%06llu %.*s\n",
+                (unsigned long long)(host_time_us / 1000000), (unsigned long long)(host_time_us % 1000000),
+                (int)strnlen((const char *)payload, len), (const char *)payload);
+    }
+}
+
+void sim_radio_step(void)
+{
+    if (!transmitting || sim_faults[SIM_DEV_RADIO].stuck || host_time_us < tx_done_us) return;
+
+    transmitting = false;
+    receive();
+
+    if (host_gpio_level[PIN_TRX_CE] && host_gpio_level[PIN_TX_EN]) host_gpio_level[PIN_DR] = true;
+}
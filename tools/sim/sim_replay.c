@@ -0,0 +1,460 @@
+/** @file sim_replay.c
+ ** @brief Flight log replay (see sim_replay.h).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "minmea.h"
+#include "sim_replay.h"
+
+#define EARTH_RADIUS_M 6371000.0
+#define DEG_TO_RAD (M_PI / 180.0)
+#define SECONDS_PER_DAY 86400
+
+/** @brief Boot to the first NMEA epoch when there is no GPS log to align with [s]. */
+#define FIRST_EPOCH_S 1.0
+
+#define LINE_LEN 512
+
+/** @brief Quantities of the data log. */
+enum
+{
+    CH_PRESSURE = 0,
+    CH_TEMPERATURE,
+    CH_HUMIDITY,
+    CH_METHANE,
+    CH_AMMONIA,
+    CH_OXYGEN,
+    CH_COUNT
+};
+
+typedef struct
+{
+    double t_s; /// Since boot [s].
+    double value;
+} sample_t;
+
+typedef struct
+{
+    sample_t *v;
+    size_t count;
+    size_t capacity;
+    size_t cursor; /// Last sample at or before the replay time.
+} series_t;
+
+typedef struct
+{
+    double t_s; /// Reception time, since boot [s].
+    double tod_s; /// UTC time of day of the fix [s].
+    double latitude_deg;
+    double longitude_deg;
+    double altitude_m;
+    uint8_t satellites;
+    bool fix;
+} gps_row_t;
+
+typedef struct
+{
+    double tod_s; /// UTC time of day [s].
+    size_t first; /// Index of its first sentence.
+} epoch_t;
+
+static series_t series[CH_COUNT];
+
+static gps_row_t *rows;
+static size_t row_count, row_capacity, row_cursor;
+
+static char *nmea_text; /// Sentences, each NUL-terminated.
+static size_t text_size, text_capacity;
+static size_t *sentences; /// Offsets into `nmea_text`.
+static size_t sentence_count, sentence_capacity;
+static epoch_t *epochs;
+static size_t epoch_count, epoch_capacity, epoch_cursor;
+
+static sim_replay_info_t info;
+static bool active;
+static double speed;
+static double boot_tod_s;
+
+/** @brief Makes room for one more item in a growing array. */
+static bool reserve(void **items, size_t *capacity, size_t count, size_t size)
+{
+    if (count < *capacity) return true;
+
+    size_t n = *capacity ? *capacity * 2 : 256;
+    void *p = realloc(*items, n * size);
+    if (!p) return false;
+    *items = p;
+    *capacity = n;
+    return true;
+}
+
+static void series_add(int ch, double t_s, double value)
+{
+    series_t *s = &series[ch];
+
+    // Equal times are the same reading logged again.
+    if (s->count && t_s <= s->v[s->count - 1].t_s) return;
+    if (!reserve((void **)&s->v, &s->capacity, s->count, sizeof(sample_t))) return;
+
+    s->v[s->count++] = (sample_t){t_s, value};
+    info.sensor_samples++;
+}
+
+/** @brief Value of a quantity at `t_s`, linear between samples. */
+static bool series_at(series_t *s, double t_s, double *value)
+{
+    if (s->count == 0) return false;
+
+    while (s->cursor + 1 < s->count && s->v[s->cursor + 1].t_s <= t_s) s->cursor++;
+
+    const sample_t *a = &s->v[s->cursor];
+    if (t_s <= a->t_s || s->cursor + 1 == s->count)
+    {
+        *value = a->value;
+        return true;
+    }
+
+    const sample_t *b = a + 1;
+    *value = a->value + (b->value - a->value) * (t_s - a->t_s) / (b->t_s - a->t_s);
+    return true;
+}
+
+static double last_time_s(void)
+{
+    double last = 0;
+
+    for (int ch = 0; ch < CH_COUNT; ch++)
+    {
+        if (series[ch].count) last = fmax(last, series[ch].v[series[ch].count - 1].t_s);
+    }
+    if (row_count) last = fmax(last, rows[row_count - 1].t_s);
+    return last;
+}
+
+bool sim_replay_load_data_log(const char *path)
+{
+    FILE *in = fopen(path, "r");
+    char line[LINE_LEN];
+    double boot_t = -1; // Latest time seen: a smaller one starts a new boot.
+    bool rebooted = false;
+
+    if (!in) return false;
+
+    for (int ch = 0; ch < CH_COUNT; ch++)
+    {
+        series[ch].count = 0;
+        series[ch].cursor = 0;
+    }
+    info.sensor_samples = info.skipped_samples = 0;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        const char *p;
+        double t[3], v[3];
+        int fields = 0;
+
+        if ((p = strstr(line, "[BMP280] ")))
+        {
+            fields = sscanf(p, "[BMP280] t=%lf s | Pressure: %lf Pa", &t[0], &v[0]);
+            if (fields != 2) continue;
+            if (t[0] < boot_t) rebooted = true;
+            if (rebooted || v[0] == -1.0) info.skipped_samples++;
+            else series_add(CH_PRESSURE, t[0], v[0]);
+            boot_t = fmax(boot_t, t[0]);
+        }
+        else if ((p = strstr(line, "[SHTC3] ")))
+        {
+            fields = sscanf(p, "[SHTC3] t=%lf s | Temperature: %lf C, Humidity: %lf", &t[0], &v[0], &v[1]);
+            if (fields != 3) continue;
+            if (t[0] < boot_t) rebooted = true;
+            // A failed read logs zero for both.
+            if (rebooted || (v[0] == 0.0 && v[1] == 0.0)) info.skipped_samples += 2;
+            else
+            {
+                series_add(CH_TEMPERATURE, t[0], v[0]);
+                series_add(CH_HUMIDITY, t[0], v[1]);
+            }
+            boot_t = fmax(boot_t, t[0]);
+        }
+        else if ((p = strstr(line, "[GASES] ")))
+        {
+            fields = sscanf(p, "[GASES] CH4: %lf ppm (t=%lf s), NH3: %lf ppm (t=%lf s), O2: %lf %% (t=%lf s)",
+                            &v[0], &t[0], &v[1], &t[1], &v[2], &t[2]);
+            if (fields != 6) continue;
+            if (t[0] < boot_t) rebooted = true;
+            for (int i = 0; i < 3; i++)
+            {
+                if (rebooted || v[i] < 0 || (i == 2 && v[i] == 0)) info.skipped_samples++;
+                else series_add(CH_METHANE + i, t[i], v[i]);
+                boot_t = fmax(boot_t, t[i]);
+            }
+        }
+    }
+
+    fclose(in);
+    return true;
+}
+
+bool sim_replay_load_gps_log(const char *path)
+{
+    FILE *in = fopen(path, "r");
+    char line[LINE_LEN];
+
+    if (!in) return false;
+
+    row_count = 0;
+    info.gps_rows = 0;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        gps_row_t r;
+        int hour, min, sats, fix;
+        double sec;
+
+        if (sscanf(line, "%lf,%d:%d:%lf,%lf,%lf,%lf,%d,%d", &r.t_s, &hour, &min, &sec,
+                   &r.latitude_deg, &r.longitude_deg, &r.altitude_m, &sats, &fix) != 9) continue;
+
+        // No sentence received yet.
+        if (r.t_s == 0) continue;
+        if (row_count)
+        {
+            // The same fix logged again, or a later boot.
+            if (r.t_s == rows[row_count - 1].t_s) continue;
+            if (r.t_s < rows[row_count - 1].t_s) break;
+        }
+        if (!reserve((void **)&rows, &row_capacity, row_count, sizeof(gps_row_t))) break;
+
+        r.tod_s = hour * 3600 + min * 60 + sec;
+        r.satellites = (uint8_t)sats;
+        r.fix = fix != 0;
+        rows[row_count++] = r;
+    }
+    info.gps_rows = (uint32_t)row_count;
+
+    fclose(in);
+    return true;
+}
+
+/** @brief UTC time of day carried by a sentence, if it has one. */
+static bool sentence_time(const char *s, double *tod_s)
+{
+    struct minmea_time t = { .hours = -1 };
+
+    switch (minmea_sentence_id(s, false))
+    {
+        case MINMEA_SENTENCE_RMC:
+        {
+            struct minmea_sentence_rmc f;
+            if (minmea_parse_rmc(&f, s)) t = f.time;
+            break;
+        }
+        case MINMEA_SENTENCE_GGA:
+        {
+            struct minmea_sentence_gga f;
+            if (minmea_parse_gga(&f, s)) t = f.time;
+            break;
+        }
+        case MINMEA_SENTENCE_GLL:
+        {
+            struct minmea_sentence_gll f;
+            if (minmea_parse_gll(&f, s)) t = f.time;
+            break;
+        }
+        case MINMEA_SENTENCE_ZDA:
+        {
+            struct minmea_sentence_zda f;
+            if (minmea_parse_zda(&f, s)) t = f.time;
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (t.hours < 0) return false;
+    *tod_s = t.hours * 3600 + t.minutes * 60 + t.seconds + t.microseconds / 1e6;
+    return true;
+}
+
+bool sim_replay_load_nmea(const char *path)
+{
+    FILE *in = fopen(path, "r");
+    char line[LINE_LEN];
+
+    if (!in) return false;
+
+    text_size = sentence_count = epoch_count = 0;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        char *s = strchr(line, '$');
+        if (!s) continue;
+
+        size_t len = strcspn(s, "\r\n");
+        s[len] = '\0';
+
+        while (text_size + len + 1 > text_capacity)
+        {
+            size_t n = text_capacity ? text_capacity * 2 : 65536;
+            char *p = realloc(nmea_text, n);
+            if (!p) goto done;
+            nmea_text = p;
+            text_capacity = n;
+        }
+        if (!reserve((void **)&sentences, &sentence_capacity, sentence_count, sizeof(size_t))) break;
+
+        memcpy(nmea_text + text_size, s, len + 1);
+        sentences[sentence_count] = text_size;
+        text_size += len + 1;
+
+        // A new UTC time starts an epoch; sentences before the first one belong to it.
+        double tod;
+        if (sentence_time(s, &tod) && (epoch_count == 0 || fabs(tod - epochs[epoch_count - 1].tod_s) > 1e-6))
+        {
+            if (!reserve((void **)&epochs, &epoch_capacity, epoch_count, sizeof(epoch_t))) break;
+            epochs[epoch_count] = (epoch_t){tod, epoch_count ? sentence_count : 0};
+            epoch_count++;
+        }
+        sentence_count++;
+    }
+
+done:
+    info.nmea_sentences = (uint32_t)sentence_count;
+    info.nmea_epochs = (uint32_t)epoch_count;
+    fclose(in);
+    return true;
+}
+
+/** @brief UTC time of day at boot: from the first GPS log row with a fix, else from the capture. */
+static double boot_time_of_day(void)
+{
+    for (size_t i = 0; i < row_count; i++)
+    {
+        if (rows[i].fix) return rows[i].tod_s - rows[i].t_s;
+    }
+    return epoch_count ? epochs[0].tod_s - FIRST_EPOCH_S : 0;
+}
+
+/** @brief Recorded time of an epoch, since boot [s] (negative: before boot). */
+static double epoch_time_s(size_t e)
+{
+    double t = epochs[e].tod_s - boot_tod_s;
+
+    // Across midnight.
+    if (t < -SECONDS_PER_DAY / 2) t += SECONDS_PER_DAY;
+    return t;
+}
+
+/** @brief Simulated time at which an epoch is sent [us], or UINT64_MAX if it lies before boot. */
+static uint64_t epoch_time_us(size_t e)
+{
+    double t = epoch_time_s(e);
+
+    return t < 0 ? UINT64_MAX : (uint64_t)llround(t / speed * 1e6);
+}
+
+const sim_replay_info_t *sim_replay_info(void)
+{
+    boot_tod_s = boot_time_of_day();
+    info.duration_s = last_time_s();
+    if (epoch_count) info.duration_s = fmax(info.duration_s, epoch_time_s(epoch_count - 1));
+    return &info;
+}
+
+void sim_replay_reset(void)
+{
+    active = false;
+}
+
+void sim_replay_start(double replay_speed)
+{
+    speed = replay_speed > 0 ? replay_speed : 1.0;
+    active = true;
+
+    for (int ch = 0; ch < CH_COUNT; ch++) series[ch].cursor = 0;
+    row_cursor = 0;
+    epoch_cursor = 0;
+
+    // The GNSS model reports the recorded UTC.
+    boot_tod_s = boot_time_of_day();
+    if (row_count || epoch_count)
+    {
+        int64_t midnight = sim_env.utc_at_boot_s - sim_env.utc_at_boot_s % SECONDS_PER_DAY;
+        double tod = fmod(boot_tod_s + SECONDS_PER_DAY, SECONDS_PER_DAY);
+        sim_env.utc_at_boot_s = midnight + (int64_t)floor(tod);
+    }
+
+    // Epochs recorded before boot cannot be sent.
+    while (epoch_cursor < epoch_count && epoch_time_us(epoch_cursor) == UINT64_MAX) epoch_cursor++;
+    if (epoch_count) sim_gnss_set_navigation_output(false);
+
+    sim_replay_step();
+}
+
+uint64_t sim_replay_end_us(void)
+{
+    double duration = sim_replay_info()->duration_s;
+
+    return (uint64_t)llround(duration / speed * 1e6);
+}
+
+uint64_t sim_replay_next_event_us(void)
+{
+    return (active && epoch_cursor < epoch_count) ? epoch_time_us(epoch_cursor) : UINT64_MAX;
+}
+
+/** @brief Sets the GNSS part of `sim_env` from the GPS log row in force at `t_s`. */
+static void apply_gps(double t_s)
+{
+    if (row_count == 0 || rows[0].t_s > t_s) return;
+
+    while (row_cursor + 1 < row_count && rows[row_cursor + 1].t_s <= t_s) row_cursor++;
+
+    const gps_row_t *r = &rows[row_cursor];
+
+    sim_env.latitude_deg = r->latitude_deg;
+    sim_env.longitude_deg = r->longitude_deg;
+    sim_env.altitude_m = r->altitude_m;
+    sim_env.satellites = r->satellites;
+    sim_env.fix = r->fix;
+
+    sim_env.ground_speed_mps = 0;
+    if (row_cursor > 0 && r->fix && r[-1].fix)
+    {
+        const gps_row_t *p = r - 1;
+        double north = (r->latitude_deg - p->latitude_deg) * DEG_TO_RAD * EARTH_RADIUS_M;
+        double east = (r->longitude_deg - p->longitude_deg) * DEG_TO_RAD * EARTH_RADIUS_M * cos(r->latitude_deg * DEG_TO_RAD);
+
+        sim_env.ground_speed_mps = hypot(north, east) / (r->t_s - p->t_s);
+        if (sim_env.ground_speed_mps > 0) sim_env.course_deg = fmod(atan2(east, north) / DEG_TO_RAD + 360.0, 360.0);
+    }
+}
+
+void sim_replay_step(void)
+{
+    if (!active) return;
+
+    double t_s = host_time_us / 1e6 * speed;
+    double *targets[CH_COUNT] = {
+        [CH_PRESSURE] = &sim_env.pressure_pa,
+        [CH_TEMPERATURE] = &sim_env.temperature_c,
+        [CH_HUMIDITY] = &sim_env.humidity_pct,
+        [CH_METHANE] = &sim_env.methane_ppm,
+        [CH_AMMONIA] = &sim_env.ammonia_ppm,
+        [CH_OXYGEN] = &sim_env.o2_pct,
+    };
+
+    for (int ch = 0; ch < CH_COUNT; ch++) series_at(&series[ch], t_s, targets[ch]);
+    apply_gps(t_s);
+
+    while (epoch_cursor < epoch_count && epoch_time_us(epoch_cursor) <= host_time_us)
+    {
+        size_t end = (epoch_cursor + 1 < epoch_count) ? epochs[epoch_cursor + 1].first : sentence_count;
+
+        for (size_t i = epochs[epoch_cursor].first; i < end; i++) sim_gnss_send_sentence(nmea_text + sentences[i]);
+        epoch_cursor++;
+    }
+}
@@ -0,0 +1,69 @@
+/** @file sim_replay.h
+ ** @brief Flight log replay: drives `sim_env` and the GNSS output from recorded data.
+ * @details Recordings are read from the files the firmware and the receiver produce:
+ * - `data_log.txt` (microsd_module.c): every sensor value with its acquisition time. Between
+ *   two samples the quantity is interpolated linearly; readings the firmware flagged as
+ *   failed are skipped. Only the first boot of a log is used.
+ * - `gps_log.csv` (microsd_module.c): position, altitude, satellites and fix at the time they
+ *   were received. They are held until the next row; ground speed and course follow from
+ *   consecutive positions. The GNSS model outputs them as it would its own.
+ * - NMEA text captured from the receiver (as read by tools/nmea_ingest): sent verbatim
+ *   through the GNSS model in place of its own output, one epoch (the sentences sharing a UTC
+ *   time) at a time. The epochs keep their recorded spacing; they are placed on the boot
+ *   timeline by the UTC times of `gps_log.csv` if it is loaded, else from 1 s after boot.
+ *
+ * The recorded timeline starts at boot; it is replayed as recorded or `speed` times faster
+ * (all recorded times divided by `speed`), with the firmware running at its own pace. Faster
+ * NMEA text has to fit through the receiver's link: what does not fit into its transmit buffer
+ * is dropped, as on the receiver.
+ */
+
+#ifndef SIM_REPLAY_H
+#define SIM_REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+// DATA STRUCTURES
+
+/** @brief What was loaded. */
+typedef struct
+{
+    uint32_t sensor_samples; /// Values read from the data log, all quantities.
+    uint32_t skipped_samples; /// Readings flagged as failed, or from a later boot.
+    uint32_t gps_rows;
+    uint32_t nmea_sentences;
+    uint32_t nmea_epochs;
+    double duration_s; /// Last recorded time, since boot [s].
+} sim_replay_info_t;
+
+// FUNCTIONS
+
+/** @brief Loads the sensor values of a `data_log.txt`, replacing earlier ones.
+ ** @return false if the file cannot be read.
+ */
+extern bool sim_replay_load_data_log(const char *path);
+
+/** @brief Loads the fixes of a `gps_log.csv`, replacing earlier ones.
+ ** @return false if the file cannot be read.
+ */
+extern bool sim_replay_load_gps_log(const char *path);
+
+/** @brief Loads captured NMEA text, replacing earlier text.
+ ** @return false if the file cannot be read.
+ */
+extern bool sim_replay_load_nmea(const char *path);
+
+/** @brief Describes the loaded recordings. */
+extern const sim_replay_info_t *sim_replay_info(void);
+
+/** @brief Starts the replay at simulated time 0 (call after `sim_init()`).
+ ** @param[in] speed Replay rate; 1 for the recorded timing.
+ */
+extern void sim_replay_start(double speed);
+
+/** @brief Simulated time at which the recording ends [us]. */
+extern uint64_t sim_replay_end_us(void);
+
+#endif // SIM_REPLAY_H
@@ -0,0 +1,151 @@
+/** @file sim_sd.c
+ ** @brief microSD card behind the host `diskio.h`: initialization and block transfer timing.
+ * @details The card sits on SPI at the clock of src/hw_config.c. The data itself lives in
+ * sim_fatfs.c; this model accounts for the time of each operation, as the SPI driver of
+ * no-OS-FatFS-SD-SPI-RPi-Pico would spend it:
+ * - `disk_initialize()`: the SPI-mode power-up (CMD0, CMD8, ACMD41 until the card leaves
+ *   idle), once per power cycle,
+ * - `disk_read()`: command, access time, then each 512-byte block with its token and CRC,
+ * - `disk_write()`: command, each block with its token and CRC, then the busy time while the
+ *   card programs it (`conversion_us`), plus `stall_us` with `stall_prob` (the card's internal
+ *   garbage collection; the SD specification allows up to 250 ms).
+ *
+ * `nak_prob` fails an operation after its time; a stuck card is missing: initialization fails
+ * and every operation reports the drive not ready.
+ */
+
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "diskio.h"
+#include "sd_card.h"
+#include "sim.h"
+
+#define SECTOR_SIZE 512
+
+/** @brief Bytes on the bus per command: CMD (6), response wait and R1. */
+#define COMMAND_BYTES 16
+
+/** @brief Bytes around each block: start token, CRC, data response. */
+#define BLOCK_OVERHEAD_BYTES 4
+
+/** @brief Power-up until ACMD41 reports the card ready [us]. */
+#define INIT_US 120000
+
+/** @brief Read access time, from the command to the data token [us]. */
+#define READ_ACCESS_US 300
+
+extern sd_card_t *sd_get_by_num(size_t num);
+
+static double remainder_us;
+
+void sim_sd_reset(void)
+{
+    sd_card_t *card = sd_get_by_num(0);
+
+    if (card) card->m_Status = STA_NOINIT;
+    remainder_us = 0;
+}
+
+/** @brief Spends the time of `bytes` on the card's SPI bus plus `extra_us`. */
+static void bus_time(uint32_t bytes, uint32_t extra_us)
+{
+    sd_card_t *card = sd_get_by_num(0);
+    double us = remainder_us + extra_us + bytes * 8.0 * 1e6 / card->spi->baud_rate;
+
+    remainder_us = us - (uint64_t)us;
+    sleep_us((uint64_t)us);
+}
+
+static sd_card_t *card_of(BYTE pdrv)
+{
+    return pdrv == 0 ? sd_get_by_num(0) : NULL;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+    sd_card_t *card = card_of(pdrv);
+
+    if (!card) return STA_NOINIT;
+    if (!(card->m_Status & STA_NOINIT)) return (DSTATUS)card->m_Status;
+
+    if (sim_faults[SIM_DEV_SD].stuck)
+    {
+        // No answer to CMD0: the driver gives up after its retries.
+        bus_time(10 * COMMAND_BYTES, 0);
+        sim_stats[SIM_DEV_SD].timeouts++;
+        card->m_Status = STA_NOINIT | STA_NODISK;
+        return (DSTATUS)card->m_Status;
+    }
+
+    bus_time(4 * COMMAND_BYTES, INIT_US);
+    card->m_Status &= ~(STA_NOINIT | STA_NODISK);
+    return (DSTATUS)card->m_Status;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+    sd_card_t *card = card_of(pdrv);
+
+    return card ? (DSTATUS)card->m_Status : STA_NOINIT;
+}
+
+/** @brief Common checks of a block operation. */
+static DRESULT begin(BYTE pdrv, UINT count)
+{
+    sd_card_t *card = card_of(pdrv);
+
+    if (!card || count == 0) return RES_PARERR;
+    sim_stats[SIM_DEV_SD].transfers++;
+    if (card->m_Status & STA_NOINIT) return RES_NOTRDY;
+    if (sim_faults[SIM_DEV_SD].stuck)
+    {
+        bus_time(COMMAND_BYTES, 0);
+        sim_stats[SIM_DEV_SD].timeouts++;
+        return RES_NOTRDY;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    (void)sector;
+    DRESULT res = begin(pdrv, count);
+
+    if (res != RES_OK) return res;
+
+    bus_time(COMMAND_BYTES + count * (SECTOR_SIZE + BLOCK_OVERHEAD_BYTES), count * READ_ACCESS_US);
+    for (UINT i = 0; i < count * SECTOR_SIZE; i++) buff[i] = 0;
+
+    if (sim_chance(sim_faults[SIM_DEV_SD].nak_prob))
+    {
+        sim_stats[SIM_DEV_SD].naks_injected++;
+        return RES_ERROR;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    (void)buff;
+    (void)sector;
+    const sim_faults_t *f = &sim_faults[SIM_DEV_SD];
+    DRESULT res = begin(pdrv, count);
+
+    if (res != RES_OK) return res;
+
+    uint32_t busy_us = count * f->conversion_us;
+    if (sim_chance(f->stall_prob))
+    {
+        busy_us += f->stall_us;
+        sim_stats[SIM_DEV_SD].stalls++;
+    }
+    bus_time(COMMAND_BYTES + count * (SECTOR_SIZE + BLOCK_OVERHEAD_BYTES), busy_us);
+
+    if (sim_chance(f->nak_prob))
+    {
+        sim_stats[SIM_DEV_SD].naks_injected++;
+        return RES_ERROR;
+    }
+    sim_stats[SIM_DEV_SD].conversions += count;
+    return RES_OK;
+}
@@ -0,0 +1,156 @@
+/** @file sim_shtc3.c
+ ** @brief SHTC3 model: command set, sleep and wake-up, conversion timing, CRC-8.
+ * @details Follows the datasheet: in sleep mode the device answers to nothing but the wake-up
+ * command, wake-up takes up to 240 us, and during a measurement the address is NAKed unless
+ * a clock-stretching command was used (then the read is held until the result is ready).
+ * Normal mode takes `conversion_us`, low power mode 1/15 of it (0.8 ms vs 12.1 ms).
+ * Results carry the datasheet CRC-8 (polynomial 0x31, init 0xFF) after every word.
+ */
+
+#include "pico/stdlib.h"
+#include "sim.h"
+
+#define CMD_WAKEUP 0x3517
+#define CMD_SLEEP 0xB098
+#define CMD_SOFT_RESET 0x805D
+#define CMD_READ_ID 0xEFC8
+
+#define WAKEUP_US 240
+#define CHIP_ID 0x0887
+
+typedef struct
+{
+    uint16_t cmd;
+    bool stretch; /// Clock stretching: the read waits for the result.
+    bool low_power;
+    bool rh_first;
+} measure_cmd_t;
+
+static const measure_cmd_t measure_cmds[] = {
+    {0x7866, false, false, false},
+    {0x58E0, false, false, true},
+    {0x609C, false, true, false},
+    {0x401A, false, true, true},
+    {0x7CA2, true, false, false},
+    {0x5C24, true, false, true},
+    {0x6458, true, true, false},
+    {0x44DE, true, true, true},
+};
+
+static bool asleep;
+static uint64_t awake_at_us;
+static uint64_t result_at_us;
+static bool stretch;
+static uint8_t result[6];
+static size_t result_len; /// 0: nothing to read.
+
+static uint8_t crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0xFF;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void put_word(uint8_t *dst, uint16_t word)
+{
+    dst[0] = (uint8_t)(word >> 8);
+    dst[1] = (uint8_t)word;
+    dst[2] = crc8(dst, 2);
+}
+
+static uint16_t to_raw(double value, double offset, double span)
+{
+    double raw = (value + offset) * 65535.0 / span;
+    if (raw < 0) raw = 0;
+    if (raw > 65535) raw = 65535;
+    return (uint16_t)(raw + 0.5);
+}
+
+void sim_shtc3_reset(void)
+{
+    asleep = false;
+    awake_at_us = 0;
+    result_len = 0;
+}
+
+int sim_shtc3_write(const uint8_t *src, size_t len)
+{
+    if (len != 2) return PICO_ERROR_GENERIC;
+
+    uint16_t cmd = (uint16_t)(src[0] << 8 | src[1]);
+
+    if (asleep)
+    {
+        if (cmd != CMD_WAKEUP) return PICO_ERROR_GENERIC;
+        asleep = false;
+        awake_at_us = host_time_us + WAKEUP_US;
+        return 2;
+    }
+    if (host_time_us < awake_at_us) return PICO_ERROR_GENERIC;
+    if (result_len && host_time_us < result_at_us) return PICO_ERROR_GENERIC;
+
+    switch (cmd)
+    {
+        case CMD_WAKEUP:
+            return 2;
+        case CMD_SLEEP:
+            asleep = true;
+            result_len = 0;
+            return 2;
+        case CMD_SOFT_RESET:
+            sim_shtc3_reset();
+            return 2;
+        case CMD_READ_ID:
+            put_word(result, CHIP_ID);
+            result_len = 3;
+            result_at_us = host_time_us;
+            return 2;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < sizeof(measure_cmds) / sizeof(measure_cmds[0]); i++)
+    {
+        const measure_cmd_t *m = &measure_cmds[i];
+        if (m->cmd != cmd) continue;
+
+        uint16_t t = to_raw(sim_env.temperature_c, 45.0, 175.0);
+        uint16_t rh = to_raw(sim_env.humidity_pct, 0.0, 100.0);
+        uint32_t conversion = sim_faults[SIM_DEV_SHTC3].conversion_us;
+
+        put_word(&result[0], m->rh_first ? rh : t);
+        put_word(&result[3], m->rh_first ? t : rh);
+        result_len = 6;
+        result_at_us = host_time_us + (m->low_power ? conversion / 15 : conversion);
+        stretch = m->stretch;
+        sim_stats[SIM_DEV_SHTC3].conversions++;
+        return 2;
+    }
+    return PICO_ERROR_GENERIC; // Unknown command
+}
+
+int sim_shtc3_read(uint8_t *dst, size_t len)
+{
+    if (asleep || host_time_us < awake_at_us || result_len == 0) return PICO_ERROR_GENERIC;
+    if (host_time_us < result_at_us)
+    {
+        if (!stretch) return PICO_ERROR_GENERIC;
+        sleep_us(result_at_us - host_time_us);
+    }
+
+    for (size_t i = 0; i < len; i++)
+    {
+        // Reading past the result clocks out 0xFF (nobody drives SDA).
+        dst[i] = (i < result_len) ? result[i] : 0xFF;
+    }
+    result_len = 0;
+    return (int)len;
+}
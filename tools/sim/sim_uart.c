@@ -0,0 +1,243 @@
+/** @file sim_uart.c
+ ** @brief PL011 UART and interrupt controller behind the host SDK headers.
+ * @details Bytes sent by the GNSS model are queued with their arrival time, one character
+ * time (10 bits at the transmitter's baud rate) apart. As simulated time passes they move into
+ * the 32-entry receive FIFO; a byte arriving at a full FIFO is lost and the next one stored
+ * carries the overrun flag, and bytes sent at a baud rate other than the Pico's arrive as
+ * garbage with the framing error flag, as on the PL011.
+ *
+ * While the RX interrupt is enabled and interrupts are not masked
+ * (`save_and_disable_interrupts()`), the registered handler runs whenever the FIFO holds
+ * data. The handler is not re-entered when it reads the clock itself.
+ */
+
+#include <stdio.h>
+#include "hardware/uart.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "sim.h"
+
+#define FIFO_LEN 32
+#define QUEUE_LEN 8192
+
+struct uart_inst
+{
+    uint baudrate;
+    bool rx_irq;
+    bool shown; /// The last register access showed a non-empty FIFO: the next one reads `dr`.
+    uart_hw_t hw;
+};
+
+typedef struct
+{
+    uint8_t byte;
+    uint32_t baudrate; /// Baud rate of the transmitter.
+    uint64_t arrival_us;
+} queued_byte_t;
+
+static struct uart_inst instances[2];
+
+uart_inst_t *const host_uart[2] = {&instances[0], &instances[1]};
+
+// Bytes in flight towards uart0.
+static queued_byte_t queue[QUEUE_LEN];
+static uint32_t queue_head, queue_tail;
+static uint64_t line_free_us;
+
+static uint32_t fifo[FIFO_LEN];
+static uint32_t fifo_head, fifo_tail;
+static bool overrun_pending;
+
+static irq_handler_t uart0_handler;
+static bool uart0_irq_enabled;
+static bool interrupts_masked;
+static bool in_irq;
+
+// Fractions of a microsecond left over by previous writes.
+static double tx_remainder_us;
+
+static double char_time_us(uint32_t baudrate)
+{
+    return 10.0 * 1e6 / baudrate;
+}
+
+void sim_uart_reset(void)
+{
+    for (int i = 0; i < 2; i++) instances[i] = (struct uart_inst){0};
+    queue_head = queue_tail = 0;
+    line_free_us = 0;
+    fifo_head = fifo_tail = 0;
+    overrun_pending = false;
+    uart0_handler = NULL;
+    uart0_irq_enabled = false;
+    interrupts_masked = false;
+    in_irq = false;
+    tx_remainder_us = 0;
+}
+
+void sim_uart_transmit(const uint8_t *data, size_t len, uint32_t baudrate)
+{
+    double t = (double)((line_free_us > host_time_us) ? line_free_us : host_time_us);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (queue_head - queue_tail == QUEUE_LEN)
+        {
+            fprintf(stderr, "[SIM] UART queue full, receiver output dropped\n");
+            break;
+        }
+        t += char_time_us(baudrate);
+        queue[queue_head++ % QUEUE_LEN] = (queued_byte_t){
+            .byte = data[i],
+            .baudrate = baudrate,
+            .arrival_us = (uint64_t)t,
+        };
+    }
+    line_free_us = (uint64_t)t;
+}
+
+uint32_t sim_uart_tx_pending(void)
+{
+    return queue_head - queue_tail;
+}
+
+uint64_t sim_uart_next_event_us(void)
+{
+    return (queue_tail != queue_head) ? queue[queue_tail % QUEUE_LEN].arrival_us : UINT64_MAX;
+}
+
+/** @brief Moves the bytes that have arrived by now into the FIFO. */
+static void receive(void)
+{
+    struct uart_inst *u = &instances[0];
+
+    while (queue_tail != queue_head && queue[queue_tail % QUEUE_LEN].arrival_us <= host_time_us)
+    {
+        const queued_byte_t *q = &queue[queue_tail++ % QUEUE_LEN];
+        uint32_t dr = q->byte;
+
+        if (u->baudrate == 0) continue; // UART not initialised: the line is ignored.
+
+        if (q->baudrate != u->baudrate) dr = (uint32_t)(sim_random() * 256) | UART_UARTDR_FE_BITS;
+
+        if (fifo_head - fifo_tail == FIFO_LEN)
+        {
+            overrun_pending = true;
+            continue;
+        }
+        if (overrun_pending)
+        {
+            dr |= UART_UARTDR_OE_BITS;
+            overrun_pending = false;
+        }
+        fifo[fifo_head++ % FIFO_LEN] = dr;
+    }
+}
+
+void sim_uart_pump(void)
+{
+    receive();
+
+    if (in_irq || interrupts_masked || !uart0_handler || !uart0_irq_enabled || !instances[0].rx_irq) return;
+    if (fifo_head == fifo_tail) return;
+
+    in_irq = true;
+    uart0_handler();
+    in_irq = false;
+}
+
+uint uart_init(uart_inst_t *uart, uint baudrate)
+{
+    uart->baudrate = baudrate;
+    if (uart == uart0) fifo_tail = fifo_head;
+    return baudrate;
+}
+
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate)
+{
+    uart->baudrate = baudrate;
+    return baudrate;
+}
+
+bool uart_is_readable(uart_inst_t *uart)
+{
+    return uart == uart0 && fifo_head != fifo_tail;
+}
+
+uart_hw_t *uart_get_hw(uart_inst_t *uart)
+{
+    uart->hw.dr = (uart == uart0 && fifo_head != fifo_tail) ? fifo[fifo_tail++ % FIFO_LEN] : 0;
+    return &uart->hw;
+}
+
+uart_hw_t *host_uart_hw(uart_inst_t *uart)
+{
+    bool readable = uart_is_readable(uart);
+
+    if (uart->shown) uart_get_hw(uart);
+    else uart->hw.fr = readable ? 0 : UART_UARTFR_RXFE_BITS;
+    uart->shown = !uart->shown && readable;
+    return &uart->hw;
+}
+
+char uart_getc(uart_inst_t *uart)
+{
+    while (!uart_is_readable(uart)) sleep_us(1);
+    return (char)uart_get_hw(uart)->dr;
+}
+
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        double us = tx_remainder_us + char_time_us(uart->baudrate);
+
+        tx_remainder_us = us - (uint64_t)us;
+        sleep_us((uint64_t)us);
+        if (uart == uart0) sim_gnss_receive(src[i], uart->baudrate);
+    }
+}
+
+void uart_tx_wait_blocking(uart_inst_t *uart)
+{
+    (void)uart; // uart_write_blocking() returns once the last byte is on the wire.
+}
+
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data, bool tx_needs_data)
+{
+    (void)tx_needs_data;
+    uart->rx_irq = rx_has_data;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+    if (num == UART0_IRQ) uart0_handler = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    if (num == UART0_IRQ)
+    {
+        uart0_irq_enabled = enabled;
+        sim_uart_pump();
+    }
+}
+
+bool irq_is_enabled(uint num)
+{
+    return num == UART0_IRQ && uart0_irq_enabled;
+}
+
+uint32_t save_and_disable_interrupts(void)
+{
+    uint32_t status = interrupts_masked;
+
+    interrupts_masked = true;
+    return status;
+}
+
+void restore_interrupts(uint32_t status)
+{
+    interrupts_masked = status != 0;
+    sim_uart_pump();
+}
@@ -0,0 +1,125 @@
+/** @file trace2json.c
+ ** @brief Host tool: converts a firmware trace dump into Chrome trace JSON.
+ * @details Reads the text printed by `trace_dump()` (src/trace.c), typically a capture of
+ * the USB serial console, and writes a Chrome trace event file that opens in Perfetto
+ * (ui.perfetto.dev) or chrome://tracing. Other console output around the dump is ignored.
+ *
+ * Usage: `trace2json [dump.txt] [trace.json]` (stdin/stdout when omitted).
+ *
+ * - Event names come from the `# name <id> <name>` lines of the dump header.
+ * - Each core becomes one thread of the timeline.
+ * - The 32-bit microsecond timestamps are unwrapped, so dumps spanning a wrap stay ordered.
+ * - End events whose begin has already been overwritten in the ring are dropped.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_IDS 256
+#define MAX_CORES 2
+
+static char *names[MAX_IDS];
+
+/** @brief Open begin events per core and ID, used to drop orphaned end events. */
+static unsigned open_count[MAX_CORES][MAX_IDS];
+
+static const char *event_name(unsigned id)
+{
+    static char fallback[16];
+
+    if (id < MAX_IDS && names[id]) return names[id];
+    snprintf(fallback, sizeof(fallback), "id_%u", id);
+    return fallback;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = (argc > 1) ? fopen(argv[1], "r") : stdin;
+    FILE *out = (argc > 2) ? fopen(argv[2], "w") : stdout;
+    if (!in || !out)
+    {
+        perror(argc > 1 ? argv[1] : "trace2json");
+        return EXIT_FAILURE;
+    }
+
+    char line[256];
+    uint64_t epoch = 0;
+    uint32_t prev = 0;
+    bool first = true;
+    unsigned long events = 0, dropped = 0;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CS_Soft\"}}");
+    for (int core = 0; core < MAX_CORES; core++)
+    {
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"core%d\"}}", core, core);
+    }
+
+    while (fgets(line, sizeof(line), in))
+    {
+        unsigned id, core, arg;
+        unsigned long time_us;
+        char phase;
+        char name[64];
+
+        if (sscanf(line, "# name %u %63s", &id, name) == 2)
+        {
+            if (id < MAX_IDS)
+            {
+                free(names[id]);
+                names[id] = strdup(name);
+            }
+            continue;
+        }
+        if (!strncmp(line, "# trace", 7))
+        {
+            // A new dump starts: its first timestamp sets the epoch again.
+            first = true;
+            memset(open_count, 0, sizeof(open_count));
+            continue;
+        }
+        if (sscanf(line, "%lu,%c,%u,%u,%u", &time_us, &phase, &id, &core, &arg) != 5) continue;
+        if (core >= MAX_CORES || id >= MAX_IDS) continue;
+
+        uint32_t t = (uint32_t)time_us;
+        if (!first && t < prev && prev - t > 0x80000000u) epoch += 1ULL << 32;
+        first = false;
+        prev = t;
+        uint64_t ts = epoch + t;
+
+        switch (phase)
+        {
+            case 'B':
+                open_count[core][id]++;
+                break;
+            case 'E':
+                if (open_count[core][id] == 0)
+                {
+                    dropped++;
+                    continue;
+                }
+                open_count[core][id]--;
+                break;
+            case 'i':
+                break;
+            default:
+                continue;
+        }
+
+        fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u",
+                event_name(id), phase, (unsigned long long)ts, core);
+        if (phase == 'i') fprintf(out, ",\"s\":\"t\",\"args\":{\"arg\":%u}", arg);
+        fprintf(out, "}");
+        events++;
+    }
+
+    fprintf(out, "\n]}\n");
+    fprintf(stderr, "trace2json: %lu events, %lu orphaned end events dropped\n", events, dropped);
+
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+    return EXIT_SUCCESS;
+}
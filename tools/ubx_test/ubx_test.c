@@ -0,0 +1,266 @@
+/** @file ubx_test.c
+ ** @brief Host unit tests of the UBX framer and decoders (src/ubx_protocol.c).
+ * @details Feeds NAV-PVT and NAV-CLK frames, byte for byte as the receiver sends them, through
+ * `ubx_parser_feed()` and checks the decoded fields, then the cases the GPS UART meets in
+ * practice: a corrupted checksum, NMEA text around the frames, a frame arriving over several
+ * reads of the receive ring, and a corrupted length field.
+ *
+ * The built-in frames are synthetic: laid out field by field from the interface description,
+ * with the checksum computed, not recorded from a receiver. A raw capture of the GPS UART
+ * (NMEA and UBX interleaved, e.g. `cat /dev/ttyACM0 > capture.ubx` from the receiver's USB
+ * port) can be checked as well: every frame in it must pass the checksum, and every NAV-PVT and
+ * NAV-CLK must decode.
+ *
+ * Usage: `ubx_test [capture.ubx]` (run by ctest without a capture). Prints each failed check
+ * and exits non-zero if any failed.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ubx_protocol.h"
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { failures++; printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+// Synthetic NAV-PVT of a 3-D fix at 51.1156808 N, 17.0252815 E, 120 m MSL, 9 satellites, 2026-03-14 12:00:05.0001 UTC.
+static const uint8_t nav_pvt_frame[] = {
+    0xB5, 0x62, 0x01, 0x07, 0x5C, 0x00, 0x78, 0xF7, 0x37, 0x17, 0xEA, 0x07,
+    0x03, 0x0E, 0x0C, 0x00, 0x05, 0x37, 0x19, 0x00, 0x00, 0x00, 0xA0, 0x86,
+    0x01, 0x00, 0x03, 0x01, 0x0A, 0x09, 0x0F, 0xDA, 0x25, 0x0A, 0x48, 0xA2,
+    0x77, 0x1E, 0x59, 0x72, 0x02, 0x00, 0xC0, 0xD4, 0x01, 0x00, 0x08, 0x07,
+    0x00, 0x00, 0xC4, 0x09, 0x00, 0x00, 0x50, 0xFB, 0xFF, 0xFF, 0x48, 0x0D,
+    0x00, 0x00, 0x14, 0xEC, 0xFF, 0xFF, 0x16, 0x0E, 0x00, 0x00, 0x08, 0xD3,
+    0xA6, 0x00, 0x5E, 0x01, 0x00, 0x00, 0x38, 0x1F, 0x1C, 0x00, 0x84, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x2E, 0x26,
+};
+
+// Synthetic NAV-CLK of the same epoch: bias 281 ns, drift 1234 ns/s.
+static const uint8_t nav_clk_frame[] = {
+    0xB5, 0x62, 0x01, 0x22, 0x14, 0x00, 0x78, 0xF7, 0x37, 0x17, 0x19, 0x01,
+    0x00, 0x00, 0xD2, 0x04, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x6C, 0x02,
+    0x00, 0x00, 0x5E, 0xB1,
+};
+
+static const char nmea_noise[] =
+    "$GNRMC,120005.00,A,5106.94085,N,01701.51689,E,0.016,,140326,,,A*6B\r\n"
+    "$GNGGA,120005.00,5106.94085,N,01701.51689,E,1,09,1.32,120.0,M,40.5,M,,*4F\r\n";
+
+/** @brief Feeds `len` bytes; returns how many frames they completed, the last one left in `parser`. */
+static int feed(ubx_parser_t *parser, const uint8_t *data, size_t len)
+{
+    int frames = 0;
+
+    for (size_t i = 0; i < len; i++) frames += ubx_parser_feed(parser, data[i]);
+    return frames;
+}
+
+static void check_nav_pvt(const ubx_parser_t *parser)
+{
+    ubx_nav_pvt_t pvt;
+
+    CHECK(ubx_decode_nav_pvt(parser, &pvt));
+    CHECK(pvt.itow_ms == 389543800);
+    CHECK(pvt.year == 2026 && pvt.month == 3 && pvt.day == 14);
+    CHECK(pvt.hour == 12 && pvt.min == 0 && pvt.sec == 5);
+    CHECK((pvt.valid & (UBX_NAV_PVT_VALID_DATE | UBX_NAV_PVT_VALID_TIME)) == (UBX_NAV_PVT_VALID_DATE | UBX_NAV_PVT_VALID_TIME));
+    CHECK(pvt.nano == 100000);
+    CHECK(pvt.fix_type == UBX_FIX_3D && (pvt.flags & UBX_NAV_PVT_FLAGS_FIX_OK));
+    CHECK(pvt.num_sv == 9);
+    CHECK(pvt.lat_e7 == 511156808 && pvt.lon_e7 == 170252815);
+    CHECK(pvt.hmsl_mm == 120000);
+    CHECK(pvt.vel_d_mm_s == -5100 && pvt.g_speed_mm_s == 3606);
+    CHECK(pvt.pdop_e2 == 132);
+}
+
+static void test_nav_pvt(void)
+{
+    ubx_parser_t parser;
+    ubx_nav_clk_t clk;
+
+    ubx_parser_init(&parser);
+    CHECK(feed(&parser, nav_pvt_frame, sizeof(nav_pvt_frame)) == 1);
+    CHECK(parser.msg_class == UBX_CLASS_NAV && parser.msg_id == UBX_ID_NAV_PVT);
+    CHECK(parser.length == UBX_NAV_PVT_LEN);
+    check_nav_pvt(&parser);
+    CHECK(!ubx_decode_nav_clk(&parser, &clk));
+    CHECK(parser.checksum_errors == 0 && parser.length_errors == 0);
+}
+
+static void test_nav_clk(void)
+{
+    ubx_parser_t parser;
+    ubx_nav_clk_t clk;
+    ubx_nav_pvt_t pvt;
+
+    ubx_parser_init(&parser);
+    CHECK(feed(&parser, nav_clk_frame, sizeof(nav_clk_frame)) == 1);
+    CHECK(ubx_decode_nav_clk(&parser, &clk));
+    CHECK(clk.itow_ms == 389543800);
+    CHECK(clk.clk_b_ns == 281 && clk.clk_d_ns_s == 1234);
+    CHECK(clk.t_acc_ns == 12 && clk.f_acc_ps_s == 620);
+    CHECK(!ubx_decode_nav_pvt(&parser, &pvt));
+}
+
+static void test_built_frame(void)
+{
+    // ubx_build_frame() must reproduce the receiver's framing and checksum.
+    uint8_t out[sizeof(nav_clk_frame)];
+
+    CHECK(ubx_build_frame(out, UBX_CLASS_NAV, UBX_ID_NAV_CLK, &nav_clk_frame[6], UBX_NAV_CLK_LEN) == sizeof(out));
+    CHECK(memcmp(out, nav_clk_frame, sizeof(out)) == 0);
+}
+
+static void test_corrupted_checksum(void)
+{
+    ubx_parser_t parser;
+    uint8_t frame[sizeof(nav_pvt_frame)];
+
+    ubx_parser_init(&parser);
+
+    // A flipped payload bit, then a flipped CK_B: both frames dropped and counted.
+    memcpy(frame, nav_pvt_frame, sizeof(frame));
+    frame[30] ^= 0x01;
+    CHECK(feed(&parser, frame, sizeof(frame)) == 0);
+
+    memcpy(frame, nav_pvt_frame, sizeof(frame));
+    frame[sizeof(frame) - 1] ^= 0xFF;
+    CHECK(feed(&parser, frame, sizeof(frame)) == 0);
+    CHECK(parser.checksum_errors == 2);
+
+    // The parser is back in sync for the next good frame.
+    CHECK(feed(&parser, nav_pvt_frame, sizeof(nav_pvt_frame)) == 1);
+    check_nav_pvt(&parser);
+}
+
+static void test_nmea_noise(void)
+{
+    ubx_parser_t parser;
+    ubx_nav_clk_t clk;
+
+    ubx_parser_init(&parser);
+    CHECK(feed(&parser, (const uint8_t *)nmea_noise, strlen(nmea_noise)) == 0);
+    CHECK(feed(&parser, nav_pvt_frame, sizeof(nav_pvt_frame)) == 1);
+    check_nav_pvt(&parser);
+
+    // NMEA between two frames, and a lone sync character before the second.
+    static const uint8_t stray[] = {UBX_SYNC_1, '$', 'G'};
+    CHECK(feed(&parser, (const uint8_t *)nmea_noise, strlen(nmea_noise)) == 0);
+    CHECK(feed(&parser, stray, sizeof(stray)) == 0);
+    CHECK(feed(&parser, nav_clk_frame, sizeof(nav_clk_frame)) == 1);
+    CHECK(ubx_decode_nav_clk(&parser, &clk) && clk.clk_d_ns_s == 1234);
+    CHECK(parser.checksum_errors == 0 && parser.length_errors == 0);
+}
+
+static void test_split_frame(void)
+{
+    // The main loop drains the receive ring in whatever pieces the UART delivered.
+    static const size_t cuts[] = {1, 2, 5, 6, 7, 50, sizeof(nav_pvt_frame) - 2, sizeof(nav_pvt_frame) - 1};
+    ubx_parser_t parser;
+
+    for (size_t c = 0; c < sizeof(cuts) / sizeof(cuts[0]); c++)
+    {
+        ubx_parser_init(&parser);
+        CHECK(feed(&parser, nav_pvt_frame, cuts[c]) == 0);
+        CHECK(feed(&parser, &nav_pvt_frame[cuts[c]], sizeof(nav_pvt_frame) - cuts[c]) == 1);
+        check_nav_pvt(&parser);
+    }
+
+    // Two frames back to back, split across the boundary between them.
+    uint8_t stream[sizeof(nav_pvt_frame) + sizeof(nav_clk_frame)];
+    ubx_nav_clk_t clk;
+
+    memcpy(stream, nav_pvt_frame, sizeof(nav_pvt_frame));
+    memcpy(&stream[sizeof(nav_pvt_frame)], nav_clk_frame, sizeof(nav_clk_frame));
+    ubx_parser_init(&parser);
+    CHECK(feed(&parser, stream, 60) == 0);
+    CHECK(feed(&parser, &stream[60], sizeof(nav_pvt_frame) - 60 + 3) == 1);
+    check_nav_pvt(&parser);
+    CHECK(feed(&parser, &stream[sizeof(nav_pvt_frame) + 3], sizeof(nav_clk_frame) - 3) == 1);
+    CHECK(ubx_decode_nav_clk(&parser, &clk) && clk.clk_b_ns == 281);
+}
+
+static void test_corrupted_length(void)
+{
+    ubx_parser_t parser;
+    uint8_t frame[sizeof(nav_pvt_frame)];
+
+    // A length high byte hit by noise: 0x5C -> 0xFF5C. The parser must not wait for 65 KB.
+    memcpy(frame, nav_pvt_frame, sizeof(frame));
+    frame[5] = 0xFF;
+    ubx_parser_init(&parser);
+    CHECK(feed(&parser, frame, sizeof(frame)) == 0);
+    CHECK(parser.length_errors == 1);
+
+    // The very next frame is decoded.
+    CHECK(feed(&parser, nav_clk_frame, sizeof(nav_clk_frame)) == 1);
+    CHECK(parser.msg_id == UBX_ID_NAV_CLK);
+}
+
+/** @brief Checks a raw receiver capture: no checksum or length errors, every NAV message decodes. */
+static void test_capture(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    ubx_parser_t parser;
+    uint32_t frames = 0, pvt_count = 0, clk_count = 0;
+    int c;
+
+    CHECK(f != NULL);
+    if (!f) return;
+
+    ubx_parser_init(&parser);
+    while ((c = fgetc(f)) != EOF)
+    {
+        if (!ubx_parser_feed(&parser, (uint8_t)c)) continue;
+        frames++;
+
+        ubx_nav_pvt_t pvt;
+        ubx_nav_clk_t clk;
+
+        if (parser.msg_class == UBX_CLASS_NAV && parser.msg_id == UBX_ID_NAV_PVT)
+        {
+            CHECK(ubx_decode_nav_pvt(&parser, &pvt));
+            pvt_count++;
+        }
+        if (parser.msg_class == UBX_CLASS_NAV && parser.msg_id == UBX_ID_NAV_CLK)
+        {
+            CHECK(ubx_decode_nav_clk(&parser, &clk));
+            clk_count++;
+        }
+    }
+    fclose(f);
+
+    printf("%s: %u frames, %u NAV-PVT, %u NAV-CLK, %u checksum errors, %u length errors\n", path,
+           (unsigned)frames, (unsigned)pvt_count, (unsigned)clk_count,
+           (unsigned)parser.checksum_errors, (unsigned)parser.length_errors);
+    CHECK(frames > 0);
+    CHECK(parser.checksum_errors == 0 && parser.length_errors == 0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; i++) test_capture(argv[i]);
+        if (failures) printf("%d check(s) failed\n", failures);
+        return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    test_nav_pvt();
+    test_nav_clk();
+    test_built_frame();
+    test_corrupted_checksum();
+    test_nmea_noise();
+    test_split_frame();
+    test_corrupted_length();
+
+    if (failures) printf("%d check(s) failed\n", failures);
+    else printf("ubx_test: all checks passed\n");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}